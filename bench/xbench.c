@@ -0,0 +1,969 @@
+/**
+ * @file xbench.c
+ * @brief 热点文本处理函数的微基准（make bench）
+ * @note 覆盖 URL 编码、UTF-8 校验/转码、JSON 转义解码、模式提取、Google TK、语言检测和请求拼接，
+ *       每个函数在 ASCII / CJK / 中英混排（部分函数另加 GBK）语料的多种尺寸上运行，
+ *       输出 ns/op、ns/byte 和每次调用的堆分配次数/字节数。
+ *       --csv / --json 输出机器可读结果（JSON 每行一条），便于前后两次结果直接 diff 找回归。
+ *
+ *       堆分配通过链接器 --wrap=malloc/calloc/realloc/free 统计（见 Makefile 的 bench 目标），
+ *       libc 内部的分配（如 strdup）不计入。
+ *       gen_tk 是 xtrans_google.c 的静态函数，这里直接包含该源文件（bench 链接时不再单独链接它）；
+ *       xutf8.c 同样直接包含，以便 --verify 逐个对照 SSE2/AVX2 与标量实现。
+ *
+ *       --verify 不计时，只做自检：固定用例 + 随机输入上的差分对照（UTF-8 校验、JSON 流式提取、JSON 字符串解码），
+ *       有不一致时退出码为 1。
+ */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xhttpc.h"
+#include "xarena.h"
+#include "xutf8.h"
+#include "xjson.h"
+#include "xlimit.h"
+#include "../xtrans_google.c"
+#include "../xutf8.c"
+
+#define XBENCH_DEFAULT_MS   200     // 每个用例的默认计时预算
+#define XBENCH_ROUNDS       5       // 每个用例重复测量的轮数（取中位数）
+#define XBENCH_MAX_INPUT    65536
+
+// ---------------------------------------------------------------------------
+// 堆分配计数（--wrap 把所有目标文件里的 malloc 系列调用转到这里）
+// ---------------------------------------------------------------------------
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+static size_t xbench_allocs = 0;
+static size_t xbench_alloc_bytes = 0;
+
+void* __wrap_malloc(size_t size) {
+    xbench_allocs++;
+    xbench_alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    xbench_allocs++;
+    xbench_alloc_bytes += n * size;
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    xbench_allocs++;
+    xbench_alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr) {
+    __real_free(ptr);
+}
+
+// ---------------------------------------------------------------------------
+// 语料
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    XBENCH_ASCII = 0,
+    XBENCH_CJK,
+    XBENCH_MIXED,
+    XBENCH_GBK,
+    XBENCH_CORPUS_COUNT
+} xbench_corpus_t;
+
+static const char* const xbench_corpus_names[XBENCH_CORPUS_COUNT] = { "ascii", "cjk", "mixed", "gbk" };
+
+static const char* const xbench_seeds[XBENCH_CORPUS_COUNT] = {
+    // 英文：短句 + 标点、数字、URL（URL 编码时需要转义的字符较多）
+    "The quick brown fox jumps over the lazy dog. Most translation requests are short "
+    "sentences; some are whole paragraphs with \"quotes\", numbers like 42 or 3.14 and "
+    "links such as https://example.com/search?q=a+b&lang=en#top. ",
+    // 中文：全部为 3 字节字符
+    "机器翻译把一种自然语言的文本转换为另一种语言。短句是最常见的请求，"
+    "有时也会整段提交，其中包含标点符号、数字和引号。",
+    // 中英混排：含 4 字节字符（JSON 转义后为代理对）
+    "xtrans 支持 Google、Bing 和 MyMemory 三个引擎；用 -e bing 指定引擎，"
+    "或者设置 ALL_PROXY=socks5://127.0.0.1:1080 走代理 👍 ",
+    // GBK："你好，世界。机器翻译 xtrans "
+    "\xC4\xE3\xBA\xC3\xA3\xAC\xCA\xC0\xBD\xE7\xA1\xA3"
+    "\xBB\xFA\xC6\xF7\xB7\xAD\xD2\xEB xtrans ",
+};
+
+static const size_t xbench_sizes[] = { 16, 256, 4096, 65536 };
+#define XBENCH_SIZE_COUNT (sizeof(xbench_sizes) / sizeof(xbench_sizes[0]))
+
+/**
+ * @brief 用户输入：重复种子文本到指定长度，截断在字符边界上
+ */
+static size_t xbench_fill(char* out, size_t size, xbench_corpus_t corpus) {
+    const char* seed = xbench_seeds[corpus];
+    size_t seed_len = strlen(seed);
+    size_t len = 0;
+
+    while (len < size) {
+        size_t n = size - len < seed_len ? size - len : seed_len;
+        memcpy(out + len, seed, n);
+        len += n;
+    }
+
+    if (corpus == XBENCH_GBK) {
+        // GBK 双字节：前导字节 >= 0x81，按字符起点回退到偶数个高位字节
+        size_t i = 0, last = 0;
+        while (i < len) {
+            last = i;
+            i += (unsigned char)out[i] >= 0x81 ? 2 : 1;
+        }
+        if (i > len) len = last;
+    } else {
+        // UTF-8：最后一个字符不完整时整个丢掉
+        size_t i = len;
+        while (i > 0 && ((unsigned char)out[i - 1] & 0xC0) == 0x80) i--;
+        if (i > 0) {
+            unsigned char lead = (unsigned char)out[i - 1];
+            size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+            if (len - (i - 1) < need) len = i - 1;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief 服务端响应里的字符串：非 ASCII 转为 \uXXXX（补充平面为代理对），引号和反斜杠转义
+ */
+static size_t xbench_json_escape(const char* in, size_t len, char* out, size_t out_size) {
+    size_t o = 0;
+    for (size_t i = 0; i < len && o + 13 < out_size; ) {
+        unsigned char c = (unsigned char)in[i];
+        if (c < 0x80) {
+            if (c == '"' || c == '\\') out[o++] = '\\';
+            out[o++] = (char)c;
+            i++;
+            continue;
+        }
+
+        unsigned cp;
+        size_t n = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+        cp = c & (0x7F >> n);
+        for (size_t k = 1; k < n && i + k < len; k++) cp = (cp << 6) | ((unsigned char)in[i + k] & 0x3F);
+        i += n;
+
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            o += (size_t)sprintf(out + o, "\\u%04x\\u%04x", 0xD800 + (cp >> 10), 0xDC00 + (cp & 0x3FF));
+        } else {
+            o += (size_t)sprintf(out + o, "\\u%04x", cp);
+        }
+    }
+    out[o] = '\0';
+    return o;
+}
+
+// ---------------------------------------------------------------------------
+// 用例
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char* text;       // 原始语料（以 '\0' 结尾）
+    size_t len;
+    const char* escaped;    // JSON 转义后的语料
+    size_t escaped_len;
+    const char* response;   // 模拟 Bing 响应体
+    size_t response_len;
+    const char* form;       // URL 编码后的表单（请求体）
+    size_t form_len;
+    char* out;              // 输出缓冲区
+    size_t out_size;
+    xarena_t* arena;
+} xbench_input_t;
+
+typedef size_t (*xbench_fn)(const xbench_input_t* in);
+
+typedef struct {
+    const char* name;
+    xbench_fn fn;
+    unsigned corpora;       // 适用的语料（1 << xbench_corpus_t）
+    int bytes;              // ns/byte 的分母：0=原文，1=转义文本，2=响应体，3=请求体
+} xbench_case_t;
+
+static volatile size_t xbench_sink;
+
+static size_t bench_url_encode(const xbench_input_t* in) {
+    char* s = httpc_url_encode(in->text);
+    size_t n = s ? strlen(s) : 0;
+    free(s);
+    return n;
+}
+
+static size_t bench_url_encode_into(const xbench_input_t* in) {
+    return httpc_url_encode_into(in->text, in->len, HTTPC_URL_FORM, in->out, in->out_size);
+}
+
+static size_t bench_utf8_validate(const xbench_input_t* in) {
+    return (size_t)xutf8_validate(in->text, in->len);
+}
+
+static size_t bench_utf8_validate_scalar(const xbench_input_t* in) {
+    return (size_t)xutf8_validate_scalar(in->text, in->len);
+}
+
+static size_t bench_any_to_utf8(const xbench_input_t* in) {
+    return (size_t)httpc_any_to_utf8(in->text, in->out, in->out_size);
+}
+
+static size_t bench_decode_unicode(const xbench_input_t* in) {
+    return (size_t)httpc_decode_unicode(in->escaped, in->escaped_len, in->out, in->out_size);
+}
+
+static size_t bench_extract_pattern(const xbench_input_t* in) {
+    return (size_t)httpc_extract_pattern(in->response, "\"text\":\"", "\",\"to\":", in->out, in->out_size);
+}
+
+/**
+ * @brief 丢弃 TK 缓存（冷路径用例：每次都重新计算）
+ */
+static void bench_tk_drop(void) {
+    for (int i = 0; i < tk_cache_size; i++) {
+        free(tk_cache[i].text);
+        free(tk_cache[i].tk);
+    }
+    tk_cache_size = 0;
+}
+
+static size_t bench_gen_tk(const xbench_input_t* in) {
+    xarena_mark_t mark = xarena_mark(in->arena);
+    char* tk = gen_tk(in->arena, in->text);
+    size_t n = tk ? strlen(tk) : 0;
+    xarena_rewind(in->arena, mark);
+    bench_tk_drop();
+    return n;
+}
+
+static size_t bench_gen_tk_cached(const xbench_input_t* in) {
+    xarena_mark_t mark = xarena_mark(in->arena);
+    char* tk = gen_tk(in->arena, in->text);
+    size_t n = tk ? strlen(tk) : 0;
+    xarena_rewind(in->arena, mark);
+    return n;
+}
+
+static size_t bench_detect_language(const xbench_input_t* in) {
+    return (size_t)httpc_detect_language(in->text)[0];
+}
+
+static size_t bench_build_request(const xbench_input_t* in) {
+    httpc_config_t config = {
+        .server_host = "www.bing.com",
+        .server_port = "443",
+        .is_https = 1,
+        .method = "POST",
+        .url_path = "/ttranslatev3?isVertical=1&IG=0123456789ABCDEF0123456789ABCDEF&IID=translator.5023.1",
+        .content_type = "application/x-www-form-urlencoded",
+        .data = in->form,
+        .data_length = in->form_len,
+        .extra_headers = "Referer: https://www.bing.com/translator\r\nAccept: */*",
+    };
+    char* req = httpc_build_request(&config);
+    size_t n = req ? strlen(req) : 0;
+    free(req);
+    return n;
+}
+
+#define UTF8_CORPORA ((1u << XBENCH_ASCII) | (1u << XBENCH_CJK) | (1u << XBENCH_MIXED))
+#define ALL_CORPORA  (UTF8_CORPORA | (1u << XBENCH_GBK))
+
+static const xbench_case_t xbench_cases[] = {
+    { "url_encode",           bench_url_encode,           UTF8_CORPORA, 0 },
+    { "url_encode_into",      bench_url_encode_into,      UTF8_CORPORA, 0 },
+    { "utf8_validate",        bench_utf8_validate,        ALL_CORPORA,  0 },
+    { "utf8_validate_scalar", bench_utf8_validate_scalar, ALL_CORPORA,  0 },
+    { "any_to_utf8",          bench_any_to_utf8,          ALL_CORPORA,  0 },
+    { "decode_unicode",       bench_decode_unicode,       UTF8_CORPORA, 1 },
+    { "extract_pattern",      bench_extract_pattern,      UTF8_CORPORA, 2 },
+    { "gen_tk",               bench_gen_tk,               UTF8_CORPORA, 0 },
+    { "gen_tk_cached",        bench_gen_tk_cached,        UTF8_CORPORA, 0 },
+    { "detect_language",      bench_detect_language,      ALL_CORPORA,  0 },
+    { "build_request",        bench_build_request,        UTF8_CORPORA, 3 },
+};
+#define XBENCH_CASE_COUNT (sizeof(xbench_cases) / sizeof(xbench_cases[0]))
+
+// ---------------------------------------------------------------------------
+// 自检（--verify）
+// ---------------------------------------------------------------------------
+
+#define XBENCH_VERIFY_RANDOM    20000   // 随机输入个数
+#define XBENCH_VERIFY_SHOW      10      // 最多打印的失败用例数
+
+static size_t xbench_verify_failures = 0;
+
+static uint64_t xbench_rng = 0x9E3779B97F4A7C15ull;
+
+static uint32_t xbench_rand(void) {
+    xbench_rng ^= xbench_rng << 13;
+    xbench_rng ^= xbench_rng >> 7;
+    xbench_rng ^= xbench_rng << 17;
+    return (uint32_t)(xbench_rng >> 32);
+}
+
+static void xbench_verify_fail(const char* what, const char* data, size_t len, const char* detail) {
+    if (++xbench_verify_failures > XBENCH_VERIFY_SHOW) return;
+    printf("FAIL %s: %s, len=%zu:", what, detail, len);
+    for (size_t i = 0; i < len && i < 64; i++) printf(" %02x", (unsigned char)data[i]);
+    printf(len > 64 ? " ...\n" : "\n");
+}
+
+typedef struct {
+    const char* name;
+    int (*fn)(const char* str, size_t len);
+} xbench_utf8_impl_t;
+
+typedef struct {
+    const char* bytes;
+    int valid;
+} xbench_utf8_fixture_t;
+
+// 边界码点、超长编码、代理区、越界码点、孤立续字节和截断序列
+static const xbench_utf8_fixture_t xbench_utf8_fixtures[] = {
+    { "\xC2\x80", 1 },               // U+0080
+    { "\xDF\xBF", 1 },               // U+07FF
+    { "\xE0\xA0\x80", 1 },           // U+0800
+    { "\xED\x9F\xBF", 1 },           // U+D7FF
+    { "\xEE\x80\x80", 1 },           // U+E000
+    { "\xEF\xBF\xBF", 1 },           // U+FFFF
+    { "\xF0\x90\x80\x80", 1 },       // U+10000
+    { "\xF4\x8F\xBF\xBF", 1 },       // U+10FFFF
+    { "\xC0\x80", 0 },               // 超长 U+0000
+    { "\xC1\xBF", 0 },               // 超长 U+007F
+    { "\xE0\x9F\xBF", 0 },           // 超长 U+07FF
+    { "\xF0\x8F\xBF\xBF", 0 },       // 超长 U+FFFF
+    { "\xED\xA0\x80", 0 },           // U+D800
+    { "\xED\xBF\xBF", 0 },           // U+DFFF
+    { "\xED\xA0\xBD\xED\xB8\x80", 0 },// CESU-8 代理对
+    { "\xF4\x90\x80\x80", 0 },       // U+110000
+    { "\xF5\x80\x80\x80", 0 },
+    { "\xFF", 0 },
+    { "\x80", 0 },                   // 孤立续字节
+    { "\xC2\x80\x80", 0 },           // 多余续字节
+    { "\xC2", 0 },                   // 截断
+    { "\xE4\xB8", 0 },
+    { "\xF0\x9F\x91", 0 },
+    { "\xE4\x41\x80", 0 },           // 序列中间出现 ASCII
+};
+#define XBENCH_UTF8_FIXTURE_COUNT (sizeof(xbench_utf8_fixtures) / sizeof(xbench_utf8_fixtures[0]))
+
+/**
+ * @brief 本机可用的 UTF-8 校验实现（首项为标量参考实现）
+ */
+static size_t xbench_utf8_impls(xbench_utf8_impl_t* impls) {
+    size_t n = 0;
+    impls[n++] = (xbench_utf8_impl_t){ "scalar", xutf8_validate_scalar };
+#ifdef XUTF8_X86
+    impls[n++] = (xbench_utf8_impl_t){ "sse2", xutf8_validate_sse2 };
+    if (xutf8_has_avx2()) impls[n++] = (xbench_utf8_impl_t){ "avx2", xutf8_validate_avx2 };
+#endif
+    return n;
+}
+
+/**
+ * @brief 所有实现对同一输入的结论应一致；expected >= 0 时还要与之相同
+ * @note 输入复制到恰好 len 字节的堆块，越界读取能被 ASan 发现
+ */
+static void xbench_utf8_check(const xbench_utf8_impl_t* impls, size_t count, const char* data, size_t len,
+                              int expected) {
+    char* copy = malloc(len ? len : 1);
+    if (!copy) return;
+    memcpy(copy, data, len);
+
+    int want = expected >= 0 ? expected : impls[0].fn(copy, len);
+    for (size_t i = 0; i < count; i++) {
+        int got = impls[i].fn(copy, len);
+        if (got != want) {
+            char detail[64];
+            snprintf(detail, sizeof(detail), "%s returned %d, expected %d", impls[i].name, got, want);
+            xbench_verify_fail("utf8", copy, len, detail);
+        }
+    }
+    free(copy);
+}
+
+/**
+ * @brief 码点编码为 UTF-8，返回字节数
+ */
+static size_t xbench_utf8_encode(uint32_t cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/**
+ * @brief 随机码点序列（按字节长度大致均匀），返回写入的字节数
+ */
+static size_t xbench_utf8_random(char* out, size_t cap) {
+    size_t len = 0;
+    while (len + 4 <= cap) {
+        uint32_t r = xbench_rand();
+        uint32_t cp;
+        switch (r & 3) {
+        case 0:  cp = (r >> 8) % 0x80; break;
+        case 1:  cp = 0x80 + (r >> 8) % (0x800 - 0x80); break;
+        case 2:  cp = 0x800 + (r >> 8) % (0x10000 - 0x800 - 0x800); if (cp >= 0xD800) cp += 0x800; break;
+        default: cp = 0x10000 + (r >> 8) % (0x110000 - 0x10000); break;
+        }
+        len += xbench_utf8_encode(cp, out + len);
+    }
+    return len;
+}
+
+/**
+ * @brief UTF-8：各实现与标量实现及固定结论对照
+ * @note 固定用例嵌在 ASCII 中，放到 16/32 字节块边界两侧并在末尾截断；
+ *       随机输入先生成合法文本，再随机改写字节或截断
+ */
+static size_t xbench_verify_utf8(void) {
+    xbench_utf8_impl_t impls[3];
+    size_t count = xbench_utf8_impls(impls);
+    size_t inputs = 0;
+    char buf[160];
+
+    for (size_t f = 0; f < XBENCH_UTF8_FIXTURE_COUNT; f++) {
+        const char* seq = xbench_utf8_fixtures[f].bytes;
+        size_t seq_len = strlen(seq);
+        for (size_t pos = 0; pos + seq_len <= 100; pos++) {
+            // 序列前后都是 ASCII，总长覆盖整块和非整块
+            for (size_t tail = 0; tail <= 34; tail += 17) {
+                size_t len = pos + seq_len + tail;
+                memset(buf, 'a', len);
+                memcpy(buf + pos, seq, seq_len);
+                xbench_utf8_check(impls, count, buf, len, xbench_utf8_fixtures[f].valid);
+                inputs++;
+            }
+            // 序列被输入结尾截断：只有完整合法序列的真前缀才需要判为非法
+            for (size_t cut = 1; cut < seq_len; cut++) {
+                memset(buf, 'a', pos);
+                memcpy(buf + pos, seq, cut);
+                xbench_utf8_check(impls, count, buf, pos + cut, xbench_utf8_fixtures[f].valid ? 0 : -1);
+                inputs++;
+            }
+        }
+    }
+
+    for (int k = 0; k < XBENCH_VERIFY_RANDOM; k++) {
+        size_t len = xbench_utf8_random(buf, 4 + xbench_rand() % (sizeof(buf) - 4));
+        int mutate = xbench_rand() % 4;
+        if (mutate == 1 && len > 0) {
+            buf[xbench_rand() % len] = (char)xbench_rand();
+        } else if (mutate == 2 && len > 0) {
+            len = xbench_rand() % len;
+        } else if (mutate == 3) {
+            const char* seq = xbench_utf8_fixtures[xbench_rand() % XBENCH_UTF8_FIXTURE_COUNT].bytes;
+            size_t seq_len = strlen(seq);
+            size_t pos = len > seq_len ? xbench_rand() % (len - seq_len) : 0;
+            memcpy(buf + pos, seq, seq_len);
+            if (pos + seq_len > len) len = pos + seq_len;
+        }
+        xbench_utf8_check(impls, count, buf, len, mutate == 0 ? 1 : -1);
+        inputs++;
+    }
+
+    printf("utf8: %zu inputs, impls:", inputs);
+    for (size_t i = 0; i < count; i++) printf(" %s", impls[i].name);
+    printf("\n");
+    return inputs;
+}
+
+typedef struct {
+    const char* json;
+    const char* pointer;
+    const char* expected;   // NULL 表示未找到或语法错误
+} xbench_json_fixture_t;
+
+// 引擎响应的形状、转义键、代理对、通配符路径和各种不提取的情况
+static const xbench_json_fixture_t xbench_json_fixtures[] = {
+    { "{\"responseData\":{\"translatedText\":\"Hallo\"}}", "/responseData/translatedText", "Hallo" },
+    { "{\"b\":{\"a\":\"no\"},\"a\":\"yes\"}", "/a", "yes" },
+    { "[{\"translations\":[{\"text\":\"\\u4f60\\u597d\",\"to\":\"zh\"}]}]", "/0/translations/0/text", "\xE4\xBD\xA0\xE5\xA5\xBD" },
+    { "{ \"a\" : [ 1 , 22 , 333 ] }", "/a/2", "333" },
+    { "{\"a\":12.5e3,\"b\":true}", "/a", "12.5e3" },
+    { "{\"a\":false}", "/a", "false" },
+    // 转义键：按解码后的字节与路径段比较
+    { "{\"tra\\u006eslation\":\"ok\"}", "/translation", "ok" },
+    { "{\"k\\\"q\":\"quote\"}", "/k\"q", "quote" },
+    { "{\"a/b\":\"slash\",\"a~b\":\"tilde\"}", "/a~1b", "slash" },
+    { "{\"a/b\":\"slash\",\"a~b\":\"tilde\"}", "/a~0b", "tilde" },
+    { "{\"\\u00e9\":\"e\"}", "/\xC3\xA9", "e" },
+    // 代理对合成补充平面字符，孤立代理输出 U+FFFD
+    { "[\"\\ud83d\\ude00\"]", "/0", "\xF0\x9F\x98\x80" },
+    { "[\"\\uD83D\\uDE00!\"]", "/0", "\xF0\x9F\x98\x80!" },
+    { "[\"\\ud83d\"]", "/0", "\xEF\xBF\xBD" },
+    { "[\"\\ude00x\"]", "/0", "\xEF\xBF\xBDx" },
+    { "[\"\\ud83dx\"]", "/0", "\xEF\xBF\xBDx" },
+    { "{\"a\":\"\\b\\f\\n\\r\\t\\\\\\/\\\"\"}", "/a", "\b\f\n\r\t\\/\"" },
+    // 通配符：所有匹配依次拼接
+    { "[[[\"Hello \",\"x\"],[\"world\",\"y\"]]]", "/0/*/0", "Hello world" },
+    { "{\"s\":[{\"t\":\"A\"},{\"u\":1},{\"t\":\"B\"}]}", "/s/*/t", "AB" },
+    { "{\"x\":{\"p\":\"1\",\"q\":\"2\"}}", "/x/*", "12" },
+    { "{\"s\":[{\"t\":[\"nested\"]},{\"t\":\"C\"}]}", "/s/*/t", "C" },
+    // 不提取
+    { "{\"a\":null}", "/a", NULL },
+    { "{\"a\":[1,2]}", "/a", NULL },
+    { "{\"a\":\"x\"}", "/b", NULL },
+    { "{\"a\":\"x\"}", "/a/0", NULL },
+    { "[\"x\"]", "/1", NULL },
+    { "{\"a\" \"x\"}", "/a", NULL },
+    { "{\"a\":\"x\"]", "/b", NULL },
+};
+#define XBENCH_JSON_FIXTURE_COUNT (sizeof(xbench_json_fixtures) / sizeof(xbench_json_fixtures[0]))
+
+/**
+ * @brief 按给定切分点把文档分块喂入提取器（step=0 时随机切块），返回结果长度，未找到或出错返回 -1
+ */
+static int xbench_json_stream(const char* json, size_t len, const char* pointer, size_t step,
+                              char* out, size_t out_size) {
+    xjson_t j;
+    if (xjson_init(&j, pointer, out, out_size) != 0) return -1;
+
+    int st = XJSON_MORE;
+    for (size_t pos = 0; pos < len && st == XJSON_MORE; ) {
+        size_t n = step ? step : 1 + xbench_rand() % 8;
+        if (n > len - pos) n = len - pos;
+        // 每块单独复制到恰好大小的堆块，越界读取能被 ASan 发现
+        char* chunk = malloc(n);
+        if (!chunk) return -1;
+        memcpy(chunk, json + pos, n);
+        st = xjson_feed(&j, chunk, n);
+        free(chunk);
+        pos += n;
+    }
+    if (st == XJSON_ERROR || j.matches == 0) return -1;
+    return (int)j.out_len;
+}
+
+static void xbench_json_expect(const xbench_json_fixture_t* f, const char* mode, int got, const char* out) {
+    const char* want = f->expected;
+    if (want ? got >= 0 && (size_t)got == strlen(want) && memcmp(out, want, (size_t)got) == 0 : got < 0) return;
+
+    char detail[256];
+    snprintf(detail, sizeof(detail), "%s %s returned %d \"%s\", expected \"%s\"", mode, f->pointer, got,
+             got >= 0 ? out : "", want ? want : "(none)");
+    xbench_verify_fail("json", f->json, strlen(f->json), detail);
+}
+
+/**
+ * @brief JSON 流式提取：一次性、逐字节、任意两段切分和随机切块的结果都应与固定结论一致
+ */
+static size_t xbench_verify_json(void) {
+    size_t inputs = 0;
+    char out[256];
+
+    for (size_t f = 0; f < XBENCH_JSON_FIXTURE_COUNT; f++) {
+        const xbench_json_fixture_t* fx = &xbench_json_fixtures[f];
+        size_t len = strlen(fx->json);
+
+        xbench_json_expect(fx, "one-shot", xjson_extract(fx->json, len, fx->pointer, out, sizeof(out)), out);
+        xbench_json_expect(fx, "byte-by-byte", xbench_json_stream(fx->json, len, fx->pointer, 1, out, sizeof(out)), out);
+        inputs += 2;
+
+        for (size_t cut = 1; cut < len; cut++) {
+            xjson_t j;
+            int got = -1;
+            if (xjson_init(&j, fx->pointer, out, sizeof(out)) == 0) {
+                int st = xjson_feed(&j, fx->json, cut);
+                if (st == XJSON_MORE) st = xjson_feed(&j, fx->json + cut, len - cut);
+                got = st == XJSON_ERROR || j.matches == 0 ? -1 : (int)j.out_len;
+            }
+            xbench_json_expect(fx, "split", got, out);
+            inputs++;
+        }
+        for (int k = 0; k < 16; k++) {
+            xbench_json_expect(fx, "chunked", xbench_json_stream(fx->json, len, fx->pointer, 0, out, sizeof(out)), out);
+            inputs++;
+        }
+    }
+
+    printf("json: %zu parses over %zu fixtures\n", inputs, XBENCH_JSON_FIXTURE_COUNT);
+    return inputs;
+}
+
+typedef struct {
+    const char* in;         // 字符串内容（不含两端引号）
+    const char* out;
+} xbench_unescape_fixture_t;
+
+static const xbench_unescape_fixture_t xbench_unescape_fixtures[] = {
+    { "plain text", "plain text" },
+    { "\\\"\\\\\\/\\b\\f\\n\\r\\t", "\"\\/\b\f\n\r\t" },
+    { "\\u0041\\u00e9\\u4E2D\\uFFFF", "A\xC3\xA9\xE4\xB8\xAD\xEF\xBF\xBF" },
+    { "\\ud83d\\ude00", "\xF0\x9F\x98\x80" },
+    { "\\uD83D\\uDE00", "\xF0\x9F\x98\x80" },
+    { "\\udbff\\udfff", "\xF4\x8F\xBF\xBF" },
+    { "\\ud800\\udc00", "\xF0\x90\x80\x80" },
+    // 孤立代理输出 U+FFFD
+    { "\\ud83d", "\xEF\xBF\xBD" },
+    { "\\ud83dx", "\xEF\xBF\xBDx" },
+    { "\\ud83d\\u0041", "\xEF\xBF\xBD" "A" },
+    { "\\ud83d\\ud83d\\ude00", "\xEF\xBF\xBD\xF0\x9F\x98\x80" },
+    { "\\ude00\\ud83d", "\xEF\xBF\xBD\xEF\xBF\xBD" },
+    // 非法或不完整的转义原样保留
+    { "a\\x", "a\\x" },
+    { "\\u12", "\\u12" },
+    { "\\u12zz", "\\u12zz" },
+    { "abc\\", "abc\\" },
+    // 未转义的 UTF-8 原样拷贝
+    { "\xE4\xBD\xA0\\n\xF0\x9F\x91\x8D", "\xE4\xBD\xA0\n\xF0\x9F\x91\x8D" },
+};
+#define XBENCH_UNESCAPE_FIXTURE_COUNT (sizeof(xbench_unescape_fixtures) / sizeof(xbench_unescape_fixtures[0]))
+
+static void xbench_unescape_expect(const char* mode, const char* in, size_t in_len, int got, const char* out,
+                                   const char* want, size_t want_len) {
+    if (got >= 0 && (size_t)got == want_len && memcmp(out, want, want_len) == 0) return;
+
+    char detail[64];
+    snprintf(detail, sizeof(detail), "%s returned %d, expected %zu bytes", mode, got, want_len);
+    xbench_verify_fail("unescape", in, in_len, detail);
+}
+
+/**
+ * @brief 随机转义字符串：按片段生成输入，同时写出期望的解码结果
+ * @note 片段都是合法 JSON 字符串内容，因此同一输入加上引号后也能交给流式提取器解码
+ */
+static void xbench_unescape_random(char* in, size_t* in_len, char* want, size_t* want_len, size_t pieces) {
+    static const char simple[] = "\"\\/bfnrt";
+    static const char simple_out[] = "\"\\/\b\f\n\r\t";
+    size_t i = 0, o = 0;
+
+    for (size_t k = 0; k < pieces; k++) {
+        uint32_t r = xbench_rand();
+        switch (r % 6) {
+        case 0: {   // 一段 ASCII（长短不一，覆盖 SIMD 整块拷贝）
+            size_t n = 1 + (r >> 8) % 40;
+            for (size_t m = 0; m < n; m++) {
+                char c = (char)('a' + xbench_rand() % 26);
+                in[i++] = c;
+                want[o++] = c;
+            }
+            break;
+        }
+        case 1: {   // 未转义的多字节字符
+            static const char* const raw[] = { "\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x91\x8D" };
+            const char* c = raw[(r >> 8) % 3];
+            size_t n = strlen(c);
+            memcpy(in + i, c, n);
+            memcpy(want + o, c, n);
+            i += n;
+            o += n;
+            break;
+        }
+        case 2: {   // 单字符转义
+            size_t e = (r >> 8) % (sizeof(simple) - 1);
+            in[i++] = '\\';
+            in[i++] = simple[e];
+            want[o++] = simple_out[e];
+            break;
+        }
+        case 3: {   // BMP 非代理码点
+            uint32_t cp = 1 + (r >> 8) % 0xFFFE;
+            if (cp >= 0xD800 && cp <= 0xDFFF) cp -= 0x800;
+            i += (size_t)sprintf(in + i, (r & 0x80) ? "\\u%04X" : "\\u%04x", cp);
+            o += (size_t)xbench_utf8_encode(cp, want + o);
+            break;
+        }
+        case 4: {   // 代理对
+            uint32_t cp = 0x10000 + (r >> 8) % 0x100000;
+            i += (size_t)sprintf(in + i, "\\u%04x\\u%04x", 0xD800 + ((cp - 0x10000) >> 10), 0xDC00 + (cp & 0x3FF));
+            o += (size_t)xbench_utf8_encode(cp, want + o);
+            break;
+        }
+        default: {  // 孤立代理（高位代理后跟普通字符，不会与下一片段组成代理对）
+            if (r & 0x100) {
+                i += (size_t)sprintf(in + i, "\\u%04xz", 0xD800 + (r >> 16) % 0x400);
+                o += (size_t)xbench_utf8_encode(0xFFFD, want + o);
+                want[o++] = 'z';
+            } else {
+                i += (size_t)sprintf(in + i, "\\u%04x", 0xDC00 + (r >> 16) % 0x400);
+                o += (size_t)xbench_utf8_encode(0xFFFD, want + o);
+            }
+            break;
+        }
+        }
+    }
+    *in_len = i;
+    *want_len = o;
+}
+
+/**
+ * @brief JSON 字符串解码：固定用例；随机输入上 xjson_unescape、一次性提取和逐字节提取三者与期望一致；
+ *        输出空间不足时返回 -1 且结果是期望的前缀
+ */
+static size_t xbench_verify_unescape(void) {
+    size_t inputs = 0;
+    char in[1024], want[1024], doc[1040], out[1040];
+
+    for (size_t f = 0; f < XBENCH_UNESCAPE_FIXTURE_COUNT; f++) {
+        const xbench_unescape_fixture_t* fx = &xbench_unescape_fixtures[f];
+        size_t in_len = strlen(fx->in);
+        // 反斜杠放到 16/32 字节块边界两侧
+        for (size_t pad = 0; pad <= 40; pad++) {
+            memset(in, 'p', pad);
+            memcpy(in + pad, fx->in, in_len);
+            memset(want, 'p', pad);
+            memcpy(want + pad, fx->out, strlen(fx->out));
+            char* copy = malloc(pad + in_len);
+            if (!copy) return inputs;
+            memcpy(copy, in, pad + in_len);
+            int got = xjson_unescape(copy, pad + in_len, out, sizeof(out));
+            xbench_unescape_expect("xjson_unescape", copy, pad + in_len, got, out, want, pad + strlen(fx->out));
+            free(copy);
+            inputs++;
+        }
+    }
+
+    for (int k = 0; k < XBENCH_VERIFY_RANDOM / 10; k++) {
+        size_t in_len, want_len;
+        xbench_unescape_random(in, &in_len, want, &want_len, 1 + xbench_rand() % 20);
+        xbench_unescape_expect("xjson_unescape", in, in_len, xjson_unescape(in, in_len, out, sizeof(out)),
+                               out, want, want_len);
+
+        doc[0] = '"';
+        memcpy(doc + 1, in, in_len);
+        doc[in_len + 1] = '"';
+        xbench_unescape_expect("one-shot extract", in, in_len, xjson_extract(doc, in_len + 2, "", out, sizeof(out)),
+                               out, want, want_len);
+        xbench_unescape_expect("byte-by-byte extract", in, in_len,
+                               xbench_json_stream(doc, in_len + 2, "", 1, out, sizeof(out)), out, want, want_len);
+        inputs += 3;
+
+        // 空间不足：返回 -1，已写出的部分是期望结果的前缀
+        size_t room = 1 + xbench_rand() % (want_len + 1);
+        if (room <= want_len) {
+            int got = xjson_unescape(in, in_len, out, room);
+            size_t n = strlen(out);
+            if (got != -1 || n >= room || memcmp(out, want, n) != 0) {
+                xbench_verify_fail("unescape", in, in_len, "truncated output is not a prefix");
+            }
+            inputs++;
+        }
+    }
+
+    printf("unescape: %zu inputs over %zu fixtures\n", inputs, XBENCH_UNESCAPE_FIXTURE_COUNT);
+    return inputs;
+}
+
+/**
+ * @brief 运行全部自检
+ * @return 失败个数
+ */
+static size_t xbench_verify(void) {
+    xbench_verify_utf8();
+    xbench_verify_json();
+    xbench_verify_unescape();
+    if (xbench_verify_failures > 0) {
+        printf("verify: %zu failures\n", xbench_verify_failures);
+    } else {
+        printf("verify: ok\n");
+    }
+    return xbench_verify_failures;
+}
+
+// ---------------------------------------------------------------------------
+// 计时与输出
+// ---------------------------------------------------------------------------
+
+typedef enum { XBENCH_TABLE, XBENCH_CSV, XBENCH_JSON } xbench_format_t;
+
+typedef struct {
+    double ns_op;           // 中位数
+    double ns_op_min;
+    double ns_byte;
+    double allocs_op;
+    double alloc_bytes_op;
+    size_t iterations;      // 每轮迭代次数
+} xbench_result_t;
+
+static int xbench_cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 运行一个用例：先倍增迭代次数找到单轮约 budget/ROUNDS 的规模，再测 ROUNDS 轮取中位数
+ */
+static void xbench_run(const xbench_case_t* c, const xbench_input_t* in, size_t bytes,
+                       double budget_ms, xbench_result_t* r) {
+    double round_ms = budget_ms / XBENCH_ROUNDS;
+    size_t iters = 1;
+
+    xbench_sink += c->fn(in);   // 预热（首次调用会选择 SIMD 实现、打开转码器等）
+    for (;;) {
+        double t0 = xlimit_now_ms();
+        for (size_t i = 0; i < iters; i++) xbench_sink += c->fn(in);
+        double dt = xlimit_now_ms() - t0;
+        if (dt >= round_ms || iters >= ((size_t)1 << 30)) break;
+        if (dt < round_ms / 16) iters *= 8;
+        else iters = (size_t)(iters * round_ms / dt) + 1;
+    }
+
+    double samples[XBENCH_ROUNDS];
+    size_t allocs = xbench_allocs, alloc_bytes = xbench_alloc_bytes;
+    for (int k = 0; k < XBENCH_ROUNDS; k++) {
+        double t0 = xlimit_now_ms();
+        for (size_t i = 0; i < iters; i++) xbench_sink += c->fn(in);
+        samples[k] = (xlimit_now_ms() - t0) * 1e6 / (double)iters;
+    }
+    double total = (double)iters * XBENCH_ROUNDS;
+    qsort(samples, XBENCH_ROUNDS, sizeof(samples[0]), xbench_cmp_double);
+
+    r->ns_op = samples[XBENCH_ROUNDS / 2];
+    r->ns_op_min = samples[0];
+    r->ns_byte = bytes ? r->ns_op / (double)bytes : 0.0;
+    r->allocs_op = (double)(xbench_allocs - allocs) / total;
+    r->alloc_bytes_op = (double)(xbench_alloc_bytes - alloc_bytes) / total;
+    r->iterations = iters;
+}
+
+static void xbench_print(xbench_format_t format, const char* name, const char* corpus, size_t size,
+                         size_t bytes, const xbench_result_t* r) {
+    switch (format) {
+    case XBENCH_CSV:
+        printf("%s,%s,%zu,%zu,%.1f,%.1f,%.4f,%.2f,%.1f,%zu\n", name, corpus, size, bytes,
+               r->ns_op, r->ns_op_min, r->ns_byte, r->allocs_op, r->alloc_bytes_op, r->iterations);
+        break;
+    case XBENCH_JSON:
+        printf("{\"bench\":\"%s\",\"corpus\":\"%s\",\"size\":%zu,\"bytes\":%zu,\"ns_op\":%.1f,"
+               "\"ns_op_min\":%.1f,\"ns_byte\":%.4f,\"allocs_op\":%.2f,\"alloc_bytes_op\":%.1f,\"iters\":%zu}\n",
+               name, corpus, size, bytes, r->ns_op, r->ns_op_min, r->ns_byte, r->allocs_op,
+               r->alloc_bytes_op, r->iterations);
+        break;
+    default:
+        printf("%-22s %-6s %6zu %7zu %12.1f %9.3f %8.2f %10.1f\n", name, corpus, size, bytes,
+               r->ns_op, r->ns_byte, r->allocs_op, r->alloc_bytes_op);
+        break;
+    }
+    fflush(stdout);
+}
+
+static void xbench_usage(const char* prog) {
+    printf("Usage: %s [--csv | --json] [--filter NAME] [--time MS] | --verify\n", prog);
+    printf("  --csv          CSV output (header line first)\n");
+    printf("  --json         JSON Lines output (one object per case)\n");
+    printf("  --filter NAME  run only benchmarks whose name contains NAME\n");
+    printf("  --time MS      time budget per case (default %d)\n", XBENCH_DEFAULT_MS);
+    printf("  --verify       self-check (SIMD UTF-8 vs scalar, streaming JSON vs one-shot), no timing\n");
+}
+
+int main(int argc, char* argv[]) {
+    xbench_format_t format = XBENCH_TABLE;
+    const char* filter = NULL;
+    double budget_ms = XBENCH_DEFAULT_MS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            format = XBENCH_CSV;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            format = XBENCH_JSON;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            return xbench_verify() > 0 ? 1 : 0;
+        } else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            budget_ms = atof(argv[++i]);
+            if (budget_ms <= 0) budget_ms = XBENCH_DEFAULT_MS;
+        } else {
+            xbench_usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0 ? 0 : 1;
+        }
+    }
+
+    // 输入/输出缓冲一次分配，计时循环内只统计被测函数自身的分配
+    size_t cap = XBENCH_MAX_INPUT * 13 + 256;
+    char* text = malloc(XBENCH_MAX_INPUT + 1);
+    char* escaped = malloc(cap);
+    char* response = malloc(cap + 128);
+    char* form = malloc(XBENCH_MAX_INPUT * 3 + 16);
+    char* out = malloc(cap);
+    if (!text || !escaped || !response || !form || !out) {
+        fprintf(stderr, "xbench: out of memory\n");
+        return 1;
+    }
+
+    xarena_t arena;
+    xarena_init(&arena, 0);
+
+    if (format == XBENCH_CSV) {
+        printf("bench,corpus,size,bytes,ns_op,ns_op_min,ns_byte,allocs_op,alloc_bytes_op,iters\n");
+    } else if (format == XBENCH_TABLE) {
+        printf("# utf8 impl: %s, %.0f ms per case\n", xutf8_impl(), budget_ms);
+        printf("%-22s %-6s %6s %7s %12s %9s %8s %10s\n",
+               "bench", "corpus", "size", "bytes", "ns/op", "ns/byte", "allocs", "bytes/op");
+    }
+
+    for (size_t ci = 0; ci < XBENCH_CASE_COUNT; ci++) {
+        const xbench_case_t* c = &xbench_cases[ci];
+        if (filter && !strstr(c->name, filter)) continue;
+
+        for (int corpus = 0; corpus < XBENCH_CORPUS_COUNT; corpus++) {
+            if (!(c->corpora & (1u << corpus))) continue;
+
+            for (size_t si = 0; si < XBENCH_SIZE_COUNT; si++) {
+                xbench_input_t in;
+                memset(&in, 0, sizeof(in));
+                in.text = text;
+                in.len = xbench_fill(text, xbench_sizes[si], (xbench_corpus_t)corpus);
+                in.escaped = escaped;
+                in.escaped_len = xbench_json_escape(text, in.len, escaped, cap);
+                in.response = response;
+                in.response_len = (size_t)snprintf(response, cap + 128,
+                    "[{\"detectedLanguage\":{\"language\":\"en\",\"score\":1.0},"
+                    "\"translations\":[{\"text\":\"%s\",\"to\":\"zh-Hans\",\"sentLen\":{}}]}]", escaped);
+                in.form = form;
+                in.form_len = httpc_url_encode_into(text, in.len, HTTPC_URL_FORM, form, XBENCH_MAX_INPUT * 3 + 16);
+                in.out = out;
+                in.out_size = cap;
+                in.arena = &arena;
+
+                size_t bytes = c->bytes == 1 ? in.escaped_len :
+                               c->bytes == 2 ? in.response_len :
+                               c->bytes == 3 ? in.form_len : in.len;
+
+                xbench_result_t r;
+                xbench_run(c, &in, bytes, budget_ms, &r);
+                xbench_print(format, c->name, xbench_corpus_names[corpus], xbench_sizes[si], bytes, &r);
+            }
+        }
+    }
+
+    bench_tk_drop();
+    xarena_free(&arena);
+    free(text);
+    free(escaped);
+    free(response);
+    free(form);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file xbench_e2e.c
+ * @brief 端到端基准：经本地模拟服务器（bench/xmock.c）测量各引擎接口的吞吐和延迟
+ * @note 通过 httpc_set_connect_to 把引擎主机的 80/443 端口指向模拟服务器，
+ *       httpc_set_default_ca 信任模拟服务器生成的 CA，引擎代码本身不做任何改动。
+ *       每个模式 = 接口（google / bing / bing-dict / mymemory）× 传输（http / https）× 场景
+ *       （X-Mock 头指定：基线、延迟、chunked、重定向、节流、失败、断连、短连接），
+ *       另有 adapter 模式走完整的引擎适配器（Bing 含 /translator 页面解析）。
+ *       顺序发送请求（与 CLI 相同：连接池复用连接），输出 req/s、p50/p99 和平均尝试次数；
+ *       --csv / --json 输出机器可读结果
+ */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/net_sockets.h"
+
+#include "xhttpc.h"
+#include "xlimit.h"
+#include "xtrans_bing.h"
+#include "xtrans_google.h"
+
+#define E2E_DEFAULT_REQUESTS    200
+#define E2E_DEFAULT_HTTP        "127.0.0.1:18080"
+#define E2E_DEFAULT_HTTPS       "127.0.0.1:18443"
+#define E2E_DEFAULT_CA          "xmock_ca.pem"
+#define E2E_WAIT_MS             5000        // 等待模拟服务器启动的上限
+#define E2E_TEXT                "The quick brown fox jumps over the lazy dog."
+#define E2E_TEXT_ENCODED        "The%20quick%20brown%20fox%20jumps%20over%20the%20lazy%20dog."
+
+// 被测接口（与各引擎发出的请求一致）
+typedef struct {
+    const char* name;
+    const char* host;
+    const char* method;
+    const char* path;
+    const char* content_type;
+    const char* data;
+} e2e_endpoint_t;
+
+static const e2e_endpoint_t e2e_endpoints[] = {
+    { "google", "translate.googleapis.com", "GET",
+      "/translate_a/single?client=gtx&ie=UTF-8&oe=UTF-8&dt=t&sl=en&tl=zh-CN&hl=en&tk=1.1&q=" E2E_TEXT_ENCODED,
+      NULL, NULL },
+    { "bing", "www.bing.com", "POST",
+      "/ttranslatev3?IG=0123456789ABCDEF0123456789ABCDEF&IID=translator.5023",
+      "application/x-www-form-urlencoded",
+      "&text=" E2E_TEXT_ENCODED "&fromLang=en&to=zh-Hans&token=xmock-token&key=1700000000000" },
+    { "bing-dict", "cn.bing.com", "GET", "/dict/search?q=hello&mkt=zh-CN&setlang=zh", NULL, NULL },
+    { "mymemory", "api.mymemory.translated.net", "GET", "/get?q=" E2E_TEXT_ENCODED "&langpair=en|zh", NULL, NULL },
+};
+#define E2E_ENDPOINT_COUNT (sizeof(e2e_endpoints) / sizeof(e2e_endpoints[0]))
+
+// 场景：X-Mock 头的内容
+typedef struct {
+    const char* name;
+    const char* mock;
+} e2e_scenario_t;
+
+static const e2e_scenario_t e2e_scenarios[] = {
+    { "base",     NULL },
+    { "latency",  "latency=5,jitter=5" },
+    { "chunked",  "chunk=16" },
+    { "redirect", "redirect=1" },
+    { "throttle", "throttle=0.1" },
+    { "fail",     "fail=0.1" },
+    { "drop",     "drop=0.05" },
+    { "close",    "close=1" },
+};
+#define E2E_SCENARIO_COUNT (sizeof(e2e_scenarios) / sizeof(e2e_scenarios[0]))
+
+typedef enum { E2E_TABLE, E2E_CSV, E2E_JSON } e2e_format_t;
+
+typedef struct {
+    int requests;
+    int errors;
+    double attempts;        // 平均尝试次数（含重试）
+    double rps;
+    double mean_ms;
+    double p50_ms;
+    double p99_ms;
+    double max_ms;
+} e2e_result_t;
+
+static int e2e_cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 最近秩百分位
+ */
+static double e2e_percentile(const double* sorted, int n, double p) {
+    int rank = (int)(p / 100.0 * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+static int e2e_status_of(const char* resp, size_t len) {
+    const char* sp = len > 5 && strncmp(resp, "HTTP/", 5) == 0 ? memchr(resp, ' ', len) : NULL;
+    return sp ? atoi(sp + 1) : 0;
+}
+
+/**
+ * @brief 一次接口请求（与引擎相同：httpc_request_retry + 连接池）
+ * @return 1 成功（2xx），0 失败
+ */
+static int e2e_request(const e2e_endpoint_t* ep, int https, const char* mock, char* buf, size_t buf_len,
+                       int* attempts) {
+    char extra[128] = "Accept: */*";
+    if (mock) snprintf(extra, sizeof(extra), "Accept: */*\r\nX-Mock: %s", mock);
+
+    httpc_config_t config = {
+        .server_host = ep->host,
+        .server_port = https ? "443" : "80",
+        .is_https = https,
+        .method = ep->method,
+        .url_path = ep->path,
+        .content_type = ep->content_type,
+        .data = ep->data,
+        .data_length = ep->data ? strlen(ep->data) : 0,
+        .extra_headers = extra,
+    };
+    static const httpc_retry_t retry = { .idempotent = 1 };
+
+    size_t actual_read = 0;
+    httpc_err_t err = httpc_request_retry(&config, &retry, buf, buf_len, &actual_read, attempts);
+    int status = err == HTTPC_SUCCESS ? e2e_status_of(buf, actual_read) : 0;
+    return status >= 200 && status < 300;
+}
+
+/**
+ * @brief 一次完整的引擎适配器调用（ep->name 选择引擎）
+ */
+static int e2e_adapter(const e2e_endpoint_t* ep, char* buf, size_t buf_len) {
+    if (strcmp(ep->name, "google") == 0) {
+        char* result = translate_google(E2E_TEXT, "en", "zh-CN", 0, NULL);
+        int ok = result && strncmp(result, "[mock]", 6) == 0;
+        free(result);
+        return ok;
+    }
+    return translate_bing_long(E2E_TEXT, "en", "zh", buf, buf_len, 0, NULL) > 0 &&
+           strncmp(buf, "[mock]", 6) == 0;
+}
+
+/**
+ * @brief 运行一个模式：先发一个不计时的请求建立连接，再顺序发送 n 个请求
+ * @param https -1 表示适配器模式
+ */
+static void e2e_run(const e2e_endpoint_t* ep, int https, const char* mock, int n, e2e_result_t* r) {
+    static char buf[256 * 1024];
+    double* lat = malloc((size_t)n * sizeof(double));
+    memset(r, 0, sizeof(*r));
+    if (!lat) return;
+
+    int attempts = 0;
+    if (https < 0) e2e_adapter(ep, buf, sizeof(buf));
+    else e2e_request(ep, https, mock, buf, sizeof(buf), &attempts);
+
+    int total_attempts = 0;
+    double start = xlimit_now_ms();
+    for (int i = 0; i < n; i++) {
+        double t0 = xlimit_now_ms();
+        int ok;
+        if (https < 0) {
+            ok = e2e_adapter(ep, buf, sizeof(buf));
+            attempts = 1;
+        } else {
+            attempts = 0;
+            ok = e2e_request(ep, https, mock, buf, sizeof(buf), &attempts);
+        }
+        lat[i] = xlimit_now_ms() - t0;
+        total_attempts += attempts;
+        if (!ok) r->errors++;
+    }
+    double elapsed = xlimit_now_ms() - start;
+
+    qsort(lat, (size_t)n, sizeof(double), e2e_cmp_double);
+    double sum = 0;
+    for (int i = 0; i < n; i++) sum += lat[i];
+
+    r->requests = n;
+    r->attempts = (double)total_attempts / n;
+    r->rps = elapsed > 0 ? n * 1000.0 / elapsed : 0.0;
+    r->mean_ms = sum / n;
+    r->p50_ms = e2e_percentile(lat, n, 50);
+    r->p99_ms = e2e_percentile(lat, n, 99);
+    r->max_ms = lat[n - 1];
+    free(lat);
+}
+
+static void e2e_print(e2e_format_t format, const char* endpoint, const char* transport, const char* scenario,
+                      const e2e_result_t* r) {
+    switch (format) {
+    case E2E_CSV:
+        printf("%s,%s,%s,%d,%d,%.2f,%.1f,%.3f,%.3f,%.3f,%.3f\n", endpoint, transport, scenario,
+               r->requests, r->errors, r->attempts, r->rps, r->mean_ms, r->p50_ms, r->p99_ms, r->max_ms);
+        break;
+    case E2E_JSON:
+        printf("{\"endpoint\":\"%s\",\"transport\":\"%s\",\"scenario\":\"%s\",\"requests\":%d,\"errors\":%d,"
+               "\"attempts\":%.2f,\"rps\":%.1f,\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}\n",
+               endpoint, transport, scenario, r->requests, r->errors, r->attempts, r->rps,
+               r->mean_ms, r->p50_ms, r->p99_ms, r->max_ms);
+        break;
+    default:
+        printf("%-10s %-7s %-9s %6d %6d %8.2f %9.1f %9.3f %9.3f %9.3f\n", endpoint, transport, scenario,
+               r->requests, r->errors, r->attempts, r->rps, r->mean_ms, r->p50_ms, r->p99_ms);
+        break;
+    }
+    fflush(stdout);
+}
+
+/**
+ * @brief 等待模拟服务器开始监听（make bench-e2e 在后台启动它）
+ */
+static int e2e_wait_for(const char* addr_port) {
+    char addr[256];
+    snprintf(addr, sizeof(addr), "%s", addr_port);
+    char* colon = strrchr(addr, ':');
+    if (!colon) return -1;
+    *colon = '\0';
+    const char* port = colon + 1;
+    const char* host = addr;
+    if (addr[0] == '[' && colon > addr && colon[-1] == ']') {
+        colon[-1] = '\0';
+        host = addr + 1;
+    }
+
+    for (double waited = 0; waited < E2E_WAIT_MS; waited += 50) {
+        mbedtls_net_context fd;
+        mbedtls_net_init(&fd);
+        int ret = mbedtls_net_connect(&fd, host, port, MBEDTLS_NET_PROTO_TCP);
+        mbedtls_net_free(&fd);
+        if (ret == 0) return 0;
+        xlimit_sleep_ms(50);
+    }
+    return -1;
+}
+
+static void e2e_usage(const char* prog) {
+    printf("Usage: %s [OPTIONS]\n\n", prog);
+    printf("End-to-end benchmark against the mock server (bench/xmock.c).\n\n");
+    printf("Options:\n");
+    printf("  --requests N       requests per mode (default %d)\n", E2E_DEFAULT_REQUESTS);
+    printf("  --http ADDR:PORT   mock HTTP listener (default %s)\n", E2E_DEFAULT_HTTP);
+    printf("  --https ADDR:PORT  mock TLS listener (default %s)\n", E2E_DEFAULT_HTTPS);
+    printf("  --cacert FILE      CA written by the mock (default %s)\n", E2E_DEFAULT_CA);
+    printf("  --filter TEXT      run only modes whose \"endpoint/transport/scenario\" contains TEXT\n");
+    printf("  --csv | --json     machine-readable output\n");
+}
+
+int main(int argc, char* argv[]) {
+    int requests = E2E_DEFAULT_REQUESTS;
+    const char* http = E2E_DEFAULT_HTTP;
+    const char* https = E2E_DEFAULT_HTTPS;
+    const char* cacert = E2E_DEFAULT_CA;
+    const char* filter = NULL;
+    e2e_format_t format = E2E_TABLE;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "--csv") == 0) format = E2E_CSV;
+        else if (strcmp(a, "--json") == 0) format = E2E_JSON;
+        else if (strcmp(a, "--requests") == 0 && i + 1 < argc) requests = atoi(argv[++i]);
+        else if (strcmp(a, "--http") == 0 && i + 1 < argc) http = argv[++i];
+        else if (strcmp(a, "--https") == 0 && i + 1 < argc) https = argv[++i];
+        else if (strcmp(a, "--cacert") == 0 && i + 1 < argc) cacert = argv[++i];
+        else if (strcmp(a, "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else {
+            e2e_usage(argv[0]);
+            return strcmp(a, "--help") == 0 || strcmp(a, "-h") == 0 ? 0 : 1;
+        }
+    }
+    if (requests < 1) requests = 1;
+
+    if (e2e_wait_for(http) != 0 || e2e_wait_for(https) != 0) {
+        fprintf(stderr, "xbench_e2e: mock server not reachable at %s / %s\n", http, https);
+        return 1;
+    }
+
+    char spec[600];
+    snprintf(spec, sizeof(spec), ":80:%s,:443:%s", http, https);
+    if (httpc_set_connect_to(spec) != 0) return 1;
+    httpc_set_default_ca(cacert);
+
+    // 限流器不参与测量：节流场景只体现重试本身的代价，不体现按主机的退避暂停
+    xlimit_cfg_t unlimited = { 1e9, 1e9, 0, 0 };
+    xlimit_set(NULL, &unlimited);
+
+    if (format == E2E_CSV) {
+        printf("endpoint,transport,scenario,requests,errors,attempts,rps,mean_ms,p50_ms,p99_ms,max_ms\n");
+    } else if (format == E2E_TABLE) {
+        printf("%-10s %-7s %-9s %6s %6s %8s %9s %9s %9s %9s\n",
+               "endpoint", "trans", "scenario", "reqs", "errors", "attempts", "req/s", "mean ms", "p50 ms", "p99 ms");
+    }
+
+    for (size_t e = 0; e < E2E_ENDPOINT_COUNT; e++) {
+        const e2e_endpoint_t* ep = &e2e_endpoints[e];
+        for (int tls = 0; tls <= 1; tls++) {
+            for (size_t s = 0; s < E2E_SCENARIO_COUNT; s++) {
+                char mode[128];
+                snprintf(mode, sizeof(mode), "%s/%s/%s", ep->name, tls ? "https" : "http", e2e_scenarios[s].name);
+                if (filter && !strstr(mode, filter)) continue;
+
+                e2e_result_t r;
+                e2e_run(ep, tls, e2e_scenarios[s].mock, requests, &r);
+                e2e_print(format, ep->name, tls ? "https" : "http", e2e_scenarios[s].name, &r);
+            }
+        }
+
+        // 完整适配器（引擎自身决定传输方式：Google HTTPS，Bing 页面 + POST 走 HTTP）
+        if (strcmp(ep->name, "google") == 0 || strcmp(ep->name, "bing") == 0) {
+            char mode[128];
+            snprintf(mode, sizeof(mode), "%s/engine/adapter", ep->name);
+            if (filter && !strstr(mode, filter)) continue;
+
+            e2e_result_t r;
+            e2e_run(ep, -1, NULL, requests, &r);
+            e2e_print(format, ep->name, "engine", "adapter", &r);
+        }
+    }
+
+    httpc_pool_clear();
+    return 0;
+}
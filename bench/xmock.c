@@ -0,0 +1,872 @@
+/**
+ * @file xmock.c
+ * @brief 离线模拟翻译服务器（端到端基准/测试用）
+ * @note 按请求路径模拟各引擎接口：
+ *         Google    GET  /translate_a/single?...&q=TEXT
+ *         Bing      GET  /translator（含 IG / IID / params_AbusePreventionHelper 标记的页面）
+ *                   POST /ttranslatev3（表单 text=...）
+ *                   GET  /dict/search?q=TEXT（meta description）
+ *         MyMemory  GET  /get?q=TEXT&langpair=...
+ *       译文为 "[mock] " + 原文。同时监听 HTTP 和 HTTPS 端口；HTTPS 证书在启动时由自签 CA 现场签发
+ *       （SAN 覆盖各引擎主机名），CA 证书写到 --ca-out 指定的文件供客户端校验。
+ *       客户端用 httpc_set_connect_to / xtrans --connect-to 把引擎主机指向这里：
+ *         xtrans --connect-to ":80:127.0.0.1:18080,:443:127.0.0.1:18443" --cacert xmock_ca.pem ...
+ *
+ *       响应行为（延迟、chunked、重定向、节流、失败、断连）由命令行设置默认值，
+ *       单个请求可用 "X-Mock: key=value,..." 头覆盖，键名与命令行选项相同（见 xmock_usage）
+ */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/oid.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ecp.h"
+
+#include "xlimit.h"
+
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION xmock_mutex_t;
+#define xmock_mutex_init(m)   InitializeCriticalSection(m)
+#define xmock_mutex_lock(m)   EnterCriticalSection(m)
+#define xmock_mutex_unlock(m) LeaveCriticalSection(m)
+#else
+#include <pthread.h>
+#include <signal.h>
+typedef pthread_mutex_t xmock_mutex_t;
+#define xmock_mutex_init(m)   pthread_mutex_init(m, NULL)
+#define xmock_mutex_lock(m)   pthread_mutex_lock(m)
+#define xmock_mutex_unlock(m) pthread_mutex_unlock(m)
+#endif
+
+#define XMOCK_HTTP_PORT     "18080"
+#define XMOCK_HTTPS_PORT    "18443"
+#define XMOCK_CA_FILE       "xmock_ca.pem"
+#define XMOCK_BUF_SIZE      (256 * 1024)    // 请求头 + 请求体上限
+#define XMOCK_TEXT_MAX      (64 * 1024)     // 回显原文上限
+
+// 证书 SAN：被模拟的服务主机名
+static const char* const xmock_hosts[] = {
+    "translate.googleapis.com",
+    "www.bing.com",
+    "cn.bing.com",
+    "api.mymemory.translated.net",
+    "localhost",
+};
+#define XMOCK_HOST_COUNT (sizeof(xmock_hosts) / sizeof(xmock_hosts[0]))
+
+/**
+ * @brief 响应行为（命令行默认值，X-Mock 头逐请求覆盖）
+ */
+typedef struct {
+    double latency_ms;      // 响应前延迟
+    double jitter_ms;       // 额外均匀随机延迟 [0, jitter)
+    size_t chunk;           // >0：chunked 编码，每块字节数；0：Content-Length
+    double trickle_ms;      // chunked 时块之间的延迟
+    int redirect;           // 1：先返回一次重定向（GET 302，其他 307），跳转后的请求正常应答
+    double throttle;        // 节流概率：ttranslatev3 返回 {"statusCode":205}，其他返回 429
+    double fail;            // 失败概率：返回 503
+    double drop;            // 断连概率：读完请求后不应答直接关闭连接
+    int retry_after;        // 429/503 带 Retry-After（秒），0 不带
+    int close;              // 每个响应后关闭连接（Connection: close）
+    int status;             // 强制状态码（空 JSON 响应体），0 = 正常
+    size_t page;            // /translator 页面在标记之前的填充字节数（真实页面约数百 KB）
+} xmock_opts_t;
+
+static xmock_opts_t xmock_defaults = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 32 * 1024 };
+static int xmock_verbose = 0;
+
+// TLS：配置和证书在线程间只读共享；随机数生成器加锁
+static mbedtls_ctr_drbg_context xmock_drbg;
+static mbedtls_entropy_context xmock_entropy;
+static xmock_mutex_t xmock_rng_lock;
+static mbedtls_ssl_config xmock_ssl_conf;
+static mbedtls_x509_crt xmock_chain;
+static mbedtls_pk_context xmock_ca_key;
+static mbedtls_pk_context xmock_srv_key;
+
+static int xmock_rng(void* ctx, unsigned char* out, size_t len) {
+    (void)ctx;
+    xmock_mutex_lock(&xmock_rng_lock);
+    int ret = mbedtls_ctr_drbg_random(&xmock_drbg, out, len);
+    xmock_mutex_unlock(&xmock_rng_lock);
+    return ret;
+}
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+// 会话票据：客户端重连时走简短握手，"close" 场景测得的是会话恢复的开销。
+// 未启用 MBEDTLS_THREADING_C 时票据上下文不是线程安全的，这里加锁
+static mbedtls_ssl_ticket_context xmock_ticket;
+static xmock_mutex_t xmock_ticket_lock;
+
+static int xmock_ticket_write(void* p_ticket, const mbedtls_ssl_session* session, unsigned char* start,
+                              const unsigned char* end, size_t* tlen, uint32_t* lifetime) {
+    xmock_mutex_lock(&xmock_ticket_lock);
+    int ret = mbedtls_ssl_ticket_write(p_ticket, session, start, end, tlen, lifetime);
+    xmock_mutex_unlock(&xmock_ticket_lock);
+    return ret;
+}
+
+static int xmock_ticket_parse(void* p_ticket, mbedtls_ssl_session* session, unsigned char* buf, size_t len) {
+    xmock_mutex_lock(&xmock_ticket_lock);
+    int ret = mbedtls_ssl_ticket_parse(p_ticket, session, buf, len);
+    xmock_mutex_unlock(&xmock_ticket_lock);
+    return ret;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 证书
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 生成 P-256 密钥
+ */
+static int xmock_gen_key(mbedtls_pk_context* key) {
+    mbedtls_pk_init(key);
+    int ret = mbedtls_pk_setup(key, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+    if (ret == 0) ret = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, mbedtls_pk_ec(*key), xmock_rng, NULL);
+    return ret;
+}
+
+/**
+ * @brief subjectAltName 扩展值（DER）：SEQUENCE OF dNSName
+ */
+static size_t xmock_san_der(unsigned char* out, size_t size) {
+    size_t body = 0;
+    for (size_t i = 0; i < XMOCK_HOST_COUNT; i++) body += 2 + strlen(xmock_hosts[i]);
+    if (body > 255 || body + 3 > size) return 0;
+
+    size_t n = 0;
+    out[n++] = 0x30;                            // SEQUENCE
+    if (body >= 0x80) out[n++] = 0x81;          // 长格式长度（1 字节）
+    out[n++] = (unsigned char)body;
+    for (size_t i = 0; i < XMOCK_HOST_COUNT; i++) {
+        size_t len = strlen(xmock_hosts[i]);
+        out[n++] = 0x82;                        // [2] dNSName
+        out[n++] = (unsigned char)len;
+        memcpy(out + n, xmock_hosts[i], len);
+        n += len;
+    }
+    return n;
+}
+
+/**
+ * @brief 签发证书（PEM）：is_ca 时为自签 CA，否则为 CA 签发的服务器证书
+ */
+static int xmock_issue(mbedtls_pk_context* subject_key, const char* subject, int is_ca, int serial_no,
+                       unsigned char* pem, size_t pem_size) {
+    mbedtls_x509write_cert crt;
+    mbedtls_mpi serial;
+    mbedtls_x509write_crt_init(&crt);
+    mbedtls_mpi_init(&serial);
+
+    mbedtls_x509write_crt_set_version(&crt, MBEDTLS_X509_CRT_VERSION_3);
+    mbedtls_x509write_crt_set_md_alg(&crt, MBEDTLS_MD_SHA256);
+    mbedtls_x509write_crt_set_subject_key(&crt, subject_key);
+    mbedtls_x509write_crt_set_issuer_key(&crt, &xmock_ca_key);
+
+    int ret = mbedtls_mpi_lset(&serial, serial_no);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_serial(&crt, &serial);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_subject_name(&crt, subject);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_issuer_name(&crt, "CN=xtrans mock CA,O=xtrans");
+    if (ret == 0) ret = mbedtls_x509write_crt_set_validity(&crt, "20240101000000", "20491231235959");
+    if (ret == 0) ret = mbedtls_x509write_crt_set_basic_constraints(&crt, is_ca, is_ca ? 0 : -1);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_key_usage(&crt, is_ca
+                        ? MBEDTLS_X509_KU_KEY_CERT_SIGN | MBEDTLS_X509_KU_CRL_SIGN
+                        : MBEDTLS_X509_KU_DIGITAL_SIGNATURE | MBEDTLS_X509_KU_KEY_AGREEMENT);
+    if (ret == 0 && !is_ca) {
+        unsigned char san[512];
+        size_t san_len = xmock_san_der(san, sizeof(san));
+        ret = san_len ? mbedtls_x509write_crt_set_extension(&crt, MBEDTLS_OID_SUBJECT_ALT_NAME,
+                            MBEDTLS_OID_SIZE(MBEDTLS_OID_SUBJECT_ALT_NAME), 0, san, san_len) : -1;
+    }
+    if (ret == 0) ret = mbedtls_x509write_crt_pem(&crt, pem, pem_size, xmock_rng, NULL);
+
+    mbedtls_mpi_free(&serial);
+    mbedtls_x509write_crt_free(&crt);
+    return ret;
+}
+
+/**
+ * @brief 生成 CA 和服务器证书，CA 写到 ca_out，初始化服务端 TLS 配置
+ */
+static int xmock_tls_init(const char* ca_out) {
+    const char* pers = "xmock";
+    static unsigned char ca_pem[4096], srv_pem[4096];
+    int ret;
+
+    mbedtls_ctr_drbg_init(&xmock_drbg);
+    mbedtls_entropy_init(&xmock_entropy);
+    mbedtls_x509_crt_init(&xmock_chain);
+    mbedtls_ssl_config_init(&xmock_ssl_conf);
+    xmock_mutex_init(&xmock_rng_lock);
+
+    ret = mbedtls_ctr_drbg_seed(&xmock_drbg, mbedtls_entropy_func, &xmock_entropy,
+                                (const unsigned char*)pers, strlen(pers));
+    if (ret != 0) {
+        fprintf(stderr, "xmock: random generator init failed: -0x%04x\n", (unsigned int)-ret);
+        return -1;
+    }
+
+    if ((ret = xmock_gen_key(&xmock_ca_key)) != 0 ||
+        (ret = xmock_gen_key(&xmock_srv_key)) != 0 ||
+        (ret = xmock_issue(&xmock_ca_key, "CN=xtrans mock CA,O=xtrans", 1, 1, ca_pem, sizeof(ca_pem))) != 0 ||
+        (ret = xmock_issue(&xmock_srv_key, "CN=xtrans mock server,O=xtrans", 0, 2, srv_pem, sizeof(srv_pem))) != 0) {
+        fprintf(stderr, "xmock: certificate generation failed: -0x%04x\n", (unsigned int)-ret);
+        return -1;
+    }
+
+    // 证书链：服务器证书在前，CA 在后
+    if ((ret = mbedtls_x509_crt_parse(&xmock_chain, srv_pem, strlen((char*)srv_pem) + 1)) != 0 ||
+        (ret = mbedtls_x509_crt_parse(&xmock_chain, ca_pem, strlen((char*)ca_pem) + 1)) != 0) {
+        fprintf(stderr, "xmock: certificate parse failed: -0x%04x\n", (unsigned int)-ret);
+        return -1;
+    }
+
+    FILE* f = fopen(ca_out, "w");
+    if (!f || fputs((char*)ca_pem, f) < 0 || fclose(f) != 0) {
+        fprintf(stderr, "xmock: cannot write CA certificate to %s\n", ca_out);
+        return -1;
+    }
+
+    ret = mbedtls_ssl_config_defaults(&xmock_ssl_conf, MBEDTLS_SSL_IS_SERVER,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret == 0) ret = mbedtls_ssl_conf_own_cert(&xmock_ssl_conf, &xmock_chain, &xmock_srv_key);
+    if (ret != 0) {
+        fprintf(stderr, "xmock: SSL config failed: -0x%04x\n", (unsigned int)-ret);
+        return -1;
+    }
+    mbedtls_ssl_conf_rng(&xmock_ssl_conf, xmock_rng, NULL);
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_init(&xmock_ticket);
+    xmock_mutex_init(&xmock_ticket_lock);
+    ret = mbedtls_ssl_ticket_setup(&xmock_ticket, xmock_rng, NULL, MBEDTLS_CIPHER_AES_256_GCM, 86400);
+    if (ret != 0) {
+        fprintf(stderr, "xmock: session ticket setup failed: -0x%04x\n", (unsigned int)-ret);
+        return -1;
+    }
+    mbedtls_ssl_conf_session_tickets_cb(&xmock_ssl_conf, xmock_ticket_write, xmock_ticket_parse, &xmock_ticket);
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 连接 I/O
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    mbedtls_net_context fd;
+    mbedtls_ssl_context ssl;
+    int tls;
+    unsigned long long rng;     // 行为概率用的 xorshift 状态
+    char* buf;                  // 已收到未处理的数据
+    size_t len;
+} xmock_conn_t;
+
+static int xmock_send(xmock_conn_t* c, const char* data, size_t len) {
+    while (len > 0) {
+        int n = c->tls ? mbedtls_ssl_write(&c->ssl, (const unsigned char*)data, len)
+                       : mbedtls_net_send(&c->fd, (const unsigned char*)data, len);
+        if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int xmock_recv(xmock_conn_t* c) {
+    if (c->len >= XMOCK_BUF_SIZE - 1) return -1;
+    for (;;) {
+        int n = c->tls ? mbedtls_ssl_read(&c->ssl, (unsigned char*)c->buf + c->len, XMOCK_BUF_SIZE - 1 - c->len)
+                       : mbedtls_net_recv(&c->fd, (unsigned char*)c->buf + c->len, XMOCK_BUF_SIZE - 1 - c->len);
+        if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+        if (n <= 0) return -1;
+        c->len += (size_t)n;
+        c->buf[c->len] = '\0';
+        return n;
+    }
+}
+
+static double xmock_random(xmock_conn_t* c) {
+    c->rng ^= c->rng >> 12;
+    c->rng ^= c->rng << 25;
+    c->rng ^= c->rng >> 27;
+    return (double)((c->rng * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+}
+
+// ---------------------------------------------------------------------------
+// 响应体
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} xmock_buf_t;
+
+static void xmock_append(xmock_buf_t* b, const char* s, size_t len) {
+    if (b->len + len + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 4096;
+        while (cap < b->len + len + 1) cap *= 2;
+        char* p = realloc(b->data, cap);
+        if (!p) return;
+        b->data = p;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, len);
+    b->len += len;
+    b->data[b->len] = '\0';
+}
+
+static void xmock_puts(xmock_buf_t* b, const char* s) {
+    xmock_append(b, s, strlen(s));
+}
+
+/**
+ * @brief JSON 字符串转义（非 ASCII 原样输出 UTF-8）
+ */
+static void xmock_json(xmock_buf_t* b, const char* s) {
+    for (; *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        char esc[8];
+        if (ch == '"' || ch == '\\') {
+            esc[0] = '\\';
+            esc[1] = (char)ch;
+            xmock_append(b, esc, 2);
+        } else if (ch < 0x20) {
+            snprintf(esc, sizeof(esc), "\\u%04x", ch);
+            xmock_append(b, esc, 6);
+        } else {
+            xmock_append(b, s, 1);
+        }
+    }
+}
+
+/**
+ * @brief HTML 属性值转义
+ */
+static void xmock_html(xmock_buf_t* b, const char* s) {
+    for (; *s; s++) {
+        if (*s == '"') xmock_puts(b, "&quot;");
+        else if (*s == '<') xmock_puts(b, "&lt;");
+        else if (*s == '&') xmock_puts(b, "&amp;");
+        else xmock_append(b, s, 1);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 请求
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    char method[16];
+    char path[8192];
+    char host[256];
+    const char* body;
+    size_t body_len;
+    int close;                  // 客户端要求 Connection: close 或 HTTP/1.0
+    xmock_opts_t opts;
+} xmock_req_t;
+
+/**
+ * @brief 设置一项行为参数（命令行和 X-Mock 头共用）
+ * @return 0 成功，-1 未知键
+ */
+static int xmock_set(xmock_opts_t* o, const char* key, size_t key_len, const char* value) {
+#define XMOCK_KEY(name) (key_len == strlen(name) && strncmp(key, name, key_len) == 0)
+    if (XMOCK_KEY("latency")) o->latency_ms = atof(value);
+    else if (XMOCK_KEY("jitter")) o->jitter_ms = atof(value);
+    else if (XMOCK_KEY("chunk")) o->chunk = (size_t)atol(value);
+    else if (XMOCK_KEY("trickle")) o->trickle_ms = atof(value);
+    else if (XMOCK_KEY("redirect")) o->redirect = atoi(value);
+    else if (XMOCK_KEY("throttle")) o->throttle = atof(value);
+    else if (XMOCK_KEY("fail")) o->fail = atof(value);
+    else if (XMOCK_KEY("drop")) o->drop = atof(value);
+    else if (XMOCK_KEY("retry-after")) o->retry_after = atoi(value);
+    else if (XMOCK_KEY("close")) o->close = atoi(value);
+    else if (XMOCK_KEY("status")) o->status = atoi(value);
+    else if (XMOCK_KEY("page")) o->page = (size_t)atol(value);
+    else return -1;
+    return 0;
+#undef XMOCK_KEY
+}
+
+/**
+ * @brief 解析 X-Mock 头的值："key=value,key=value"
+ */
+static void xmock_set_header(xmock_opts_t* o, const char* value, size_t len) {
+    char spec[512];
+    if (len >= sizeof(spec)) len = sizeof(spec) - 1;
+    memcpy(spec, value, len);
+    spec[len] = '\0';
+
+    for (char* item = strtok(spec, ","); item; item = strtok(NULL, ",")) {
+        while (*item == ' ') item++;
+        char* eq = strchr(item, '=');
+        if (!eq || xmock_set(o, item, (size_t)(eq - item), eq + 1) != 0) {
+            if (xmock_verbose) fprintf(stderr, "xmock: ignoring X-Mock item '%s'\n", item);
+        }
+    }
+}
+
+/**
+ * @brief 解析请求头；请求不完整返回 0，格式错误返回 -1，完整返回请求总长度
+ */
+static long xmock_parse(xmock_conn_t* c, xmock_req_t* r) {
+    const char* end = strstr(c->buf, "\r\n\r\n");
+    if (!end) return c->len >= XMOCK_BUF_SIZE - 1 ? -1 : 0;
+    size_t head_len = (size_t)(end - c->buf) + 4;
+
+    char version[16] = "";
+    if (sscanf(c->buf, "%15s %8191s %15s", r->method, r->path, version) != 3) return -1;
+    r->close = strcmp(version, "HTTP/1.0") == 0;
+    r->host[0] = '\0';
+    r->opts = xmock_defaults;
+
+    size_t content_length = 0;
+    for (const char* line = strstr(c->buf, "\r\n") + 2; line < end; ) {
+        const char* eol = strstr(line, "\r\n");
+        const char* colon = memchr(line, ':', (size_t)(eol - line));
+        if (colon) {
+            size_t name_len = (size_t)(colon - line);
+            const char* value = colon + 1;
+            while (*value == ' ') value++;
+            size_t value_len = (size_t)(eol - value);
+
+            if (name_len == 4 && strncmp(line, "Host", 4) == 0 && value_len < sizeof(r->host)) {
+                memcpy(r->host, value, value_len);
+                r->host[value_len] = '\0';
+            } else if (name_len == 14 && strncmp(line, "Content-Length", 14) == 0) {
+                content_length = (size_t)atol(value);
+            } else if (name_len == 10 && strncmp(line, "Connection", 10) == 0) {
+                r->close = value_len >= 5 && strncmp(value, "close", 5) == 0;
+            } else if (name_len == 6 && strncmp(line, "X-Mock", 6) == 0) {
+                xmock_set_header(&r->opts, value, value_len);
+            }
+        }
+        line = eol + 2;
+    }
+
+    if (head_len + content_length >= XMOCK_BUF_SIZE) return -1;
+    if (c->len < head_len + content_length) return 0;
+    r->body = c->buf + head_len;
+    r->body_len = content_length;
+    return (long)(head_len + content_length);
+}
+
+/**
+ * @brief 取出查询串/表单中的参数并 URL 解码
+ */
+static int xmock_param(const char* s, size_t len, const char* name, char* out, size_t out_size) {
+    size_t name_len = strlen(name);
+    const char* end = s + len;
+
+    for (const char* p = s; p < end; ) {
+        const char* amp = memchr(p, '&', (size_t)(end - p));
+        if (!amp) amp = end;
+        if ((size_t)(amp - p) > name_len && strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            size_t n = 0;
+            for (const char* q = p + name_len + 1; q < amp && n + 1 < out_size; q++) {
+                if (*q == '+') {
+                    out[n++] = ' ';
+                } else if (*q == '%' && q + 2 < amp && isxdigit((unsigned char)q[1]) && isxdigit((unsigned char)q[2])) {
+                    char hex[3] = { q[1], q[2], '\0' };
+                    out[n++] = (char)strtol(hex, NULL, 16);
+                    q += 2;
+                } else {
+                    out[n++] = *q;
+                }
+            }
+            out[n] = '\0';
+            return 1;
+        }
+        p = amp + 1;
+    }
+    out[0] = '\0';
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 应答
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 发送响应（Content-Length 或按 opts.chunk 分块）
+ * @note 不逐块 trickle 时整个响应拼好后一次写出：头和体分两次小写会触发 Nagle + 延迟 ACK，
+ *       每个 keep-alive 响应凭空多出约 40ms
+ */
+static int xmock_respond(xmock_conn_t* c, const xmock_req_t* r, int status, const char* reason,
+                         const char* content_type, const char* extra, const xmock_buf_t* body, int close) {
+    char line[1024];
+    xmock_buf_t out = { NULL, 0, 0 };
+    size_t chunk = r->opts.chunk;
+    int trickle = chunk > 0 && r->opts.trickle_ms > 0;
+    int ret = 0;
+
+    snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\nServer: xmock\r\nContent-Type: %s\r\n%s%s",
+             status, reason, content_type, extra ? extra : "", close ? "Connection: close\r\n" : "");
+    xmock_puts(&out, line);
+
+    if (chunk == 0) {
+        snprintf(line, sizeof(line), "Content-Length: %zu\r\n\r\n", body->len);
+        xmock_puts(&out, line);
+        xmock_append(&out, body->data ? body->data : "", body->len);
+    } else {
+        xmock_puts(&out, "Transfer-Encoding: chunked\r\n\r\n");
+        for (size_t off = 0; off < body->len && ret == 0; off += chunk) {
+            size_t len = body->len - off < chunk ? body->len - off : chunk;
+            snprintf(line, sizeof(line), "%zx\r\n", len);
+            xmock_puts(&out, line);
+            xmock_append(&out, body->data + off, len);
+            xmock_puts(&out, "\r\n");
+            if (trickle && off + len < body->len) {
+                ret = xmock_send(c, out.data, out.len);
+                out.len = 0;
+                xlimit_sleep_ms(r->opts.trickle_ms);
+            }
+        }
+        xmock_puts(&out, "0\r\n\r\n");
+    }
+
+    if (ret == 0) ret = out.data ? xmock_send(c, out.data, out.len) : -1;
+    free(out.data);
+    return ret;
+}
+
+/**
+ * @brief 处理一个请求
+ * @return 0 保持连接，-1 关闭连接
+ */
+static int xmock_handle(xmock_conn_t* c, const xmock_req_t* r) {
+    const xmock_opts_t* o = &r->opts;
+    const char* query = strchr(r->path, '?');
+    size_t path_len = query ? (size_t)(query - r->path) : strlen(r->path);
+    size_t query_len = query ? strlen(query + 1) : 0;
+    if (query) query++;
+    int is_get = strcmp(r->method, "GET") == 0;
+    int close = r->close || o->close;
+
+    double delay = o->latency_ms + (o->jitter_ms > 0 ? xmock_random(c) * o->jitter_ms : 0.0);
+    if (delay > 0) xlimit_sleep_ms(delay);
+
+    if (o->drop > 0 && xmock_random(c) < o->drop) {
+        if (xmock_verbose) printf("[MOCK] %s %s%s -> dropped\n", r->method, r->host, r->path);
+        return -1;
+    }
+
+    xmock_buf_t body = { NULL, 0, 0 };
+    char extra[1200] = "";
+    int status = 200;
+    const char* reason = "OK";
+    const char* type = "application/json; charset=utf-8";
+
+#define XMOCK_PATH(p) (path_len == strlen(p) && strncmp(r->path, p, path_len) == 0)
+    int is_ttranslate = XMOCK_PATH("/ttranslatev3");
+
+    if (o->redirect && !(query && strstr(query, "xmock_hop=1"))) {
+        // 重定向到同一路径（加上标记避免循环）；POST 用 307 保留方法和请求体
+        status = is_get ? 302 : 307;
+        reason = is_get ? "Found" : "Temporary Redirect";
+        snprintf(extra, sizeof(extra), "Location: %s%cxmock_hop=1\r\n", r->path, query ? '&' : '?');
+    } else if (o->status) {
+        status = o->status;
+        reason = "Mock";
+        xmock_puts(&body, "{}");
+    } else if (o->fail > 0 && xmock_random(c) < o->fail) {
+        status = 503;
+        reason = "Service Unavailable";
+        xmock_puts(&body, "{\"error\":\"mock failure\"}");
+    } else if (o->throttle > 0 && xmock_random(c) < o->throttle) {
+        if (is_ttranslate) {
+            xmock_puts(&body, "{\"statusCode\":205}");          // Bing：HTTP 200 + 205 状态
+        } else {
+            status = 429;
+            reason = "Too Many Requests";
+            xmock_puts(&body, "{\"error\":\"mock throttle\"}");
+        }
+    }
+    if (status == 429 || status == 503) {
+        if (o->retry_after > 0) snprintf(extra, sizeof(extra), "Retry-After: %d\r\n", o->retry_after);
+    }
+
+    if (status == 200 && body.len == 0) {
+        char* text = malloc(XMOCK_TEXT_MAX);
+        if (!text) return -1;
+        const char* params = is_get ? query : r->body;
+        size_t params_len = is_get ? query_len : r->body_len;
+        if (!params) params = "";
+
+        if (XMOCK_PATH("/translate_a/single")) {
+            char sl[16];
+            xmock_param(params, params_len, "q", text, XMOCK_TEXT_MAX);
+            xmock_param(params, params_len, "sl", sl, sizeof(sl));
+            if (!sl[0] || strcmp(sl, "auto") == 0) strcpy(sl, "en");
+            xmock_puts(&body, "[[[\"[mock] ");
+            xmock_json(&body, text);
+            xmock_puts(&body, "\",\"");
+            xmock_json(&body, text);
+            xmock_puts(&body, "\",null,null,10]],null,\"");
+            xmock_json(&body, sl);
+            xmock_puts(&body, "\",null,null,null,1,[],[[\"");
+            xmock_json(&body, sl);
+            xmock_puts(&body, "\"],null,[1],[\"");
+            xmock_json(&body, sl);
+            xmock_puts(&body, "\"]]]");
+        } else if (XMOCK_PATH("/translator")) {
+            // 标记之前的填充模拟真实页面体积（客户端边收边扫描，找到标记即停止接收）
+            type = "text/html; charset=utf-8";
+            xmock_puts(&body, "<!DOCTYPE html><html><head><title>Translator</title>");
+            while (body.len < o->page) xmock_puts(&body, "<script>/* xtrans mock page padding */</script>\n");
+            xmock_puts(&body, "<script>_G={IG:\"0123456789ABCDEF0123456789ABCDEF\"};"
+                              "var params_AbusePreventionHelper = [1700000000000,\"xmock-token\",3600000];"
+                              "</script></head><body><div id=\"rich_tta\" data-iid=\"translator.5023\"></div>"
+                              "</body></html>");
+        } else if (is_ttranslate) {
+            xmock_param(params, params_len, "text", text, XMOCK_TEXT_MAX);
+            char to[16];
+            xmock_param(params, params_len, "to", to, sizeof(to));
+            xmock_puts(&body, "[{\"detectedLanguage\":{\"language\":\"en\",\"score\":1.0},"
+                              "\"translations\":[{\"text\":\"[mock] ");
+            xmock_json(&body, text);
+            xmock_puts(&body, "\",\"to\":\"");
+            xmock_json(&body, to);
+            xmock_puts(&body, "\",\"sentLen\":{\"srcSentLen\":[1],\"transSentLen\":[1]}}]}]");
+        } else if (XMOCK_PATH("/dict/search")) {
+            type = "text/html; charset=utf-8";
+            xmock_param(params, params_len, "q", text, XMOCK_TEXT_MAX);
+            xmock_puts(&body, "<!DOCTYPE html><html><head><meta name=\"description\" content=\"[mock] ");
+            xmock_html(&body, text);
+            xmock_puts(&body, "\" /></head><body></body></html>");
+        } else if (XMOCK_PATH("/get")) {
+            xmock_param(params, params_len, "q", text, XMOCK_TEXT_MAX);
+            xmock_puts(&body, "{\"responseData\":{\"translatedText\":\"[mock] ");
+            xmock_json(&body, text);
+            xmock_puts(&body, "\",\"match\":1},\"quotaFinished\":false,\"responseStatus\":200,\"matches\":[]}");
+        } else {
+            status = 404;
+            reason = "Not Found";
+            xmock_puts(&body, "{\"error\":\"unknown path\"}");
+        }
+        free(text);
+    }
+#undef XMOCK_PATH
+
+    if (xmock_verbose) {
+        printf("[MOCK] %s %s %s%s -> %d (%zu bytes)\n", c->tls ? "https" : "http", r->method, r->host, r->path,
+               status, body.len);
+        fflush(stdout);
+    }
+
+    int ret = xmock_respond(c, r, status, reason, type, extra, &body, close);
+    free(body.data);
+    return ret != 0 || close ? -1 : 0;
+}
+
+/**
+ * @brief 连接线程：TLS 握手后按顺序处理请求（支持 keep-alive 和流水线）
+ */
+static void xmock_serve(xmock_conn_t* c) {
+    c->buf = malloc(XMOCK_BUF_SIZE);
+    if (!c->buf) return;
+
+    if (c->tls) {
+        mbedtls_ssl_init(&c->ssl);
+        int ret = mbedtls_ssl_setup(&c->ssl, &xmock_ssl_conf);
+        if (ret == 0) {
+            mbedtls_ssl_set_bio(&c->ssl, &c->fd, mbedtls_net_send, mbedtls_net_recv, NULL);
+            while ((ret = mbedtls_ssl_handshake(&c->ssl)) == MBEDTLS_ERR_SSL_WANT_READ ||
+                   ret == MBEDTLS_ERR_SSL_WANT_WRITE) {}
+        }
+        if (ret != 0) {
+            if (xmock_verbose) fprintf(stderr, "xmock: TLS handshake failed: -0x%04x\n", (unsigned int)-ret);
+            goto done;
+        }
+    }
+
+    for (;;) {
+        xmock_req_t* r = malloc(sizeof(xmock_req_t));
+        if (!r) break;
+        long used;
+        while ((used = xmock_parse(c, r)) == 0) {
+            if (xmock_recv(c) < 0) break;
+        }
+        int keep = used > 0 && xmock_handle(c, r) == 0;
+        free(r);
+        if (!keep) break;
+
+        // 流水线：保留已收到的后续请求
+        memmove(c->buf, c->buf + used, c->len - (size_t)used);
+        c->len -= (size_t)used;
+        c->buf[c->len] = '\0';
+    }
+
+    if (c->tls) mbedtls_ssl_close_notify(&c->ssl);
+done:
+    if (c->tls) mbedtls_ssl_free(&c->ssl);
+    free(c->buf);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI xmock_thread(LPVOID arg) {
+#else
+static void* xmock_thread(void* arg) {
+#endif
+    xmock_conn_t* c = arg;
+    xmock_serve(c);
+    mbedtls_net_free(&c->fd);
+    free(c);
+    return 0;
+}
+
+typedef struct {
+    mbedtls_net_context listen;
+    int tls;
+} xmock_listener_t;
+
+/**
+ * @brief 接受连接，每个连接一个线程
+ */
+#ifdef _WIN32
+static DWORD WINAPI xmock_accept_loop(LPVOID arg) {
+#else
+static void* xmock_accept_loop(void* arg) {
+#endif
+    xmock_listener_t* l = arg;
+    unsigned long long seq = 0;
+
+    for (;;) {
+        xmock_conn_t* c = calloc(1, sizeof(xmock_conn_t));
+        if (!c) break;
+        mbedtls_net_init(&c->fd);
+        if (mbedtls_net_accept(&l->listen, &c->fd, NULL, 0, NULL) != 0) {
+            free(c);
+            continue;
+        }
+        c->tls = l->tls;
+        c->rng = 0x9E3779B97F4A7C15ULL ^ (++seq * 0xBF58476D1CE4E5B9ULL) ^ (unsigned long long)xlimit_now_ms();
+
+#ifdef _WIN32
+        HANDLE h = CreateThread(NULL, 0, xmock_thread, c, 0, NULL);
+        if (h) {
+            CloseHandle(h);
+            continue;
+        }
+#else
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, xmock_thread, c) == 0) {
+            pthread_detach(tid);
+            continue;
+        }
+#endif
+        mbedtls_net_free(&c->fd);
+        free(c);
+    }
+    return 0;
+}
+
+static void xmock_usage(const char* prog) {
+    printf("Usage: %s [OPTIONS]\n\n", prog);
+    printf("Offline mock of the Google / Bing / MyMemory endpoints used by xtrans.\n\n");
+    printf("Options:\n");
+    printf("  --bind ADDR        listen address (default 127.0.0.1)\n");
+    printf("  --http PORT        plain HTTP port (default %s)\n", XMOCK_HTTP_PORT);
+    printf("  --https PORT       TLS port (default %s)\n", XMOCK_HTTPS_PORT);
+    printf("  --ca-out FILE      where to write the generated CA certificate (default %s)\n", XMOCK_CA_FILE);
+    printf("  -v, --verbose      log every request\n");
+    printf("\nResponse behaviour (defaults; a request may override with \"X-Mock: key=value,...\"):\n");
+    printf("  --latency MS       delay before every response\n");
+    printf("  --jitter MS        extra uniform random delay\n");
+    printf("  --chunk BYTES      chunked transfer encoding with this chunk size\n");
+    printf("  --trickle MS       delay between chunks\n");
+    printf("  --redirect 1       answer 302/307 once before the real response\n");
+    printf("  --throttle P       probability of throttling (Bing statusCode 205, others 429)\n");
+    printf("  --fail P           probability of 503\n");
+    printf("  --drop P           probability of closing the connection without a response\n");
+    printf("  --retry-after S    Retry-After seconds on 429/503\n");
+    printf("  --close 1          close the connection after every response\n");
+    printf("  --status CODE      answer every request with this status\n");
+    printf("  --page BYTES       padding before the markers of the Bing /translator page (default 32768)\n");
+    printf("\nClient side:\n");
+    printf("  xtrans --connect-to \":80:127.0.0.1:%s,:443:127.0.0.1:%s\" --cacert %s TEXT\n",
+           XMOCK_HTTP_PORT, XMOCK_HTTPS_PORT, XMOCK_CA_FILE);
+}
+
+int main(int argc, char* argv[]) {
+    const char* bind_addr = "127.0.0.1";
+    const char* http_port = XMOCK_HTTP_PORT;
+    const char* https_port = XMOCK_HTTPS_PORT;
+    const char* ca_out = XMOCK_CA_FILE;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "-v") == 0 || strcmp(a, "--verbose") == 0) {
+            xmock_verbose = 1;
+        } else if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            xmock_usage(argv[0]);
+            return 0;
+        } else if (strncmp(a, "--", 2) == 0 && i + 1 < argc) {
+            const char* v = argv[++i];
+            if (strcmp(a, "--bind") == 0) bind_addr = v;
+            else if (strcmp(a, "--http") == 0) http_port = v;
+            else if (strcmp(a, "--https") == 0) https_port = v;
+            else if (strcmp(a, "--ca-out") == 0) ca_out = v;
+            else if (xmock_set(&xmock_defaults, a + 2, strlen(a + 2), v) != 0) {
+                fprintf(stderr, "xmock: unknown option %s\n", a);
+                return 1;
+            }
+        } else {
+            xmock_usage(argv[0]);
+            return 1;
+        }
+    }
+
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);   // 客户端提前断开时 write 不应终止进程
+#endif
+
+    if (xmock_tls_init(ca_out) != 0) return 1;
+
+    static xmock_listener_t http, https;
+    mbedtls_net_init(&http.listen);
+    mbedtls_net_init(&https.listen);
+    https.tls = 1;
+
+    int ret = mbedtls_net_bind(&http.listen, bind_addr, http_port, MBEDTLS_NET_PROTO_TCP);
+    if (ret == 0) ret = mbedtls_net_bind(&https.listen, bind_addr, https_port, MBEDTLS_NET_PROTO_TCP);
+    if (ret != 0) {
+        fprintf(stderr, "xmock: cannot listen on %s:%s / %s:%s: -0x%04x\n",
+                bind_addr, http_port, bind_addr, https_port, (unsigned int)-ret);
+        return 1;
+    }
+
+    printf("xmock: http %s:%s, https %s:%s, CA %s\n", bind_addr, http_port, bind_addr, https_port, ca_out);
+    fflush(stdout);
+
+#ifdef _WIN32
+    HANDLE h = CreateThread(NULL, 0, xmock_accept_loop, &https, 0, NULL);
+    if (!h) {
+#else
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, xmock_accept_loop, &https) != 0) {
+#endif
+        fprintf(stderr, "xmock: cannot start the TLS listener\n");
+        return 1;
+    }
+    xmock_accept_loop(&http);
+    return 0;
+}
@@ -99,7 +99,7 @@ md .obj\mbedtls\library 2>nul
 
 REM ===== 批量编译主程序.c文件（当前目录下的xtrans.c、xhttpc.c，或直接*.c）=====
 echo %GREEN%[INFO]%RESET% Compiling main files...
-cl %CFLAGS% /Fo.obj\ xargs.c xtrans_google.c xtrans_bing.c xtrans.c xhttpc.c
+cl %CFLAGS% /Fo.obj\ xargs.c xtrans_google.c xtrans_bing.c xtrans_engine.c xtrans.c xhttpc.c xhttpc_h2.c xarena.c xutf8.c xgbk.c xjson.c xlang.c xlimit.c xmetrics.c xtrace.c
 REM 如果要批量匹配当前目录所有.c，替换为：
 REM cl %CFLAGS% /Fo.obj\ *.c
 if %ERRORLEVEL% neq 0 (
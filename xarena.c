@@ -0,0 +1,160 @@
+#include "xarena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define XARENA_DEFAULT_BLOCK (64 * 1024)
+#define XARENA_ALIGN 16
+
+#if defined(_MSC_VER)
+#define XARENA_TLS __declspec(thread)
+#else
+#define XARENA_TLS _Thread_local
+#endif
+
+struct xarena_block_s {
+    xarena_block_t* next;
+    size_t size;              // 可用字节数（不含块头）
+    size_t used;              // 已切分字节数
+    // 数据紧随其后（块头按 XARENA_ALIGN 对齐）
+};
+
+#define XARENA_HEADER_SIZE ((sizeof(xarena_block_t) + XARENA_ALIGN - 1) & ~(size_t)(XARENA_ALIGN - 1))
+
+static unsigned char* xarena_block_data(xarena_block_t* block) {
+    return (unsigned char*)block + XARENA_HEADER_SIZE;
+}
+
+void xarena_init(xarena_t* arena, size_t block_size) {
+    memset(arena, 0, sizeof(*arena));
+    arena->block_size = block_size ? block_size : XARENA_DEFAULT_BLOCK;
+}
+
+/**
+ * @brief 当前块放不下时，找一个后续空闲块或申请新块（大请求单独成块）
+ */
+static xarena_block_t* xarena_grow(xarena_t* arena, size_t size) {
+    // 回退后留在链上的块都是空闲的，按顺序复用
+    xarena_block_t* b = arena->cur ? arena->cur->next : arena->first;
+    xarena_block_t* last = arena->cur;
+    while (b) {
+        b->used = 0;
+        if (b->size >= size) {
+            return b;
+        }
+        last = b;
+        b = b->next;
+    }
+
+    size_t block_size = size > arena->block_size ? size : arena->block_size;
+    b = (xarena_block_t*)malloc(XARENA_HEADER_SIZE + block_size);
+    if (!b) {
+        return NULL;
+    }
+    b->next = NULL;
+    b->size = block_size;
+    b->used = 0;
+
+    if (last) {
+        last->next = b;
+    } else {
+        arena->first = b;
+    }
+    arena->block_allocs++;
+    arena->bytes_reserved += block_size;
+    return b;
+}
+
+void* xarena_alloc(xarena_t* arena, size_t size) {
+    if (!arena->block_size) {
+        xarena_init(arena, 0);
+    }
+    size = (size + XARENA_ALIGN - 1) & ~(size_t)(XARENA_ALIGN - 1);
+    if (size == 0) size = XARENA_ALIGN;
+
+    xarena_block_t* b = arena->cur;
+    if (!b || b->size - b->used < size) {
+        b = xarena_grow(arena, size);
+        if (!b) {
+            return NULL;
+        }
+        arena->cur = b;
+    }
+
+    void* p = xarena_block_data(b) + b->used;
+    b->used += size;
+
+    arena->alloc_calls++;
+    arena->bytes_used += size;
+    if (arena->bytes_used > arena->bytes_peak) {
+        arena->bytes_peak = arena->bytes_used;
+    }
+    return p;
+}
+
+void* xarena_calloc(xarena_t* arena, size_t size) {
+    void* p = xarena_alloc(arena, size);
+    if (p) {
+        memset(p, 0, size);
+    }
+    return p;
+}
+
+char* xarena_strndup(xarena_t* arena, const char* str, size_t n) {
+    if (!str) return NULL;
+
+    size_t len = 0;
+    while (len < n && str[len]) len++;
+
+    char* p = (char*)xarena_alloc(arena, len + 1);
+    if (p) {
+        memcpy(p, str, len);
+        p[len] = '\0';
+    }
+    return p;
+}
+
+char* xarena_strdup(xarena_t* arena, const char* str) {
+    return str ? xarena_strndup(arena, str, strlen(str)) : NULL;
+}
+
+xarena_mark_t xarena_mark(const xarena_t* arena) {
+    xarena_mark_t mark;
+    mark.block = arena->cur;
+    mark.used = arena->cur ? arena->cur->used : 0;
+    mark.bytes_used = arena->bytes_used;
+    return mark;
+}
+
+void xarena_rewind(xarena_t* arena, xarena_mark_t mark) {
+    arena->cur = mark.block;
+    if (mark.block) {
+        mark.block->used = mark.used;
+    }
+    arena->bytes_used = mark.bytes_used;
+}
+
+void xarena_reset(xarena_t* arena) {
+    xarena_mark_t start = { NULL, 0, 0 };
+    xarena_rewind(arena, start);
+}
+
+void xarena_free(xarena_t* arena) {
+    xarena_block_t* b = arena->first;
+    while (b) {
+        xarena_block_t* next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->first = NULL;
+    arena->cur = NULL;
+    arena->bytes_reserved = 0;
+    arena->bytes_used = 0;
+}
+
+xarena_t* xarena_thread(void) {
+    static XARENA_TLS xarena_t thread_arena;
+    if (!thread_arena.block_size) {
+        xarena_init(&thread_arena, 0);
+    }
+    return &thread_arena;
+}
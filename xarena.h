@@ -0,0 +1,91 @@
+#ifndef XARENA_H
+#define XARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief 内存块（竞技场内部链表节点）
+ */
+typedef struct xarena_block_s xarena_block_t;
+
+/**
+ * @brief 竞技场分配器：按块批量申请，逐次顺序切分，整体回退/释放
+ * @note 一次翻译的临时内存（URL 编码、请求拼接、响应缓冲、中间字符串）都从这里取，
+ *       结束时 xarena_rewind 回到翻译开始前的位置，O(1) 释放；块保留给下一次翻译复用
+ */
+typedef struct {
+    xarena_block_t* first;    // 第一个块
+    xarena_block_t* cur;      // 当前切分的块
+    size_t block_size;        // 普通块大小（0 使用默认 64KB）
+
+    // 统计
+    size_t alloc_calls;       // xarena_alloc 调用次数（原本每次都是一次 malloc）
+    size_t block_allocs;      // 实际向系统申请块的次数
+    size_t bytes_reserved;    // 已向系统申请的总字节数
+    size_t bytes_used;        // 当前已切分出去的字节数
+    size_t bytes_peak;        // bytes_used 峰值
+} xarena_t;
+
+/**
+ * @brief 回退点（xarena_mark 取得，xarena_rewind 回退）
+ */
+typedef struct {
+    xarena_block_t* block;
+    size_t used;
+    size_t bytes_used;
+} xarena_mark_t;
+
+/**
+ * @brief 初始化竞技场
+ * @param arena 竞技场
+ * @param block_size 普通块大小（0 使用默认值）
+ */
+void xarena_init(xarena_t* arena, size_t block_size);
+
+/**
+ * @brief 分配内存（16 字节对齐，内容未初始化）
+ * @return 内存指针（NULL 表示申请块失败）
+ */
+void* xarena_alloc(xarena_t* arena, size_t size);
+
+/**
+ * @brief 分配并清零
+ */
+void* xarena_calloc(xarena_t* arena, size_t size);
+
+/**
+ * @brief 复制字符串
+ */
+char* xarena_strdup(xarena_t* arena, const char* str);
+
+/**
+ * @brief 复制字符串前 n 个字节（遇到终止符提前结束，结果总是以 '\0' 结尾）
+ */
+char* xarena_strndup(xarena_t* arena, const char* str, size_t n);
+
+/**
+ * @brief 记录当前位置
+ */
+xarena_mark_t xarena_mark(const xarena_t* arena);
+
+/**
+ * @brief 回退到 mark 位置，之后分配的内存全部失效（O(1)，不释放块）
+ */
+void xarena_rewind(xarena_t* arena, xarena_mark_t mark);
+
+/**
+ * @brief 清空竞技场（等价于回退到最开始，块保留复用）
+ */
+void xarena_reset(xarena_t* arena);
+
+/**
+ * @brief 释放全部块
+ */
+void xarena_free(xarena_t* arena);
+
+/**
+ * @brief 当前线程的竞技场（首次使用时初始化）
+ */
+xarena_t* xarena_thread(void);
+
+#endif // XARENA_H
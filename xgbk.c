@@ -0,0 +1,204 @@
+#include "xgbk.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define XGBK_CODEPAGE 54936     // GB18030（GBK 超集）
+#define XGBK_SLICE 1024         // 每次交给代码页转换的最大字节数
+#else
+#include <iconv.h>
+#include <errno.h>
+#endif
+
+#if defined(_MSC_VER)
+#define XGBK_TLS __declspec(thread)
+#else
+#define XGBK_TLS _Thread_local
+#endif
+
+// 后端返回值
+#define XGBK_BACKEND_DONE        0   // 全部转换
+#define XGBK_BACKEND_FULL        1   // 输出已满
+#define XGBK_BACKEND_INCOMPLETE  2   // 末尾是不完整字符
+
+/**
+ * @brief 从 p 开始的一个字符的长度
+ * @return 1/2/4；0 表示数据不足；-1 表示非法
+ */
+static int xgbk_char_len(const unsigned char* p, size_t left) {
+    if (left == 0) return 0;
+    unsigned char c = p[0];
+    if (c < 0x80) return 1;
+    if (c == 0x80 || c == 0xFF) return -1;
+    if (left < 2) return 0;
+
+    unsigned char c2 = p[1];
+    if ((c2 >= 0x40 && c2 <= 0x7E) || (c2 >= 0x80 && c2 <= 0xFE)) return 2;
+    if (c2 < 0x30 || c2 > 0x39) return -1;
+
+    // GB18030 四字节：[81-FE][30-39][81-FE][30-39]
+    if (left < 3) return 0;
+    if (p[2] < 0x81 || p[2] > 0xFE) return -1;
+    if (left < 4) return 0;
+    if (p[3] < 0x30 || p[3] > 0x39) return -1;
+    return 4;
+}
+
+/**
+ * @brief 转换一段数据，in_used/out_used 返回实际消耗/产出的字节数
+ * @return XGBK_BACKEND_* 或 -1（非法序列，停在 in + in_used）
+ */
+static int xgbk_backend(xgbk_t* t, const char* in, size_t in_len, char* out, size_t out_left,
+                        size_t* in_used, size_t* out_used) {
+#ifdef _WIN32
+    (void)t;
+    WCHAR wbuf[XGBK_SLICE];
+    size_t i = 0, o = 0;
+    int status = XGBK_BACKEND_DONE;
+
+    while (i < in_len) {
+        // 收集一段完整字符，且按最坏情况（2→3、4→4 字节）保证输出放得下
+        size_t j = i, worst = 0;
+        int n = 1;
+        while (j < in_len && j - i + 4 <= XGBK_SLICE) {
+            n = xgbk_char_len((const unsigned char*)in + j, in_len - j);
+            if (n <= 0) break;
+            size_t w = (n == 2) ? 3 : (size_t)n;
+            if (o + worst + w > out_left) {
+                n = -2;
+                break;
+            }
+            worst += w;
+            j += n;
+        }
+
+        if (j > i) {
+            int wn = MultiByteToWideChar(XGBK_CODEPAGE, MB_ERR_INVALID_CHARS, in + i, (int)(j - i), wbuf, XGBK_SLICE);
+            int un = wn > 0 ? WideCharToMultiByte(CP_UTF8, 0, wbuf, wn, out + o, (int)(out_left - o), NULL, NULL) : 0;
+            if (un <= 0) {
+                status = -1;
+                break;
+            }
+            i = j;
+            o += un;
+        }
+
+        if (n == -1) { status = -1; break; }
+        if (n == -2) { status = XGBK_BACKEND_FULL; break; }
+        if (n == 0)  { status = XGBK_BACKEND_INCOMPLETE; break; }
+    }
+
+    *in_used = i;
+    *out_used = o;
+    return status;
+#else
+    char* ip = (char*)in;
+    size_t il = in_len;
+    char* op = out;
+    size_t ol = out_left;
+
+    size_t r = iconv((iconv_t)t->cd, &ip, &il, &op, &ol);
+    *in_used = in_len - il;
+    *out_used = out_left - ol;
+    if (r != (size_t)-1) return XGBK_BACKEND_DONE;
+    if (errno == E2BIG) return XGBK_BACKEND_FULL;
+    if (errno == EINVAL) return XGBK_BACKEND_INCOMPLETE;
+    return -1;
+#endif
+}
+
+int xgbk_open(xgbk_t* t) {
+    memset(t, 0, sizeof(*t));
+#ifndef _WIN32
+    iconv_t cd = iconv_open("UTF-8", "GB18030");
+    if (cd == (iconv_t)-1) {
+        cd = iconv_open("UTF-8", "GBK");
+    }
+    if (cd == (iconv_t)-1) return -1;
+    t->cd = (void*)cd;
+#endif
+    return 0;
+}
+
+int xgbk_convert(xgbk_t* t, const char** in, size_t* in_left, char** out, size_t* out_left) {
+    size_t iu, ou;
+
+    // 1. 先补全上一块留下的半个字符
+    if (t->pend_len > 0) {
+        int n;
+        while ((n = xgbk_char_len(t->pend, t->pend_len)) == 0 && *in_left > 0) {
+            t->pend[t->pend_len++] = (unsigned char)**in;
+            (*in)++;
+            (*in_left)--;
+        }
+        if (n < 0) return XGBK_INVALID;
+        if (n == 0) return XGBK_OK;  // 仍不完整，等下一块
+
+        int st = xgbk_backend(t, (const char*)t->pend, t->pend_len, *out, *out_left, &iu, &ou);
+        if (st < 0) return XGBK_INVALID;
+        if (iu < t->pend_len) return XGBK_FULL;
+        *out += ou;
+        *out_left -= ou;
+        t->pend_len = 0;
+    }
+
+    // 2. 主体
+    int st = xgbk_backend(t, *in, *in_left, *out, *out_left, &iu, &ou);
+    *in += iu;
+    *in_left -= iu;
+    *out += ou;
+    *out_left -= ou;
+
+    if (st == XGBK_BACKEND_FULL) return XGBK_FULL;
+    if (st < 0) return XGBK_INVALID;
+    if (st == XGBK_BACKEND_INCOMPLETE) {
+        // 块尾不完整字符（最多 3 字节）暂存
+        if (*in_left >= sizeof(t->pend)) return XGBK_INVALID;
+        memcpy(t->pend, *in, *in_left);
+        t->pend_len = *in_left;
+        *in += *in_left;
+        *in_left = 0;
+    }
+    return XGBK_OK;
+}
+
+int xgbk_finish(xgbk_t* t) {
+    int truncated = t->pend_len > 0;
+    t->pend_len = 0;
+#ifndef _WIN32
+    if (t->cd) {
+        iconv((iconv_t)t->cd, NULL, NULL, NULL, NULL);
+    }
+#endif
+    return truncated ? -1 : 0;
+}
+
+void xgbk_close(xgbk_t* t) {
+#ifndef _WIN32
+    if (t->cd) {
+        iconv_close((iconv_t)t->cd);
+    }
+#endif
+    memset(t, 0, sizeof(*t));
+}
+
+int xgbk_to_utf8(const char* in, size_t in_len, char* out, size_t out_len) {
+    // 每个线程缓存一个转码器（线程退出时由系统回收）
+    static XGBK_TLS xgbk_t cached;
+    static XGBK_TLS int cached_ok = 0;
+
+    if (in == NULL || out == NULL || out_len == 0) return -1;
+    if (!cached_ok) {
+        if (xgbk_open(&cached) != 0) return -1;
+        cached_ok = 1;
+    }
+
+    char* op = out;
+    size_t ol = out_len - 1;  // 留终止符
+    int st = xgbk_convert(&cached, &in, &in_len, &op, &ol);
+    int truncated = xgbk_finish(&cached);
+    if (st != XGBK_OK || truncated) return -1;
+
+    *op = '\0';
+    return (int)(op - out);
+}
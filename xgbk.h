@@ -0,0 +1,59 @@
+#ifndef XGBK_H
+#define XGBK_H
+
+#include <stddef.h>
+
+/**
+ * @brief GBK/GB18030 → UTF-8 流式转码器
+ * @note 描述符只在 xgbk_open 时创建一次，可反复 xgbk_convert；
+ *       输入可以任意切块，块尾不完整的字符暂存到下一块
+ */
+typedef struct {
+    void* cd;                   // iconv 描述符（Windows 使用代码页转换，不用）
+    unsigned char pend[4];      // 上一块末尾不完整的字符
+    size_t pend_len;
+} xgbk_t;
+
+#define XGBK_OK       0         // 输入已全部处理（块尾不完整字符已暂存）
+#define XGBK_FULL     1         // 输出缓冲区已满，腾出空间后继续调用
+#define XGBK_INVALID  (-1)      // 非法 GBK 序列（*in 指向出错位置）
+
+/**
+ * @brief 打开转码器
+ * @return 0 成功，-1 失败
+ */
+int xgbk_open(xgbk_t* t);
+
+/**
+ * @brief 转换一块数据（iconv 风格：推进输入/输出指针并减少剩余长度）
+ * @param t 转码器
+ * @param in 输入指针（输出：处理到的位置）
+ * @param in_left 输入剩余长度
+ * @param out 输出指针（输出：写到的位置，不写终止符）
+ * @param out_left 输出剩余长度
+ * @return XGBK_OK / XGBK_FULL / XGBK_INVALID
+ */
+int xgbk_convert(xgbk_t* t, const char** in, size_t* in_left, char** out, size_t* out_left);
+
+/**
+ * @brief 结束一段流并复位状态（之后可以转换新的流）
+ * @return 0 成功，-1 流在字符中间截断
+ */
+int xgbk_finish(xgbk_t* t);
+
+/**
+ * @brief 关闭转码器
+ */
+void xgbk_close(xgbk_t* t);
+
+/**
+ * @brief 一次性转换（使用当前线程缓存的转码器，不重复打开描述符）
+ * @param in 输入 GBK 数据
+ * @param in_len 输入长度
+ * @param out 输出缓冲区（结果以 '\0' 结尾）
+ * @param out_len 输出缓冲区长度
+ * @return 成功: UTF-8 长度, 失败: -1
+ */
+int xgbk_to_utf8(const char* in, size_t in_len, char* out, size_t out_len);
+
+#endif // XGBK_H
@@ -1,15 +1,29 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "xhttpc.h"
+#include "xhttpc_h2.h"
+#include "xutf8.h"
+#include "xgbk.h"
+#include "xjson.h"
+#include "xlang.h"
+#include "xlimit.h"
+#include "xmetrics.h"
+#include "xtrace.h"
 #include "mbedtls/net_sockets.h"
 #include "mbedtls/ssl.h"
 #include "mbedtls/x509_crt.h"
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/entropy.h"
 #include "mbedtls/error.h"
+#include "mbedtls/base64.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
-#include <string.h>  // for strndup
+#include <stdarg.h>
+#include <time.h>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -18,29 +32,145 @@
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
-#include <iconv.h>
+#include <errno.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HTTPC_URL_SIMD 1
 #endif
 
 #include "xhttpc_cacert.h"
-#define strndup(str) str?strcpy((char*)malloc(strlen(str) + 1), str):NULL
+
+#define HTTPC_POOL_KEY_LEN 640
 
 /**
- * @brief 客户端上下文具体实现（对外隐藏）
+ * @brief 连接（套接字 + TLS 会话 + h2 会话）
+ * @note 总是从堆分配：mbedtls 上下文之间互相持有指针，不能搬移；
+ *       客户端释放时可复用的连接整体交给连接池，下一个同目标的客户端直接接管
  */
-struct httpc_client_s {
-    httpc_config_t config;                // 配置拷贝
+typedef struct {
     mbedtls_net_context net_fd;           // 网络套接字
     mbedtls_ssl_context ssl;              // SSL 上下文（HTTPS 用）
     mbedtls_ssl_config ssl_conf;          // SSL 配置（HTTPS 用）
     mbedtls_x509_crt cacert;              // CA 证书（HTTPS 用）
     mbedtls_ctr_drbg_context ctr_drbg;    // 随机数生成器（HTTPS 用）
     mbedtls_entropy_context entropy;      // 熵源（HTTPS 用）
+    int is_https;                         // 建立时的协议（决定 I/O 走 TLS 还是明文）
+    httpc_h2_t* h2;                       // ALPN 协商到 h2 时的会话（NULL 表示 HTTP/1.1）
+    char key[HTTPC_POOL_KEY_LEN];         // 连接池键：scheme/主机/端口/代理/CA/ALPN（空串表示不入池）
+    double idle_since;                    // 放入连接池的时间（ms）
+    unsigned id;                          // 连接编号（追踪事件中区分连接，从 1 开始）
+} httpc_conn_t;
+
+/**
+ * @brief 客户端上下文具体实现（对外隐藏）
+ */
+struct httpc_client_s {
+    httpc_config_t config;                // 配置拷贝
+    httpc_conn_t* conn;                   // 连接（客户端生命周期内始终有效，is_init 表示已连通）
     int is_init;                          // 初始化标记
+    int keep_alive;                       // 上一个响应按长度完整读取且未要求关闭 → 连接可复用
+    char target_host[256];                // 重定向/缓存改写后的主机（config.server_host 指向这里）
+    char target_port[8];                  // 重定向/缓存改写后的端口
+    char target_path[1024];               // 重定向后的路径（config.url_path 指向这里）
+    char* carry;                          // 流水线：上一个响应之后多读到的数据
+    size_t carry_len;
+    size_t carry_cap;
+    size_t served;                        // 当前连接上已完整读取的响应数（>0 即为复用连接）
+    httpc_hop_timing_t conn_phase;        // 建立连接时测得的阶段，计入该客户端的第一跳
+    double first_byte_at;                 // 当前响应收到第一个字节的时间（ms，0 = 还没收到）
 };
 
+const char* httpc_err_name(httpc_err_t err) {
+    switch (err) {
+    case HTTPC_SUCCESS:                return "success";
+    case HTTPC_ERR_INIT:               return "init";
+    case HTTPC_ERR_CONNECT:            return "connect";
+    case HTTPC_ERR_SSL_HANDSHAKE:      return "ssl_handshake";
+    case HTTPC_ERR_SSL_CERT:           return "ssl_cert";
+    case HTTPC_ERR_WRITE:              return "write";
+    case HTTPC_ERR_READ:               return "read";
+    case HTTPC_ERR_PARAM:              return "param";
+    case HTTPC_ERR_PARSE:              return "parse";
+    case HTTPC_ERR_REDIRECT:           return "redirect";
+    case HTTPC_ERR_TOO_MANY_REDIRECTS: return "too_many_redirects";
+    case HTTPC_ERR_PROXY_CONNECT:      return "proxy_connect";
+    case HTTPC_ERR_PROXY_AUTH:         return "proxy_auth";
+    case HTTPC_ERR_PROXY_PARSE:        return "proxy_parse";
+    case HTTPC_ERR_THROTTLED:          return "throttled";
+    }
+    return "unknown";
+}
+
+// 指标（见 xmetrics.h）：无标签的计数器句柄第一次使用时注册，之后直接原子累加
+static xmetrics_counter_t* httpc_m_sent;
+static xmetrics_counter_t* httpc_m_received;
+
+static void httpc_count_bytes(int sent, int n) {
+    if (n <= 0) return;
+    if (sent) {
+        if (!httpc_m_sent) httpc_m_sent = xmetrics_counter("xtrans_http_sent_bytes_total",
+                                                           "HTTP payload bytes sent (TLS plaintext)", NULL);
+        xmetrics_add(httpc_m_sent, (uint64_t)n);
+    } else {
+        if (!httpc_m_received) httpc_m_received = xmetrics_counter("xtrans_http_received_bytes_total",
+                                                                   "HTTP payload bytes received (TLS plaintext)", NULL);
+        xmetrics_add(httpc_m_received, (uint64_t)n);
+    }
+}
+
+static void httpc_count_error(httpc_err_t err) {
+    char labels[48];
+    snprintf(labels, sizeof(labels), "error=\"%s\"", httpc_err_name(err));
+    xmetrics_add(xmetrics_counter("xtrans_http_errors_total", "Failed HTTP requests by httpc_err_t", labels), 1);
+}
+
+static void httpc_count_cache(const char* cache, int hit) {
+    char labels[64];
+    snprintf(labels, sizeof(labels), "cache=\"%s\",result=\"%s\"", cache, hit ? "hit" : "miss");
+    xmetrics_add(xmetrics_counter("xtrans_cache_lookups_total", "Cache lookups by cache and result", labels), 1);
+}
+
+static void httpc_observe_phase(const char* phase, double ms) {
+    char labels[32];
+    snprintf(labels, sizeof(labels), "phase=\"%s\"", phase);
+    xmetrics_observe_ms(xmetrics_histogram("xtrans_http_phase_duration_seconds",
+                                           "HTTP request phase latency", labels), ms);
+}
+
+/**
+ * @brief 一跳请求结束后更新请求数、状态码、耗时和各阶段直方图
+ */
+static void httpc_count_hop(const httpc_hop_timing_t* hop, httpc_err_t err) {
+    char labels[320];
+    snprintf(labels, sizeof(labels), "host=\"%s\",conn=\"%s\"", hop->host, hop->reused ? "reused" : "new");
+    xmetrics_add(xmetrics_counter("xtrans_http_requests_total", "HTTP requests sent, one per redirect hop", labels), 1);
+
+    if (err != HTTPC_SUCCESS) {
+        httpc_count_error(err);
+    } else {
+        snprintf(labels, sizeof(labels), "host=\"%s\",code=\"%d\"", hop->host, hop->status);
+        xmetrics_add(xmetrics_counter("xtrans_http_responses_total", "HTTP responses by status code", labels), 1);
+        httpc_observe_phase("ttfb", hop->ttfb_ms);
+    }
+
+    snprintf(labels, sizeof(labels), "host=\"%s\"", hop->host);
+    xmetrics_observe_ms(xmetrics_histogram("xtrans_http_request_duration_seconds",
+                                           "HTTP request latency per hop, including connection setup", labels),
+                        hop->total_ms);
+    if (!hop->reused) {
+        httpc_observe_phase("dns", hop->dns_ms);
+        httpc_observe_phase("connect", hop->connect_ms);
+        if (hop->proxy_ms > 0) httpc_observe_phase("proxy", hop->proxy_ms);
+        if (hop->tls_ms > 0) httpc_observe_phase("tls", hop->tls_ms);
+    }
+}
+
 static int is_empty_string(const char* str) {
     return (str == NULL || strlen(str) == 0);
 }
@@ -70,26 +200,38 @@ typedef struct {
     char* username;          // 代理用户名（可选）
     char* password;          // 代理密码（可选）
     int enabled;             // 是否启用代理（1=启用，0=禁用）
+    xarena_t* arena;         // 字符串来自该竞技场时不逐个释放
 } parsed_proxy_config_t;
 
+/**
+ * @brief 复制字符串（有竞技场时从竞技场分配，否则 malloc）
+ */
+static char* httpc_strdup(xarena_t* arena, const char* str) {
+    if (arena) {
+        return xarena_strdup(arena, str);
+    }
+    return strdup(str);
+}
+
 /**
  * @brief 解析代理字符串
  */
-static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
+static parsed_proxy_config_t parse_proxy_string(const char* proxy_str, xarena_t* arena) {
     parsed_proxy_config_t proxy = {
         .type = PROXY_NONE,
         .host = NULL,
         .port = NULL,
         .username = NULL,
         .password = NULL,
-        .enabled = 0
+        .enabled = 0,
+        .arena = arena
     };
 
     if (!proxy_str || strlen(proxy_str) == 0) {
         return proxy;
     }
 
-    char* proxy_copy = strndup(proxy_str);
+    char* proxy_copy = httpc_strdup(arena, proxy_str);
     if (!proxy_copy)
         return proxy;
 
@@ -104,11 +246,11 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
             host_part = proxy_copy + strlen("socks5h://");
         }
 
-        // 解析主机名和端口
+        // 解析主机名和端口（密码中可以有 ':'，以最后一个 '@' 分隔认证信息）
         char* colon = strchr(host_part, ':');
-        char* at = strchr(host_part, '@');
+        char* at = strrchr(host_part, '@');
 
-        if (at && colon && at < colon) {
+        if (at) {
             // 有认证信息
             char* user_part = host_part;
             *at = '\0';
@@ -116,10 +258,10 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
             char* pass_part = strchr(user_part, ':');
             if (pass_part) {
                 *pass_part = '\0';
-                proxy.username = strndup(user_part);
-                proxy.password = strndup(pass_part + 1);
+                proxy.username = httpc_strdup(arena, user_part);
+                proxy.password = httpc_strdup(arena, pass_part + 1);
             } else {
-                proxy.username = strndup(user_part);
+                proxy.username = httpc_strdup(arena, user_part);
             }
 
             host_part = at + 1;
@@ -128,8 +270,8 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
 
         if (colon) {
             *colon = '\0';
-            proxy.host = strndup(host_part);
-            proxy.port = strndup(colon + 1);
+            proxy.host = httpc_strdup(arena, host_part);
+            proxy.port = httpc_strdup(arena, colon + 1);
 
             // 去除路径部分
             char* path = strchr(proxy.port, '/');
@@ -137,8 +279,8 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
                 *path = '\0';
             }
         } else {
-            proxy.host = strndup(host_part);
-            proxy.port = strndup("1080");  // 默认SOCKS5端口
+            proxy.host = httpc_strdup(arena, host_part);
+            proxy.port = httpc_strdup(arena, "1080");  // 默认SOCKS5端口
         }
     } else if (strstr(proxy_copy, "http://") == proxy_copy || strstr(proxy_copy, "https://") == proxy_copy) {
         proxy.type = PROXY_HTTP_CONNECT;
@@ -147,11 +289,11 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
         char* scheme_end = strstr(proxy_copy, "://");
         char* host_part = scheme_end + 3;
 
-        // 解析主机名和端口
+        // 解析主机名和端口（密码中可以有 ':'，以最后一个 '@' 分隔认证信息）
         char* colon = strchr(host_part, ':');
-        char* at = strchr(host_part, '@');
+        char* at = strrchr(host_part, '@');
 
-        if (at && colon && at < colon) {
+        if (at) {
             // 有认证信息
             char* user_part = host_part;
             *at = '\0';
@@ -159,10 +301,10 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
             char* pass_part = strchr(user_part, ':');
             if (pass_part) {
                 *pass_part = '\0';
-                proxy.username = strndup(user_part);
-                proxy.password = strndup(pass_part + 1);
+                proxy.username = httpc_strdup(arena, user_part);
+                proxy.password = httpc_strdup(arena, pass_part + 1);
             } else {
-                proxy.username = strndup(user_part);
+                proxy.username = httpc_strdup(arena, user_part);
             }
 
             host_part = at + 1;
@@ -171,8 +313,8 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
 
         if (colon) {
             *colon = '\0';
-            proxy.host = strndup(host_part);
-            proxy.port = strndup(colon + 1);
+            proxy.host = httpc_strdup(arena, host_part);
+            proxy.port = httpc_strdup(arena, colon + 1);
 
             // 去除路径部分
             char* path = strchr(proxy.port, '/');
@@ -180,22 +322,22 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
                 *path = '\0';
             }
         } else {
-            proxy.host = strndup(host_part);
-            proxy.port = strndup("8080");  // 默认HTTP代理端口
+            proxy.host = httpc_strdup(arena, host_part);
+            proxy.port = httpc_strdup(arena, "8080");  // 默认HTTP代理端口
         }
     } else {
         // 直接指定的主机:端口格式
         char* colon = strchr(proxy_copy, ':');
         if (colon) {
             *colon = '\0';
-            proxy.host = strndup(proxy_copy);
-            proxy.port = strndup(colon + 1);
+            proxy.host = httpc_strdup(arena, proxy_copy);
+            proxy.port = httpc_strdup(arena, colon + 1);
             proxy.type = PROXY_HTTP_CONNECT;  // 默认HTTP CONNECT
             proxy.enabled = 1;
         }
     }
 
-    free(proxy_copy);
+    if (!arena) free(proxy_copy);
     return proxy;
 }
 
@@ -204,10 +346,12 @@ static parsed_proxy_config_t parse_proxy_string(const char* proxy_str) {
  */
 static void free_parsed_proxy(parsed_proxy_config_t* proxy) {
     if (proxy) {
-        if (proxy->host) free(proxy->host);
-        if (proxy->port) free(proxy->port);
-        if (proxy->username) free(proxy->username);
-        if (proxy->password) free(proxy->password);
+        if (!proxy->arena) {  // 竞技场里的字符串随竞技场回退释放
+            if (proxy->host) free(proxy->host);
+            if (proxy->port) free(proxy->port);
+            if (proxy->username) free(proxy->username);
+            if (proxy->password) free(proxy->password);
+        }
         proxy->type = PROXY_NONE;
         proxy->host = NULL;
         proxy->port = NULL;
@@ -217,6 +361,100 @@ static void free_parsed_proxy(parsed_proxy_config_t* proxy) {
     }
 }
 
+/**
+ * @brief 连接改写表（httpc_set_connect_to）和默认 CA（httpc_set_default_ca）
+ * @note 只改变 TCP 连接（或代理隧道）的目标；SNI、Host 头、证书主机名校验、
+ *       连接池键和限流仍按原主机名，因此本地模拟服务器可以按 Host 头区分被模拟的服务
+ */
+#define HTTPC_CONNECT_TO_MAX 16
+
+static int str_ieq(const char* a, const char* b);
+
+typedef struct {
+    char host[256];                       // 空 = 任意主机
+    char port[8];                         // 空 = 任意端口
+    char addr[256];                       // 空 = 保持原主机
+    char addr_port[8];                    // 空 = 保持原端口
+} httpc_connect_to_t;
+
+static httpc_connect_to_t httpc_connect_to[HTTPC_CONNECT_TO_MAX];
+static int httpc_connect_to_size = 0;
+static char httpc_default_ca[1024];
+
+/**
+ * @brief 读取 spec 的一个字段（到 ':'、',' 或结尾；"[...]" 内的 ':' 属于字段本身，如 IPv6 地址）
+ * @return 字段之后的位置，字段过长返回 NULL
+ */
+static const char* httpc_spec_field(const char* p, char* out, size_t size) {
+    size_t n = 0;
+    int bracket = *p == '[';
+    if (bracket) p++;
+    while (*p && (bracket ? *p != ']' : (*p != ':' && *p != ','))) {
+        if (n + 1 >= size) return NULL;
+        out[n++] = *p++;
+    }
+    out[n] = '\0';
+    if (bracket) {
+        if (*p != ']') return NULL;
+        p++;
+    }
+    return p;
+}
+
+int httpc_set_connect_to(const char* spec) {
+    httpc_connect_to_size = 0;
+    const char* p = spec;
+
+    while (p && *p) {
+        if (httpc_connect_to_size == HTTPC_CONNECT_TO_MAX) {
+            fprintf(stderr, u8"连接改写条目过多（最多 %d 条）\n", HTTPC_CONNECT_TO_MAX);
+            return -1;
+        }
+        httpc_connect_to_t* e = &httpc_connect_to[httpc_connect_to_size];
+        char* fields[4] = { e->host, e->port, e->addr, e->addr_port };
+        size_t sizes[4] = { sizeof(e->host), sizeof(e->port), sizeof(e->addr), sizeof(e->addr_port) };
+
+        for (int i = 0; i < 4; i++) {
+            p = httpc_spec_field(p, fields[i], sizes[i]);
+            if (!p || (i < 3 && *p != ':') || (i == 3 && *p && *p != ',')) {
+                fprintf(stderr, u8"连接改写格式错误（应为 HOST:PORT:ADDR:PORT）: %s\n", spec);
+                httpc_connect_to_size = 0;
+                return -1;
+            }
+            if (*p) p++;
+        }
+        httpc_connect_to_size++;
+    }
+    return 0;
+}
+
+void httpc_set_default_ca(const char* path) {
+    snprintf(httpc_default_ca, sizeof(httpc_default_ca), "%s", path ? path : "");
+}
+
+/**
+ * @brief 按连接改写表得到实际要连接的地址（无匹配时为原主机/端口）
+ */
+static void httpc_connect_target(const char* host, const char* port, const char** addr, const char** addr_port) {
+    *addr = host;
+    *addr_port = port;
+    for (int i = 0; i < httpc_connect_to_size; i++) {
+        const httpc_connect_to_t* e = &httpc_connect_to[i];
+        if ((e->host[0] && !str_ieq(e->host, host)) || (e->port[0] && strcmp(e->port, port) != 0)) continue;
+        if (e->addr[0]) *addr = e->addr;
+        if (e->addr_port[0]) *addr_port = e->addr_port;
+        return;
+    }
+}
+
+/**
+ * @brief 实际使用的 CA 文件：配置指定的优先，其次 httpc_set_default_ca，NULL 表示内置证书
+ */
+static const char* httpc_ca_path(const httpc_config_t* config) {
+    if (!is_empty_string(config->ca_cert_path)) return config->ca_cert_path;
+    return httpc_default_ca[0] ? httpc_default_ca : NULL;
+}
+
 /**
  * @brief 初始化 HTTPS 相关上下文（双证书策略，适配 mbedtls 2.16.11）
  */
@@ -224,10 +462,15 @@ static httpc_err_t httpc_https_init(httpc_client_t* client) {
     int ret;
     const char* pers = "httpc_client";
 
+    // 先初始化全部上下文，任一步失败后都可统一释放
+    mbedtls_ctr_drbg_init(&client->conn->ctr_drbg);
+    mbedtls_entropy_init(&client->conn->entropy);
+    mbedtls_x509_crt_init(&client->conn->cacert);
+    mbedtls_ssl_config_init(&client->conn->ssl_conf);
+    mbedtls_ssl_init(&client->conn->ssl);
+
     // 初始化随机数生成器
-    mbedtls_ctr_drbg_init(&client->ctr_drbg);
-    mbedtls_entropy_init(&client->entropy);
-    ret = mbedtls_ctr_drbg_seed(&client->ctr_drbg, mbedtls_entropy_func, &client->entropy,
+    ret = mbedtls_ctr_drbg_seed(&client->conn->ctr_drbg, mbedtls_entropy_func, &client->conn->entropy,
         (const unsigned char*)pers, strlen(pers));
     if (ret != 0) {
         fprintf(stderr, u8"随机数生成器初始化失败: %d\n", ret);
@@ -235,23 +478,23 @@ static httpc_err_t httpc_https_init(httpc_client_t* client) {
     }
 
     // ===================== 核心：双证书分支加载逻辑 =====================
-    mbedtls_x509_crt_init(&client->cacert);
     int cert_ret = 0;
 
-    // 1. 优先使用指定的证书文件（若路径有效）
-    if (!is_empty_string(client->config.ca_cert_path)) {
-        cert_ret = mbedtls_x509_crt_parse_file(&client->cacert, client->config.ca_cert_path);
+    // 1. 优先使用指定的证书文件（若路径有效；未指定时取 httpc_set_default_ca 的设置）
+    const char* ca_path = httpc_ca_path(&client->config);
+    if (ca_path) {
+        cert_ret = mbedtls_x509_crt_parse_file(&client->conn->cacert, ca_path);
         if (cert_ret < 0) {
-            fprintf(stderr, u8"证书文件 [%s] 加载失败: -0x%04x\n", client->config.ca_cert_path, (unsigned int)-cert_ret);
+            fprintf(stderr, u8"证书文件 [%s] 加载失败: -0x%04x\n", ca_path, (unsigned int)-cert_ret);
             return HTTPC_ERR_SSL_CERT;
         }
-        //fprintf(stdout, u8"✅ 证书文件 [%s] 加载成功（跳过 %d 个无效证书）\n", client->config.ca_cert_path, cert_ret);
+        //fprintf(stdout, u8"✅ 证书文件 [%s] 加载成功（跳过 %d 个无效证书）\n", ca_path, cert_ret);
     }
     // 2. 回退使用内置内存证书（路径无效时）
     else {
         const unsigned char* cacert_data = httpc_cacert_get_data();
         size_t cacert_len = httpc_cacert_get_len();
-        cert_ret = mbedtls_x509_crt_parse(&client->cacert, cacert_data, cacert_len);
+        cert_ret = mbedtls_x509_crt_parse(&client->conn->cacert, cacert_data, cacert_len);
         if (cert_ret < 0) {
             fprintf(stderr, u8"❌ 内置证书解析失败: -0x%04x\n", (unsigned int)-cert_ret);
             return HTTPC_ERR_SSL_CERT;
@@ -260,8 +503,7 @@ static httpc_err_t httpc_https_init(httpc_client_t* client) {
     }
 
     // 初始化 SSL 配置
-    mbedtls_ssl_config_init(&client->ssl_conf);
-    ret = mbedtls_ssl_config_defaults(&client->ssl_conf, MBEDTLS_SSL_IS_CLIENT,
+    ret = mbedtls_ssl_config_defaults(&client->conn->ssl_conf, MBEDTLS_SSL_IS_CLIENT,
         MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
     if (ret != 0) {
         fprintf(stderr, u8"SSL 配置初始化失败: %d\n", ret);
@@ -269,25 +511,41 @@ static httpc_err_t httpc_https_init(httpc_client_t* client) {
     }
 
     // 设置 SSL 验证模式和 CA 证书链
-    mbedtls_ssl_conf_authmode(&client->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
-    mbedtls_ssl_conf_ca_chain(&client->ssl_conf, &client->cacert, NULL);
-    mbedtls_ssl_conf_rng(&client->ssl_conf, mbedtls_ctr_drbg_random, &client->ctr_drbg);
+    mbedtls_ssl_conf_authmode(&client->conn->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&client->conn->ssl_conf, &client->conn->cacert, NULL);
+    mbedtls_ssl_conf_rng(&client->conn->ssl_conf, mbedtls_ctr_drbg_random, &client->conn->ctr_drbg);
 
     // 启用调试（如果配置开启）
     if (client->config.debug_level > 0) {
-        mbedtls_ssl_conf_dbg(&client->ssl_conf, httpc_debug, stdout);
+        mbedtls_ssl_conf_dbg(&client->conn->ssl_conf, httpc_debug, stdout);
+    }
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    // 会话票据：下次连接同一主机时恢复会话（见 httpc_tls_sessions）
+    mbedtls_ssl_conf_session_tickets(&client->conn->ssl_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+#if defined(MBEDTLS_SSL_ALPN)
+    // 按配置通过 ALPN 提供 h2（完整请求字符串模式只能按 HTTP/1.1 原样发送）
+    if (client->config.http2 && !client->config.request) {
+        static const char* alpn_list[] = { "h2", "http/1.1", NULL };
+        ret = mbedtls_ssl_conf_alpn_protocols(&client->conn->ssl_conf, alpn_list);
+        if (ret != 0) {
+            fprintf(stderr, u8"设置 ALPN 失败: %d\n", ret);
+            return HTTPC_ERR_INIT;
+        }
     }
+#endif
 
     // 初始化 SSL 上下文
-    mbedtls_ssl_init(&client->ssl);
-    ret = mbedtls_ssl_setup(&client->ssl, &client->ssl_conf);
+    ret = mbedtls_ssl_setup(&client->conn->ssl, &client->conn->ssl_conf);
     if (ret != 0) {
         fprintf(stderr, u8"SSL 上下文初始化失败: %d\n", ret);
         return HTTPC_ERR_INIT;
     }
 
     // 设置服务器主机名（SNI 扩展，mbedtls 2.16.11 支持）
-    ret = mbedtls_ssl_set_hostname(&client->ssl, client->config.server_host);
+    ret = mbedtls_ssl_set_hostname(&client->conn->ssl, client->config.server_host);
     if (ret != 0) {
         fprintf(stderr, u8"设置 SNI 失败: %d\n", ret);
         return HTTPC_ERR_INIT;
@@ -297,93 +555,223 @@ static httpc_err_t httpc_https_init(httpc_client_t* client) {
 }
 
 /**
- * @brief SOCKS5代理连接握手
+ * @brief 代理握手阶段的明文收发（按长度收/发完整）
+ * @return 0 成功，-1 失败或对端关闭
  */
-static httpc_err_t socks5_handshake(httpc_client_t* client, const char* target_host, const char* target_port) {
-    if (!client || !target_host || !target_port) {
-        return HTTPC_ERR_PARAM;
+static int httpc_net_send_all(mbedtls_net_context* fd, const unsigned char* buf, size_t len) {
+    while (len > 0) {
+        int ret = mbedtls_net_send(fd, buf, len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) continue;
+        if (ret <= 0) return -1;
+        buf += ret;
+        len -= (size_t)ret;
     }
+    return 0;
+}
 
-    // SOCKS5 版本标识和认证方法选择
-    unsigned char req1[] = {0x05, 0x01, 0x00};  // 版本5，1种认证方法，无认证
-    int ret = mbedtls_net_send(&client->net_fd, req1, sizeof(req1));
-    if (ret <= 0) {
-        fprintf(stderr, u8"SOCKS5代理握手失败: 发送认证方法选择失败\n");
-        return HTTPC_ERR_PROXY_CONNECT;
+static int httpc_net_recv_exact(mbedtls_net_context* fd, unsigned char* buf, size_t len) {
+    while (len > 0) {
+        int ret = mbedtls_net_recv(fd, buf, len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ) continue;
+        if (ret <= 0) return -1;
+        buf += ret;
+        len -= (size_t)ret;
     }
+    return 0;
+}
 
-    unsigned char resp1[2];
-    ret = mbedtls_net_recv(&client->net_fd, resp1, sizeof(resp1));
-    if (ret <= 0) {
-        fprintf(stderr, u8"SOCKS5代理握手失败: 接收认证方法响应失败\n");
-        return HTTPC_ERR_PROXY_CONNECT;
+/**
+ * @brief SOCKS5 认证方法缓存（按代理地址 + 用户名记录上次协商出的方法）
+ * @note 方法已知时，问候、用户名/密码认证（RFC 1929）和 CONNECT 合并为一次发送，
+ *       经代理建立连接只多一个往返；问候只提供已知方法，代理改变策略时回 0xFF，丢弃缓存项后由重试层重连
+ */
+#define HTTPC_PROXY_AUTH_MAX 8
+
+#define SOCKS5_METHOD_NONE     0x00
+#define SOCKS5_METHOD_USERPASS 0x02
+#define SOCKS5_METHOD_UNKNOWN  0xFF   // 未缓存（也是代理"无可接受方法"的回复）
+
+typedef struct {
+    char key[320];                  // "host:port|user"，空串表示空闲槽
+    unsigned char method;
+} httpc_proxy_auth_t;
+
+static httpc_proxy_auth_t httpc_proxy_auths[HTTPC_PROXY_AUTH_MAX];
+static int httpc_proxy_auth_next = 0;  // 满了之后按 FIFO 覆盖
+
+static httpc_proxy_auth_t* httpc_proxy_auth_find(const char* key) {
+    for (int i = 0; i < HTTPC_PROXY_AUTH_MAX; i++) {
+        if (strcmp(httpc_proxy_auths[i].key, key) == 0) return &httpc_proxy_auths[i];
     }
+    return NULL;
+}
 
-    if (resp1[0] != 0x05) {
-        fprintf(stderr, u8"SOCKS5代理不支持的版本: 0x%02X\n", resp1[0]);
-        return HTTPC_ERR_PROXY_CONNECT;
+static void httpc_proxy_auth_put(const char* key, unsigned char method) {
+    httpc_proxy_auth_t* e = httpc_proxy_auth_find(key);
+    if (!e) {
+        e = &httpc_proxy_auths[httpc_proxy_auth_next];
+        httpc_proxy_auth_next = (httpc_proxy_auth_next + 1) % HTTPC_PROXY_AUTH_MAX;
     }
+    snprintf(e->key, sizeof(e->key), "%s", key);
+    e->method = method;
+}
 
-    if (resp1[1] != 0x00) {  // 只支持无认证
-        if (resp1[1] == 0xFF) {
-            fprintf(stderr, u8"SOCKS5代理需要认证，当前版本不支持\n");
-            return HTTPC_ERR_PROXY_AUTH;
-        } else {
-            fprintf(stderr, u8"SOCKS5代理不支持的认证方法: 0x%02X\n", resp1[1]);
-            return HTTPC_ERR_PROXY_CONNECT;
-        }
+/**
+ * @brief SOCKS5代理连接握手
+ * @note 没有凭据时只提供"无认证"，方法总是已知；有凭据时同时提供"无认证"和用户名/密码，
+ *       协商结果记入 httpc_proxy_auths，之后的连接把三步合并为一次发送（见上）
+ */
+static httpc_err_t socks5_handshake(httpc_client_t* client, const char* target_host, const char* target_port,
+                                    const parsed_proxy_config_t* proxy) {
+    if (!client || !target_host || !target_port || !proxy) {
+        return HTTPC_ERR_PARAM;
     }
 
-    // SOCKS5 请求
     int port = atoi(target_port);
     if (port <= 0 || port > 65535) {
         return HTTPC_ERR_PARAM;
     }
 
-    unsigned char req2[1024];
-    int req2_len = 0;
-    req2[req2_len++] = 0x05;  // 版本5
-    req2[req2_len++] = 0x01;  // 命令：CONNECT
-    req2[req2_len++] = 0x00;  // 保留字段
+    const char* user = proxy->username;
+    const char* pass = proxy->password ? proxy->password : "";
+    size_t user_len = user ? strlen(user) : 0;
+    size_t pass_len = strlen(pass);
+    if (user_len > 255 || pass_len > 255) {
+        fprintf(stderr, u8"SOCKS5代理用户名或密码过长（最多 255 字节）\n");
+        return HTTPC_ERR_PROXY_AUTH;
+    }
+
+    char auth_key[320];
+    snprintf(auth_key, sizeof(auth_key), "%s:%s|%s", proxy->host, proxy->port, user ? user : "");
+    httpc_proxy_auth_t* cached = user ? httpc_proxy_auth_find(auth_key) : NULL;
+    unsigned char known = user ? (cached ? cached->method : SOCKS5_METHOD_UNKNOWN) : SOCKS5_METHOD_NONE;
+    if (user) httpc_count_cache("proxy_auth", cached != NULL);
+
+    // 一次发送的内容：问候 [+ 认证] [+ CONNECT]
+    unsigned char req[3 + 3 + 255 + 255 + 4 + 1 + 255 + 2];
+    size_t req_len = 0;
+    req[req_len++] = 0x05;  // 版本5
+    if (known != SOCKS5_METHOD_UNKNOWN) {
+        req[req_len++] = 0x01;
+        req[req_len++] = known;
+    } else {
+        req[req_len++] = 0x02;
+        req[req_len++] = SOCKS5_METHOD_NONE;
+        req[req_len++] = SOCKS5_METHOD_USERPASS;
+    }
+    size_t greeting_len = req_len;
+
+    // 用户名/密码子协商（RFC 1929），方法未知时在收到方法选择后发送
+    size_t auth_off = req_len;
+    if (user) {
+        req[req_len++] = 0x01;  // 子协商版本
+        req[req_len++] = (unsigned char)user_len;
+        memcpy(req + req_len, user, user_len);
+        req_len += user_len;
+        req[req_len++] = (unsigned char)pass_len;
+        memcpy(req + req_len, pass, pass_len);
+        req_len += pass_len;
+    }
+    size_t auth_len = req_len - auth_off;
+
+    // CONNECT 请求
+    size_t connect_off = req_len;
+    req[req_len++] = 0x05;  // 版本5
+    req[req_len++] = 0x01;  // 命令：CONNECT
+    req[req_len++] = 0x00;  // 保留字段
 
     // 目标地址类型
     struct in_addr addr4;
     struct in6_addr addr6;
 
     if (inet_pton(AF_INET, target_host, &addr4) == 1) {  // IPv4
-        req2[req2_len++] = 0x01;  // IPv4地址类型
-        memcpy(req2 + req2_len, &addr4, 4);
-        req2_len += 4;
+        req[req_len++] = 0x01;  // IPv4地址类型
+        memcpy(req + req_len, &addr4, 4);
+        req_len += 4;
     } else if (inet_pton(AF_INET6, target_host, &addr6) == 1) {  // IPv6
-        req2[req2_len++] = 0x04;  // IPv6地址类型
-        memcpy(req2 + req2_len, &addr6, 16);
-        req2_len += 16;
+        req[req_len++] = 0x04;  // IPv6地址类型
+        memcpy(req + req_len, &addr6, 16);
+        req_len += 16;
     } else {  // 域名
-        req2[req2_len++] = 0x03;  // 域名地址类型
-        int host_len = (int)strlen(target_host);
+        req[req_len++] = 0x03;  // 域名地址类型
+        size_t host_len = strlen(target_host);
         if (host_len > 255) {
             return HTTPC_ERR_PARAM;
         }
-        req2[req2_len++] = (unsigned char)host_len;
-        memcpy(req2 + req2_len, target_host, host_len);
-        req2_len += host_len;
+        req[req_len++] = (unsigned char)host_len;
+        memcpy(req + req_len, target_host, host_len);
+        req_len += host_len;
     }
 
     // 目标端口（网络字节序）
-    req2[req2_len++] = (unsigned char)((port >> 8) & 0xFF);
-    req2[req2_len++] = (unsigned char)(port & 0xFF);
+    req[req_len++] = (unsigned char)((port >> 8) & 0xFF);
+    req[req_len++] = (unsigned char)(port & 0xFF);
+    size_t connect_len = req_len - connect_off;
+
+    mbedtls_net_context* fd = &client->conn->net_fd;
+    int pipelined = known != SOCKS5_METHOD_UNKNOWN;
+    if (pipelined) {
+        // 方法已知：用户名/密码方法带上认证，无认证方法跳过认证部分
+        if (known == SOCKS5_METHOD_NONE && auth_len > 0) {
+            memmove(req + auth_off, req + connect_off, connect_len);
+            req_len = auth_off + connect_len;
+        }
+        if (httpc_net_send_all(fd, req, req_len) != 0) {
+            fprintf(stderr, u8"SOCKS5代理握手失败: 发送请求失败\n");
+            return HTTPC_ERR_PROXY_CONNECT;
+        }
+    } else if (httpc_net_send_all(fd, req, greeting_len) != 0) {
+        fprintf(stderr, u8"SOCKS5代理握手失败: 发送认证方法选择失败\n");
+        return HTTPC_ERR_PROXY_CONNECT;
+    }
 
-    ret = mbedtls_net_send(&client->net_fd, req2, req2_len);
-    if (ret <= 0) {
-        fprintf(stderr, u8"SOCKS5代理握手失败: 发送连接请求失败\n");
+    unsigned char resp1[2];
+    if (httpc_net_recv_exact(fd, resp1, sizeof(resp1)) != 0) {
+        fprintf(stderr, u8"SOCKS5代理握手失败: 接收认证方法响应失败\n");
+        if (cached) cached->method = SOCKS5_METHOD_UNKNOWN;
+        return HTTPC_ERR_PROXY_CONNECT;
+    }
+
+    if (resp1[0] != 0x05) {
+        fprintf(stderr, u8"SOCKS5代理不支持的版本: 0x%02X\n", resp1[0]);
+        return HTTPC_ERR_PROXY_CONNECT;
+    }
+
+    unsigned char method = resp1[1];
+    if ((method != SOCKS5_METHOD_NONE && (method != SOCKS5_METHOD_USERPASS || !user)) ||
+        (pipelined && method != known)) {
+        if (cached) cached->method = SOCKS5_METHOD_UNKNOWN;  // 代理改变了策略，下次重新协商
+        if (method == 0xFF) {
+            fprintf(stderr, user ? u8"SOCKS5代理拒绝了提供的认证方法\n" : u8"SOCKS5代理需要认证，请在代理地址中提供用户名和密码\n");
+            return HTTPC_ERR_PROXY_AUTH;
+        }
+        fprintf(stderr, u8"SOCKS5代理不支持的认证方法: 0x%02X\n", method);
         return HTTPC_ERR_PROXY_CONNECT;
     }
 
-    // SOCKS5 响应
-    unsigned char resp2[1024];
-    ret = mbedtls_net_recv(&client->net_fd, resp2, 4);
-    if (ret < 4) {
-        fprintf(stderr, u8"SOCKS5代理响应不完整: 只收到 %d 字节\n", ret);
+    if (!pipelined) {
+        // 方法刚协商出来：认证和 CONNECT 一起发送（认证失败时代理会关闭连接，CONNECT 随之作废）
+        size_t off = method == SOCKS5_METHOD_USERPASS ? auth_off : connect_off;
+        if (httpc_net_send_all(fd, req + off, req_len - off) != 0) {
+            fprintf(stderr, u8"SOCKS5代理握手失败: 发送连接请求失败\n");
+            return HTTPC_ERR_PROXY_CONNECT;
+        }
+    }
+
+    if (method == SOCKS5_METHOD_USERPASS) {
+        unsigned char auth_resp[2];
+        if (httpc_net_recv_exact(fd, auth_resp, sizeof(auth_resp)) != 0 || auth_resp[1] != 0x00) {
+            fprintf(stderr, u8"SOCKS5代理认证失败: 用户名或密码错误\n");
+            if (cached) cached->method = SOCKS5_METHOD_UNKNOWN;
+            return HTTPC_ERR_PROXY_AUTH;
+        }
+    }
+    if (user) httpc_proxy_auth_put(auth_key, method);
+
+    // SOCKS5 响应：固定 4 字节 + 地址首字节，其余（地址 + 端口）一次读完
+    unsigned char resp2[4 + 1 + 255 + 2];
+    if (httpc_net_recv_exact(fd, resp2, 5) != 0) {
+        fprintf(stderr, u8"SOCKS5代理响应不完整\n");
         return HTTPC_ERR_PROXY_CONNECT;
     }
 
@@ -407,41 +795,20 @@ static httpc_err_t socks5_handshake(httpc_client_t* client, const char* target_h
         return HTTPC_ERR_PROXY_CONNECT;
     }
 
-    // 解析响应地址
+    // 绑定地址的剩余部分（域名类型的首字节是长度）和端口
     int addr_type = resp2[3];
-    int addr_len = 0;
+    size_t rest;
     if (addr_type == 0x01) {
-        addr_len = 4;  // IPv4
+        rest = 4 - 1 + 2;  // IPv4
     } else if (addr_type == 0x04) {
-        addr_len = 16;  // IPv6
+        rest = 16 - 1 + 2;  // IPv6
     } else if (addr_type == 0x03) {
-        unsigned char domain_len;
-        ret = mbedtls_net_recv(&client->net_fd, &domain_len, 1);
-        if (ret != 1) {
-            return HTTPC_ERR_PROXY_CONNECT;
-        }
-        addr_len = domain_len;
+        rest = (size_t)resp2[4] + 2;  // 域名
     } else {
         fprintf(stderr, u8"SOCKS5代理响应地址类型不支持: 0x%02X\n", addr_type);
         return HTTPC_ERR_PROXY_CONNECT;
     }
-
-    if (addr_len > 0) {
-        unsigned char addr_buf[256];
-        int need_read = addr_len;
-        while (need_read > 0) {
-            ret = mbedtls_net_recv(&client->net_fd, addr_buf, (size_t)need_read);
-            if (ret <= 0) {
-                return HTTPC_ERR_PROXY_CONNECT;
-            }
-            need_read -= ret;
-        }
-    }
-
-    // 解析响应端口
-    unsigned char port_buf[2];
-    ret = mbedtls_net_recv(&client->net_fd, port_buf, 2);
-    if (ret != 2) {
+    if (httpc_net_recv_exact(fd, resp2 + 5, rest) != 0) {
         return HTTPC_ERR_PROXY_CONNECT;
     }
 
@@ -450,6 +817,7 @@ static httpc_err_t socks5_handshake(httpc_client_t* client, const char* target_h
 
 /**
  * @brief HTTP CONNECT代理连接
+ * @note 有凭据时直接带上 Proxy-Authorization（Basic），不等 407 质询，建立隧道只需一个往返
  */
 static httpc_err_t http_connect_proxy(httpc_client_t* client, const char* target_host, const char* target_port, const parsed_proxy_config_t* proxy) {
     if (!client || !target_host || !target_port) {
@@ -465,41 +833,63 @@ static httpc_err_t http_connect_proxy(httpc_client_t* client, const char* target
                           "Proxy-Connection: Keep-Alive\r\n",
                           target_host, target_port,
                           target_host, target_port);
+    if (req_len < 0 || (size_t)req_len >= sizeof(connect_req)) {
+        return HTTPC_ERR_PARAM;
+    }
 
     // 添加代理认证（如果有）
-    if (proxy && proxy->username && proxy->password) {
-        // 使用Base64编码用户名:密码
+    if (proxy && proxy->username) {
+        // Base64 编码 用户名:密码
         char creds[256];
         int creds_len = snprintf(creds, sizeof(creds), "%s:%s",
                                 proxy->username,
-                                proxy->password);
-
-        // 简单的Base64编码（仅用于演示，生产环境需要完整实现）
-        // 这里使用一个简化的实现
-        char b64_creds[512];
-        int b64_len = 0;
-        // 省略Base64编码实现，实际项目中需要补充
+                                proxy->password ? proxy->password : "");
+        unsigned char b64_creds[(sizeof(creds) + 2) / 3 * 4 + 1];
+        size_t b64_len = 0;
+        if (creds_len < 0 || (size_t)creds_len >= sizeof(creds) ||
+            mbedtls_base64_encode(b64_creds, sizeof(b64_creds), &b64_len,
+                                  (const unsigned char*)creds, (size_t)creds_len) != 0) {
+            fprintf(stderr, u8"HTTP代理用户名或密码过长\n");
+            return HTTPC_ERR_PROXY_AUTH;
+        }
 
-        req_len += snprintf(connect_req + req_len, sizeof(connect_req) - req_len,
-                          "Proxy-Authorization: Basic %s\r\n", b64_creds);
+        int n = snprintf(connect_req + req_len, sizeof(connect_req) - req_len,
+                         "Proxy-Authorization: Basic %.*s\r\n", (int)b64_len, (const char*)b64_creds);
+        if (n < 0 || (size_t)n >= sizeof(connect_req) - req_len) {
+            return HTTPC_ERR_PARAM;
+        }
+        req_len += n;
     }
 
-    req_len += snprintf(connect_req + req_len, sizeof(connect_req) - req_len,
-                      "\r\n");
+    int tail = snprintf(connect_req + req_len, sizeof(connect_req) - req_len, "\r\n");
+    if (tail < 0 || (size_t)(req_len + tail) >= sizeof(connect_req)) {
+        return HTTPC_ERR_PARAM;
+    }
+    req_len += tail;
 
-    int ret = mbedtls_net_send(&client->net_fd, (const unsigned char*)connect_req, req_len);
-    if (ret <= 0) {
+    if (httpc_net_send_all(&client->conn->net_fd, (const unsigned char*)connect_req, (size_t)req_len) != 0) {
         fprintf(stderr, u8"HTTP代理连接请求失败: 发送失败\n");
         return HTTPC_ERR_PROXY_CONNECT;
     }
 
-    // 读取代理响应
+    // 读取代理响应头（到空行为止；隧道建立前对端不会发送其他数据）
     char resp_buffer[1024];
-    memset(resp_buffer, 0, sizeof(resp_buffer));
-    ret = mbedtls_net_recv(&client->net_fd, (unsigned char*)resp_buffer, sizeof(resp_buffer) - 1);
-    if (ret <= 0) {
-        fprintf(stderr, u8"HTTP代理响应失败: 接收失败\n");
-        return HTTPC_ERR_PROXY_CONNECT;
+    size_t resp_len = 0;
+    for (;;) {
+        int ret = mbedtls_net_recv(&client->conn->net_fd, (unsigned char*)resp_buffer + resp_len,
+                                   sizeof(resp_buffer) - 1 - resp_len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ) continue;
+        if (ret <= 0) {
+            fprintf(stderr, u8"HTTP代理响应失败: 接收失败\n");
+            return HTTPC_ERR_PROXY_CONNECT;
+        }
+        resp_len += (size_t)ret;
+        resp_buffer[resp_len] = '\0';
+        if (strstr(resp_buffer, "\r\n\r\n")) break;
+        if (resp_len == sizeof(resp_buffer) - 1) {
+            fprintf(stderr, u8"HTTP代理响应头过长\n");
+            return HTTPC_ERR_PROXY_CONNECT;
+        }
     }
 
     // 解析状态码
@@ -518,178 +908,664 @@ static httpc_err_t http_connect_proxy(httpc_client_t* client, const char* target
 }
 
 /**
- * @brief 初始化客户端上下文
+ * @brief 忽略大小写比较前 n 个字符（主机名、头部名用）
  */
-httpc_client_t* httpc_client_init(const httpc_config_t* config) {
-    if (config == NULL || config->server_host == NULL || config->server_port == NULL) {
-        fprintf(stderr, u8"参数非法（服务器地址/端口不能为空）\n");
-        return NULL;
-    }
-
-    // 检查HTTP请求配置
-    if (!config->request && (!config->method || !config->url_path)) {
-        fprintf(stderr, u8"参数非法（必须提供完整request字符串或method+url_path组件）\n");
-        return NULL;
+static int str_nieq(const char* a, const char* b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return 0;
+        if (a[i] == '\0') return 1;
     }
+    return 1;
+}
 
-    // 分配客户端上下文
-    httpc_client_t* client = (httpc_client_t*)calloc(1, sizeof(httpc_client_t));
-    if (client == NULL) {
-        fprintf(stderr, u8"内存分配失败\n");
-        return NULL;
-    }
+static int str_ieq(const char* a, const char* b) {
+    if (!a || !b) return 0;
+    size_t la = strlen(a);
+    return la == strlen(b) && str_nieq(a, b, la);
+}
 
-    // 拷贝配置
-    memcpy(&client->config, config, sizeof(httpc_config_t));
-    client->is_init = 0;
+/**
+ * @brief 有界拷贝（截断并保证终止符，允许源与目标重叠）
+ */
+static char* copy_bounded(char* dst, size_t dst_size, const char* src) {
+    if (src != dst) {
+        size_t n = 0;
+        while (n + 1 < dst_size && src[n]) n++;
+        memmove(dst, src, n);
+        dst[n] = '\0';
+    }
+    return dst;
+}
 
-    // 初始化网络套接字
-    mbedtls_net_init(&client->net_fd);
-
-    // 处理代理连接
-    if (config->proxy && strlen(config->proxy) > 0) {
-        parsed_proxy_config_t parsed_proxy = parse_proxy_string(config->proxy);
-        if (parsed_proxy.enabled) {
-            // 连接代理服务器
-            int ret = mbedtls_net_connect(&client->net_fd, parsed_proxy.host, parsed_proxy.port, MBEDTLS_NET_PROTO_TCP);
-            if (ret != 0) {
-                fprintf(stderr, u8"连接代理服务器 %s:%s 失败: %d\n", parsed_proxy.host, parsed_proxy.port, ret);
-                free_parsed_proxy(&parsed_proxy);
-                free(client);
-                return NULL;
-            }
+/**
+ * @brief 让 config.server_host/server_port/url_path 指向客户端自有缓冲区
+ * @note 重定向目标通常在调用方栈上，拷贝后客户端生命周期内始终有效；允许源与目标重叠
+ */
+static void httpc_own_target(httpc_client_t* client, const char* host, const char* port, const char* path) {
+    if (host) client->config.server_host = copy_bounded(client->target_host, sizeof(client->target_host), host);
+    if (port) client->config.server_port = copy_bounded(client->target_port, sizeof(client->target_port), port);
+    if (path) client->config.url_path = copy_bounded(client->target_path, sizeof(client->target_path), path);
+}
 
-            // 根据代理类型进行握手
-            if (parsed_proxy.type == PROXY_SOCKS5) {
-                httpc_err_t proxy_err = socks5_handshake(client, config->server_host, config->server_port);
-                if (proxy_err != HTTPC_SUCCESS) {
-                    fprintf(stderr, u8"SOCKS5代理连接失败: %d\n", proxy_err);
-                    mbedtls_net_free(&client->net_fd);
-                    free_parsed_proxy(&parsed_proxy);
-                    free(client);
-                    return NULL;
-                }
-            } else if (parsed_proxy.type == PROXY_HTTP_CONNECT) {
-                httpc_err_t proxy_err = http_connect_proxy(client, config->server_host, config->server_port, &parsed_proxy);
-                if (proxy_err != HTTPC_SUCCESS) {
-                    fprintf(stderr, u8"HTTP代理连接失败: %d\n", proxy_err);
-                    mbedtls_net_free(&client->net_fd);
-                    free_parsed_proxy(&parsed_proxy);
-                    free(client);
-                    return NULL;
-                }
-            }
+/**
+ * @brief 永久重定向缓存（301/308，按源站 scheme+host+port 记录）
+ * @note 只缓存"路径不变、仅切换源站"的跳转（如 www.bing.com → cn.bing.com），
+ *       下次 httpc_client_init 直接连接最终主机，省掉一次连接+TLS+往返
+ */
+#define HTTPC_REDIRECT_CACHE_MAX 16
+#define HTTPC_REDIRECT_CACHE_HOPS 4
 
-            free_parsed_proxy(&parsed_proxy);
-        } else {
-            free_parsed_proxy(&parsed_proxy);
-            // 直接连接服务器（TCP）
-            int ret = mbedtls_net_connect(&client->net_fd, config->server_host, config->server_port, MBEDTLS_NET_PROTO_TCP);
-            if (ret != 0) {
-                fprintf(stderr, u8"连接服务器 %s:%s 失败: %d\n", config->server_host, config->server_port, ret);
-                free(client);
-                return NULL;
-            }
-        }
-    } else {
-        // 直接连接服务器（TCP）
-        int ret = mbedtls_net_connect(&client->net_fd, config->server_host, config->server_port, MBEDTLS_NET_PROTO_TCP);
-        if (ret != 0) {
-            fprintf(stderr, u8"连接服务器 %s:%s 失败: %d\n", config->server_host, config->server_port, ret);
-            free(client);
-            return NULL;
+typedef struct {
+    int from_https;
+    char from_host[256];
+    char from_port[8];
+    int to_https;
+    char to_host[256];
+    char to_port[8];
+} redirect_cache_entry_t;
+
+static redirect_cache_entry_t redirect_cache[HTTPC_REDIRECT_CACHE_MAX];
+static int redirect_cache_size = 0;
+static int redirect_cache_next = 0;  // 满了之后按 FIFO 覆盖
+
+static redirect_cache_entry_t* httpc_redirect_cache_find(int is_https, const char* host, const char* port) {
+    for (int i = 0; i < redirect_cache_size; i++) {
+        redirect_cache_entry_t* e = &redirect_cache[i];
+        if (e->from_https == is_https && str_ieq(e->from_host, host) && strcmp(e->from_port, port) == 0) {
+            return e;
         }
     }
+    return NULL;
+}
 
-    // 如果是 HTTPS，初始化 SSL 相关逻辑
-    if (config->is_https) {
-        int ret = httpc_https_init(client);
-        if (ret != HTTPC_SUCCESS) {
-            mbedtls_net_free(&client->net_fd);
-            free(client);
-            return NULL;
-        }
-
-        // 绑定 SSL BIO
-        mbedtls_ssl_set_bio(&client->ssl, &client->net_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
-
-        // SSL 握手
-        ret = 0;
-        while ((ret = mbedtls_ssl_handshake(&client->ssl)) != 0) {
-            if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-                fprintf(stderr, u8"SSL 握手失败: -0x%04x\n", (unsigned int)-ret);
-                mbedtls_net_free(&client->net_fd);
-                free(client);
-                return NULL;
-            }
-        }
+static void httpc_redirect_cache_put(int from_https, const char* from_host, const char* from_port,
+                                     int to_https, const char* to_host, const char* to_port) {
+    if (strlen(from_host) >= sizeof(redirect_cache[0].from_host) || strlen(to_host) >= sizeof(redirect_cache[0].to_host) ||
+        strlen(from_port) >= sizeof(redirect_cache[0].from_port) || strlen(to_port) >= sizeof(redirect_cache[0].to_port)) {
+        return;
+    }
 
-        // 验证服务器证书
-        uint32_t verify_flags = mbedtls_ssl_get_verify_result(&client->ssl);
-        if (verify_flags != 0) {
-            char vrfy_buf[512];
-            mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", verify_flags);
-            fprintf(stderr, u8"服务器证书验证失败: %s\n", vrfy_buf);
-            mbedtls_net_free(&client->net_fd);
-            free(client);
-            return NULL;
-        }
+    redirect_cache_entry_t* e = httpc_redirect_cache_find(from_https, from_host, from_port);
+    if (!e) {
+        e = &redirect_cache[redirect_cache_next];
+        redirect_cache_next = (redirect_cache_next + 1) % HTTPC_REDIRECT_CACHE_MAX;
+        if (redirect_cache_size < HTTPC_REDIRECT_CACHE_MAX) redirect_cache_size++;
     }
 
-    client->is_init = 1;
-    return client;
+    e->from_https = from_https;
+    strcpy(e->from_host, from_host);
+    strcpy(e->from_port, from_port);
+    e->to_https = to_https;
+    strcpy(e->to_host, to_host);
+    strcpy(e->to_port, to_port);
 }
 
 /**
- * @brief 解析HTTP响应头
+ * @brief 按重定向缓存改写连接目标（最多跟随 HTTPC_REDIRECT_CACHE_HOPS 跳，防止环）
  */
-httpc_err_t httpc_parse_response(const char* response_data, httpc_response_t* response) {
-    if (!response_data || !response) {
-        return HTTPC_ERR_PARAM;
+static void httpc_redirect_cache_apply(httpc_client_t* client) {
+    for (int hop = 0; hop < HTTPC_REDIRECT_CACHE_HOPS; hop++) {
+        redirect_cache_entry_t* e = httpc_redirect_cache_find(client->config.is_https,
+            client->config.server_host, client->config.server_port);
+        if (hop == 0) httpc_count_cache("redirect", e != NULL);
+        if (!e) break;
+
+        if (client->config.debug_level) {
+            printf("[REDIRECT] cached: %s://%s:%s -> %s://%s:%s\n",
+                   e->from_https ? "https" : "http", e->from_host, e->from_port,
+                   e->to_https ? "https" : "http", e->to_host, e->to_port);
+        }
+        client->config.is_https = e->to_https;
+        httpc_own_target(client, e->to_host, e->to_port, NULL);
     }
+}
 
-    // 初始化响应结构
-    memset(response, 0, sizeof(httpc_response_t));
+static httpc_err_t httpc_h2_attach(httpc_client_t* client);
+static void httpc_client_disconnect(httpc_client_t* client);
 
-    // 查找状态行 "HTTP/1.1 200 OK"
-    const char* status_line = response_data;
-    while (*status_line && *status_line != '\n') {
-        status_line++;
-    }
+/**
+ * @brief 空闲连接池：按 scheme/主机/端口/代理/CA/ALPN 复用已建立的连接（含代理隧道和 TLS 会话）
+ * @note 客户端释放时，按长度完整读取且未要求关闭的连接放回池中；下一个同目标的
+ *       httpc_client_init（包括重试和重定向）直接接管，省掉 TCP/代理/TLS 握手。
+ *       空闲太久或已被对端关闭的连接取出时丢弃
+ */
+#define HTTPC_POOL_MAX 8
+#define HTTPC_POOL_IDLE_MS 30000    // 服务端通常 60s 左右关闭空闲连接，留足余量
 
-    // 解析状态码 - 查找 "HTTP/1.x XXX" 格式
-    const char* status_start = response_data;
-    // 跳过 "HTTP/"
-    while (*status_start && *status_start != ' ') {
-        status_start++;
-    }
-    // 跳过空格
-    while (*status_start && *status_start == ' ') {
-        status_start++;
-    }
+static httpc_conn_t* httpc_pool[HTTPC_POOL_MAX];
+static int httpc_pool_size = 0;
 
-    if (isdigit(*status_start)) {
-        response->status_code = atoi(status_start);
+static double httpc_now_ms(void) {
+    return xlimit_now_ms();
+}
+
+static void httpc_conn_close(httpc_conn_t* conn) {
+    if (conn->h2) {
+        httpc_h2_close(conn->h2);
+        conn->h2 = NULL;
     }
 
-    // 查找Location头
-    const char* location_pos = strstr(response_data, "\nLocation:");
-    if (location_pos) {
-        location_pos += 10; // 跳过 "\nLocation:"
-        while (*location_pos && isspace(*location_pos)) {
-            location_pos++;
-        }
+    if (conn->is_https) {
+        mbedtls_ssl_close_notify(&conn->ssl);
+        mbedtls_x509_crt_free(&conn->cacert);
+        mbedtls_ssl_free(&conn->ssl);
+        mbedtls_ssl_config_free(&conn->ssl_conf);
+        mbedtls_ctr_drbg_free(&conn->ctr_drbg);
+        mbedtls_entropy_free(&conn->entropy);
+    }
 
-        const char* location_end = location_pos;
-        while (*location_end && *location_end != '\r' && *location_end != '\n') {
-            location_end++;
-        }
+    mbedtls_net_free(&conn->net_fd);
+}
 
-        size_t location_len = location_end - location_pos;
-        if (location_len > 0 && location_len < sizeof(response->location) - 1) {
-            strncpy(response->location, location_pos, location_len);
-            response->location[location_len] = '\0';
-        }
+/**
+ * @brief 连接池和 TLS 会话缓存共用的键：scheme/主机/端口/代理/CA/ALPN
+ * @note 键会出现在调试输出里：代理的 user:pass@ 部分不写入，只用其 FNV-1a 哈希区分不同账号
+ * @return 0 成功，-1 键放不下（key 置为空串：连接不入池，也不缓存 TLS 会话）
+ */
+static int httpc_pool_key(const httpc_config_t* config, char* key, size_t key_size) {
+    const char* proxy = config->proxy ? config->proxy : "";
+    const char* at = strrchr(proxy, '@');
+    uint64_t auth = 0;
+    if (at) {
+        auth = 14695981039346656037ull;
+        for (const char* p = proxy; p < at; p++) auth = (auth ^ (unsigned char)*p) * 1099511628211ull;
+        proxy = at + 1;
+    }
+
+    int n = snprintf(key, key_size, "%s://%s:%s|%s#%016llx|%s|%d", config->is_https ? "https" : "http",
+                     config->server_host, config->server_port, proxy, (unsigned long long)auth,
+                     httpc_ca_path(config) ? httpc_ca_path(config) : "", config->http2 && !config->request);
+    if (n < 0 || (size_t)n >= key_size) {
+        key[0] = '\0';
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 取出一个同键的可用连接（NULL 表示没有）
+ */
+static httpc_conn_t* httpc_pool_take(const char* key) {
+    double now = httpc_now_ms();
+    for (int i = httpc_pool_size - 1; i >= 0; i--) {
+        httpc_conn_t* conn = httpc_pool[i];
+        if (strcmp(conn->key, key) != 0) continue;
+        httpc_pool[i] = httpc_pool[--httpc_pool_size];
+
+        // HTTP/1.1 空闲连接上不应有数据：可读即对端已关闭（或发来了多余数据）
+        int usable = now - conn->idle_since < HTTPC_POOL_IDLE_MS &&
+                     (conn->h2 ? httpc_h2_is_usable(conn->h2)
+                               : mbedtls_net_poll(&conn->net_fd, MBEDTLS_NET_POLL_READ, 0) == 0);
+        if (usable) return conn;
+
+        httpc_conn_close(conn);
+        free(conn);
+    }
+    return NULL;
+}
+
+static void httpc_pool_put(httpc_conn_t* conn) {
+    if (httpc_pool_size == HTTPC_POOL_MAX) {
+        // 池满：关闭最早放入的连接
+        httpc_conn_close(httpc_pool[0]);
+        free(httpc_pool[0]);
+        memmove(httpc_pool, httpc_pool + 1, (HTTPC_POOL_MAX - 1) * sizeof(httpc_pool[0]));
+        httpc_pool_size--;
+    }
+    conn->idle_since = httpc_now_ms();
+    httpc_pool[httpc_pool_size++] = conn;
+}
+
+void httpc_pool_clear(void) {
+    for (int i = 0; i < httpc_pool_size; i++) {
+        httpc_conn_close(httpc_pool[i]);
+        free(httpc_pool[i]);
+    }
+    httpc_pool_size = 0;
+}
+
+/**
+ * @brief TLS 会话缓存：按连接池键保存最近一次握手得到的会话（TLS 1.2 的会话 ID/票据）
+ * @note 新建连接时交给 mbedtls_ssl_set_session，服务端接受即走简短握手：少一个往返，
+ *       并省掉证书链校验和密钥交换的计算。
+ *       服务端不接受时照常完整握手并保存新会话；带缓存会话握手失败的条目丢弃。
+ *       连接池里的连接不需要握手，缓存用于连接被关闭（Connection: close、空闲超时、重试）之后
+ */
+#define HTTPC_TLS_SESSION_MAX 8
+#define HTTPC_TLS_SESSION_TTL_MS 3600000.0  // 票据一般有效数小时，超过 1 小时不再提供
+
+typedef struct {
+    char key[HTTPC_POOL_KEY_LEN];       // 空串表示空闲槽
+    mbedtls_ssl_session session;        // 全零即已初始化（mbedtls_ssl_session_init 只做清零）
+    double saved_at;
+} httpc_tls_session_t;
+
+static httpc_tls_session_t httpc_tls_sessions[HTTPC_TLS_SESSION_MAX];
+static int httpc_tls_session_next = 0;  // 满了之后按 FIFO 覆盖
+
+static httpc_tls_session_t* httpc_tls_session_find(const char* key) {
+    for (int i = 0; i < HTTPC_TLS_SESSION_MAX; i++) {
+        if (strcmp(httpc_tls_sessions[i].key, key) == 0) return &httpc_tls_sessions[i];
+    }
+    return NULL;
+}
+
+static void httpc_tls_session_drop(const char* key) {
+    httpc_tls_session_t* e = httpc_tls_session_find(key);
+    if (!e) return;
+    mbedtls_ssl_session_free(&e->session);
+    mbedtls_ssl_session_init(&e->session);
+    e->key[0] = '\0';
+}
+
+/**
+ * @brief 保存连接当前的会话（同键覆盖）
+ */
+static void httpc_tls_session_save(httpc_conn_t* conn) {
+    if (conn->key[0] == '\0') return;
+
+    httpc_tls_session_t* e = httpc_tls_session_find(conn->key);
+    if (!e) e = httpc_tls_session_find("");
+    if (!e) {
+        e = &httpc_tls_sessions[httpc_tls_session_next];
+        httpc_tls_session_next = (httpc_tls_session_next + 1) % HTTPC_TLS_SESSION_MAX;
+    }
+    mbedtls_ssl_session_free(&e->session);
+    mbedtls_ssl_session_init(&e->session);
+    if (mbedtls_ssl_get_session(&conn->ssl, &e->session) != 0) {
+        e->key[0] = '\0';
+        return;
+    }
+    memcpy(e->key, conn->key, sizeof(e->key));
+    e->saved_at = httpc_now_ms();
+}
+
+/**
+ * @brief 建立 TCP 连接，DNS 解析和 TCP 连接分别计入 phase
+ * @note 先自行解析，再逐个地址交给 mbedtls_net_connect（数字地址不再查询 DNS）；
+ *       解析失败时（如 Windows 上 Winsock 还没初始化）退回由 mbedtls_net_connect 解析，耗时全部计入连接
+ */
+static int httpc_tcp_connect(mbedtls_net_context* fd, const char* host, const char* port, httpc_hop_timing_t* phase) {
+    struct addrinfo hints, *list = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    uint64_t span = xtrace_begin();
+    double t0 = httpc_now_ms();
+    if (getaddrinfo(host, port, &hints, &list) != 0) list = NULL;
+    double t1 = httpc_now_ms();
+    phase->dns_ms += t1 - t0;
+    xtrace_end(span, "http", "dns", "\"host\":\"%s\",\"ok\":%d", host, list != NULL);
+
+    span = xtrace_begin();
+
+    int ret = MBEDTLS_ERR_NET_UNKNOWN_HOST;
+    if (!list) {
+        ret = mbedtls_net_connect(fd, host, port, MBEDTLS_NET_PROTO_TCP);
+    } else {
+        for (struct addrinfo* ai = list; ai != NULL; ai = ai->ai_next) {
+            char numeric[128];
+            if (getnameinfo(ai->ai_addr, (socklen_t)ai->ai_addrlen, numeric, sizeof(numeric),
+                            NULL, 0, NI_NUMERICHOST) != 0) {
+                continue;
+            }
+            ret = mbedtls_net_connect(fd, numeric, port, MBEDTLS_NET_PROTO_TCP);
+            if (ret == 0) break;
+        }
+        freeaddrinfo(list);
+    }
+    phase->connect_ms += httpc_now_ms() - t1;
+    xtrace_end(span, "http", "tcp_connect", "\"host\":\"%s\",\"port\":\"%s\",\"ret\":%d", host, port, ret);
+    return ret;
+}
+
+/**
+ * @brief 分配下一跳的耗时记录，带上客户端建立连接时测得的阶段（之后的请求视为复用连接）
+ * @param local 未配置 timing 或跳数已满时使用的记录（指标总是需要）
+ */
+static httpc_hop_timing_t* httpc_timing_hop(httpc_client_t* client, httpc_hop_timing_t* local) {
+    httpc_timing_t* timing = client->config.timing;
+    httpc_hop_timing_t* hop = timing && timing->hops < HTTPC_TIMING_MAX_HOPS ? &timing->hop[timing->hops++] : local;
+    *hop = client->conn_phase;
+    copy_bounded(hop->host, sizeof(hop->host), client->config.server_host);
+    memset(&client->conn_phase, 0, sizeof(client->conn_phase));
+    client->conn_phase.reused = 1;
+    return hop;
+}
+
+/**
+ * @brief 在已连通的套接字上完成 TLS：初始化、握手、证书校验、ALPN 协商（h2 时建立 HTTP/2 会话）
+ */
+static httpc_err_t httpc_tls_connect(httpc_client_t* client) {
+    int ret;
+    httpc_err_t err = httpc_https_init(client);
+    if (err != HTTPC_SUCCESS) {
+        return err;
+    }
+
+    // 绑定 SSL BIO
+    mbedtls_ssl_set_bio(&client->conn->ssl, &client->conn->net_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    // 有同目标的缓存会话时请求恢复
+    httpc_tls_session_t* cached = client->conn->key[0] ? httpc_tls_session_find(client->conn->key) : NULL;
+    if (cached && httpc_now_ms() - cached->saved_at >= HTTPC_TLS_SESSION_TTL_MS) {
+        httpc_tls_session_drop(client->conn->key);
+        cached = NULL;
+    }
+    if (cached && mbedtls_ssl_set_session(&client->conn->ssl, &cached->session) != 0) {
+        cached = NULL;
+    }
+    httpc_count_cache("tls_session", cached != NULL);
+    if (cached && client->config.debug_level > 0) printf("[DEBUG] offering cached TLS session %s\n", client->conn->key);
+
+    // SSL 握手
+    while ((ret = mbedtls_ssl_handshake(&client->conn->ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            fprintf(stderr, u8"SSL 握手失败: -0x%04x\n", (unsigned int)-ret);
+            if (cached) httpc_tls_session_drop(client->conn->key);  // 下次完整握手
+            return HTTPC_ERR_SSL_HANDSHAKE;
+        }
+    }
+
+    // 验证服务器证书
+    uint32_t verify_flags = mbedtls_ssl_get_verify_result(&client->conn->ssl);
+    if (verify_flags != 0) {
+        char vrfy_buf[512];
+        mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", verify_flags);
+        fprintf(stderr, u8"服务器证书验证失败: %s\n", vrfy_buf);
+        return HTTPC_ERR_SSL_CERT;
+    }
+
+    // 握手完成即保存会话，供下一个连接恢复
+    httpc_tls_session_save(client->conn);
+
+    // ALPN 选中 h2 则建立 HTTP/2 会话，否则保持 HTTP/1.1
+    return httpc_h2_attach(client);
+}
+
+static unsigned httpc_conn_ids = 0;
+
+/**
+ * @brief 建立到 config 中目标主机的连接（代理握手、TLS 握手、ALPN 协商）
+ * @note 优先接管连接池中同目标的连接；失败时已释放本次建立的全部连接资源
+ */
+static httpc_err_t httpc_client_establish(httpc_client_t* client) {
+    const httpc_config_t* config = &client->config;
+    int ret;
+
+    char key[HTTPC_POOL_KEY_LEN];
+    if (httpc_pool_key(config, key, sizeof(key)) != 0 && config->debug_level > 0) {
+        printf("[DEBUG] connection key too long, not pooling this connection\n");
+    }
+    httpc_hop_timing_t* phase = &client->conn_phase;
+    memset(phase, 0, sizeof(*phase));
+
+    httpc_conn_t* pooled = key[0] ? httpc_pool_take(key) : NULL;
+    httpc_count_cache("conn_pool", pooled != NULL);
+    if (pooled) {
+        phase->reused = 1;
+        free(client->conn);
+        client->conn = pooled;
+        client->is_init = 1;
+        client->keep_alive = 1;
+        client->served = 1;  // 复用连接：失效时幂等请求可重发
+        if (config->debug_level > 0) printf("[DEBUG] reusing pooled connection %s\n", key);
+        return HTTPC_SUCCESS;
+    }
+
+    // 初始化网络套接字
+    memset(client->conn, 0, sizeof(*client->conn));
+    memcpy(client->conn->key, key, sizeof(key));
+    client->conn->id = ++httpc_conn_ids;
+    client->conn->is_https = config->is_https;
+    mbedtls_net_init(&client->conn->net_fd);
+
+    // 连接改写只换 TCP/隧道目标，TLS 仍按原主机名校验
+    const char* addr;
+    const char* addr_port;
+    httpc_connect_target(config->server_host, config->server_port, &addr, &addr_port);
+    if (config->debug_level > 0 && (addr != config->server_host || addr_port != config->server_port)) {
+        printf("[DEBUG] connect-to %s:%s -> %s:%s\n", config->server_host, config->server_port, addr, addr_port);
+    }
+
+    // 处理代理连接（解析出的字符串只在握手期间使用）
+    xarena_mark_t proxy_mark = config->arena ? xarena_mark(config->arena) : (xarena_mark_t){ 0 };
+    parsed_proxy_config_t parsed_proxy = parse_proxy_string(config->proxy, config->arena);
+    if (parsed_proxy.enabled) {
+        // 连接代理服务器
+        ret = httpc_tcp_connect(&client->conn->net_fd, parsed_proxy.host, parsed_proxy.port, phase);
+        if (ret != 0) {
+            fprintf(stderr, u8"连接代理服务器 %s:%s 失败: %d\n", parsed_proxy.host, parsed_proxy.port, ret);
+            free_parsed_proxy(&parsed_proxy);
+            if (config->arena) xarena_rewind(config->arena, proxy_mark);
+            return HTTPC_ERR_PROXY_CONNECT;
+        }
+
+        // 根据代理类型进行握手
+        uint64_t span = xtrace_begin();
+        double proxy_start = httpc_now_ms();
+        httpc_err_t proxy_err = HTTPC_SUCCESS;
+        if (parsed_proxy.type == PROXY_SOCKS5) {
+            proxy_err = socks5_handshake(client, addr, addr_port, &parsed_proxy);
+            if (proxy_err != HTTPC_SUCCESS) {
+                fprintf(stderr, u8"SOCKS5代理连接失败: %d\n", proxy_err);
+            }
+        } else if (parsed_proxy.type == PROXY_HTTP_CONNECT) {
+            proxy_err = http_connect_proxy(client, addr, addr_port, &parsed_proxy);
+            if (proxy_err != HTTPC_SUCCESS) {
+                fprintf(stderr, u8"HTTP代理连接失败: %d\n", proxy_err);
+            }
+        }
+        phase->proxy_ms = httpc_now_ms() - proxy_start;
+        xtrace_end(span, "http", "proxy_handshake", "\"conn\":%u,\"proxy\":\"%s\",\"error\":\"%s\"",
+                   client->conn->id, parsed_proxy.type == PROXY_SOCKS5 ? "socks5" : "http",
+                   httpc_err_name(proxy_err));
+        free_parsed_proxy(&parsed_proxy);
+        if (config->arena) xarena_rewind(config->arena, proxy_mark);
+        if (proxy_err != HTTPC_SUCCESS) {
+            mbedtls_net_free(&client->conn->net_fd);
+            return proxy_err;
+        }
+    } else {
+        free_parsed_proxy(&parsed_proxy);
+        if (config->arena) xarena_rewind(config->arena, proxy_mark);
+        // 直接连接服务器（TCP）
+        ret = httpc_tcp_connect(&client->conn->net_fd, addr, addr_port, phase);
+        if (ret != 0) {
+            fprintf(stderr, u8"连接服务器 %s:%s 失败: %d\n", addr, addr_port, ret);
+            return HTTPC_ERR_CONNECT;
+        }
+    }
+
+    client->is_init = 1;
+
+    // 如果是 HTTPS，TLS 握手（失败时已记录耗时，便于定位慢握手/超时）
+    if (config->is_https) {
+        uint64_t span = xtrace_begin();
+        double tls_start = httpc_now_ms();
+        httpc_err_t err = httpc_tls_connect(client);
+        phase->tls_ms = httpc_now_ms() - tls_start;
+        xtrace_end(span, "http", "tls_handshake", "\"conn\":%u,\"host\":\"%s\",\"h2\":%d,\"error\":\"%s\"",
+                   client->conn->id, config->server_host, client->conn->h2 != NULL, httpc_err_name(err));
+        if (err != HTTPC_SUCCESS) {
+            httpc_client_disconnect(client);
+            return err;
+        }
+    }
+
+    return HTTPC_SUCCESS;
+}
+
+/**
+ * @brief 取得连接：接管池中连接或新建，追踪时记为 conn_acquire 区间
+ */
+static httpc_err_t httpc_client_connect(httpc_client_t* client) {
+    uint64_t span = xtrace_begin();
+    httpc_err_t err = httpc_client_establish(client);
+    xtrace_end(span, "http", "conn_acquire", "\"host\":\"%s\",\"conn\":%u,\"reused\":%d,\"error\":\"%s\"",
+               client->config.server_host, client->conn->id, client->conn_phase.reused, httpc_err_name(err));
+    return err;
+}
+
+/**
+ * @brief 断开连接并释放连接相关资源（客户端上下文本身保留，可重新连接）
+ */
+static void httpc_client_disconnect(httpc_client_t* client) {
+    if (!client->is_init) return;
+
+    httpc_conn_close(client->conn);
+    client->is_init = 0;
+    client->keep_alive = 0;
+    client->carry_len = 0;
+    client->served = 0;
+}
+
+/**
+ * @brief 对端拒绝开流（并发上限为 0 或 REFUSED_STREAM）时改用 HTTP/1.1 重新连接
+ * @note ALPN 不再提供 h2，池键随之不同，不会再取回同一个 h2 连接
+ */
+static httpc_err_t httpc_h2_fallback(httpc_client_t* client) {
+    if (client->config.debug_level > 0)
+        printf("[DEBUG] h2 peer refuses streams, falling back to HTTP/1.1\n");
+    httpc_client_disconnect(client);
+    client->config.http2 = 0;
+    return httpc_client_connect(client);
+}
+
+/**
+ * @brief 初始化客户端上下文，*err 返回失败原因（重试层据此区分可重试/致命错误）
+ */
+static httpc_client_t* httpc_client_open(const httpc_config_t* config, httpc_err_t* err) {
+    *err = HTTPC_ERR_PARAM;
+    if (config == NULL || config->server_host == NULL || config->server_port == NULL) {
+        fprintf(stderr, u8"参数非法（服务器地址/端口不能为空）\n");
+        return NULL;
+    }
+
+    // 检查HTTP请求配置
+    if (!config->request && (!config->method || !config->url_path)) {
+        fprintf(stderr, u8"参数非法（必须提供完整request字符串或method+url_path组件）\n");
+        return NULL;
+    }
+
+    // 分配客户端上下文（指定竞技场时从竞技场分配，随竞技场回退释放）
+    *err = HTTPC_ERR_INIT;
+    httpc_client_t* client = config->arena ? (httpc_client_t*)xarena_calloc(config->arena, sizeof(httpc_client_t))
+                                           : (httpc_client_t*)calloc(1, sizeof(httpc_client_t));
+    if (client == NULL) {
+        fprintf(stderr, u8"内存分配失败\n");
+        return NULL;
+    }
+
+    // 连接总在堆上（可能被连接池接管，生命周期长于竞技场）
+    client->conn = (httpc_conn_t*)calloc(1, sizeof(httpc_conn_t));
+    if (client->conn == NULL) {
+        fprintf(stderr, u8"内存分配失败\n");
+        if (!config->arena) free(client);
+        return NULL;
+    }
+
+    // 拷贝配置
+    memcpy(&client->config, config, sizeof(httpc_config_t));
+    client->is_init = 0;
+
+    // 命中永久重定向缓存时直接连接最终主机
+    httpc_redirect_cache_apply(client);
+
+    *err = httpc_client_connect(client);
+    if (*err != HTTPC_SUCCESS) {
+        // 连接失败也记一跳（status 0），耗时落在哪个阶段即失败在哪里
+        httpc_hop_timing_t local;
+        httpc_hop_timing_t* hop = httpc_timing_hop(client, &local);
+        hop->total_ms = hop->dns_ms + hop->connect_ms + hop->proxy_ms + hop->tls_ms;
+        httpc_count_hop(hop, *err);
+        free(client->conn);
+        if (!client->config.arena) free(client);
+        return NULL;
+    }
+    return client;
+}
+
+/**
+ * @brief 初始化客户端上下文
+ */
+httpc_client_t* httpc_client_init(const httpc_config_t* config) {
+    httpc_err_t err;
+    return httpc_client_open(config, &err);
+}
+
+/**
+ * @brief 在头部区域中查找指定头部（大小写不敏感）
+ * @param headers 从状态行开始的响应数据
+ * @param headers_len 可扫描的长度（遇到空行即停止）
+ * @param name 头部名（不含冒号）
+ * @param value_len 输出值长度（已去掉前导空白和行尾）
+ * @return 值的起始位置，未找到返回 NULL
+ */
+static const char* httpc_find_header(const char* headers, size_t headers_len, const char* name, size_t* value_len) {
+    size_t name_len = strlen(name);
+    const char* end = headers + headers_len;
+    const char* line = memchr(headers, '\n', headers_len);  // 跳过状态行
+
+    while (line && ++line < end) {
+        if (*line == '\r' || *line == '\n') break;  // 空行：头部结束
+
+        const char* eol = memchr(line, '\n', (size_t)(end - line));
+        if (!eol) eol = end;
+
+        if ((size_t)(eol - line) > name_len && line[name_len] == ':' && str_nieq(line, name, name_len)) {
+            const char* v = line + name_len + 1;
+            while (v < eol && (*v == ' ' || *v == '\t')) v++;
+            const char* v_end = eol;
+            while (v_end > v && (v_end[-1] == '\r' || v_end[-1] == ' ' || v_end[-1] == '\t')) v_end--;
+            if (value_len) *value_len = (size_t)(v_end - v);
+            return v;
+        }
+        line = eol < end ? eol : NULL;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 解析HTTP响应头
+ */
+httpc_err_t httpc_parse_response(const char* response_data, httpc_response_t* response) {
+    if (!response_data || !response) {
+        return HTTPC_ERR_PARAM;
+    }
+
+    // 初始化响应结构
+    memset(response, 0, sizeof(httpc_response_t));
+
+    // 查找状态行 "HTTP/1.1 200 OK"
+    const char* status_line = response_data;
+    while (*status_line && *status_line != '\n') {
+        status_line++;
+    }
+
+    // 解析状态码 - 查找 "HTTP/1.x XXX" 格式
+    const char* status_start = response_data;
+    // 跳过 "HTTP/"
+    while (*status_start && *status_start != ' ') {
+        status_start++;
+    }
+    // 跳过空格
+    while (*status_start && *status_start == ' ') {
+        status_start++;
+    }
+
+    if (isdigit(*status_start)) {
+        response->status_code = atoi(status_start);
+    }
+
+    // 查找Location头（头部名大小写不敏感）
+    size_t location_len = 0;
+    const char* location_pos = httpc_find_header(response_data, strlen(response_data), "Location", &location_len);
+    if (location_pos && location_len > 0 && location_len < sizeof(response->location) - 1) {
+        memcpy(response->location, location_pos, location_len);
+        response->location[location_len] = '\0';
     }
 
     // 查找头部和内容的分界 "\r\n\r\n"
@@ -708,256 +1584,1301 @@ httpc_err_t httpc_parse_response(const char* response_data, httpc_response_t* re
 }
 
 /**
- * @brief 从URL解析主机和路径
+ * @brief 从URL解析主机、端口和路径
+ * @note 端口缺省时按协议取 443/80；支持 [IPv6]:port 形式
  */
-static httpc_err_t parse_url(const char* url, char* host, size_t host_len, char* path, size_t path_len, int* is_https) {
-    if (!url || !host || !path || !is_https) {
+static httpc_err_t parse_url(const char* url, char* host, size_t host_len, char* port, size_t port_len,
+                             char* path, size_t path_len, int* is_https) {
+    if (!url || !host || !port || !path || !is_https) {
         return HTTPC_ERR_PARAM;
     }
 
     // 默认值
     *is_https = 0;
     host[0] = '\0';
+    port[0] = '\0';
     path[0] = '\0';
 
     // 跳过协议
     const char* url_start = url;
-    if (strncmp(url_start, "https://", 8) == 0) {
+    if (str_nieq(url_start, "https://", 8)) {
         *is_https = 1;
         url_start += 8;
-    } else if (strncmp(url_start, "http://", 7) == 0) {
+    } else if (str_nieq(url_start, "http://", 7)) {
         url_start += 7;
+    } else {
+        return HTTPC_ERR_PARAM;
     }
 
-    // 提取主机名
+    // 提取 authority（主机[:端口]）和路径
     const char* host_start = url_start;
-    const char* host_end = strchr(host_start, '/');
-
-    size_t host_len_actual;
-    if (host_end) {
-        host_len_actual = host_end - host_start;
-        // 提取路径
-        strncpy(path, host_end, path_len - 1);
-        path[path_len - 1] = '\0';
+    const char* authority_end = host_start + strcspn(host_start, "/?#");
+    if (strlen(authority_end) + 2 > path_len) {
+        return HTTPC_ERR_PARAM;  // 路径放不下：截断会请求错误的资源
+    }
+    copy_bounded(path, path_len, *authority_end == '/' ? authority_end : "/");
+    if (*authority_end == '?') {
+        // "https://host?q" → "/?q"
+        snprintf(path, path_len, "/%s", authority_end);
+    }
+
+    const char* host_end = authority_end;
+    const char* port_start = NULL;
+    if (*host_start == '[') {
+        const char* bracket = memchr(host_start, ']', (size_t)(authority_end - host_start));
+        if (!bracket) return HTTPC_ERR_PARAM;
+        host_start++;
+        host_end = bracket;
+        if (bracket + 1 < authority_end && bracket[1] == ':') port_start = bracket + 2;
     } else {
-        host_len_actual = strlen(host_start);
-        strncpy(path, "/", path_len - 1);
-        path[path_len - 1] = '\0';
+        const char* colon = memchr(host_start, ':', (size_t)(authority_end - host_start));
+        if (colon) {
+            host_end = colon;
+            port_start = colon + 1;
+        }
     }
 
-    if (host_len_actual >= host_len) {
+    size_t host_len_actual = (size_t)(host_end - host_start);
+    if (host_len_actual == 0 || host_len_actual >= host_len) {
         return HTTPC_ERR_PARAM;
     }
-
-    strncpy(host, host_start, host_len_actual);
+    memcpy(host, host_start, host_len_actual);
     host[host_len_actual] = '\0';
 
+    if (port_start && port_start < authority_end) {
+        size_t n = (size_t)(authority_end - port_start);
+        if (n >= port_len) return HTTPC_ERR_PARAM;
+        memcpy(port, port_start, n);
+        port[n] = '\0';
+    } else {
+        copy_bounded(port, port_len, *is_https ? "443" : "80");
+    }
+
     return HTTPC_SUCCESS;
 }
 
+/**
+ * @brief 请求分段（指向静态片段、配置中的字符串或调用方的请求体，不拷贝）
+ */
+typedef struct {
+    const void* base;
+    size_t len;
+} httpc_seg_t;
+
+#define HTTPC_REQUEST_SEGS_MAX 24
+
+static const char HTTPC_DEFAULT_UA[] =
+    "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0.0) Safari/537.36";
+
+static void httpc_seg_add(httpc_seg_t* segs, size_t* n, const void* base, size_t len) {
+    if (len > 0) {
+        segs[*n].base = base;
+        segs[*n].len = len;
+        (*n)++;
+    }
+}
+
+#define HTTPC_SEG_LIT(segs, n, lit) httpc_seg_add(segs, n, lit, sizeof(lit) - 1)
+#define HTTPC_SEG_STR(segs, n, str) httpc_seg_add(segs, n, str, strlen(str))
+
+/**
+ * @brief 把请求拆成分段（请求行、Host、各头部、请求体）
+ * @param num_buf Content-Length 数字的存放处（调用方栈上，至少 24 字节）
+ * @return 分段个数，0 表示配置不完整
+ */
+static size_t httpc_request_segments(const httpc_config_t* config, httpc_seg_t* segs, char* num_buf) {
+    size_t n = 0;
+
+    // 模式2：完整请求字符串原样发送
+    if (config->request) {
+        HTTPC_SEG_STR(segs, &n, config->request);
+        return n;
+    }
+
+    // 模式1：按组件拼接
+    if (!config->method || !config->url_path) {
+        return 0;
+    }
+
+    // 请求行 + Host 头部
+    HTTPC_SEG_STR(segs, &n, config->method);
+    HTTPC_SEG_LIT(segs, &n, " ");
+    HTTPC_SEG_STR(segs, &n, config->url_path);
+    HTTPC_SEG_LIT(segs, &n, " HTTP/1.1\r\nHost: ");
+    HTTPC_SEG_STR(segs, &n, config->server_host);
+
+    // Connection头部（保持连接，便于同源重定向复用）+ User-Agent头部
+    HTTPC_SEG_LIT(segs, &n, "\r\nConnection: keep-alive\r\nUser-Agent: ");
+    HTTPC_SEG_STR(segs, &n, config->user_agent ? config->user_agent : HTTPC_DEFAULT_UA);
+    HTTPC_SEG_LIT(segs, &n, "\r\n");
+
+    // Content-Type/Content-Length头部（如果有数据）
+    size_t data_len = config->data ? (config->data_length > 0 ? config->data_length : strlen(config->data)) : 0;
+    if (data_len > 0) {
+        HTTPC_SEG_LIT(segs, &n, "Content-Type: ");
+        HTTPC_SEG_STR(segs, &n, config->content_type ? config->content_type : "application/x-www-form-urlencoded");
+        HTTPC_SEG_LIT(segs, &n, "\r\nContent-Length: ");
+        int num_len = snprintf(num_buf, 24, "%zu", data_len);
+        httpc_seg_add(segs, &n, num_buf, (size_t)num_len);
+        HTTPC_SEG_LIT(segs, &n, "\r\n");
+    }
+
+    // 额外头部
+    if (config->extra_headers && config->extra_headers[0]) {
+        HTTPC_SEG_STR(segs, &n, config->extra_headers);
+        HTTPC_SEG_LIT(segs, &n, "\r\n");
+    }
+
+    // 结束头部 + 请求体（直接引用调用方数据）
+    HTTPC_SEG_LIT(segs, &n, "\r\n");
+    httpc_seg_add(segs, &n, config->data, data_len);
+    return n;
+}
+
 /**
  * @brief 动态拼接HTTP请求字符串
+ * @note 内部发送走分段路径，不再调用本函数；保留给需要完整请求文本的调用方
  */
 char* httpc_build_request(const httpc_config_t* config) {
     if (!config) {
         return NULL;
     }
 
-    // 模式2：如果提供了完整请求字符串，直接复制
-    if (config->request) {
-        char* request = malloc(strlen(config->request) + 1);
-        if (!request) {
-            return NULL;
-        }
-        strcpy(request, config->request);
-        return request;
+    httpc_seg_t segs[HTTPC_REQUEST_SEGS_MAX];
+    char num_buf[24];
+    size_t n = httpc_request_segments(config, segs, num_buf);
+    if (n == 0) {
+        return NULL;
     }
 
-    // 模式1：动态构建请求
-    if (!config->method || !config->url_path) {
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) total += segs[i].len;
+
+    char* request = malloc(total + 1);
+    if (!request) {
         return NULL;
     }
 
-    // 计算所需缓冲区大小
-    size_t buffer_size = 4096; // 基础大小
-    if (config->data && config->data_length > 0) {
-        buffer_size += config->data_length + 1024; // 额外空间给数据和其他头部
+    size_t pos = 0;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(request + pos, segs[i].base, segs[i].len);
+        pos += segs[i].len;
     }
-    if (config->extra_headers) {
-        buffer_size += strlen(config->extra_headers) + 256;
+    request[pos] = '\0';
+    return request;
+}
+
+/**
+ * @brief 底层发送（HTTPS/HTTP 统一，处理部分写入）
+ */
+static int httpc_send_all(httpc_conn_t* conn, const unsigned char* buf, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        int ret;
+        if (conn->is_https) {
+            ret = mbedtls_ssl_write(&conn->ssl, buf + sent, len - sent);
+        } else {
+            ret = mbedtls_net_send(&conn->net_fd, buf + sent, len - sent);
+        }
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (ret <= 0) {
+            return ret == 0 ? -1 : ret;
+        }
+        sent += (size_t)ret;
     }
+    return (int)sent;
+}
 
-    char* request = malloc(buffer_size);
-    if (!request) {
-        return NULL;
+/**
+ * @brief 发送请求分段
+ * @note 明文连接用 writev/WSASend 一次系统调用发出全部分段；
+ *       TLS 连接把分段拼进一个记录大小的栈缓冲区，每满一个记录调用一次 mbedtls_ssl_write，
+ *       已对齐记录边界的大块请求体直接从调用方缓冲区发送。全程无堆分配。
+ */
+#define HTTPC_TLS_RECORD_LEN 16384   // TLS 单个记录最大明文长度
+
+static int httpc_send_segments(httpc_client_t* client, const httpc_seg_t* segs, size_t n) {
+    size_t total = 0;
+
+    if (client->conn->is_https) {
+        unsigned char record[HTTPC_TLS_RECORD_LEN];
+        size_t fill = 0;
+        for (size_t i = 0; i < n; i++) {
+            const unsigned char* p = (const unsigned char*)segs[i].base;
+            size_t left = segs[i].len;
+            while (left > 0) {
+                if (fill == 0 && left >= sizeof(record)) {
+                    size_t k = left - left % sizeof(record);
+                    int ret = httpc_send_all(client->conn, p, k);
+                    if (ret <= 0) return ret;
+                    p += k;
+                    left -= k;
+                    continue;
+                }
+                size_t k = sizeof(record) - fill;
+                if (k > left) k = left;
+                memcpy(record + fill, p, k);
+                fill += k;
+                p += k;
+                left -= k;
+                if (fill == sizeof(record)) {
+                    int ret = httpc_send_all(client->conn, record, fill);
+                    if (ret <= 0) return ret;
+                    fill = 0;
+                }
+            }
+            total += segs[i].len;
+        }
+        if (fill > 0) {
+            int ret = httpc_send_all(client->conn, record, fill);
+            if (ret <= 0) return ret;
+        }
+        return (int)total;
+    }
+
+#ifdef _WIN32
+    WSABUF bufs[HTTPC_REQUEST_SEGS_MAX];
+    for (size_t i = 0; i < n; i++) {
+        bufs[i].buf = (CHAR*)segs[i].base;
+        bufs[i].len = (ULONG)segs[i].len;
+        total += segs[i].len;
+    }
+    DWORD sent = 0;
+    size_t idx = 0;
+    while (idx < n) {
+        if (WSASend((SOCKET)client->conn->net_fd.fd, bufs + idx, (DWORD)(n - idx), &sent, 0, NULL, NULL) != 0) {
+            return MBEDTLS_ERR_NET_SEND_FAILED;
+        }
+        size_t w = sent;
+        while (idx < n && w >= bufs[idx].len) {
+            w -= bufs[idx].len;
+            idx++;
+        }
+        if (idx < n) {
+            bufs[idx].buf += w;
+            bufs[idx].len -= (ULONG)w;
+        }
+    }
+#else
+    struct iovec iov[HTTPC_REQUEST_SEGS_MAX];
+    for (size_t i = 0; i < n; i++) {
+        iov[i].iov_base = (void*)segs[i].base;
+        iov[i].iov_len = segs[i].len;
+        total += segs[i].len;
+    }
+    size_t idx = 0;
+    while (idx < n) {
+        ssize_t w = writev(client->conn->net_fd.fd, iov + idx, (int)(n - idx));
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return MBEDTLS_ERR_NET_SEND_FAILED;
+        }
+        while (idx < n && (size_t)w >= iov[idx].iov_len) {
+            w -= (ssize_t)iov[idx].iov_len;
+            idx++;
+        }
+        if (idx < n) {
+            iov[idx].iov_base = (char*)iov[idx].iov_base + w;
+            iov[idx].iov_len -= (size_t)w;
+        }
+    }
+#endif
+    return (int)total;
+}
+
+/**
+ * @brief 底层接收（HTTPS/HTTP 统一，屏蔽 WANT_READ/WANT_WRITE）
+ * @return >0 读取字节数，0 连接关闭，<0 错误
+ */
+static int httpc_recv_some(httpc_conn_t* conn, unsigned char* buf, size_t len) {
+    int ret;
+    do {
+        if (conn->is_https) {
+            ret = mbedtls_ssl_read(&conn->ssl, buf, len);
+        } else {
+            ret = mbedtls_net_recv(&conn->net_fd, buf, len);
+        }
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+    if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+        return 0;
+    }
+    httpc_count_bytes(0, ret);
+    return ret;
+}
+
+static int httpc_h2_io_send(void* ctx, const unsigned char* buf, size_t len) {
+    int ret = httpc_send_all((httpc_conn_t*)ctx, buf, len);
+    httpc_count_bytes(1, ret);
+    return ret;
+}
+
+static int httpc_h2_io_recv(void* ctx, unsigned char* buf, size_t len) {
+    return httpc_recv_some((httpc_conn_t*)ctx, buf, len);
+}
+
+/**
+ * @brief TLS 握手后检查 ALPN 结果，选中 h2 时建立 HTTP/2 会话
+ */
+static httpc_err_t httpc_h2_attach(httpc_client_t* client) {
+#if defined(MBEDTLS_SSL_ALPN)
+    const char* alpn = mbedtls_ssl_get_alpn_protocol(&client->conn->ssl);
+    if (!alpn || strcmp(alpn, "h2") != 0) {
+        return HTTPC_SUCCESS;
+    }
+
+    // :authority 使用默认端口时省略端口，IPv6 字面量加方括号
+    char authority[300];
+    int is_ipv6 = strchr(client->config.server_host, ':') != NULL;
+    if (strcmp(client->config.server_port, "443") == 0) {
+        snprintf(authority, sizeof(authority), is_ipv6 ? "[%s]" : "%s", client->config.server_host);
+    } else {
+        snprintf(authority, sizeof(authority), is_ipv6 ? "[%s]:%s" : "%s:%s",
+                 client->config.server_host, client->config.server_port);
+    }
+
+    httpc_h2_io_t io = { client->conn, httpc_h2_io_send, httpc_h2_io_recv };
+    client->conn->h2 = httpc_h2_open(&io, authority, client->config.debug_level);
+    if (!client->conn->h2) {
+        fprintf(stderr, u8"HTTP/2 会话建立失败\n");
+        return HTTPC_ERR_INIT;
+    }
+    if (client->config.debug_level > 0) {
+        printf("[DEBUG] ALPN negotiated h2 with %s\n", authority);
+    }
+#else
+    (void)client;
+#endif
+    return HTTPC_SUCCESS;
+}
+
+/**
+ * @brief HTTP/1.1 响应分帧信息（内部使用）
+ */
+typedef struct {
+    size_t header_length;     // 头部长度（含 \r\n\r\n）
+    int status_code;          // 状态码
+    int no_body;              // 1xx/204/304/HEAD：没有响应体
+    int chunked;              // Transfer-Encoding: chunked
+    int has_length;           // 有 Content-Length
+    size_t content_length;    // Content-Length 值
+    int conn_close;           // 服务端要求关闭（或 HTTP/1.0 未声明 keep-alive）
+} httpc_frame_t;
+
+/**
+ * @brief 解析响应头部分帧信息
+ * @return 1 头部完整，0 头部尚未收全
+ */
+static int httpc_parse_frame(const char* buf, int is_head, httpc_frame_t* frame) {
+    const char* header_end = strstr(buf, "\r\n\r\n");
+    if (!header_end) {
+        return 0;
+    }
+
+    memset(frame, 0, sizeof(*frame));
+    frame->header_length = (size_t)(header_end - buf) + 4;
+
+    const char* sp = memchr(buf, ' ', frame->header_length);
+    if (sp && isdigit((unsigned char)sp[1])) {
+        frame->status_code = atoi(sp + 1);
+    }
+
+    size_t value_len = 0;
+    const char* value = httpc_find_header(buf, frame->header_length, "Connection", &value_len);
+    int is_http10 = strncmp(buf, "HTTP/1.0", 8) == 0;
+    if (value) {
+        frame->conn_close = str_nieq(value, "close", 5) && value_len == 5;
+        if (is_http10 && !(value_len == 10 && str_nieq(value, "keep-alive", 10))) frame->conn_close = 1;
+    } else {
+        frame->conn_close = is_http10;
+    }
+
+    value = httpc_find_header(buf, frame->header_length, "Transfer-Encoding", &value_len);
+    if (value && value_len >= 7 && str_nieq(value + value_len - 7, "chunked", 7)) {
+        frame->chunked = 1;
+    }
+
+    value = httpc_find_header(buf, frame->header_length, "Content-Length", &value_len);
+    if (value && !frame->chunked && isdigit((unsigned char)*value)) {
+        frame->has_length = 1;
+        frame->content_length = (size_t)strtoull(value, NULL, 10);
+    }
+
+    frame->no_body = is_head || (frame->status_code >= 100 && frame->status_code < 200) ||
+                     frame->status_code == 204 || frame->status_code == 304;
+    return 1;
+}
+
+#define HTTPC_CHUNK_LINE_MAX 1024   // 块大小行（含块扩展）的最大长度
+#define HTTPC_CHUNK_SIZE_MAX ((size_t)1 << 31)  // 单块上限：更大的块大小视为格式错误（32 位下加上偏移也不会回绕）
+
+/**
+ * @brief 解析块大小行（十六进制，之后可跟 ";扩展"）
+ * @param len 行长度（不含 '\n'）
+ * @return 0 成功，-1 格式错误、行过长或大小超过 HTTPC_CHUNK_SIZE_MAX
+ */
+static int httpc_chunk_size(const char* line, size_t len, size_t* size) {
+    if (len > HTTPC_CHUNK_LINE_MAX) return -1;
+    size_t v = 0, i = 0;
+    for (; i < len; i++) {
+        int c = (unsigned char)line[i], d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else break;
+        if (v > (HTTPC_CHUNK_SIZE_MAX - (size_t)d) / 16) return -1;
+        v = v * 16 + (size_t)d;
+    }
+    if (i == 0) return -1;
+    if (i < len && line[i] != ';' && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') return -1;
+    *size = v;
+    return 0;
+}
+
+/**
+ * @brief 检查 chunked 响应体是否接收完整
+ * @return 1 完整（*msg_len 为响应体原始长度），0 未完整，-1 格式错误
+ */
+static int httpc_chunked_complete(const char* body, size_t avail, size_t* msg_len) {
+    size_t pos = 0;
+    for (;;) {
+        const char* eol = pos < avail ? memchr(body + pos, '\n', avail - pos) : NULL;
+        if (!eol) return avail - pos > HTTPC_CHUNK_LINE_MAX ? -1 : 0;
+
+        size_t chunk;
+        if (httpc_chunk_size(body + pos, (size_t)(eol - (body + pos)), &chunk) != 0) return -1;
+
+        pos = (size_t)(eol - body) + 1;
+        if (chunk == 0) {
+            // 终止块之后：可选 trailer，最后一个空行结束
+            for (;;) {
+                const char* trailer_eol = pos < avail ? memchr(body + pos, '\n', avail - pos) : NULL;
+                if (!trailer_eol) return 0;
+                size_t line_len = (size_t)(trailer_eol - (body + pos));
+                pos = (size_t)(trailer_eol - body) + 1;
+                if (line_len == 0 || (line_len == 1 && body[pos - 2] == '\r')) {
+                    *msg_len = pos;
+                    return 1;
+                }
+            }
+        }
+
+        if (chunk > avail - pos || avail - pos - chunk < 2) return 0;  // 数据 + CRLF 还没收全
+        pos += chunk + 2;
+    }
+}
+
+/**
+ * @brief 原地去掉 chunked 编码
+ * @param out_len 解码后的响应体长度
+ * @return 0 成功，-1 块大小行格式错误
+ */
+static int httpc_dechunk(char* body, size_t len, size_t* out_len) {
+    size_t in = 0, out = 0;
+    int ret = 0;
+    while (in < len) {
+        const char* eol = memchr(body + in, '\n', len - in);
+        if (!eol) break;
+
+        size_t chunk;
+        if (httpc_chunk_size(body + in, (size_t)(eol - (body + in)), &chunk) != 0) {
+            ret = -1;
+            break;
+        }
+        in = (size_t)(eol - body) + 1;
+        if (chunk == 0) break;
+
+        size_t n = chunk;
+        if (n > len - in) n = len - in;  // 截断的响应：保留已有部分
+        memmove(body + out, body + in, n);
+        out += n;
+        in += n;
+        in += len - in < 2 ? len - in : 2;  // CRLF
+    }
+    body[out] = '\0';
+    *out_len = out;
+    return ret;
+}
+
+/**
+ * @brief 响应体回调进度
+ */
+typedef struct {
+    size_t raw_pos;           // 已处理的原始响应体字节（含 chunked 编码）
+    size_t chunk_left;        // chunked：当前块剩余数据
+    size_t skip;              // chunked：块数据之后待跳过的 CRLF
+    int done;                 // chunked：已到终止块
+} httpc_body_feed_t;
+
+/**
+ * @brief 把新到达的响应体交给 on_body（chunked 边解码边回调）
+ * @return 1 回调要求停止，0 继续，-1 块大小行格式错误
+ */
+static int httpc_body_feed(httpc_client_t* client, httpc_body_feed_t* feed, const httpc_frame_t* frame,
+                           const char* body, size_t avail) {
+    int (*on_body)(void*, const char*, size_t) = client->config.on_body;
+    void* ctx = client->config.on_body_ctx;
+
+    if (!frame->chunked) {
+        size_t end = avail;
+        if (frame->has_length && end > frame->content_length) end = frame->content_length;
+        if (end <= feed->raw_pos) return 0;
+        size_t start = feed->raw_pos;
+        feed->raw_pos = end;
+        return on_body(ctx, body + start, end - start) != 0;
+    }
+
+    while (!feed->done && feed->raw_pos < avail) {
+        if (feed->chunk_left > 0) {
+            size_t n = avail - feed->raw_pos;
+            if (n > feed->chunk_left) n = feed->chunk_left;
+            size_t start = feed->raw_pos;
+            feed->raw_pos += n;
+            feed->chunk_left -= n;
+            if (feed->chunk_left == 0) feed->skip = 2;
+            if (on_body(ctx, body + start, n)) return 1;
+        } else if (feed->skip > 0) {
+            feed->raw_pos++;
+            feed->skip--;
+        } else {
+            const char* eol = memchr(body + feed->raw_pos, '\n', avail - feed->raw_pos);
+            if (!eol) {
+                if (avail - feed->raw_pos > HTTPC_CHUNK_LINE_MAX) return -1;
+                break;
+            }
+            size_t chunk;
+            if (httpc_chunk_size(body + feed->raw_pos, (size_t)(eol - (body + feed->raw_pos)), &chunk) != 0) return -1;
+            feed->raw_pos = (size_t)(eol - body) + 1;
+            feed->chunk_left = chunk;
+            if (chunk == 0) feed->done = 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 接收一个完整的 HTTP/1.1 响应（按 Content-Length/chunked 分帧，chunked 原地解码）
+ * @note 能按长度完整读到响应且服务端未要求关闭时置 client->keep_alive，连接可继续发送请求；
+ *       流水线模式下多读到的下一个响应的开头保存在 client->carry，下次读取时先消费
+ */
+static httpc_err_t httpc_read_response(httpc_client_t* client, char* resp_buf, size_t resp_buf_len, size_t* actual_read) {
+    int is_head = client->config.method && strcmp(client->config.method, "HEAD") == 0;
+    httpc_frame_t frame;
+    httpc_body_feed_t feed = {0};
+    int feed_body = 0;
+    int have_header = 0;
+    int complete = 0;
+    size_t total_read = 0;
+    size_t msg_len = 0;       // 当前响应的原始长度（含头部，chunked 未解码）
+
+    client->keep_alive = 0;
+    resp_buf[0] = '\0';
+
+    // 先取出上一个响应之后多读的数据
+    if (client->carry_len > 0) {
+        total_read = client->carry_len < resp_buf_len - 1 ? client->carry_len : resp_buf_len - 1;
+        memcpy(resp_buf, client->carry, total_read);
+        resp_buf[total_read] = '\0';
+        client->carry_len -= total_read;
+        memmove(client->carry, client->carry + total_read, client->carry_len);
+        client->first_byte_at = httpc_now_ms();
+    }
+
+    for (;;) {
+        if (!have_header && total_read > 0 && httpc_parse_frame(resp_buf, is_head, &frame)) {
+            if (strncmp(resp_buf, "HTTP/1.", 7) != 0) {
+                // 不是 HTTP/1.x 状态行：流已错位（常见于不支持流水线的服务端）
+                fprintf(stderr, u8"响应状态行非法\n");
+                return HTTPC_ERR_PARSE;
+            }
+            if (frame.status_code >= 100 && frame.status_code < 200 && frame.status_code != 101) {
+                // 100 Continue 等中间响应：丢弃后继续等最终响应
+                total_read -= frame.header_length;
+                memmove(resp_buf, resp_buf + frame.header_length, total_read + 1);
+                continue;
+            }
+            have_header = 1;
+            feed_body = client->config.on_body && !frame.no_body &&
+                        frame.status_code >= 200 && frame.status_code < 300;
+        }
+
+        if (have_header) {
+            size_t body_avail = total_read - frame.header_length;
+            int fed = feed_body ? httpc_body_feed(client, &feed, &frame, resp_buf + frame.header_length, body_avail) : 0;
+            if (fed < 0) {
+                fprintf(stderr, u8"chunked 块大小格式错误\n");
+                return HTTPC_ERR_PARSE;
+            }
+            if (fed) {
+                // 调用方已拿到所需内容：剩余数据不再接收，连接不可复用
+                if (client->config.debug_level > 0)
+                    printf("[DEBUG] Body callback finished early after %zu bytes.\n", total_read);
+                break;
+            }
+            if (frame.no_body) {
+                complete = 1;
+                msg_len = frame.header_length;
+            } else if (frame.has_length) {
+                complete = body_avail >= frame.content_length;
+                msg_len = frame.header_length + frame.content_length;
+            } else if (frame.chunked) {
+                size_t chunked_len = 0;
+                int st = httpc_chunked_complete(resp_buf + frame.header_length, body_avail, &chunked_len);
+                if (st < 0) {
+                    fprintf(stderr, u8"chunked 块大小格式错误\n");
+                    return HTTPC_ERR_PARSE;
+                }
+                complete = st;
+                msg_len = frame.header_length + chunked_len;
+            }
+            if (complete) break;
+        }
+
+        size_t read_len = resp_buf_len - total_read - 1; // 留空终止符
+        if (read_len == 0) break;  // 缓冲区满：截断
+
+        int ret = httpc_recv_some(client->conn, (unsigned char*)(resp_buf + total_read), read_len);
+        if (ret == 0) {
+            if (total_read == 0) {
+                // 一个字节都没收到就关闭（复用的连接已被服务端关闭，或流水线中途断开）
+                return HTTPC_ERR_READ;
+            }
+            break; // 连接关闭
+        }
+        if (ret < 0) {
+            fprintf(stderr, u8"接收响应失败: %d\n", ret);
+            return HTTPC_ERR_READ;
+        }
+
+        if (client->first_byte_at == 0) client->first_byte_at = httpc_now_ms();
+        total_read += ret;
+        resp_buf[total_read] = '\0';
+    }
+
+    if (have_header && complete) {
+        client->keep_alive = !frame.conn_close;
+        client->served++;
+
+        // 超出本响应的部分属于下一个响应
+        if (total_read > msg_len && client->keep_alive) {
+            size_t extra = total_read - msg_len;
+            if (client->carry_len + extra > client->carry_cap) {
+                size_t cap = client->carry_len + extra;
+                char* nb;
+                if (client->config.arena) {
+                    nb = (char*)xarena_alloc(client->config.arena, cap);
+                    if (nb && client->carry_len) memcpy(nb, client->carry, client->carry_len);
+                } else {
+                    nb = (char*)realloc(client->carry, cap);
+                }
+                if (!nb) return HTTPC_ERR_READ;
+                client->carry = nb;
+                client->carry_cap = cap;
+            }
+            memmove(client->carry + extra, client->carry, client->carry_len);
+            memcpy(client->carry, resp_buf + msg_len, extra);
+            client->carry_len += extra;
+        }
+        total_read = msg_len;
+    }
+    if (have_header && frame.chunked && !frame.no_body) {
+        size_t body_len = 0;
+        int bad = httpc_dechunk(resp_buf + frame.header_length, total_read - frame.header_length, &body_len);
+        total_read = frame.header_length + body_len;
+        if (bad) {
+            client->keep_alive = 0;
+            resp_buf[total_read] = '\0';
+            fprintf(stderr, u8"chunked 块大小格式错误\n");
+            return HTTPC_ERR_PARSE;
+        }
+    }
+    resp_buf[total_read] = '\0';
+
+    if (actual_read != NULL) {
+        *actual_read = total_read;
+    }
+    return HTTPC_SUCCESS;
+}
+
+/**
+ * @brief 按当前配置构建并发送一个 HTTP/1.1 请求（不等待响应）
+ */
+static httpc_err_t httpc_send_request(httpc_client_t* client) {
+    httpc_seg_t segs[HTTPC_REQUEST_SEGS_MAX];
+    char num_buf[24];
+    size_t n = httpc_request_segments(&client->config, segs, num_buf);
+    if (n == 0) {
+        fprintf(stderr, "Failed to build HTTP request\n");
+        return HTTPC_ERR_PARAM;
+    }
+
+    // 只发送请求本身：多发的终止符在 keep-alive 连接上会被当成下一个请求的开头
+    if (client->config.debug_level > 0) {
+        size_t req_len = 0;
+        for (size_t i = 0; i < n; i++) req_len += segs[i].len;
+        printf("[DEBUG] http request sending, len=%d: \n", (int)req_len);
+        for (size_t i = 0; i < n; i++) printf("%.*s", (int)segs[i].len, (const char*)segs[i].base);
+        printf("\n");
+    }
+
+    int ret = httpc_send_segments(client, segs, n);
+    if (ret <= 0) {
+        fprintf(stderr, u8"%s 发送失败: %d\n", client->config.is_https ? "HTTPS" : "HTTP", ret);
+        return HTTPC_ERR_WRITE;
+    }
+    httpc_count_bytes(1, ret);
+    return HTTPC_SUCCESS;
+}
+
+/**
+ * @brief 响应的状态码（状态行不完整时返回 0）
+ */
+static int httpc_status_of(const char* resp, size_t len) {
+    const char* sp = len > 5 && strncmp(resp, "HTTP/", 5) == 0 ? memchr(resp, ' ', len) : NULL;
+    return sp && isdigit((unsigned char)sp[1]) ? atoi(sp + 1) : 0;
+}
+
+/**
+ * @brief 把响应状态码和 Retry-After 反馈给主机限流器
+ */
+static void httpc_limit_observe(const httpc_client_t* client, const char* resp, size_t len) {
+    int status = httpc_status_of(resp, len);
+    if (status == 0) return;
+
+    size_t value_len = 0;
+    const char* value = httpc_find_header(resp, len, "Retry-After", &value_len);
+    xlimit_observe(client->config.server_host, status, value ? xlimit_retry_after(value, value_len) : -1);
+}
+
+/**
+ * @brief 发送单个HTTP请求（不处理重定向），在 hop 中记录限流等待、发送、首字节和响应体耗时
+ */
+static httpc_err_t httpc_exchange(httpc_client_t* client, char* resp_buf, size_t resp_buf_len, size_t* actual_read,
+                                  httpc_hop_timing_t* hop) {
+    // 按主机限流：必要时等待令牌补充或 Retry-After 到期
+    double t0 = httpc_now_ms();
+    int limited = xlimit_acquire(client->config.server_host, client->config.debug_level > 0);
+    double t1 = httpc_now_ms();
+    hop->wait_ms = t1 - t0;
+    if (limited != 0) {
+        return HTTPC_ERR_THROTTLED;
+    }
+
+    // HTTP/2：作为单个流发送
+    if (client->conn->h2) {
+        httpc_request_t req = {
+            .method = client->config.method,
+            .url_path = client->config.url_path,
+            .content_type = client->config.content_type,
+            .data = client->config.data,
+            .data_length = client->config.data_length,
+            .extra_headers = client->config.extra_headers,
+            .resp_buf = resp_buf,
+            .resp_buf_len = resp_buf_len
+        };
+        httpc_err_t err = httpc_h2_execute(client->conn->h2, &client->config, &req, 1);
+        client->keep_alive = httpc_h2_is_usable(client->conn->h2);
+        hop->h2 = 1;
+        // 与 HTTP/1.1 相同的划分：发送 → 响应 HEADERS → 响应读完
+        double t2 = req.sent_at > 0 ? req.sent_at : t1;
+        hop->write_ms = t2 - t1;
+        if (req.first_byte_at > 0) {
+            hop->ttfb_ms = req.first_byte_at > t2 ? req.first_byte_at - t2 : 0;
+            hop->body_ms = httpc_now_ms() - req.first_byte_at;
+        }
+        if (err != HTTPC_SUCCESS && !httpc_h2_refused(client->conn->h2)) {
+            fprintf(stderr, u8"HTTP/2 请求失败: %d\n", err);
+            return err;
+        }
+        if (err == HTTPC_SUCCESS) {
+            if (actual_read != NULL) {
+                *actual_read = req.actual_read;
+            }
+            httpc_limit_observe(client, resp_buf, req.actual_read);
+            if (client->config.debug_level > 0)
+                printf("[DEBUG] Receive h2 response, len=%d.\n", (int)req.actual_read);
+
+            // h2 的响应整体返回：一次性交给 on_body
+            httpc_response_t info;
+            if (client->config.on_body && httpc_parse_response(resp_buf, &info) == HTTPC_SUCCESS &&
+                info.status_code >= 200 && info.status_code < 300 && info.content_start) {
+                client->config.on_body(client->config.on_body_ctx, info.content_start,
+                                       req.actual_read - (size_t)(info.content_start - resp_buf));
+            }
+            return HTTPC_SUCCESS;
+        }
+
+        // 对端拒绝开流，请求未被处理：换 HTTP/1.1 连接后走下面的普通路径
+        hop->h2 = 0;
+        err = httpc_h2_fallback(client);
+        if (err != HTTPC_SUCCESS) {
+            return err;
+        }
+        t1 = httpc_now_ms();
+    }
+
+    // 发送请求
+    httpc_err_t err = httpc_send_request(client);
+    double t2 = httpc_now_ms();
+    hop->write_ms = t2 - t1;
+    if (err != HTTPC_SUCCESS) {
+        return err;
+    }
+
+    // 接收响应
+    size_t total_read = 0;
+    client->first_byte_at = 0;
+    err = httpc_read_response(client, resp_buf, resp_buf_len, &total_read);
+    if (client->first_byte_at > 0) {
+        hop->ttfb_ms = client->first_byte_at - t2;
+        hop->body_ms = httpc_now_ms() - client->first_byte_at;
+    }
+    if (err != HTTPC_SUCCESS) {
+        return err;
+    }
+
+    if (actual_read != NULL) {
+        *actual_read = total_read;
+    }
+    httpc_limit_observe(client, resp_buf, total_read);
+    if (client->config.debug_level > 0)
+        printf("[DEBUG] Receive response, len=%d%s.\n", (int)total_read, client->keep_alive ? " (keep-alive)" : "");
+    return HTTPC_SUCCESS;
+}
+
+/**
+ * @brief 发送单个HTTP请求（不处理重定向），配置了 timing 时追加一跳耗时记录，并更新指标
+ */
+static httpc_err_t httpc_single_request(httpc_client_t* client, char* resp_buf, size_t resp_buf_len, size_t* actual_read) {
+    if (client == NULL || !client->is_init || resp_buf == NULL || resp_buf_len == 0) {
+        return HTTPC_ERR_PARAM;
     }
 
-    // 开始构建请求
-    int pos = 0;
-
-    // 请求行
-    pos += snprintf(request + pos, buffer_size - pos,
-                   "%s %s HTTP/1.1\r\n",
-                   config->method, config->url_path);
-
-    // Host头部
-    pos += snprintf(request + pos, buffer_size - pos,
-                   "Host: %s\r\n",
-                   config->server_host);
+    httpc_hop_timing_t local;
+    httpc_hop_timing_t* hop = httpc_timing_hop(client, &local);
+    uint64_t span = xtrace_begin();
+    double start = httpc_now_ms();
+    size_t n = 0;
+    httpc_err_t err = httpc_exchange(client, resp_buf, resp_buf_len, &n, hop);
+    hop->status = err == HTTPC_SUCCESS ? httpc_status_of(resp_buf, n) : 0;
+    hop->total_ms = hop->dns_ms + hop->connect_ms + hop->proxy_ms + hop->tls_ms + httpc_now_ms() - start;
+    httpc_count_hop(hop, err);
+    xtrace_end(span, "http", "request", "\"host\":\"%s\",\"conn\":%u,\"reused\":%d,\"h2\":%d,"
+               "\"status\":%d,\"bytes\":%zu,\"error\":\"%s\"", hop->host, client->conn->id, hop->reused,
+               hop->h2, hop->status, n, httpc_err_name(err));
+    if (err == HTTPC_SUCCESS && actual_read != NULL) {
+        *actual_read = n;
+    }
+    return err;
+}
 
-    // Connection头部
-    pos += snprintf(request + pos, buffer_size - pos,
-                   "Connection: close\r\n");
+void httpc_client_free(httpc_client_t* client) {
+    if (client == NULL) return;
 
-    // User-Agent头部
-    if (config->user_agent) {
-        pos += snprintf(request + pos, buffer_size - pos,
-                       "User-Agent: %s\r\n",
-                       config->user_agent);
+    // 完整读取且可复用、没有流水线余留数据的连接放回连接池
+    if (client->is_init && client->keep_alive && client->carry_len == 0 && client->conn->key[0] &&
+        (!client->conn->h2 || httpc_h2_is_usable(client->conn->h2))) {
+        httpc_pool_put(client->conn);
     } else {
-        pos += snprintf(request + pos, buffer_size - pos,
-                       "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0.0) Safari/537.36\r\n");
+        httpc_client_disconnect(client);
+        free(client->conn);
+    }
+    client->conn = NULL;
+    client->is_init = 0;
+    if (!client->config.arena) {
+        free(client->carry);
+        free(client);
     }
+}
 
-    // Content-Type头部（如果有数据）
-    if (config->data && (config->data_length > 0 || strlen(config->data) > 0)) {
-        if (config->content_type) {
-            pos += snprintf(request + pos, buffer_size - pos,
-                           "Content-Type: %s\r\n",
-                           config->content_type);
-        } else {
-            pos += snprintf(request + pos, buffer_size - pos,
-                           "Content-Type: application/x-www-form-urlencoded\r\n");
-        }
+/**
+ * @brief 不支持流水线的主机（流水线中途关闭连接或响应错位），之后对其只按顺序发送
+ */
+#define HTTPC_PIPELINE_MAX_DEPTH 16
+#define HTTPC_PIPELINE_DENY_MAX 16
 
-        // Content-Length头部
-        size_t data_len = config->data_length > 0 ? config->data_length : strlen(config->data);
-        pos += snprintf(request + pos, buffer_size - pos,
-                       "Content-Length: %zu\r\n",
-                       data_len);
+typedef struct {
+    char host[256];
+    char port[8];
+} pipeline_deny_entry_t;
+
+static pipeline_deny_entry_t pipeline_deny[HTTPC_PIPELINE_DENY_MAX];
+static int pipeline_deny_size = 0;
+static int pipeline_deny_next = 0;  // 满了之后按 FIFO 覆盖
+
+static int httpc_pipeline_denied(const httpc_client_t* client) {
+    for (int i = 0; i < pipeline_deny_size; i++) {
+        if (str_ieq(pipeline_deny[i].host, client->config.server_host) &&
+            strcmp(pipeline_deny[i].port, client->config.server_port) == 0) {
+            return 1;
+        }
     }
+    return 0;
+}
 
-    // 额外头部
-    if (config->extra_headers) {
-        pos += snprintf(request + pos, buffer_size - pos,
-                       "%s\r\n",
-                       config->extra_headers);
-    }
+static void httpc_pipeline_deny(const httpc_client_t* client) {
+    if (httpc_pipeline_denied(client)) return;
 
-    // 结束头部
-    pos += snprintf(request + pos, buffer_size - pos, "\r\n");
+    pipeline_deny_entry_t* e = &pipeline_deny[pipeline_deny_next];
+    pipeline_deny_next = (pipeline_deny_next + 1) % HTTPC_PIPELINE_DENY_MAX;
+    if (pipeline_deny_size < HTTPC_PIPELINE_DENY_MAX) pipeline_deny_size++;
+    copy_bounded(e->host, sizeof(e->host), client->config.server_host);
+    copy_bounded(e->port, sizeof(e->port), client->config.server_port);
 
-    // 添加数据（如果有）
-    if (config->data && (config->data_length > 0 || strlen(config->data) > 0)) {
-        size_t data_len = config->data_length > 0 ? config->data_length : strlen(config->data);
-        memcpy(request + pos, config->data, data_len);
-        pos += (int)data_len;
+    if (client->config.debug_level > 0) {
+        printf("[DEBUG] pipelining disabled for %s:%s\n", e->host, e->port);
     }
-
-    request[pos] = '\0';
-    return request;
 }
 
 /**
- * @brief 发送单个HTTP请求（不处理重定向）
+ * @brief 只有幂等且无请求体的请求可以进入流水线（出错时可安全重发）
  */
-static httpc_err_t httpc_single_request(httpc_client_t* client, char* resp_buf, size_t resp_buf_len, size_t* actual_read) {
-    if (client == NULL || !client->is_init || resp_buf == NULL || resp_buf_len == 0) {
-        return HTTPC_ERR_PARAM;
-    }
-
-    int ret;
-    size_t total_read = 0;
+static int httpc_pipelinable(const httpc_request_t* r) {
+    const char* method = r->method ? r->method : "GET";
+    return !r->data && (strcmp(method, "GET") == 0 || strcmp(method, "HEAD") == 0);
+}
 
-    // 动态构建请求
-    char* req = client->config.request?(char*)client->config.request:httpc_build_request(&client->config);
-    if (!req) {
-        fprintf(stderr, "Failed to build HTTP request\n");
-        return HTTPC_ERR_PARAM;
-    }
+static void httpc_apply_request(httpc_client_t* client, const httpc_request_t* r) {
+    client->config.method = r->method ? r->method : "GET";
+    client->config.url_path = r->url_path;
+    client->config.content_type = r->content_type;
+    client->config.data = r->data;
+    client->config.data_length = r->data_length;
+    client->config.extra_headers = r->extra_headers;
+}
 
-    size_t req_len = strlen(req)+1;
-    if (client->config.debug_level > 0)
-        printf("[DEBUG] http request sending, len=%d: \n%s\n", (int)req_len, req);
+/**
+ * @brief HTTP/2 批量请求：按主机并发窗口分批作为并发流发送，每个流先取令牌
+ */
+static httpc_err_t httpc_h2_multi(httpc_client_t* client, httpc_request_t* reqs, size_t count) {
+    httpc_err_t result = HTTPC_SUCCESS;
+    size_t done = 0;
+    while (done < count) {
+        int window = xlimit_concurrency(client->config.server_host);
+        size_t batch = window > 0 && (size_t)window < count - done ? (size_t)window : count - done;
+
+        // 取不到令牌的请求记为被限流；批次在第一个被拒绝的请求处截断
+        size_t ready = 0;
+        while (ready < batch && xlimit_acquire(client->config.server_host, client->config.debug_level > 0) == 0) {
+            ready++;
+        }
+        if (ready == 0) {
+            reqs[done].err = HTTPC_ERR_THROTTLED;
+            reqs[done].actual_read = 0;
+            if (result == HTTPC_SUCCESS) result = HTTPC_ERR_THROTTLED;
+            done++;
+            continue;
+        }
 
-    // 发送请求
-    if (client->config.is_https) {
-        ret = 0;
-        while ((ret = mbedtls_ssl_write(&client->ssl, (const unsigned char*)req, req_len)) <= 0) {
-            if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-                fprintf(stderr, u8"HTTPS 发送失败: %d\n", ret);
-                if (!client->config.request)
-                    free(req);
-                return HTTPC_ERR_WRITE;
+        httpc_err_t err = httpc_h2_execute(client->conn->h2, &client->config, reqs + done, ready);
+        if (err != HTTPC_SUCCESS && result == HTTPC_SUCCESS) result = err;
+        for (size_t i = done; i < done + ready; i++) {
+            if (reqs[i].err == HTTPC_SUCCESS) httpc_limit_observe(client, reqs[i].resp_buf, reqs[i].actual_read);
+        }
+        if (httpc_h2_refused(client->conn->h2)) {
+            // 对端拒绝开流：换 HTTP/1.1 连接，未被处理的请求（CONNECT）逐个重发，剩余请求按流水线发送
+            if (httpc_h2_fallback(client) == HTTPC_SUCCESS) {
+                for (size_t i = done; i < done + ready; i++) {
+                    if (reqs[i].err == HTTPC_ERR_CONNECT) httpc_client_request_multi(client, &reqs[i], 1);
+                }
+                done += ready;
+                if (done < count) httpc_client_request_multi(client, reqs + done, count - done);
+                result = HTTPC_SUCCESS;
+                for (size_t i = 0; i < count && result == HTTPC_SUCCESS; i++) result = reqs[i].err;
+                return result;
             }
         }
-    } else {
-        ret = mbedtls_net_send(&client->net_fd, (const unsigned char*)req, req_len);
-        if (ret <= 0) {
-            fprintf(stderr, u8"HTTP 发送失败: %d\n", ret);
-            if (!client->config.request)
-                free(req);
-            return HTTPC_ERR_WRITE;
+        done += ready;
+        if (!httpc_h2_is_usable(client->conn->h2)) {
+            // 连接已不可用（GOAWAY/错误），剩余请求无法发出（同 httpc_h2_execute）
+            for (size_t i = done; i < count; i++) {
+                reqs[i].err = HTTPC_ERR_CONNECT;
+                reqs[i].actual_read = 0;
+            }
+            if (result == HTTPC_SUCCESS && done < count) result = HTTPC_ERR_CONNECT;
+            break;
         }
     }
+    return result;
+}
+
+/**
+ * @brief 在同一连接上执行一批请求
+ * @note HTTP/1.1 下 config.pipeline_depth > 1 时启用流水线：连续发送至多 depth 个
+ *       GET/HEAD 请求，再按发送顺序逐个读取响应（reqs 本身即有序响应队列）。
+ *       服务端在流水线中途关闭连接或响应错位时，未应答的请求重连后按顺序重发，
+ *       并记住该主机不支持流水线。
+ */
+httpc_err_t httpc_client_request_multi(httpc_client_t* client, httpc_request_t* reqs, size_t count) {
+    if (!client || !reqs) {
+        return HTTPC_ERR_PARAM;
+    }
 
-    if (!client->config.request)
-        free(req);
+    uint64_t span = xtrace_begin();
+    if (client->conn->h2) {
+        httpc_err_t err = httpc_h2_multi(client, reqs, count);
+        xtrace_end(span, "http", "request_batch", "\"host\":\"%s\",\"conn\":%u,\"h2\":1,\"count\":%zu,\"error\":\"%s\"",
+                   client->config.server_host, client->conn->id, count, httpc_err_name(err));
+        return err;
+    }
+
+    httpc_config_t saved = client->config;
+    httpc_err_t result = HTTPC_SUCCESS;
+    client->config.request = NULL;
+    client->config.on_body = NULL;  // 批量请求会重发，响应体回调只用于单个请求
+
+    int depth = saved.pipeline_depth > 1 ? saved.pipeline_depth : 1;
+    if (depth > HTTPC_PIPELINE_MAX_DEPTH) depth = HTTPC_PIPELINE_MAX_DEPTH;
+    if (depth > 1 && httpc_pipeline_denied(client)) depth = 1;
+
+    size_t done = 0;    // 已得到结果的请求数（队头）
+    size_t sent = 0;    // 已发送的请求数（队尾）
+    int retried = 0;    // 队头请求是否已因连接失效重发过
+    while (done < count) {
+        httpc_request_t* r = &reqs[done];
+
+        // 流水线深度不超过主机当前的并发窗口（随 429/5xx 收缩）
+        int window = xlimit_concurrency(client->config.server_host);
+        int limit = window > 0 && window < depth ? window : depth;
+
+        if (!client->is_init) {
+            httpc_err_t err = httpc_client_connect(client);
+            if (err != HTTPC_SUCCESS) {
+                r->err = err;
+                r->actual_read = 0;
+                if (result == HTTPC_SUCCESS) result = err;
+                done++;
+                sent = done;
+                retried = 0;
+                continue;
+            }
+        }
 
-    // 接收响应
-    memset(resp_buf, 0, resp_buf_len);
-    while (1) {
-        size_t read_len = resp_buf_len - total_read - 1; // 留空终止符
-        if (read_len == 0) break;
+        // 填充流水线：队列空时任何请求都可发送，否则只追加可流水线的请求
+        int throttled = 0;
+        while (sent < count && (sent == done ||
+               (sent - done < (size_t)limit && httpc_pipelinable(&reqs[sent]) && httpc_pipelinable(r)))) {
+            if (xlimit_acquire(client->config.server_host, client->config.debug_level > 0) != 0) {
+                throttled = 1;
+                break;
+            }
+            httpc_apply_request(client, &reqs[sent]);
+            if (httpc_send_request(client) != HTTPC_SUCCESS) break;
+            sent++;
+        }
 
-        if (client->config.is_https) {
-            ret = mbedtls_ssl_read(&client->ssl, (unsigned char*)(resp_buf + total_read), read_len);
+        size_t in_flight = sent - done;
+        if (in_flight == 0 && throttled) {
+            // 队头请求等不到令牌：记为被限流，连接保持不变
+            r->err = HTTPC_ERR_THROTTLED;
+            r->actual_read = 0;
+            if (result == HTTPC_SUCCESS) result = HTTPC_ERR_THROTTLED;
+            done++;
+            sent = done;
+            continue;
         }
-        else {
-            ret = mbedtls_net_recv(&client->net_fd, (unsigned char*)(resp_buf + total_read), read_len);
+        httpc_err_t err = HTTPC_ERR_WRITE;
+        r->actual_read = 0;
+        if (in_flight > 0) {
+            httpc_apply_request(client, r);  // HEAD 判断依赖当前 method
+            err = httpc_read_response(client, r->resp_buf, r->resp_buf_len, &r->actual_read);
         }
 
-        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        if (err != HTTPC_SUCCESS && in_flight > 1) {
+            // 流水线中响应错位/读失败：退回顺序模式，重发未应答的请求
+            httpc_pipeline_deny(client);
+            depth = 1;
+            httpc_client_disconnect(client);
+            sent = done;
             continue;
         }
-        if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY || ret == 0) {
-            break; // 连接关闭
+
+        if (err != HTTPC_SUCCESS && client->served > 0 && !retried && httpc_pipelinable(r)) {
+            // 复用的连接已被服务端悄悄关闭：幂等请求在新连接上重发一次
+            retried = 1;
+            httpc_client_disconnect(client);
+            sent = done;
+            continue;
         }
-        if (ret < 0) {
-            fprintf(stderr, u8"接收响应失败: %d\n", ret);
-            return HTTPC_ERR_READ;
+
+        r->err = err;
+        if (err != HTTPC_SUCCESS && result == HTTPC_SUCCESS) {
+            result = err;
+        }
+        if (err == HTTPC_SUCCESS) {
+            httpc_limit_observe(client, r->resp_buf, r->actual_read);
+        }
+        done++;
+        retried = 0;
+
+        if (err != HTTPC_SUCCESS || !client->keep_alive) {
+            if (sent > done) {
+                // 服务端在流水线中途关闭连接：之后的请求需要重发
+                httpc_pipeline_deny(client);
+                depth = 1;
+            }
+            httpc_client_disconnect(client);
+            sent = done;
         }
+        if (client->config.debug_level > 0)
+            printf("[DEBUG] Receive response %zu/%zu, len=%d (in flight %zu).\n",
+                   done, count, (int)r->actual_read, in_flight);
+    }
+
+    // 恢复调用方的请求配置（连接目标不变）
+    client->config.request = saved.request;
+    client->config.method = saved.method;
+    client->config.url_path = saved.url_path;
+    client->config.content_type = saved.content_type;
+    client->config.data = saved.data;
+    client->config.data_length = saved.data_length;
+    client->config.extra_headers = saved.extra_headers;
+    client->config.on_body = saved.on_body;
+    xtrace_end(span, "http", "request_batch", "\"host\":\"%s\",\"conn\":%u,\"h2\":0,\"count\":%zu,\"depth\":%d,\"error\":\"%s\"",
+               client->config.server_host, client->conn->id, count, depth, httpc_err_name(result));
+    return result;
+}
 
-        total_read += ret;
-        if (total_read >= resp_buf_len - 1) break; // 缓冲区满
-    }
+const char* httpc_client_protocol(const httpc_client_t* client) {
+    return client && client->is_init && client->conn->h2 ? "h2" : "http/1.1";
+}
 
-    if (actual_read != NULL) {
-        *actual_read = total_read;
+/**
+ * @brief 把 Location 解析为绝对目标（支持绝对URL、//host/path、/path、相对路径）
+ * @return 目标放不进缓冲区时返回 HTTPC_ERR_REDIRECT（截断的地址会跳到错误的位置）
+ */
+static httpc_err_t httpc_resolve_location(const httpc_client_t* client, const char* location,
+                                          char* host, size_t host_len, char* port, size_t port_len,
+                                          char* path, size_t path_len, int* is_https) {
+    if (location[0] == '/' && location[1] == '/') {
+        // 协议相对：沿用当前协议
+        char url[1280];
+        int n = snprintf(url, sizeof(url), "%s:%s", client->config.is_https ? "https" : "http", location);
+        if (n < 0 || (size_t)n >= sizeof(url)) return HTTPC_ERR_REDIRECT;
+        return parse_url(url, host, host_len, port, port_len, path, path_len, is_https);
+    }
+    if (strstr(location, "://")) {
+        return parse_url(location, host, host_len, port, port_len, path, path_len, is_https);
+    }
+
+    // 同源：沿用当前主机、端口和协议
+    copy_bounded(host, host_len, client->config.server_host);
+    copy_bounded(port, port_len, client->config.server_port);
+    *is_https = client->config.is_https;
+
+    if (location[0] == '/') {
+        if (strlen(location) >= path_len) return HTTPC_ERR_REDIRECT;
+        copy_bounded(path, path_len, location);
+    } else {
+        // 相对路径：替换当前路径最后一段（忽略查询串）
+        const char* cur = client->config.url_path ? client->config.url_path : "/";
+        size_t dir_len = strcspn(cur, "?#");
+        while (dir_len > 0 && cur[dir_len - 1] != '/') dir_len--;
+        if (dir_len + strlen(location) >= path_len) return HTTPC_ERR_REDIRECT;
+        memcpy(path, cur, dir_len);
+        strcpy(path + dir_len, location);
     }
-    if (client->config.debug_level > 0)
-        printf("[DEBUG] Receive response, len=%d.\n", (int)total_read);
     return HTTPC_SUCCESS;
 }
 
-void httpc_client_free(httpc_client_t* client) {
-    if (client == NULL) return;
+static FILE* httpc_timing_out = NULL;
+static int httpc_timing_json = 0;
+
+void httpc_set_timing_output(FILE* out, int json) {
+    httpc_timing_out = out;
+    httpc_timing_json = json;
+}
+
+/**
+ * @brief 追加格式化文本，返回新的写入位置（空间不足时停在缓冲区末尾）
+ */
+static size_t httpc_appendf(char* buf, size_t buf_len, size_t pos, const char* fmt, ...) {
+    if (pos + 1 >= buf_len) return pos;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + pos, buf_len - pos, fmt, ap);
+    va_end(ap);
+    if (n < 0) return pos;
+    return pos + (size_t)n < buf_len ? pos + (size_t)n : buf_len - 1;
+}
+
+size_t httpc_timing_format(const httpc_timing_t* timing, int json, char* buf, size_t buf_len) {
+    if (!buf || buf_len == 0) return 0;
+    buf[0] = '\0';
+    if (!timing) return 0;
+
+    size_t pos = 0;
+    if (json) pos = httpc_appendf(buf, buf_len, pos, "{\"total_ms\":%.3f,\"hops\":[", timing->total_ms);
+    for (int i = 0; i < timing->hops && i < HTTPC_TIMING_MAX_HOPS; i++) {
+        const httpc_hop_timing_t* h = &timing->hop[i];
+        if (json) {
+            // 主机名来自 URL/Location，只可能含可打印字符；引号和反斜杠替换掉以保证 JSON 合法
+            char host[sizeof(h->host)];
+            size_t k = 0;
+            for (; h->host[k] && k < sizeof(host) - 1; k++) {
+                unsigned char c = (unsigned char)h->host[k];
+                host[k] = c < 0x20 || c == '"' || c == '\\' ? '?' : (char)c;
+            }
+            host[k] = '\0';
+            pos = httpc_appendf(buf, buf_len, pos,
+                "%s{\"host\":\"%s\",\"status\":%d,\"reused\":%d,\"h2\":%d,\"wait_ms\":%.3f,\"dns_ms\":%.3f,"
+                "\"connect_ms\":%.3f,\"proxy_ms\":%.3f,\"tls_ms\":%.3f,\"write_ms\":%.3f,\"ttfb_ms\":%.3f,"
+                "\"body_ms\":%.3f,\"total_ms\":%.3f}",
+                i > 0 ? "," : "", host, h->status, h->reused, h->h2, h->wait_ms, h->dns_ms, h->connect_ms,
+                h->proxy_ms, h->tls_ms, h->write_ms, h->ttfb_ms, h->body_ms, h->total_ms);
+        } else {
+            pos = httpc_appendf(buf, buf_len, pos, "%s%s %d%s", i > 0 ? " -> " : "", h->host, h->status,
+                                h->h2 ? " h2" : "");
+            if (h->wait_ms > 0) pos = httpc_appendf(buf, buf_len, pos, " wait=%.2f", h->wait_ms);
+            if (h->reused) {
+                pos = httpc_appendf(buf, buf_len, pos, " reused");
+            } else {
+                pos = httpc_appendf(buf, buf_len, pos, " dns=%.2f connect=%.2f", h->dns_ms, h->connect_ms);
+                if (h->proxy_ms > 0) pos = httpc_appendf(buf, buf_len, pos, " proxy=%.2f", h->proxy_ms);
+                if (h->tls_ms > 0) pos = httpc_appendf(buf, buf_len, pos, " tls=%.2f", h->tls_ms);
+            }
+            pos = httpc_appendf(buf, buf_len, pos, " write=%.2f ttfb=%.2f body=%.2f total=%.2f ms",
+                                h->write_ms, h->ttfb_ms, h->body_ms, h->total_ms);
+        }
+    }
+    if (json) {
+        pos = httpc_appendf(buf, buf_len, pos, "]}");
+    } else if (timing->hops > 1) {
+        pos = httpc_appendf(buf, buf_len, pos, " (%d hops, %.2f ms)", timing->hops, timing->total_ms);
+    }
+    return pos;
+}
 
-    if (client->config.is_https) {
-        mbedtls_ssl_close_notify(&client->ssl);
-        mbedtls_x509_crt_free(&client->cacert);
-        mbedtls_ssl_free(&client->ssl);
-        mbedtls_ssl_config_free(&client->ssl_conf);
-        mbedtls_ctr_drbg_free(&client->ctr_drbg);
-        mbedtls_entropy_free(&client->entropy);
+/**
+ * @brief 请求结束后输出分阶段耗时：debug 时打印到 stdout，设置了输出流时写一行
+ */
+static void httpc_timing_report(const httpc_timing_t* timing, int debug) {
+    char line[4096];
+    if (debug) {
+        httpc_timing_format(timing, 0, line, sizeof(line));
+        printf("[TIMING] %s\n", line);
+    }
+    if (httpc_timing_out) {
+        httpc_timing_format(timing, httpc_timing_json, line, sizeof(line));
+        fprintf(httpc_timing_out, "%s\n", line);
+        fflush(httpc_timing_out);
     }
+}
 
-    mbedtls_net_free(&client->net_fd);
-    free(client);
+static int httpc_is_redirect(int status_code) {
+    return status_code == 301 || status_code == 302 || status_code == 303 ||
+           status_code == 307 || status_code == 308;
 }
 
 /**
  * @brief 发送 HTTP/HTTPS 请求并接收响应（带响应信息）
+ * @note 重定向规则：
+ *       - 303 改为 GET 并丢弃请求体；301/302/307/308 保持原方法和请求体
+ *         （Bing 的 POST /ttranslatev3 依赖 302 后继续 POST）
+ *       - 同源且连接可复用时直接在原连接上继续，否则建立新连接
+ *       - 301/308 且仅切换源站时写入重定向缓存，后续 httpc_client_init 直接连最终主机
  */
 httpc_err_t httpc_client_request(httpc_client_t* client,
     char* resp_buf,
@@ -971,15 +2892,29 @@ httpc_err_t httpc_client_request(httpc_client_t* client,
     int redirect_count = 0;
     const int max_redirects = 5;  // 最大重定向次数
 
-    // 保存原始配置
     httpc_err_t result = HTTPC_ERR_REDIRECT;
     httpc_client_t* new_client = NULL;
+    int hop_failed = 0;     // 失败发生在某一跳内（错误已计入指标）
+
+    // 分阶段耗时：调用方没给 timing 但需要输出（-v 或 httpc_set_timing_output）时记到栈上
+    httpc_client_t* origin = client;
+    httpc_timing_t* caller_timing = client->config.timing;
+    httpc_timing_t local_timing;
+    if (!caller_timing && (client->config.debug_level > 0 || httpc_timing_out)) {
+        client->config.timing = &local_timing;
+    }
+    httpc_timing_t* timing = client->config.timing;
+    if (timing) {
+        timing->hops = 0;
+        timing->total_ms = 0;
+    }
 
-    while (redirect_count < max_redirects) {
+    for (;;) {
         // 发送当前请求
         result = httpc_single_request(client, resp_buf, resp_buf_len, actual_read);
 
         if (result != HTTPC_SUCCESS) {
+            hop_failed = 1;
             break;
         }
 
@@ -992,127 +2927,410 @@ httpc_err_t httpc_client_request(httpc_client_t* client,
         }
 
         // 检查是否需要重定向
-        if (current_response.status_code == 301 || current_response.status_code == 302) {
-            if (strlen(current_response.location) == 0) {
-                result = HTTPC_ERR_REDIRECT;
-                break;
-            }
+        int status = current_response.status_code;
+        if (!httpc_is_redirect(status)) {
+            // 不需要重定向，成功完成
+            result = HTTPC_SUCCESS;
+            break;
+        }
 
-            // 解析重定向URL
-            char new_host[256] = {0};
-            char new_path[1024] = {0};
-            int new_is_https = 0;
-
-            // 处理相对URL和绝对URL
-            if (current_response.location[0] == '/') {
-                // 相对路径，保持当前主机
-                strcpy(new_host, client->config.server_host);
-                strncpy(new_path, current_response.location, sizeof(new_path) - 1);
-                new_is_https = client->config.is_https;
-            } else {
-                // 绝对路径，解析新主机
-                result = parse_url(current_response.location, new_host, sizeof(new_host),
-                                 new_path, sizeof(new_path), &new_is_https);
+        if (redirect_count >= max_redirects) {
+            result = HTTPC_ERR_TOO_MANY_REDIRECTS;
+            break;
+        }
 
-                if (result != HTTPC_SUCCESS) {
-                    break;
-                }
-            }
+        if (strlen(current_response.location) == 0) {
+            result = HTTPC_ERR_REDIRECT;
+            break;
+        }
 
-            if (client->config.debug_level) {
-                printf("[REDIRECT] %d: %s -> %s (Path: %s)\n",
-                       current_response.status_code,
-                       client->config.server_host,
-                       new_host,
-                       new_path);
-            }
+        // 解析重定向URL
+        char new_host[256] = {0};
+        char new_port[8] = {0};
+        char new_path[1024] = {0};
+        int new_is_https = 0;
+
+        result = httpc_resolve_location(client, current_response.location, new_host, sizeof(new_host),
+                                        new_port, sizeof(new_port), new_path, sizeof(new_path), &new_is_https);
+        if (result != HTTPC_SUCCESS) {
+            result = HTTPC_ERR_REDIRECT;
+            break;
+        }
+
+        int same_origin = new_is_https == client->config.is_https &&
+                          str_ieq(new_host, client->config.server_host) &&
+                          strcmp(new_port, client->config.server_port) == 0;
+
+        if (client->config.debug_level) {
+            printf("[REDIRECT] %d: %s -> %s (Path: %s)%s\n",
+                   status,
+                   client->config.server_host,
+                   new_host,
+                   new_path,
+                   same_origin && client->keep_alive ? " [reuse connection]" : "");
+        }
 
-            // 更新客户端配置
-            httpc_config_t new_config = client->config;
+        // 永久重定向且路径不变：记住源站跳转
+        if ((status == 301 || status == 308) && !same_origin &&
+            client->config.url_path && strcmp(new_path, client->config.url_path) == 0) {
+            httpc_redirect_cache_put(client->config.is_https, client->config.server_host, client->config.server_port,
+                                     new_is_https, new_host, new_port);
+        }
+
+        // 原始请求字符串（模式2）无法改写，重定向后一律按组件构建
+        httpc_config_t new_config = client->config;
+        new_config.request = NULL;
+        if (!new_config.method) {
+            new_config.method = "GET";
+        }
+        if (status == 303 && strcmp(new_config.method, "HEAD") != 0) {
+            new_config.method = "GET";
+            new_config.data = NULL;
+            new_config.data_length = 0;
+            new_config.content_type = NULL;
+        }
+
+        if (same_origin && client->keep_alive) {
+            // 同源：直接在已建立的连接上发送下一跳
+            client->config = new_config;
+            httpc_own_target(client, NULL, NULL, new_path);
+        } else {
             new_config.server_host = new_host;
+            new_config.server_port = new_port;
             new_config.url_path = new_path;
             new_config.is_https = new_is_https;
-            new_config.request = NULL;
 
             // 重新连接到新主机
-            if(new_client)
-                httpc_client_free(new_client);
-            new_client = httpc_client_init(&new_config);
-            if (!new_client) {
+            httpc_client_t* next_client = httpc_client_init(&new_config);
+            if (!next_client) {
                 result = HTTPC_ERR_CONNECT;
+                hop_failed = 1;
                 break;
             }
+            // 目标字符串在本函数栈上，转为客户端自有（缓存改写过的主机保持不变）
+            httpc_own_target(next_client, next_client->config.server_host,
+                             next_client->config.server_port, new_path);
 
-            // 释放旧客户端，使用新客户端
-            client = new_client;
-
-            redirect_count++;
-        } else {
-            // 不需要重定向，成功完成
-            result = HTTPC_SUCCESS;
-            break;
+            // 释放上一跳的临时客户端（调用方传入的 client 由调用方释放）
+            if (new_client)
+                httpc_client_free(new_client);
+            new_client = next_client;
+            client = next_client;
         }
-    }
 
-    if (redirect_count >= max_redirects) {
-        result = HTTPC_ERR_TOO_MANY_REDIRECTS;
+        redirect_count++;
     }
 
     if(new_client)
         httpc_client_free(new_client);
 
-    // 恢复原始配置（如果需要的话）
-    // 注意：这里我们不恢复客户端状态，因为请求可能已经成功
+    if (result != HTTPC_SUCCESS && !hop_failed) {
+        httpc_count_error(result);  // 重定向/解析错误
+    }
+    if (timing) {
+        for (int i = 0; i < timing->hops; i++) timing->total_ms += timing->hop[i].total_ms;
+        httpc_timing_report(timing, origin->config.debug_level > 0);
+        origin->config.timing = caller_timing;
+    }
     return result;
 }
 
+/**
+ * @brief 重试层默认值
+ */
+#define HTTPC_RETRY_ATTEMPTS    3
+#define HTTPC_RETRY_BASE_MS     100
+#define HTTPC_RETRY_CAP_MS      2000
+#define HTTPC_RETRY_DEADLINE_MS 10000
+
+httpc_retry_class_t httpc_retry_classify(httpc_err_t err, int status_code) {
+    switch (err) {
+    case HTTPC_SUCCESS:
+        // 429/503/425：服务端明确未处理该请求
+        if (status_code == 429 || status_code == 503 || status_code == 425) return HTTPC_RETRY_SAFE;
+        if (status_code == 408 || status_code == 500 || status_code == 502 || status_code == 504) {
+            return HTTPC_RETRY_IDEMPOTENT;
+        }
+        return HTTPC_RETRY_NO;
+    case HTTPC_ERR_CONNECT:
+    case HTTPC_ERR_PROXY_CONNECT:
+    case HTTPC_ERR_SSL_HANDSHAKE:
+        return HTTPC_RETRY_SAFE;            // 请求还没发出
+    case HTTPC_ERR_WRITE:
+    case HTTPC_ERR_READ:
+        return HTTPC_RETRY_IDEMPOTENT;      // 连接中断：请求可能已到达服务端
+    default:
+        // 参数/证书/解析/重定向/代理认证错误重试也不会变；HTTPC_ERR_THROTTLED 已由限流器等待过
+        return HTTPC_RETRY_NO;
+    }
+}
+
+/**
+ * @brief 请求方法是否幂等（RFC 9110 9.2.2）
+ */
+static int httpc_method_idempotent(const httpc_config_t* config) {
+    static const char* const methods[] = { "GET", "HEAD", "PUT", "DELETE", "OPTIONS", "TRACE" };
+    const char* m = config->request ? config->request : (config->method ? config->method : "GET");
+    size_t len = strcspn(m, " ");
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strlen(methods[i]) == len && strncmp(m, methods[i], len) == 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 转发 on_body 并记录是否已交出过数据（交出后不能再重试）
+ */
+typedef struct {
+    int (*on_body)(void* ctx, const char* data, size_t len);
+    void* ctx;
+    size_t fed;
+} httpc_retry_feed_t;
+
+static int httpc_retry_on_body(void* ctx, const char* data, size_t len) {
+    httpc_retry_feed_t* feed = (httpc_retry_feed_t*)ctx;
+    feed->fed += len;
+    return feed->on_body(feed->ctx, data, len);
+}
+
+/**
+ * @brief [0, 1) 均匀随机数（xorshift64*，只用于退避抖动）
+ */
+static double httpc_jitter(void) {
+    static uint64_t state = 0;
+    if (state == 0) {
+        state = (uint64_t)time(NULL) ^ ((uint64_t)(uintptr_t)&state << 16) ^ (uint64_t)(httpc_now_ms() * 1000.0);
+        if (state == 0) state = 0x9E3779B97F4A7C15ULL;
+    }
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (double)((state * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+
+httpc_err_t httpc_request_retry(const httpc_config_t* config, const httpc_retry_t* policy,
+    char* resp_buf, size_t resp_buf_len, size_t* actual_read, int* attempts) {
+    if (!config || !resp_buf || resp_buf_len == 0) {
+        return HTTPC_ERR_PARAM;
+    }
+
+    int max_attempts = policy && policy->max_attempts > 0 ? policy->max_attempts : HTTPC_RETRY_ATTEMPTS;
+    double base = policy && policy->base_ms > 0 ? policy->base_ms : HTTPC_RETRY_BASE_MS;
+    double cap = policy && policy->cap_ms > 0 ? policy->cap_ms : HTTPC_RETRY_CAP_MS;
+    double deadline = policy && policy->deadline_ms > 0 ? policy->deadline_ms : HTTPC_RETRY_DEADLINE_MS;
+    int idempotent = (policy && policy->idempotent) || httpc_method_idempotent(config);
+
+    httpc_config_t cfg = *config;
+    httpc_timing_t local_timing;
+    if (!cfg.timing && (cfg.debug_level > 0 || httpc_timing_out)) {
+        cfg.timing = &local_timing;  // 连接失败的尝试也要输出耗时
+    }
+    httpc_retry_feed_t feed = { config->on_body, config->on_body_ctx, 0 };
+    if (cfg.on_body) {
+        cfg.on_body = httpc_retry_on_body;
+        cfg.on_body_ctx = &feed;
+    }
+
+    double start = httpc_now_ms();
+    double sleep_ms = base;
+    httpc_err_t err = HTTPC_ERR_CONNECT;
+    size_t n = 0;
+    int attempt = 0;
+    while (attempt < max_attempts) {
+        attempt++;
+        n = 0;
+        if (cfg.timing) memset(cfg.timing, 0, sizeof(*cfg.timing));
+
+        httpc_client_t* client = httpc_client_open(&cfg, &err);
+        if (client) {
+            err = httpc_client_request(client, resp_buf, resp_buf_len, &n);
+            httpc_client_free(client);  // 可复用的连接回到连接池，下次尝试直接接管
+        } else if (cfg.timing && cfg.timing->hops > 0) {
+            cfg.timing->total_ms = cfg.timing->hop[0].total_ms;
+            httpc_timing_report(cfg.timing, cfg.debug_level > 0);
+        }
+
+        int status = err == HTTPC_SUCCESS ? httpc_status_of(resp_buf, n) : 0;
+        httpc_retry_class_t cls = httpc_retry_classify(err, status);
+        if (cls == HTTPC_RETRY_NO || (cls == HTTPC_RETRY_IDEMPOTENT && !idempotent) || feed.fed > 0) {
+            break;
+        }
+        if (attempt >= max_attempts) break;
+
+        // Decorrelated jitter：在 [base, 3 * 上次) 中随机，且不超过 cap 和剩余预算
+        sleep_ms = base + httpc_jitter() * (sleep_ms * 3.0 - base);
+        if (sleep_ms > cap) sleep_ms = cap;
+        double left = deadline - (httpc_now_ms() - start);
+        if (sleep_ms >= left) {
+            if (cfg.debug_level > 0) printf("[RETRY] deadline budget exhausted after %d attempts\n", attempt);
+            break;
+        }
+
+        if (cfg.debug_level > 0) {
+            printf("[RETRY] %s:%s attempt %d/%d failed (err %d, status %d), retrying in %.0f ms\n",
+                   cfg.server_host, cfg.server_port, attempt, max_attempts, err, status, sleep_ms);
+        }
+        uint64_t span = xtrace_begin();
+        xlimit_sleep_ms(sleep_ms);
+        xtrace_end(span, "http", "retry_backoff", "\"host\":\"%s\",\"attempt\":%d,\"error\":\"%s\",\"status\":%d",
+                   cfg.server_host, attempt, httpc_err_name(err), status);
+    }
+
+    if (actual_read) *actual_read = n;
+    if (attempts) *attempts = attempt;
+    return err;
+}
+
+// URL 编码字符类别：0=原样保留（RFC 3986 unreserved），1=空格，2=%XX 转义
+static const unsigned char httpc_url_class[256] = {
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 2,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2,
+    2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 0,
+    2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 0, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2
+};
+
+static const char httpc_hex_upper[] = "0123456789ABCDEF";
+
+#ifdef HTTPC_URL_SIMD
+static unsigned httpc_popcount16(unsigned x) {
+    x = x - ((x >> 1) & 0x5555);
+    x = (x & 0x3333) + ((x >> 2) & 0x3333);
+    x = (x + (x >> 4)) & 0x0F0F;
+    return (x + (x >> 8)) & 0x1F;
+}
+
+/**
+ * @brief 16 字节中编码后仍占 1 字节的位掩码（FORM 模式下空格编码为 '+'，也算在内）
+ */
+static unsigned httpc_url_keep_mask(const unsigned char* p, httpc_url_mode_t mode) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+#define HTTPC_IN_RANGE(lo, hi) \
+    _mm_cmpeq_epi8(_mm_min_epu8(_mm_sub_epi8(v, _mm_set1_epi8(lo)), _mm_set1_epi8((hi) - (lo))), \
+                   _mm_sub_epi8(v, _mm_set1_epi8(lo)))
+    __m128i keep = _mm_or_si128(_mm_or_si128(HTTPC_IN_RANGE('a', 'z'), HTTPC_IN_RANGE('A', 'Z')),
+                                HTTPC_IN_RANGE('0', '9'));
+#undef HTTPC_IN_RANGE
+    keep = _mm_or_si128(keep, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')),
+                                           _mm_cmpeq_epi8(v, _mm_set1_epi8('_'))));
+    keep = _mm_or_si128(keep, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')),
+                                           _mm_cmpeq_epi8(v, _mm_set1_epi8('~'))));
+    if (mode == HTTPC_URL_FORM) {
+        keep = _mm_or_si128(keep, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    }
+    return (unsigned)_mm_movemask_epi8(keep);
+}
+#endif
+
+size_t httpc_url_encode_len(const char* str, size_t len, httpc_url_mode_t mode) {
+    const unsigned char* s = (const unsigned char*)str;
+    size_t out = len;
+    size_t i = 0;
+
+#ifdef HTTPC_URL_SIMD
+    for (; i + 16 <= len; i += 16) {
+        out += 2 * (16 - httpc_popcount16(httpc_url_keep_mask(s + i, mode)));
+    }
+#endif
+    for (; i < len; i++) {
+        unsigned char cls = httpc_url_class[s[i]];
+        if (cls == 2 || (cls == 1 && mode == HTTPC_URL_COMPONENT)) {
+            out += 2;
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief 编码到 out（调用方保证空间足够），返回写入长度（不含终止符）
+ */
+static size_t httpc_url_encode_raw(const unsigned char* s, size_t len, httpc_url_mode_t mode, char* out) {
+    size_t i = 0, j = 0;
+
+    while (i < len) {
+        size_t end = len;
+#ifdef HTTPC_URL_SIMD
+        // 整段 unreserved ASCII 直接拷贝，否则这 16 字节走查表
+        if (i + 16 <= len) {
+            if (httpc_url_keep_mask(s + i, HTTPC_URL_COMPONENT) == 0xFFFF) {
+                memcpy(out + j, s + i, 16);
+                i += 16;
+                j += 16;
+                continue;
+            }
+            end = i + 16;
+        }
+#endif
+        for (; i < end; i++) {
+            unsigned char c = s[i];
+            unsigned char cls = httpc_url_class[c];
+            if (cls == 0) {
+                out[j++] = (char)c;
+            } else if (cls == 1 && mode == HTTPC_URL_FORM) {
+                out[j++] = '+';
+            } else {
+                out[j] = '%';
+                out[j + 1] = httpc_hex_upper[c >> 4];
+                out[j + 2] = httpc_hex_upper[c & 0x0F];
+                j += 3;
+            }
+        }
+    }
+    out[j] = '\0';
+    return j;
+}
+
+size_t httpc_url_encode_into(const char* str, size_t len, httpc_url_mode_t mode, char* out, size_t out_size) {
+    if (!str) return 0;
+
+    size_t need = httpc_url_encode_len(str, len, mode);
+    if (out && out_size > need) {
+        httpc_url_encode_raw((const unsigned char*)str, len, mode, out);
+    }
+    return need;
+}
+
 // URL编码函数
 char* httpc_url_encode(const char* str) {
+    return httpc_url_encode_arena(str, NULL);
+}
+
+char* httpc_url_encode_arena(const char* str, xarena_t* arena) {
     if (!str) return NULL;
 
     size_t len = strlen(str);
-    char* encoded = malloc(len * 3 + 1); // 最坏情况：所有字符都需要编码
+    // 预先算出准确长度，按需分配
+    size_t need = httpc_url_encode_len(str, len, HTTPC_URL_FORM);
+    char* encoded = arena ? (char*)xarena_alloc(arena, need + 1) : malloc(need + 1);
     if (!encoded) return NULL;
 
-    size_t j = 0;
-    for (size_t i = 0; i < len; i++) {
-        char c = str[i];
-        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
-            c == '-' || c == '_' || c == '.' || c == '~') {
-            encoded[j++] = c;
-        } else if (c == ' ') {
-            encoded[j++] = '+';
-        } else {
-            snprintf(encoded + j, 4, "%%%02X", (unsigned char)c);
-            j += 3;
-        }
-    }
-    encoded[j] = '\0';
-
+    httpc_url_encode_raw((const unsigned char*)str, len, HTTPC_URL_FORM, encoded);
     return encoded;
 }
 
-// 简单的语言检测
+// 离线语言检测（GBK 输入先转为 UTF-8）
 const char* httpc_detect_language(const char* text) {
     if (!text) return "en";
 
-    int chinese = 0, english = 0, total = 0;
-
-    for (const char* p = text; *p; p++) {
-        if ((*p & 0x80) && (*(p+1) & 0x80)) {
-            // 简单的中文字符检测（UTF-8）
-            chinese++;
-            p++; // 跳过下一个字节
-        } else if ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')) {
-            english++;
-        }
-        if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') total++;
+    char utf8_buf[2048];
+    size_t utf8_len = 0;
+    const char* utf8 = httpc_as_utf8(text, utf8_buf, sizeof(utf8_buf), &utf8_len);
+    if (!utf8) {
+        utf8 = text;
+        utf8_len = strlen(text);
     }
-
-    if (total == 0) return "en";
-    if ((double)chinese / total > 0.3) return "zh-cn";
-    if ((double)english / total > 0.5) return "en";
-    return "en";
+    return xlang_detect(utf8, utf8_len);
 }
 
 /**
@@ -1130,16 +3348,19 @@ char* httpc_extract_translation(const char* json_response) {
 
     start += strlen(pattern);
 
-    // 查找结束引号
-    char* end = strchr(start, '"');
-    if (!end) return NULL;
+    // 查找结束引号（跳过 \" 等转义）
+    const char* end = start;
+    while (*end && *end != '"') {
+        if (*end == '\\' && end[1]) end++;
+        end++;
+    }
+    if (!*end) return NULL;
 
-    // 处理Unicode转义如 \u4f60\u597d
+    // 解码后不会比原文长
     size_t len = end - start;
     char* result = malloc(len + 1);
     if (!result) return NULL;
 
-    // 复制并解码Unicode转义
     httpc_decode_unicode(start, len, result, len + 1);
 
     return result;
@@ -1158,122 +3379,22 @@ int httpc_extract_pattern(const char* content, const char* start_pattern, const
 
     size_t len = end - start;
     if (len > 0 && len < result_len) {
-        return httpc_decode_unicode(start, len, result, result_len);
+        return httpc_decode_unicode(start, len, result, result_len) > 0;
     }
 
     return 0;
 }
 
 int httpc_decode_unicode(const char* start, size_t len, char* result, size_t result_len) {
-    // 复制并解码Unicode转义
-    size_t j = 0;
-    strncpy(result, start, len);
-    for (size_t i = 0; i < len; i++) {
-        if (i + 5 < len && start[i] == '\\' && start[i+1] == 'u') {
-            // Unicode转义处理
-            int unicode;
-            if (sscanf(start + i + 2, "%4x", &unicode) == 1) {
-                if (unicode >= 0x0000 && unicode <= 0x007F) {
-                    // ASCII字符（1字节）
-                    result[j++] = (char)unicode;
-                } else if (unicode >= 0x0080 && unicode <= 0x07FF) {
-                    // 2字节UTF-8
-                    result[j++] = 0xC0 | ((unicode >> 6) & 0x1F);
-                    result[j++] = 0x80 | (unicode & 0x3F);
-                } else if (unicode >= 0x0800 && unicode <= 0xFFFF) {
-                    // 3字节UTF-8（包括中文）
-                    result[j++] = 0xE0 | ((unicode >> 12) & 0x0F);
-                    result[j++] = 0x80 | ((unicode >> 6) & 0x3F);
-                    result[j++] = 0x80 | (unicode & 0x3F);
-                } else if (unicode >= 0x10000 && unicode <= 0x10FFFF) {
-                    // 4字节UTF-8（补充字符）
-                    result[j++] = 0xF0 | ((unicode >> 18) & 0x07);
-                    result[j++] = 0x80 | ((unicode >> 12) & 0x3F);
-                    result[j++] = 0x80 | ((unicode >> 6) & 0x3F);
-                    result[j++] = 0x80 | (unicode & 0x3F);
-                } else {
-                    // 不支持的Unicode的备用处理
-                    result[j++] = '?';
-                }
-                i += 5; // 跳过 \uXXXX
-            } else {
-                result[j++] = start[i];
-            }
-        } else {
-            result[j++] = start[i];
-        }
-    }
-    result[j] = '\0';
-
-    return 1;
-}
-
-static int is_utf8(const char* str, size_t len) {
-    if (str == NULL) return 0;
-    if (len == 0) len = strlen(str);
-
-    for (size_t i = 0; i < len; ) {
-        unsigned char c = (unsigned char)str[i];
-        int need = 0;
-
-        if (c < 0x80) { // 单字节 ASCII
-            need = 1;
-        } else if (c < 0xE0) { // 双字节 UTF-8
-            need = 2;
-        } else if (c < 0xF0) { // 三字节 UTF-8（中文核心）
-            need = 3;
-        } else if (c < 0xF8) { // 四字节 UTF-8
-            need = 4;
-        } else {
-            return 0; // 非法 UTF-8 首字节
-        }
-
-        // 检查剩余长度是否足够
-        if (i + need > len) return 0;
-        // 检查后续字节是否符合 10xxxxxx 格式
-        for (int j = 1; j < need; j++) {
-            if (((unsigned char)str[i + j] & 0xC0) != 0x80) {
-                return 0;
-            }
-        }
-        i += need;
-    }
-    return 1;
+    // 与流式 JSON 提取共用转义表和 SIMD 扫描
+    return xjson_unescape(start, len, result, result_len);
 }
 
 static int gbk_to_utf8(const char* gbk_str, char* utf8_buf, size_t buf_len) {
     if (gbk_str == NULL || utf8_buf == NULL || buf_len == 0) return -1;
 
-#ifdef _WIN32
-    // Windows 平台：GBK(CP936) → 宽字符 → UTF-8
-    int wlen = MultiByteToWideChar(936, 0, gbk_str, -1, NULL, 0);
-    if (wlen <= 0) return -1;
-
-    wchar_t* wbuf = (wchar_t*)malloc(wlen * sizeof(wchar_t));
-    if (wbuf == NULL) return -1;
-    MultiByteToWideChar(936, 0, gbk_str, -1, wbuf, wlen);
-
-    int utf8_len = WideCharToMultiByte(CP_UTF8, 0, wbuf, -1, utf8_buf, (int)buf_len, NULL, NULL);
-    free(wbuf);
-    return (utf8_len > 0) ? utf8_len - 1 : -1; // 减去终止符
-
-#else
-    // Linux/嵌入式：iconv 实现 GBK → UTF-8
-    iconv_t cd = iconv_open("UTF-8", "GBK");
-    if (cd == (iconv_t)-1) return -1;
-
-    char* in_buf = (char*)gbk_str;
-    size_t in_len = strlen(gbk_str);
-    char* out_buf = utf8_buf;
-    size_t out_len = buf_len - 1; // 留终止符
-
-    size_t ret = iconv(cd, &in_buf, &in_len, &out_buf, &out_len);
-    iconv_close(cd);
-
-    if (ret == (size_t)-1) return -1;
-    *out_buf = '\0'; // 加终止符
-    return (buf_len - 1 - out_len); // 返回实际转换长度
-#endif
+    // 线程内缓存的转码器，不再每次 iconv_open/iconv_close
+    return xgbk_to_utf8(gbk_str, strlen(gbk_str), utf8_buf, buf_len);
 }
 
 // 转utf-8
@@ -1281,13 +3402,30 @@ int httpc_any_to_utf8(const char* input_str, char* output_buf, size_t buf_len) {
     if (input_str == NULL || output_buf == NULL || buf_len == 0) return -1;
 
     // 1. 先检测是否已经是 UTF-8
-    if (is_utf8(input_str, 0)) {
-        size_t len = strlen(input_str);
+    size_t len = strlen(input_str);
+    if (xutf8_validate(input_str, len)) {
         if (len >= buf_len) return -1; // 缓冲区不足
-        strcpy(output_buf, input_str);
+        memcpy(output_buf, input_str, len + 1);
         return (int)len;
     }
 
     // 2. 非 UTF-8 → 按 GBK 转 UTF-8
     return gbk_to_utf8(input_str, output_buf, buf_len);
 }
+
+const char* httpc_as_utf8(const char* input_str, char* output_buf, size_t buf_len, size_t* out_len) {
+    if (input_str == NULL) return NULL;
+
+    // 已经是 UTF-8：直接返回输入，不复制
+    size_t len = strlen(input_str);
+    if (xutf8_validate(input_str, len)) {
+        if (out_len) *out_len = len;
+        return input_str;
+    }
+
+    if (output_buf == NULL || buf_len == 0) return NULL;
+    int n = gbk_to_utf8(input_str, output_buf, buf_len);
+    if (n < 0) return NULL;
+    if (out_len) *out_len = (size_t)n;
+    return output_buf;
+}
@@ -3,8 +3,10 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "xarena.h"
 #ifndef _WIN32
 #define u8 ""
 #endif
@@ -26,9 +28,15 @@ typedef enum {
     HTTPC_ERR_TOO_MANY_REDIRECTS = -10,  // 重定向次数过多
     HTTPC_ERR_PROXY_CONNECT = -11, // 代理连接失败
     HTTPC_ERR_PROXY_AUTH = -12,    // 代理认证失败
-    HTTPC_ERR_PROXY_PARSE = -13     // 代理配置解析失败
+    HTTPC_ERR_PROXY_PARSE = -13,    // 代理配置解析失败
+    HTTPC_ERR_THROTTLED = -14       // 主机限流：等待令牌/Retry-After 超过上限（见 xlimit.h）
 } httpc_err_t;
 
+/**
+ * @brief 错误码名称（如 "connect"，用于日志和指标标签）
+ */
+const char* httpc_err_name(httpc_err_t err);
+
 /**
  * @brief HTTP 响应信息
  */
@@ -40,6 +48,38 @@ typedef struct {
     char* content_start;      // 内容起始位置
 } httpc_response_t;
 
+/**
+ * @brief 单跳请求（一次请求/一个重定向跳）的各阶段耗时（毫秒，单调时钟）
+ * @note 复用连接（连接池或同源重定向）没有 DNS/连接/代理/TLS 阶段，reused = 1。
+ *       HTTP/2 请求的各阶段按流记录：write_ms 截止到请求体发完，ttfb_ms 截止到收到响应 HEADERS
+ */
+typedef struct {
+    char host[256];           // 目标主机
+    int status;               // HTTP 状态码（0 = 没有收到响应）
+    int reused;               // 1 = 复用已建立的连接
+    int h2;                   // 1 = HTTP/2
+    double wait_ms;           // 主机限流等待
+    double dns_ms;            // DNS 解析
+    double connect_ms;        // TCP 连接（经代理时为连接代理服务器）
+    double proxy_ms;          // 代理握手（SOCKS5 / HTTP CONNECT）
+    double tls_ms;            // TLS 握手（含证书校验、ALPN）
+    double write_ms;          // 发送请求
+    double ttfb_ms;           // 请求发出 → 收到第一个字节
+    double body_ms;           // 第一个字节 → 响应读完
+    double total_ms;          // 本跳合计
+} httpc_hop_timing_t;
+
+#define HTTPC_TIMING_MAX_HOPS 6     // 首个请求 + 最多 5 次重定向
+
+/**
+ * @brief 一次 httpc_client_request（含重定向）的分阶段耗时
+ */
+typedef struct {
+    int hops;                                       // 记录的跳数
+    httpc_hop_timing_t hop[HTTPC_TIMING_MAX_HOPS];
+    double total_ms;                                // 各跳合计
+} httpc_timing_t;
+
 /**
  * @brief HTTP 客户端配置（ca_cert_path 可选）
  * @note ca_cert_path：NULL/空字符串 → 使用内置证书；有效路径 → 使用指定证书文件
@@ -70,8 +110,44 @@ typedef struct {
 
     // 代理配置（可选）
     const char* proxy;  // 代理字符串（如 "socks5://127.0.0.1:1080"，NULL或空字符串表示无代理）
+
+    // 协议选择（可选）
+    int http2;          // 1=HTTPS 时通过 ALPN 协商 HTTP/2，服务端不支持则回退 HTTP/1.1
+    int pipeline_depth; // HTTP/1.1 流水线深度（httpc_client_request_multi 用，0/1=不启用，上限 16）
+
+    // 内存（可选）
+    xarena_t* arena;    // 客户端上下文和临时缓冲从该竞技场分配（NULL 使用 malloc）；
+                        // 竞技场回退前必须先 httpc_client_free
+
+    // 响应体流式回调（可选）：2xx 响应体边接收边回调（已去掉 chunked 编码），响应仍写入 resp_buf；
+    // 返回非 0 表示已拿到需要的内容，停止接收（连接不再复用）；httpc_client_request_multi 不回调
+    int (*on_body)(void* ctx, const char* data, size_t len);
+    void* on_body_ctx;
+
+    // 分阶段耗时输出（可选）：httpc_client_request 结束时写入；
+    // httpc_request_retry 为最后一次尝试的记录（连接失败的尝试记为 status 0 的一跳）
+    httpc_timing_t* timing;
 } httpc_config_t;
 
+/**
+ * @brief 批量请求项（httpc_client_request_multi 用：同一主机上的多个请求）
+ */
+typedef struct {
+    const char* method;        // HTTP方法（NULL 使用 GET）
+    const char* url_path;      // URL路径
+    const char* content_type;  // Content-Type头（可选）
+    const char* data;          // POST/PUT数据（可选）
+    size_t data_length;        // 数据长度（0表示自动计算）
+    const char* extra_headers; // 额外头部（可选，格式同 httpc_config_t）
+
+    char* resp_buf;            // 接收响应的缓冲区
+    size_t resp_buf_len;       // 缓冲区长度
+    size_t actual_read;        // 输出：实际读取的响应长度
+    httpc_err_t err;           // 输出：该请求的错误码
+    double sent_at;            // 输出：请求（含请求体）发完的时间（xlimit_now_ms，仅 HTTP/2，0 = 未发完）
+    double first_byte_at;      // 输出：收到响应 HEADERS 的时间（同上，0 = 没有收到）
+} httpc_request_t;
+
 /**
  * @brief HTTP 客户端上下文（对外隐藏具体实现）
  */
@@ -86,6 +162,7 @@ httpc_client_t* httpc_client_init(const httpc_config_t* config);
 
 /**
  * @brief 发送 HTTP/HTTPS 请求并接收响应（自动处理重定向）
+ * @note 每次发送前按主机限流（xlimit_acquire），响应状态和 Retry-After 反馈给限流器
  * @param client 客户端上下文
  * @param resp_buf 接收响应的缓冲区
  * @param resp_buf_len 缓冲区长度
@@ -97,6 +174,24 @@ httpc_err_t httpc_client_request(httpc_client_t* client,
     size_t resp_buf_len,
     size_t* actual_read);
 
+/**
+ * @brief 在同一连接上执行一批请求（不处理重定向）
+ * @note HTTP/2 连接上作为并发流多路复用；HTTP/1.1 连接上在 keep-alive 连接上按顺序发送，
+ *       config.pipeline_depth > 1 时对 GET/HEAD 请求启用流水线（服务端不支持时自动退回顺序发送）。
+ *       每个请求都经过主机限流器，并发流数/流水线深度不超过主机当前的 AIMD 窗口
+ * @param client 客户端上下文
+ * @param reqs 请求数组（每项的 resp_buf/actual_read/err 为输入输出）
+ * @param count 请求个数
+ * @return 错误码（HTTPC_SUCCESS 表示所有请求都成功，否则为第一个失败请求的错误码）
+ */
+httpc_err_t httpc_client_request_multi(httpc_client_t* client, httpc_request_t* reqs, size_t count);
+
+/**
+ * @brief 当前连接协商到的协议
+ * @return "h2" 或 "http/1.1"
+ */
+const char* httpc_client_protocol(const httpc_client_t* client);
+
 /**
  * @brief 解析HTTP响应头
  * @param response_data 完整的HTTP响应数据
@@ -107,10 +202,88 @@ httpc_err_t httpc_parse_response(const char* response_data, httpc_response_t* re
 
 /**
  * @brief 释放 HTTP 客户端资源
+ * @note 完整读取且可复用的连接放回连接池，同目标（scheme/主机/端口/代理/CA）的下一个客户端直接接管
  * @param client 客户端上下文
  */
 void httpc_client_free(httpc_client_t* client);
 
+/**
+ * @brief 关闭连接池中的全部空闲连接（程序退出前调用）
+ */
+void httpc_pool_clear(void);
+
+/**
+ * @brief 连接改写（同 curl --connect-to）：连接 HOST:PORT 时改为连接 ADDR:PORT
+ * @note SNI、Host 头和证书校验仍使用原主机名；用于把引擎主机指向本地模拟服务器做测试/基准。
+ *       经代理时改写的是隧道目标
+ * @param spec "HOST:PORT:ADDR:PORT[,...]"，HOST/PORT 为空匹配任意，ADDR/PORT 为空保持原值，
+ *             IPv6 地址写在 [] 内；先匹配的条目生效；NULL/空字符串清除全部改写
+ * @return 0 成功，-1 格式错误或条目过多（已清除全部改写）
+ */
+int httpc_set_connect_to(const char* spec);
+
+/**
+ * @brief 默认 CA 证书文件：config.ca_cert_path 为空时代替内置证书
+ * @param path PEM 文件路径，NULL/空字符串恢复内置证书
+ */
+void httpc_set_default_ca(const char* path);
+
+/**
+ * @brief 把分阶段耗时格式化为一行文本或一个 JSON 对象（不含换行）
+ * @param json 0 = 文本："host status dns=.. connect=.. ... | 下一跳 ... | total=.."；1 = JSON
+ * @return 写入的长度（不含终止符，超出 buf_len 时截断）
+ */
+size_t httpc_timing_format(const httpc_timing_t* timing, int json, char* buf, size_t buf_len);
+
+/**
+ * @brief 每个 httpc_client_request 结束后把分阶段耗时输出一行到 out（用于按引擎统计线上延迟）
+ * @param out 输出流，NULL 关闭
+ * @param json 同 httpc_timing_format
+ */
+void httpc_set_timing_output(FILE* out, int json);
+
+/**
+ * @brief 失败分类（httpc_retry_classify 用）
+ */
+typedef enum {
+    HTTPC_RETRY_NO = 0,         // 致命错误或成功：不重试
+    HTTPC_RETRY_SAFE,           // 请求未被服务端处理（连接失败、429/503）：任何方法都可重发
+    HTTPC_RETRY_IDEMPOTENT      // 请求可能已被处理（读写中断、500/502/504/408）：只重发幂等请求
+} httpc_retry_class_t;
+
+/**
+ * @brief 重试策略
+ * @note 退避采用 decorrelated jitter：sleep = min(cap, random(base, 3 * 上次sleep))；
+ *       全部尝试（含请求耗时和等待）不超过 deadline_ms
+ */
+typedef struct {
+    int max_attempts;       // 总尝试次数（含首次），0 使用默认 3
+    int base_ms;            // 退避基数，0 使用默认 100
+    int cap_ms;             // 单次退避上限，0 使用默认 2000
+    int deadline_ms;        // 总时间预算，0 使用默认 10000
+    int idempotent;         // 1 = 把非幂等方法（POST 等）也视为幂等（如翻译接口的 POST）
+} httpc_retry_t;
+
+/**
+ * @brief 按错误码和 HTTP 状态码判断能否重试
+ * @param err 请求错误码
+ * @param status_code 请求成功时的 HTTP 状态码（err 非 HTTPC_SUCCESS 时忽略）
+ */
+httpc_retry_class_t httpc_retry_classify(httpc_err_t err, int status_code);
+
+/**
+ * @brief 带重试的单次请求：init → request（含重定向）→ free，失败时按策略退避后重发
+ * @note 连接经连接池复用：HTTP 层可重试的响应（429/503 等）之后连接放回池中，下次尝试直接接管；
+ *       传输错误的连接被丢弃，下次尝试重新建立。on_body 已收到部分响应体后不再重试（回调无法撤销）。
+ *       最后一次尝试得到的可重试状态码（如 503）仍以 HTTPC_SUCCESS 返回，由调用方检查状态码
+ * @param config 客户端配置
+ * @param policy 重试策略（NULL 使用默认值）
+ * @param attempts 输出：实际尝试次数（可传 NULL）
+ * @return 最后一次尝试的错误码
+ */
+httpc_err_t httpc_request_retry(const httpc_config_t* config, const httpc_retry_t* policy,
+    char* resp_buf, size_t resp_buf_len, size_t* actual_read, int* attempts);
+
 /**
  * @brief 动态拼接HTTP请求字符串
  * @param config HTTP配置
@@ -118,6 +291,34 @@ void httpc_client_free(httpc_client_t* client);
  */
 char* httpc_build_request(const httpc_config_t* config);
 
+/**
+ * @brief URL 编码方式
+ */
+typedef enum {
+    HTTPC_URL_FORM = 0,        // application/x-www-form-urlencoded：空格 → '+'
+    HTTPC_URL_COMPONENT = 1    // encodeURIComponent 风格：空格 → "%20"
+} httpc_url_mode_t;
+
+/**
+ * @brief 计算 URL 编码后的准确长度（不含终止符）
+ * @param str 要编码的数据
+ * @param len 数据长度
+ * @param mode 编码方式
+ * @return 编码后长度
+ */
+size_t httpc_url_encode_len(const char* str, size_t len, httpc_url_mode_t mode);
+
+/**
+ * @brief URL 编码到调用者提供的缓冲区
+ * @param str 要编码的数据
+ * @param len 数据长度
+ * @param mode 编码方式
+ * @param out 输出缓冲区（以 '\0' 结尾）
+ * @param out_size 缓冲区长度（不足时不写入）
+ * @return 编码后长度（>= out_size 表示缓冲区不足，与 snprintf 相同）
+ */
+size_t httpc_url_encode_into(const char* str, size_t len, httpc_url_mode_t mode, char* out, size_t out_size);
+
 /**
  * @brief URL编码字符串
  * @param str 要编码的字符串
@@ -126,9 +327,17 @@ char* httpc_build_request(const httpc_config_t* config);
 char* httpc_url_encode(const char* str);
 
 /**
- * @brief 简单的语言检测
+ * @brief URL编码字符串（结果从竞技场分配）
+ * @param str 要编码的字符串
+ * @param arena 竞技场（NULL 时同 httpc_url_encode，需要调用者释放）
+ * @return 编码后的字符串
+ */
+char* httpc_url_encode_arena(const char* str, xarena_t* arena);
+
+/**
+ * @brief 离线语言检测（见 xlang_detect，输入可为 GBK/UTF-8）
  * @param text 要检测的文本
- * @return 语言代码（"en"或"zh-cn"）
+ * @return 语言代码（如 "en"、"zh-cn"、"zh-tw"、"ja"、"ko"、"ru"），无法判断时为 "en"
  */
 const char* httpc_detect_language(const char* text);
 
@@ -153,12 +362,22 @@ int httpc_extract_pattern(const char* content, const char* start_pattern, const
 int httpc_any_to_utf8(const char* input_str, char* output_buf, size_t buf_len);
 
 /**
- * @brief 将 UTF-8 编码的 Unicode 字符串解码为 UTF-8（对外接口）
- * @param start 起始位置
+ * @brief 取得输入的 UTF-8 形式（已是合法 UTF-8 时零拷贝）
+ * @param input_str 输入字符串（GBK/UTF-8）
+ * @param output_buf 需要转码时的输出缓冲区
+ * @param buf_len 缓冲区长度
+ * @param out_len 输出：UTF-8 长度（可传 NULL）
+ * @return input_str 本身（已是 UTF-8）或 output_buf（GBK 转码结果），失败返回 NULL
+ */
+const char* httpc_as_utf8(const char* input_str, char* output_buf, size_t buf_len, size_t* out_len);
+
+/**
+ * @brief 解码 JSON 字符串转义（\n \" \\ \/ \uXXXX 及代理对等），结果为 UTF-8（对外接口）
+ * @param start 起始位置（引号之内）
  * @param len 长度
- * @param result 结果缓冲区
+ * @param result 结果缓冲区（总是以 '\0' 结尾）
  * @param result_len 结果缓冲区长度
- * @return 成功: 转换后长度, 失败: -1
+ * @return 成功: 转换后长度, 失败（空间不足，已截断）: -1
  */
 int httpc_decode_unicode(const char* start, size_t len, char* result, size_t result_len);
 
@@ -0,0 +1,1048 @@
+#include "xhttpc_h2.h"
+#include "xlimit.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+/*
+ * 精简 HTTP/2 客户端（RFC 7540 / RFC 7541）
+ *   - 仅客户端、仅 TLS（ALPN "h2"），不支持服务端推送（SETTINGS_ENABLE_PUSH=0）
+ *   - HPACK 编码只用静态表 + 不索引字面量；解码支持动态表和 Huffman
+ *   - 响应以 "HTTP/2 <status>\r\n头部\r\n\r\n响应体" 的形式写入调用方缓冲区，
+ *     现有的 httpc_parse_response / 各引擎解析逻辑无需区分协议
+ */
+
+#define H2_FRAME_DATA           0x0
+#define H2_FRAME_HEADERS        0x1
+#define H2_FRAME_PRIORITY       0x2
+#define H2_FRAME_RST_STREAM     0x3
+#define H2_FRAME_SETTINGS       0x4
+#define H2_FRAME_PUSH_PROMISE   0x5
+#define H2_FRAME_PING           0x6
+#define H2_FRAME_GOAWAY         0x7
+#define H2_FRAME_WINDOW_UPDATE  0x8
+#define H2_FRAME_CONTINUATION   0x9
+
+#define H2_FLAG_END_STREAM      0x1
+#define H2_FLAG_ACK             0x1
+#define H2_FLAG_END_HEADERS     0x4
+#define H2_FLAG_PADDED          0x8
+#define H2_FLAG_PRIORITY        0x20
+
+#define H2_SETTINGS_HEADER_TABLE_SIZE       0x1
+#define H2_SETTINGS_ENABLE_PUSH             0x2
+#define H2_SETTINGS_MAX_CONCURRENT_STREAMS  0x3
+#define H2_SETTINGS_INITIAL_WINDOW_SIZE     0x4
+#define H2_SETTINGS_MAX_FRAME_SIZE          0x5
+
+#define H2_ERR_NO_ERROR         0x0
+#define H2_ERR_PROTOCOL_ERROR   0x1
+#define H2_ERR_FLOW_CONTROL     0x3
+#define H2_ERR_FRAME_SIZE       0x6
+#define H2_ERR_REFUSED_STREAM   0x7
+#define H2_ERR_COMPRESSION      0x9
+
+#define H2_DEFAULT_WINDOW       65535
+#define H2_DEFAULT_FRAME_SIZE   16384
+#define H2_LOCAL_STREAM_WINDOW  (1 << 20)   // 每个流的接收窗口
+#define H2_LOCAL_CONN_WINDOW    (1 << 24)   // 连接级接收窗口
+#define H2_MAX_STREAMS          32          // 单次 execute 同时打开的流上限
+#define H2_HEADER_BLOCK_MAX     (64 * 1024) // 单个头部块（含 CONTINUATION）上限
+#define H2_HPACK_STRING_MAX     8192        // 单个头部名/值解码后上限
+#define H2_HPACK_TABLE_SIZE     4096        // 动态表大小（使用协议默认值）
+#define H2_HPACK_DYN_MAX        (H2_HPACK_TABLE_SIZE / 32)
+
+static const char H2_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+/**
+ * @brief HPACK 静态表（RFC 7541 附录 A），下标 0 空缺
+ */
+static const char* const hpack_static_table[62][2] = {
+    {NULL, NULL},
+    {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"},
+    {":path", "/index.html"}, {":scheme", "http"}, {":scheme", "https"}, {":status", "200"},
+    {":status", "204"}, {":status", "206"}, {":status", "304"}, {":status", "400"},
+    {":status", "404"}, {":status", "500"}, {"accept-charset", ""}, {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""}, {"access-control-allow-origin", ""},
+    {"age", ""}, {"allow", ""}, {"authorization", ""}, {"cache-control", ""},
+    {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""}, {"content-length", ""},
+    {"content-location", ""}, {"content-range", ""}, {"content-type", ""}, {"cookie", ""},
+    {"date", ""}, {"etag", ""}, {"expect", ""}, {"expires", ""},
+    {"from", ""}, {"host", ""}, {"if-match", ""}, {"if-modified-since", ""},
+    {"if-none-match", ""}, {"if-range", ""}, {"if-unmodified-since", ""}, {"last-modified", ""},
+    {"link", ""}, {"location", ""}, {"max-forwards", ""}, {"proxy-authenticate", ""},
+    {"proxy-authorization", ""}, {"range", ""}, {"referer", ""}, {"refresh", ""},
+    {"retry-after", ""}, {"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""},
+    {"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""}, {"via", ""},
+    {"www-authenticate", ""}
+};
+
+/**
+ * @brief HPACK Huffman 码表（RFC 7541 附录 B 为范式 Huffman 码）
+ * @note 只需每个码长的符号数和按 (码长, 符号) 排序的符号序列即可解码
+ */
+static const uint8_t hpack_huff_count[31] = {
+    0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3, 0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4
+};
+
+static const uint16_t hpack_huff_symbol[257] = {
+    48, 49, 50, 97, 99, 101, 105, 111, 115, 116, 32, 37, 45, 46, 47, 51,
+    52, 53, 54, 55, 56, 57, 61, 65, 95, 98, 100, 102, 103, 104, 108, 109,
+    110, 112, 114, 117, 58, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+    77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89, 106, 107, 113, 118,
+    119, 120, 121, 122, 38, 42, 44, 59, 88, 90, 33, 34, 40, 41, 63, 39,
+    43, 124, 35, 62, 0, 36, 64, 91, 93, 126, 94, 125, 60, 96, 123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161, 167, 172, 176, 177,
+    179, 209, 216, 217, 227, 229, 230, 129, 132, 133, 134, 136, 146, 154, 156, 160,
+    163, 164, 169, 170, 173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150, 151, 152, 155, 157,
+    158, 165, 166, 168, 174, 175, 180, 182, 183, 188, 191, 197, 231, 239, 9, 142,
+    144, 145, 148, 159, 171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243, 255, 203, 204, 211,
+    212, 214, 221, 222, 223, 241, 244, 245, 246, 247, 248, 250, 251, 252, 253, 254,
+    2, 3, 4, 5, 6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20,
+    21, 23, 24, 25, 26, 27, 28, 29, 30, 31, 127, 220, 249, 10, 13, 22,
+    256
+};
+
+/**
+ * @brief HPACK 动态表条目（名和值存放在同一块内存）
+ */
+typedef struct {
+    char* name;
+    size_t name_len;
+    char* value;
+    size_t value_len;
+} hpack_entry_t;
+
+/**
+ * @brief 单个流的状态
+ */
+typedef struct {
+    uint32_t id;                // 流 ID（0 表示空闲槽位）
+    httpc_request_t* req;       // 对应的请求项
+    const char* body;           // 待发送请求体
+    size_t body_len;
+    size_t body_sent;
+    int64_t send_window;        // 对端给该流的发送窗口
+    uint32_t recv_unacked;      // 已接收未归还的窗口
+    size_t resp_len;            // 已写入 resp_buf 的长度
+    int headers_done;           // 已写出最终响应头
+    int remote_closed;          // 收到 END_STREAM
+} h2_stream_t;
+
+struct httpc_h2_s {
+    httpc_h2_io_t io;
+    char authority[300];
+    uint32_t debug_level;
+
+    uint32_t next_stream_id;
+    int broken;                 // 连接级错误，不可再用
+    int goaway;                 // 收到 GOAWAY
+    uint32_t goaway_last_id;
+    int refused;                // 对端不接受新流（并发上限为 0 或 REFUSED_STREAM）
+
+    // 对端设置
+    uint32_t peer_max_concurrent;
+    uint32_t peer_initial_window;
+    uint32_t peer_max_frame;
+    int64_t conn_send_window;
+    uint32_t conn_recv_unacked;
+
+    // HPACK 解码动态表（下标 0 为最新条目）
+    hpack_entry_t dyn[H2_HPACK_DYN_MAX];
+    int dyn_count;
+    size_t dyn_size;
+    size_t dyn_max;
+
+    // 头部块拼接（HEADERS + CONTINUATION）
+    unsigned char* hdr_block;
+    size_t hdr_len;
+    size_t hdr_cap;
+    uint32_t hdr_stream;
+    int hdr_end_stream;
+    int hdr_pending;
+
+    // 接收缓冲：一个最大帧（16K 负载 + 9 字节帧头）
+    unsigned char in[H2_DEFAULT_FRAME_SIZE + 9];
+    size_t in_len;
+
+    h2_stream_t streams[H2_MAX_STREAMS];
+
+    char name_buf[H2_HPACK_STRING_MAX];
+    char value_buf[H2_HPACK_STRING_MAX];
+};
+
+// ============================== 帧收发 ==============================
+
+static void h2_put_frame_header(unsigned char* p, size_t len, uint8_t type, uint8_t flags, uint32_t stream_id) {
+    p[0] = (unsigned char)((len >> 16) & 0xFF);
+    p[1] = (unsigned char)((len >> 8) & 0xFF);
+    p[2] = (unsigned char)(len & 0xFF);
+    p[3] = type;
+    p[4] = flags;
+    p[5] = (unsigned char)((stream_id >> 24) & 0x7F);
+    p[6] = (unsigned char)((stream_id >> 16) & 0xFF);
+    p[7] = (unsigned char)((stream_id >> 8) & 0xFF);
+    p[8] = (unsigned char)(stream_id & 0xFF);
+}
+
+static uint32_t h2_get_u32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void h2_put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static int h2_send_frame(httpc_h2_t* h2, uint8_t type, uint8_t flags, uint32_t stream_id,
+                         const unsigned char* payload, size_t len) {
+    unsigned char head[9];
+    h2_put_frame_header(head, len, type, flags, stream_id);
+    if (h2->io.send_all(h2->io.ctx, head, sizeof(head)) <= 0) {
+        h2->broken = 1;
+        return -1;
+    }
+    if (len > 0 && h2->io.send_all(h2->io.ctx, payload, len) <= 0) {
+        h2->broken = 1;
+        return -1;
+    }
+    return 0;
+}
+
+static int h2_send_window_update(httpc_h2_t* h2, uint32_t stream_id, uint32_t increment) {
+    unsigned char p[4];
+    h2_put_u32(p, increment & 0x7FFFFFFF);
+    return h2_send_frame(h2, H2_FRAME_WINDOW_UPDATE, 0, stream_id, p, sizeof(p));
+}
+
+static void h2_send_goaway(httpc_h2_t* h2, uint32_t error_code) {
+    unsigned char p[8];
+    h2_put_u32(p, 0);
+    h2_put_u32(p + 4, error_code);
+    h2_send_frame(h2, H2_FRAME_GOAWAY, 0, 0, p, sizeof(p));
+}
+
+/**
+ * @brief 读取一个完整帧到 h2->in
+ * @return 0 成功，-1 连接关闭/出错
+ */
+static int h2_read_frame(httpc_h2_t* h2, uint8_t* type, uint8_t* flags, uint32_t* stream_id,
+                         unsigned char** payload, size_t* len) {
+    size_t need = 9;
+    while (h2->in_len < need) {
+        int ret = h2->io.recv_some(h2->io.ctx, h2->in + h2->in_len, need - h2->in_len);
+        if (ret <= 0) return -1;
+        h2->in_len += (size_t)ret;
+
+        if (need == 9 && h2->in_len >= 9) {
+            size_t frame_len = ((size_t)h2->in[0] << 16) | ((size_t)h2->in[1] << 8) | h2->in[2];
+            if (frame_len > H2_DEFAULT_FRAME_SIZE) {
+                // 我们没有放大 SETTINGS_MAX_FRAME_SIZE，超长即协议错误
+                h2_send_goaway(h2, H2_ERR_FRAME_SIZE);
+                return -1;
+            }
+            need = 9 + frame_len;
+        }
+    }
+
+    *len = ((size_t)h2->in[0] << 16) | ((size_t)h2->in[1] << 8) | h2->in[2];
+    *type = h2->in[3];
+    *flags = h2->in[4];
+    *stream_id = h2_get_u32(h2->in + 5) & 0x7FFFFFFF;
+    *payload = h2->in + 9;
+    h2->in_len = 0;
+    return 0;
+}
+
+// ============================== HPACK ==============================
+
+static int hpack_decode_int(const unsigned char** pp, const unsigned char* end, int prefix_bits, uint32_t* out) {
+    const unsigned char* p = *pp;
+    if (p >= end) return -1;
+
+    uint32_t max_prefix = (1u << prefix_bits) - 1;
+    uint32_t v = *p++ & max_prefix;
+    if (v == max_prefix) {
+        int shift = 0;
+        for (;;) {
+            if (p >= end || shift > 28) return -1;
+            unsigned char b = *p++;
+            v += (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+            if (!(b & 0x80)) break;
+        }
+    }
+    *pp = p;
+    *out = v;
+    return 0;
+}
+
+static void hpack_encode_int(unsigned char** pp, uint32_t v, int prefix_bits, unsigned char first_byte_flags) {
+    unsigned char* p = *pp;
+    uint32_t max_prefix = (1u << prefix_bits) - 1;
+    if (v < max_prefix) {
+        *p++ = (unsigned char)(first_byte_flags | v);
+    } else {
+        *p++ = (unsigned char)(first_byte_flags | max_prefix);
+        v -= max_prefix;
+        while (v >= 0x80) {
+            *p++ = (unsigned char)((v & 0x7F) | 0x80);
+            v >>= 7;
+        }
+        *p++ = (unsigned char)v;
+    }
+    *pp = p;
+}
+
+/**
+ * @brief 范式 Huffman 解码（RFC 7541 5.2）
+ */
+static int hpack_huffman_decode(const unsigned char* in, size_t in_len, char* out, size_t out_cap, size_t* out_len) {
+    size_t o = 0;
+    int code = 0, first = 0, index = 0, len = 0;
+    int ones = 1;  // 未完成的码全部为 1（EOS 前缀）才是合法填充
+
+    for (size_t i = 0; i < in_len; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            int b = (in[i] >> bit) & 1;
+            code |= b;
+            ones &= b;
+            len++;
+
+            int count = hpack_huff_count[len];
+            if (code - first < count) {
+                int sym = hpack_huff_symbol[index + (code - first)];
+                if (sym == 256 || o >= out_cap) return -1;  // EOS 不能出现在数据中
+                out[o++] = (char)sym;
+                code = first = index = len = 0;
+                ones = 1;
+                continue;
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+            if (len >= 30) return -1;
+        }
+    }
+
+    if (len > 7 || !ones) return -1;
+    *out_len = o;
+    return 0;
+}
+
+static int hpack_decode_string(const unsigned char** pp, const unsigned char* end, char* out, size_t out_cap, size_t* out_len) {
+    if (*pp >= end) return -1;
+    int huffman = (**pp & 0x80) != 0;
+
+    uint32_t len;
+    if (hpack_decode_int(pp, end, 7, &len) != 0 || (size_t)(end - *pp) < len) return -1;
+
+    if (huffman) {
+        if (hpack_huffman_decode(*pp, len, out, out_cap, out_len) != 0) return -1;
+    } else {
+        if (len > out_cap) return -1;
+        memcpy(out, *pp, len);
+        *out_len = len;
+    }
+    *pp += len;
+    return 0;
+}
+
+static void hpack_evict(httpc_h2_t* h2, size_t max_size) {
+    while (h2->dyn_count > 0 && h2->dyn_size > max_size) {
+        hpack_entry_t* e = &h2->dyn[h2->dyn_count - 1];
+        h2->dyn_size -= e->name_len + e->value_len + 32;
+        free(e->name);
+        h2->dyn_count--;
+    }
+}
+
+static void hpack_insert(httpc_h2_t* h2, const char* name, size_t name_len, const char* value, size_t value_len) {
+    size_t entry_size = name_len + value_len + 32;
+    if (entry_size > h2->dyn_max) {
+        // 超过表容量：清空表，条目本身不入表（RFC 7541 4.4）
+        hpack_evict(h2, 0);
+        return;
+    }
+    hpack_evict(h2, h2->dyn_max - entry_size);
+
+    char* mem = (char*)malloc(name_len + value_len + 2);
+    if (!mem) return;
+    memcpy(mem, name, name_len);
+    mem[name_len] = '\0';
+    memcpy(mem + name_len + 1, value, value_len);
+    mem[name_len + 1 + value_len] = '\0';
+
+    if (h2->dyn_count == H2_HPACK_DYN_MAX) {
+        hpack_evict(h2, h2->dyn_size - 1);
+    }
+    memmove(&h2->dyn[1], &h2->dyn[0], sizeof(hpack_entry_t) * (size_t)h2->dyn_count);
+    h2->dyn[0].name = mem;
+    h2->dyn[0].name_len = name_len;
+    h2->dyn[0].value = mem + name_len + 1;
+    h2->dyn[0].value_len = value_len;
+    h2->dyn_count++;
+    h2->dyn_size += entry_size;
+}
+
+static int hpack_lookup(const httpc_h2_t* h2, uint32_t index, const char** name, size_t* name_len,
+                        const char** value, size_t* value_len) {
+    if (index == 0) return -1;
+    if (index < 62) {
+        *name = hpack_static_table[index][0];
+        *name_len = strlen(*name);
+        *value = hpack_static_table[index][1];
+        *value_len = strlen(*value);
+        return 0;
+    }
+    index -= 62;
+    if ((int)index >= h2->dyn_count) return -1;
+    *name = h2->dyn[index].name;
+    *name_len = h2->dyn[index].name_len;
+    *value = h2->dyn[index].value;
+    *value_len = h2->dyn[index].value_len;
+    return 0;
+}
+
+// ============================== 流与响应 ==============================
+
+static h2_stream_t* h2_find_stream(httpc_h2_t* h2, uint32_t stream_id) {
+    if (stream_id == 0) return NULL;
+    for (int i = 0; i < H2_MAX_STREAMS; i++) {
+        if (h2->streams[i].id == stream_id) return &h2->streams[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief 向流的响应缓冲区追加数据（超出部分截断，与 HTTP/1.1 路径行为一致）
+ */
+static void h2_stream_append(h2_stream_t* st, const void* data, size_t len) {
+    httpc_request_t* req = st->req;
+    if (!req || req->resp_buf_len == 0) return;
+
+    size_t room = req->resp_buf_len - 1 - st->resp_len;
+    if (len > room) len = room;
+    memcpy(req->resp_buf + st->resp_len, data, len);
+    st->resp_len += len;
+    req->resp_buf[st->resp_len] = '\0';
+}
+
+static void h2_stream_finish(httpc_h2_t* h2, h2_stream_t* st, httpc_err_t err) {
+    if (st->req) {
+        st->req->actual_read = st->resp_len;
+        st->req->err = err;
+        if (h2->debug_level > 0) {
+            printf("[DEBUG] h2 stream %u done: err=%d, len=%zu\n", st->id, err, st->resp_len);
+        }
+    }
+    memset(st, 0, sizeof(*st));
+}
+
+/**
+ * @brief 解码一个完整的头部块
+ * @note 无论流是否还存在都必须解码，以保持 HPACK 动态表同步
+ */
+static int h2_decode_header_block(httpc_h2_t* h2, h2_stream_t* st) {
+    const unsigned char* p = h2->hdr_block;
+    const unsigned char* end = h2->hdr_block + h2->hdr_len;
+
+    // 第一个响应头块：先占位写状态行；1xx 和 trailer 只解码不输出
+    int emit = st && !st->headers_done;
+    int informational = 0;
+    size_t block_start = st ? st->resp_len : 0;
+
+    while (p < end) {
+        unsigned char b = *p;
+        const char* name = NULL;
+        const char* value = NULL;
+        size_t name_len = 0, value_len = 0;
+        uint32_t index;
+
+        if (b & 0x80) {
+            // 索引表示
+            if (hpack_decode_int(&p, end, 7, &index) != 0 ||
+                hpack_lookup(h2, index, &name, &name_len, &value, &value_len) != 0) {
+                return -1;
+            }
+        } else if ((b & 0xE0) == 0x20) {
+            // 动态表大小更新
+            if (hpack_decode_int(&p, end, 5, &index) != 0 || index > H2_HPACK_TABLE_SIZE) return -1;
+            h2->dyn_max = index;
+            hpack_evict(h2, h2->dyn_max);
+            continue;
+        } else {
+            // 字面量：01 带增量索引（6 位前缀），0000/0001 不索引（4 位前缀）
+            int incremental = (b & 0xC0) == 0x40;
+            if (hpack_decode_int(&p, end, incremental ? 6 : 4, &index) != 0) return -1;
+
+            if (index) {
+                const char* idx_value;
+                size_t idx_value_len;
+                if (hpack_lookup(h2, index, &name, &name_len, &idx_value, &idx_value_len) != 0) return -1;
+                if (name_len > sizeof(h2->name_buf)) return -1;
+                memcpy(h2->name_buf, name, name_len);
+            } else if (hpack_decode_string(&p, end, h2->name_buf, sizeof(h2->name_buf), &name_len) != 0) {
+                return -1;
+            }
+            name = h2->name_buf;
+
+            if (hpack_decode_string(&p, end, h2->value_buf, sizeof(h2->value_buf), &value_len) != 0) return -1;
+            value = h2->value_buf;
+
+            if (incremental) {
+                hpack_insert(h2, name, name_len, value, value_len);
+            }
+        }
+
+        if (!emit) continue;
+
+        if (name_len == 7 && memcmp(name, ":status", 7) == 0) {
+            char line[32];
+            int status = atoi(value);
+            informational = status >= 100 && status < 200;
+            int n = snprintf(line, sizeof(line), "HTTP/2 %.*s\r\n", (int)(value_len > 3 ? 3 : value_len), value);
+            h2_stream_append(st, line, (size_t)n);
+        } else if (name_len > 0 && name[0] != ':') {
+            h2_stream_append(st, name, name_len);
+            h2_stream_append(st, ": ", 2);
+            h2_stream_append(st, value, value_len);
+            h2_stream_append(st, "\r\n", 2);
+        }
+    }
+
+    if (emit) {
+        if (informational) {
+            // 1xx 中间响应：回退，等待最终响应头
+            st->resp_len = block_start;
+            st->req->resp_buf[st->resp_len] = '\0';
+        } else {
+            h2_stream_append(st, "\r\n", 2);
+            st->headers_done = 1;
+        }
+    }
+    return 0;
+}
+
+// ============================== 请求编码 ==============================
+
+static int hpack_static_name_index(const char* name) {
+    for (int i = 15; i < 62; i++) {
+        if (strcmp(hpack_static_table[i][0], name) == 0) return i;
+    }
+    return 0;
+}
+
+static int h2_put_header(unsigned char** pp, const unsigned char* end, const char* name, const char* value, size_t value_len) {
+    size_t name_len = strlen(name);
+    if ((size_t)(end - *pp) < name_len + value_len + 16) return -1;
+
+    // 不索引字面量（0000xxxx），名字能用静态表就用索引
+    int index = hpack_static_name_index(name);
+    if (index) {
+        hpack_encode_int(pp, (uint32_t)index, 4, 0x00);
+    } else {
+        hpack_encode_int(pp, 0, 4, 0x00);
+        hpack_encode_int(pp, (uint32_t)name_len, 7, 0x00);
+        memcpy(*pp, name, name_len);
+        *pp += name_len;
+    }
+    hpack_encode_int(pp, (uint32_t)value_len, 7, 0x00);
+    memcpy(*pp, value, value_len);
+    *pp += value_len;
+    return 0;
+}
+
+/**
+ * @brief HTTP/2 禁止的连接相关头部（RFC 7540 8.1.2.2）及由伪头部替代的 Host
+ */
+static int h2_is_forbidden_header(const char* name) {
+    static const char* const forbidden[] = {
+        "connection", "keep-alive", "proxy-connection", "transfer-encoding", "upgrade", "host", "te", NULL
+    };
+    for (int i = 0; forbidden[i]; i++) {
+        if (strcmp(name, forbidden[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 编码请求头部块
+ * @return 块长度，-1 表示缓冲区不足
+ */
+static long h2_encode_request(const httpc_h2_t* h2, const httpc_config_t* config, const httpc_request_t* req,
+                              size_t body_len, unsigned char* buf, size_t buf_len) {
+    unsigned char* p = buf;
+    const unsigned char* end = buf + buf_len;
+    const char* method = req->method ? req->method : "GET";
+    const char* path = req->url_path ? req->url_path : "/";
+    char num[32];
+
+    // 伪头部
+    if (strcmp(method, "GET") == 0) {
+        *p++ = 0x82;
+    } else if (strcmp(method, "POST") == 0) {
+        *p++ = 0x83;
+    } else if (h2_put_header(&p, end, ":method", method, strlen(method)) != 0) {
+        return -1;
+    }
+    *p++ = 0x87;  // :scheme https
+    if (h2_put_header(&p, end, ":authority", h2->authority, strlen(h2->authority)) != 0) return -1;
+    if (strcmp(path, "/") == 0) {
+        *p++ = 0x84;
+    } else if (h2_put_header(&p, end, ":path", path, strlen(path)) != 0) {
+        return -1;
+    }
+
+    const char* ua = config && config->user_agent ? config->user_agent :
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36";
+    if (h2_put_header(&p, end, "user-agent", ua, strlen(ua)) != 0) return -1;
+
+    if (req->data) {
+        const char* ct = req->content_type ? req->content_type : "application/x-www-form-urlencoded";
+        if (h2_put_header(&p, end, "content-type", ct, strlen(ct)) != 0) return -1;
+        int n = snprintf(num, sizeof(num), "%zu", body_len);
+        if (h2_put_header(&p, end, "content-length", num, (size_t)n) != 0) return -1;
+    }
+
+    // 额外头部："Name: value\r\nName2: value2"，名字转小写
+    const char* h = req->extra_headers;
+    while (h && *h) {
+        const char* eol = strstr(h, "\r\n");
+        size_t line_len = eol ? (size_t)(eol - h) : strlen(h);
+        const char* colon = memchr(h, ':', line_len);
+        if (colon && colon > h && (size_t)(colon - h) < 64) {
+            char name[64];
+            size_t name_len = (size_t)(colon - h);
+            for (size_t i = 0; i < name_len; i++) name[i] = (char)tolower((unsigned char)h[i]);
+            name[name_len] = '\0';
+
+            const char* v = colon + 1;
+            while (v < h + line_len && (*v == ' ' || *v == '\t')) v++;
+            if (!h2_is_forbidden_header(name) &&
+                h2_put_header(&p, end, name, v, (size_t)(h + line_len - v)) != 0) {
+                return -1;
+            }
+        }
+        h = eol ? eol + 2 : h + line_len;
+    }
+
+    return (long)(p - buf);
+}
+
+/**
+ * @brief 打开新流：发送 HEADERS（必要时拆分 CONTINUATION）
+ */
+static int h2_open_stream(httpc_h2_t* h2, const httpc_config_t* config, h2_stream_t* st, httpc_request_t* req) {
+    unsigned char block[8192];
+    size_t body_len = req->data ? (req->data_length > 0 ? req->data_length : strlen(req->data)) : 0;
+
+    long block_len = h2_encode_request(h2, config, req, body_len, block, sizeof(block));
+    if (block_len < 0) {
+        req->err = HTTPC_ERR_PARAM;
+        return -1;
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->id = h2->next_stream_id;
+    h2->next_stream_id += 2;
+    st->req = req;
+    st->body = req->data;
+    st->body_len = body_len;
+    st->send_window = h2->peer_initial_window;
+    req->err = HTTPC_ERR_READ;
+    req->actual_read = 0;
+    req->sent_at = 0;
+    req->first_byte_at = 0;
+    if (req->resp_buf && req->resp_buf_len > 0) req->resp_buf[0] = '\0';
+
+    size_t off = 0;
+    int first = 1;
+    while (first || off < (size_t)block_len) {
+        size_t n = (size_t)block_len - off;
+        if (n > h2->peer_max_frame) n = h2->peer_max_frame;
+        uint8_t flags = 0;
+        if (off + n == (size_t)block_len) flags |= H2_FLAG_END_HEADERS;
+        if (first && body_len == 0) flags |= H2_FLAG_END_STREAM;
+        if (h2_send_frame(h2, first ? H2_FRAME_HEADERS : H2_FRAME_CONTINUATION, flags, st->id, block + off, n) != 0) {
+            return -1;
+        }
+        off += n;
+        first = 0;
+    }
+    if (body_len == 0) req->sent_at = xlimit_now_ms();
+
+    if (h2->debug_level > 0) {
+        printf("[DEBUG] h2 stream %u: %s %s (body %zu)\n", st->id, req->method ? req->method : "GET",
+               req->url_path ? req->url_path : "/", body_len);
+    }
+    return 0;
+}
+
+/**
+ * @brief 在流量控制窗口允许的范围内发送请求体
+ */
+static int h2_flush_bodies(httpc_h2_t* h2) {
+    for (int i = 0; i < H2_MAX_STREAMS; i++) {
+        h2_stream_t* st = &h2->streams[i];
+        while (st->id && st->body && st->body_sent < st->body_len &&
+               st->send_window > 0 && h2->conn_send_window > 0) {
+            size_t n = st->body_len - st->body_sent;
+            if ((int64_t)n > st->send_window) n = (size_t)st->send_window;
+            if ((int64_t)n > h2->conn_send_window) n = (size_t)h2->conn_send_window;
+            if (n > h2->peer_max_frame) n = h2->peer_max_frame;
+
+            uint8_t flags = st->body_sent + n == st->body_len ? H2_FLAG_END_STREAM : 0;
+            if (h2_send_frame(h2, H2_FRAME_DATA, flags, st->id, (const unsigned char*)st->body + st->body_sent, n) != 0) {
+                return -1;
+            }
+            st->body_sent += n;
+            st->send_window -= (int64_t)n;
+            h2->conn_send_window -= (int64_t)n;
+            if (st->body_sent == st->body_len) st->req->sent_at = xlimit_now_ms();
+        }
+    }
+    return 0;
+}
+
+// ============================== 帧处理 ==============================
+
+static int h2_apply_settings(httpc_h2_t* h2, const unsigned char* p, size_t len) {
+    if (len % 6 != 0) return -1;
+    for (size_t off = 0; off < len; off += 6) {
+        uint16_t id = (uint16_t)((p[off] << 8) | p[off + 1]);
+        uint32_t value = h2_get_u32(p + off + 2);
+        switch (id) {
+        case H2_SETTINGS_MAX_CONCURRENT_STREAMS:
+            h2->peer_max_concurrent = value;
+            break;
+        case H2_SETTINGS_INITIAL_WINDOW_SIZE: {
+            if (value > 0x7FFFFFFF) return -1;
+            int64_t delta = (int64_t)value - (int64_t)h2->peer_initial_window;
+            h2->peer_initial_window = value;
+            for (int i = 0; i < H2_MAX_STREAMS; i++) {
+                if (h2->streams[i].id) h2->streams[i].send_window += delta;
+            }
+            break;
+        }
+        case H2_SETTINGS_MAX_FRAME_SIZE:
+            if (value < H2_DEFAULT_FRAME_SIZE || value > 0xFFFFFF) return -1;
+            h2->peer_max_frame = value;
+            break;
+        default:
+            break;  // HEADER_TABLE_SIZE：编码端不使用动态表，无需处理
+        }
+    }
+    return h2_send_frame(h2, H2_FRAME_SETTINGS, H2_FLAG_ACK, 0, NULL, 0);
+}
+
+/**
+ * @brief 去掉 PADDED 帧的填充
+ */
+static int h2_strip_padding(uint8_t flags, unsigned char** payload, size_t* len) {
+    if (!(flags & H2_FLAG_PADDED)) return 0;
+    if (*len < 1) return -1;
+    size_t pad = (*payload)[0];
+    if (pad + 1 > *len) return -1;
+    *payload += 1;
+    *len -= pad + 1;
+    return 0;
+}
+
+static int h2_handle_data(httpc_h2_t* h2, uint8_t flags, uint32_t stream_id, unsigned char* payload, size_t len,
+                          size_t* completed) {
+    size_t frame_len = len;  // 流量控制按整帧（含填充）计算
+    if (h2_strip_padding(flags, &payload, &len) != 0) return -1;
+
+    h2->conn_recv_unacked += (uint32_t)frame_len;
+    if (h2->conn_recv_unacked >= H2_LOCAL_CONN_WINDOW / 2) {
+        if (h2_send_window_update(h2, 0, h2->conn_recv_unacked) != 0) return -1;
+        h2->conn_recv_unacked = 0;
+    }
+
+    h2_stream_t* st = h2_find_stream(h2, stream_id);
+    if (!st) return 0;  // 已重置/结束的流：丢弃
+
+    h2_stream_append(st, payload, len);
+    if (flags & H2_FLAG_END_STREAM) {
+        h2_stream_finish(h2, st, HTTPC_SUCCESS);
+        (*completed)++;
+        return 0;
+    }
+
+    st->recv_unacked += (uint32_t)frame_len;
+    if (st->recv_unacked >= H2_LOCAL_STREAM_WINDOW / 2) {
+        if (h2_send_window_update(h2, st->id, st->recv_unacked) != 0) return -1;
+        st->recv_unacked = 0;
+    }
+    return 0;
+}
+
+static int h2_handle_headers(httpc_h2_t* h2, uint8_t type, uint8_t flags, uint32_t stream_id,
+                             unsigned char* payload, size_t len, size_t* completed) {
+    if (type == H2_FRAME_HEADERS) {
+        if (h2->hdr_pending || stream_id == 0) return -1;
+        if (h2_strip_padding(flags, &payload, &len) != 0) return -1;
+        if (flags & H2_FLAG_PRIORITY) {
+            if (len < 5) return -1;
+            payload += 5;
+            len -= 5;
+        }
+        h2_stream_t* st = h2_find_stream(h2, stream_id);
+        if (st && st->req->first_byte_at == 0) st->req->first_byte_at = xlimit_now_ms();
+        h2->hdr_len = 0;
+        h2->hdr_stream = stream_id;
+        h2->hdr_end_stream = (flags & H2_FLAG_END_STREAM) != 0;
+        h2->hdr_pending = 1;
+    } else {
+        if (!h2->hdr_pending || stream_id != h2->hdr_stream) return -1;
+    }
+
+    if (h2->hdr_len + len > H2_HEADER_BLOCK_MAX) return -1;
+    if (h2->hdr_len + len > h2->hdr_cap) {
+        size_t cap = h2->hdr_cap ? h2->hdr_cap : 4096;
+        while (cap < h2->hdr_len + len) cap *= 2;
+        unsigned char* nb = (unsigned char*)realloc(h2->hdr_block, cap);
+        if (!nb) return -1;
+        h2->hdr_block = nb;
+        h2->hdr_cap = cap;
+    }
+    memcpy(h2->hdr_block + h2->hdr_len, payload, len);
+    h2->hdr_len += len;
+
+    if (!(flags & H2_FLAG_END_HEADERS)) return 0;
+
+    h2->hdr_pending = 0;
+    h2_stream_t* st = h2_find_stream(h2, h2->hdr_stream);
+    if (h2_decode_header_block(h2, st) != 0) {
+        h2_send_goaway(h2, H2_ERR_COMPRESSION);
+        return -1;
+    }
+    if (st && h2->hdr_end_stream) {
+        h2_stream_finish(h2, st, st->headers_done ? HTTPC_SUCCESS : HTTPC_ERR_PARSE);
+        (*completed)++;
+    }
+    return 0;
+}
+
+/**
+ * @brief 读取并处理一个帧
+ * @param completed 本帧结束的流个数（累加）
+ * @return 0 成功，-1 连接级错误
+ */
+static int h2_process_frame(httpc_h2_t* h2, size_t* completed) {
+    uint8_t type, flags;
+    uint32_t stream_id;
+    unsigned char* payload;
+    size_t len;
+
+    if (h2_read_frame(h2, &type, &flags, &stream_id, &payload, &len) != 0) {
+        h2->broken = 1;
+        return -1;
+    }
+
+    // CONTINUATION 必须紧跟在 HEADERS 之后
+    if (h2->hdr_pending && type != H2_FRAME_CONTINUATION) {
+        h2_send_goaway(h2, H2_ERR_PROTOCOL_ERROR);
+        h2->broken = 1;
+        return -1;
+    }
+
+    int ret = 0;
+    switch (type) {
+    case H2_FRAME_DATA:
+        ret = h2_handle_data(h2, flags, stream_id, payload, len, completed);
+        break;
+    case H2_FRAME_HEADERS:
+    case H2_FRAME_CONTINUATION:
+        ret = h2_handle_headers(h2, type, flags, stream_id, payload, len, completed);
+        break;
+    case H2_FRAME_SETTINGS:
+        if (!(flags & H2_FLAG_ACK)) ret = h2_apply_settings(h2, payload, len);
+        break;
+    case H2_FRAME_PING:
+        if (!(flags & H2_FLAG_ACK) && len == 8) ret = h2_send_frame(h2, H2_FRAME_PING, H2_FLAG_ACK, 0, payload, 8);
+        break;
+    case H2_FRAME_WINDOW_UPDATE: {
+        if (len != 4) { ret = -1; break; }
+        uint32_t inc = h2_get_u32(payload) & 0x7FFFFFFF;
+        if (stream_id == 0) {
+            h2->conn_send_window += inc;
+        } else {
+            h2_stream_t* st = h2_find_stream(h2, stream_id);
+            if (st) st->send_window += inc;
+        }
+        break;
+    }
+    case H2_FRAME_RST_STREAM: {
+        h2_stream_t* st = h2_find_stream(h2, stream_id);
+        if (st) {
+            uint32_t code = len == 4 ? h2_get_u32(payload) : H2_ERR_NO_ERROR;
+            if (h2->debug_level > 0 && len == 4) {
+                printf("[DEBUG] h2 stream %u reset by peer: error 0x%x\n", stream_id, code);
+            }
+            // REFUSED_STREAM 表示请求未被处理，可以换连接重发
+            if (code == H2_ERR_REFUSED_STREAM) h2->refused = 1;
+            h2_stream_finish(h2, st, code == H2_ERR_REFUSED_STREAM ? HTTPC_ERR_CONNECT : HTTPC_ERR_READ);
+            (*completed)++;
+        }
+        break;
+    }
+    case H2_FRAME_GOAWAY:
+        if (len >= 8) {
+            h2->goaway = 1;
+            h2->goaway_last_id = h2_get_u32(payload) & 0x7FFFFFFF;
+            if (h2->debug_level > 0) {
+                printf("[DEBUG] h2 GOAWAY: last stream %u, error 0x%x\n", h2->goaway_last_id, h2_get_u32(payload + 4));
+            }
+            // 编号大于 last_stream_id 的流不会被处理
+            for (int i = 0; i < H2_MAX_STREAMS; i++) {
+                h2_stream_t* st = &h2->streams[i];
+                if (st->id && st->id > h2->goaway_last_id) {
+                    h2_stream_finish(h2, st, HTTPC_ERR_CONNECT);
+                    (*completed)++;
+                }
+            }
+        }
+        break;
+    case H2_FRAME_PUSH_PROMISE:
+        // 已通过 SETTINGS_ENABLE_PUSH=0 禁止推送
+        h2_send_goaway(h2, H2_ERR_PROTOCOL_ERROR);
+        ret = -1;
+        break;
+    default:
+        break;  // PRIORITY 及未知帧类型忽略
+    }
+
+    if (ret != 0) h2->broken = 1;
+    return ret;
+}
+
+// ============================== 对外接口 ==============================
+
+httpc_h2_t* httpc_h2_open(const httpc_h2_io_t* io, const char* authority, uint32_t debug_level) {
+    if (!io || !io->send_all || !io->recv_some || !authority) {
+        return NULL;
+    }
+
+    httpc_h2_t* h2 = (httpc_h2_t*)calloc(1, sizeof(httpc_h2_t));
+    if (!h2) return NULL;
+
+    h2->io = *io;
+    snprintf(h2->authority, sizeof(h2->authority), "%s", authority);
+    h2->debug_level = debug_level;
+    h2->next_stream_id = 1;
+    h2->peer_max_concurrent = H2_MAX_STREAMS;
+    h2->peer_initial_window = H2_DEFAULT_WINDOW;
+    h2->peer_max_frame = H2_DEFAULT_FRAME_SIZE;
+    h2->conn_send_window = H2_DEFAULT_WINDOW;
+    h2->dyn_max = H2_HPACK_TABLE_SIZE;
+
+    // 连接前言 + SETTINGS（禁止推送、放大流窗口）+ 放大连接窗口
+    unsigned char settings[12];
+    settings[0] = 0; settings[1] = H2_SETTINGS_ENABLE_PUSH;
+    h2_put_u32(settings + 2, 0);
+    settings[6] = 0; settings[7] = H2_SETTINGS_INITIAL_WINDOW_SIZE;
+    h2_put_u32(settings + 8, H2_LOCAL_STREAM_WINDOW);
+
+    if (h2->io.send_all(h2->io.ctx, (const unsigned char*)H2_PREFACE, sizeof(H2_PREFACE) - 1) <= 0 ||
+        h2_send_frame(h2, H2_FRAME_SETTINGS, 0, 0, settings, sizeof(settings)) != 0 ||
+        h2_send_window_update(h2, 0, H2_LOCAL_CONN_WINDOW - H2_DEFAULT_WINDOW) != 0) {
+        httpc_h2_close(h2);
+        return NULL;
+    }
+    return h2;
+}
+
+httpc_err_t httpc_h2_execute(httpc_h2_t* h2, const httpc_config_t* config, httpc_request_t* reqs, size_t count) {
+    if (!h2 || !reqs) {
+        return HTTPC_ERR_PARAM;
+    }
+
+    size_t next = 0, active = 0, done = 0;
+    httpc_err_t result = HTTPC_SUCCESS;
+
+    while (done < count) {
+        // 在对端并发上限内尽量多开流
+        size_t limit = h2->peer_max_concurrent < H2_MAX_STREAMS ? h2->peer_max_concurrent : H2_MAX_STREAMS;
+        while (next < count && active < limit && !h2->goaway && !h2->broken && h2->next_stream_id < 0x7FFFFFFF) {
+            h2_stream_t* st = NULL;
+            for (int i = 0; i < H2_MAX_STREAMS && !st; i++) {
+                if (h2->streams[i].id == 0) st = &h2->streams[i];
+            }
+            if (!st) break;
+
+            httpc_request_t* req = &reqs[next++];
+            if (h2_open_stream(h2, config, st, req) != 0) {
+                if (h2->broken) {
+                    req->err = HTTPC_ERR_WRITE;
+                } else {
+                    memset(st, 0, sizeof(*st));
+                }
+                done++;
+                continue;
+            }
+            active++;
+        }
+
+        if (active == 0) {
+            if (next < count) {
+                // 连接已不可用（GOAWAY/错误）或对端并发上限为 0，剩余请求无法发出
+                if (limit == 0 && !h2->goaway && !h2->broken) h2->refused = 1;
+                for (; next < count; next++) {
+                    reqs[next].err = HTTPC_ERR_CONNECT;
+                    done++;
+                }
+            }
+            break;
+        }
+
+        if (h2_flush_bodies(h2) != 0) break;
+
+        size_t completed = 0;
+        if (h2_process_frame(h2, &completed) != 0) break;
+        active -= completed;
+        done += completed;
+    }
+
+    if (h2->broken) {
+        // 连接级错误：所有未结束的流失败
+        for (int i = 0; i < H2_MAX_STREAMS; i++) {
+            if (h2->streams[i].id) h2_stream_finish(h2, &h2->streams[i], HTTPC_ERR_READ);
+        }
+        for (; next < count; next++) reqs[next].err = HTTPC_ERR_CONNECT;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (reqs[i].err != HTTPC_SUCCESS) {
+            result = reqs[i].err;
+            break;
+        }
+    }
+    return result;
+}
+
+int httpc_h2_is_usable(const httpc_h2_t* h2) {
+    return h2 && !h2->broken && !h2->goaway && !h2->refused && h2->next_stream_id < 0x7FFFFFFF;
+}
+
+int httpc_h2_refused(const httpc_h2_t* h2) {
+    return h2 && h2->refused;
+}
+
+void httpc_h2_close(httpc_h2_t* h2) {
+    if (!h2) return;
+
+    if (!h2->broken) {
+        h2_send_goaway(h2, H2_ERR_NO_ERROR);
+    }
+    hpack_evict(h2, 0);
+    free(h2->hdr_block);
+    free(h2);
+}
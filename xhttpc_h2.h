@@ -0,0 +1,55 @@
+#ifndef XHTTPC_H2_H
+#define XHTTPC_H2_H
+
+#include "xhttpc.h"
+
+/**
+ * @brief HTTP/2 连接的底层 I/O（由 xhttpc.c 绑定到已完成握手的 TLS 连接）
+ */
+typedef struct {
+    void* ctx;
+    int (*send_all)(void* ctx, const unsigned char* buf, size_t len);  // 全部发送，<=0 失败
+    int (*recv_some)(void* ctx, unsigned char* buf, size_t len);       // >0 字节数，0 关闭，<0 错误
+} httpc_h2_io_t;
+
+/**
+ * @brief HTTP/2 连接上下文（对外隐藏具体实现）
+ */
+typedef struct httpc_h2_s httpc_h2_t;
+
+/**
+ * @brief 建立 HTTP/2 会话：发送连接前言、SETTINGS 和连接级 WINDOW_UPDATE
+ * @param io 底层 I/O
+ * @param authority :authority 伪头部（主机[:端口]）
+ * @param debug_level 调试级别
+ * @return 会话上下文（NULL 表示失败）
+ */
+httpc_h2_t* httpc_h2_open(const httpc_h2_io_t* io, const char* authority, uint32_t debug_level);
+
+/**
+ * @brief 在同一连接上以多路复用流并发执行一批请求
+ * @param h2 会话上下文
+ * @param config 提供 User-Agent 等连接级默认值
+ * @param reqs 请求数组（结果写回各请求项，响应转成 HTTP/1.1 风格文本）
+ * @param count 请求个数
+ * @return 连接级错误码（单个流的失败只记录在对应请求项的 err）
+ */
+httpc_err_t httpc_h2_execute(httpc_h2_t* h2, const httpc_config_t* config, httpc_request_t* reqs, size_t count);
+
+/**
+ * @brief 会话是否还能开新流（未收到 GOAWAY、未发生连接错误、对端未拒绝开流）
+ */
+int httpc_h2_is_usable(const httpc_h2_t* h2);
+
+/**
+ * @brief 对端是否拒绝开流（SETTINGS_MAX_CONCURRENT_STREAMS=0 或 RST_STREAM(REFUSED_STREAM)）
+ * @note 被拒绝的请求 err 为 HTTPC_ERR_CONNECT，对端未处理，可在 HTTP/1.1 连接上重发
+ */
+int httpc_h2_refused(const httpc_h2_t* h2);
+
+/**
+ * @brief 发送 GOAWAY 并释放会话（不关闭底层连接）
+ */
+void httpc_h2_close(httpc_h2_t* h2);
+
+#endif // XHTTPC_H2_H
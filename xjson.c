@@ -0,0 +1,589 @@
+#include "xjson.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define XJSON_SIMD 1
+#endif
+
+enum {
+    XJSON_S_VALUE = 0,      // 等待值
+    XJSON_S_ARR_FIRST,      // '[' 之后：值或 ']'
+    XJSON_S_OBJ_FIRST,      // '{' 之后：键或 '}'
+    XJSON_S_OBJ_KEY,        // ',' 之后：键
+    XJSON_S_COLON,          // 键之后：':'
+    XJSON_S_AFTER,          // 值之后：',' 或结束符
+    XJSON_S_STRING,         // 字符串内
+    XJSON_S_ESC,            // '\' 之后
+    XJSON_S_UHEX,           // \u 之后的 4 位十六进制
+    XJSON_S_LITERAL,        // 数字/true/false/null
+    XJSON_S_DONE,
+    XJSON_S_ERROR
+};
+
+// 转义字符 → 输出字节；'u' 表示 \uXXXX；0 为非法转义
+static const char xjson_escape[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '/',
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+    0, 0, '\b', 0, 0, 0, '\f', 0, 0, 0, 0, 0, 0, 0, '\n', 0,
+    0, 0, '\r', 0, '\t', 'u', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// 十六进制数字值；0xFF 为非法
+static const unsigned char xjson_hex[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 10, 11, 12, 13, 14, 15, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 10, 11, 12, 13, 14, 15, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// 字符串内可原样输出的字节：0 为 '"'、'\\' 和控制字符
+static const unsigned char xjson_plain[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
+};
+
+/**
+ * @brief 开头连续可原样输出的字节数（遇到 '"'、'\\' 或控制字符停止）
+ */
+static size_t xjson_plain_run(const unsigned char* s, size_t len) {
+    size_t i = 0;
+#ifdef XJSON_SIMD
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)),
+                                    _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+        if (_mm_movemask_epi8(stop)) break;  // 停止字节在这 16 字节内，由下面查表定位
+    }
+#endif
+    while (i < len && xjson_plain[s[i]]) i++;
+    return i;
+}
+
+/**
+ * @brief 码点编码为 UTF-8
+ * @return 字节数
+ */
+static size_t xjson_utf8_encode(unsigned cp, char* buf) {
+    if (cp < 0x80) {
+        buf[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        buf[0] = (char)(0xC0 | (cp >> 6));
+        buf[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        buf[0] = (char)(0xE0 | (cp >> 12));
+        buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    buf[0] = (char)(0xF0 | (cp >> 18));
+    buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    buf[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static int xjson_is_ws(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static int xjson_is_literal(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E';
+}
+
+int xjson_init(xjson_t* j, const char* pointer, char* out, size_t out_size) {
+    memset(j, 0, sizeof(*j));
+    j->out = out;
+    j->out_size = out_size;
+    if (out && out_size) out[0] = '\0';
+
+    if (!pointer) return -1;
+    const char* p = pointer;
+    while (*p) {
+        if (*p != '/' || j->nsegs >= XJSON_MAX_SEGS) return -1;
+        p++;
+
+        int s = j->nsegs++;
+        size_t n = 0;
+        while (*p && *p != '/') {
+            char c = *p++;
+            if (c == '~' && (*p == '0' || *p == '1')) {
+                c = (*p++ == '0') ? '~' : '/';
+            }
+            if (n + 1 >= XJSON_MAX_KEY) return -1;
+            j->segs[s][n++] = c;
+        }
+        j->segs[s][n] = '\0';
+        j->seg_len[s] = n;
+
+        // 下标：纯数字；通配符："*"
+        j->seg_index[s] = -1;
+        if (n == 1 && j->segs[s][0] == '*') {
+            j->seg_index[s] = -2;
+            j->wildcard = 1;
+        } else if (n > 0 && n < 10) {
+            long v = 0;
+            size_t k = 0;
+            while (k < n && j->segs[s][k] >= '0' && j->segs[s][k] <= '9') {
+                v = v * 10 + (j->segs[s][k] - '0');
+                k++;
+            }
+            if (k == n) j->seg_index[s] = v;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 第 level 层当前元素之前的路径是否全部匹配
+ */
+static int xjson_parent_ok(const xjson_t* j, int level) {
+    return level == 0 ? 1 : j->ok[level - 1];
+}
+
+// 数组下标变化后重新计算该层匹配
+static void xjson_update_index(xjson_t* j) {
+    int level = j->depth - 1;
+    j->ok[level] = level < j->nsegs && xjson_parent_ok(j, level) &&
+                   (j->seg_index[level] == -2 || j->seg_index[level] == j->index[level]);
+}
+
+static void xjson_emit(xjson_t* j, const char* data, size_t len) {
+    if (j->is_key) {
+        // 键：与当前层路径段逐字节比较
+        if (!j->key_match) return;
+        int level = j->depth - 1;
+        if (j->key_pos + len > j->seg_len[level] || memcmp(j->segs[level] + j->key_pos, data, len) != 0) {
+            j->key_match = 0;
+            return;
+        }
+        j->key_pos += len;
+        return;
+    }
+    if (!j->capture || !j->out || j->out_size == 0) return;
+
+    size_t room = j->out_size - 1 - j->out_len;
+    if (len > room) {
+        len = room;
+        j->truncated = 1;
+    }
+    memcpy(j->out + j->out_len, data, len);
+    j->out_len += len;
+    j->out[j->out_len] = '\0';
+}
+
+static void xjson_emit_code(xjson_t* j, unsigned cp) {
+    char buf[4];
+    xjson_emit(j, buf, xjson_utf8_encode(cp, buf));
+}
+
+// 孤立的高位代理输出为 U+FFFD
+static void xjson_flush_surrogate(xjson_t* j) {
+    if (j->high_surrogate) {
+        j->high_surrogate = 0;
+        xjson_emit_code(j, 0xFFFD);
+    }
+}
+
+// 开始一个值：判断是否为目标
+static void xjson_begin_value(xjson_t* j) {
+    j->is_key = 0;
+    j->capture = j->depth == j->nsegs && xjson_parent_ok(j, j->depth);
+    j->value_start = j->out_len;
+}
+
+// 一个目标值结束
+static int xjson_end_value(xjson_t* j) {
+    if (j->capture) {
+        j->capture = 0;
+        if (j->state == XJSON_S_LITERAL && j->out && j->out_len - j->value_start == 4 &&
+            memcmp(j->out + j->value_start, "null", 4) == 0) {
+            // null：撤回
+            j->out_len = j->value_start;
+            j->out[j->out_len] = '\0';
+            j->state = XJSON_S_AFTER;
+            return XJSON_MORE;
+        }
+        j->matches++;
+        if (!j->wildcard) {
+            j->state = XJSON_S_DONE;
+            return XJSON_DONE;
+        }
+    }
+    j->state = XJSON_S_AFTER;
+    return XJSON_MORE;
+}
+
+static int xjson_push(xjson_t* j, unsigned char kind) {
+    if (j->depth >= XJSON_MAX_DEPTH) return -1;
+    int level = j->depth++;
+    j->kind[level] = kind;
+    j->index[level] = 0;
+    j->ok[level] = 0;
+    if (kind == '[') {
+        xjson_update_index(j);
+    }
+    return 0;
+}
+
+int xjson_feed(xjson_t* j, const char* data, size_t len) {
+    const unsigned char* s = (const unsigned char*)data;
+    size_t i = 0;
+
+    while (i < len) {
+        unsigned char c = s[i];
+
+        switch (j->state) {
+        case XJSON_S_DONE:
+            return XJSON_DONE;
+        case XJSON_S_ERROR:
+            return XJSON_ERROR;
+
+        case XJSON_S_STRING: {
+            // 连续的普通字节整段输出
+            size_t k = i + xjson_plain_run(s + i, len - i);
+            if (k > i) {
+                xjson_flush_surrogate(j);
+                xjson_emit(j, data + i, k - i);
+                i = k;
+                continue;
+            }
+            i++;
+            if (c == '\\') {
+                j->state = XJSON_S_ESC;
+            } else if (c == '"') {
+                xjson_flush_surrogate(j);
+                if (j->is_key) {
+                    int level = j->depth - 1;
+                    j->ok[level] = level < j->nsegs && xjson_parent_ok(j, level) &&
+                                   (j->seg_index[level] == -2 ||
+                                    (j->key_match && j->key_pos == j->seg_len[level]));
+                    j->is_key = 0;
+                    j->state = XJSON_S_COLON;
+                } else if (xjson_end_value(j) == XJSON_DONE) {
+                    return XJSON_DONE;
+                }
+            } else {
+                j->state = XJSON_S_ERROR;  // 未转义的控制字符
+            }
+            continue;
+        }
+
+        case XJSON_S_ESC: {
+            i++;
+            char e = xjson_escape[c];
+            if (e == 'u') {
+                j->esc_code = 0;
+                j->esc_digits = 0;
+                j->state = XJSON_S_UHEX;
+                continue;
+            }
+            if (e == 0) {
+                j->state = XJSON_S_ERROR;
+                continue;
+            }
+            xjson_flush_surrogate(j);
+            xjson_emit(j, &e, 1);
+            j->state = XJSON_S_STRING;
+            continue;
+        }
+
+        case XJSON_S_UHEX: {
+            i++;
+            unsigned v = xjson_hex[c];
+            if (v == 0xFF) {
+                j->state = XJSON_S_ERROR;
+                continue;
+            }
+            j->esc_code = (j->esc_code << 4) | v;
+            if (++j->esc_digits < 4) continue;
+
+            unsigned cp = j->esc_code;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                xjson_flush_surrogate(j);
+                j->high_surrogate = cp;
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                if (j->high_surrogate) {
+                    cp = 0x10000 + ((j->high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+                    j->high_surrogate = 0;
+                    xjson_emit_code(j, cp);
+                } else {
+                    xjson_emit_code(j, 0xFFFD);
+                }
+            } else {
+                xjson_flush_surrogate(j);
+                xjson_emit_code(j, cp);
+            }
+            j->state = XJSON_S_STRING;
+            continue;
+        }
+
+        case XJSON_S_LITERAL: {
+            size_t k = i;
+            while (k < len && xjson_is_literal(s[k])) k++;
+            if (k > i) {
+                xjson_emit(j, data + i, k - i);
+                i = k;
+                continue;
+            }
+            // 分隔符：在 AFTER 状态下重新处理
+            if (xjson_end_value(j) == XJSON_DONE) return XJSON_DONE;
+            continue;
+        }
+
+        default:
+            break;
+        }
+
+        // 结构字符
+        if (xjson_is_ws(c)) {
+            i++;
+            continue;
+        }
+
+        switch (j->state) {
+        case XJSON_S_ARR_FIRST:
+            if (c == ']') {
+                i++;
+                j->depth--;
+                j->state = XJSON_S_AFTER;
+                break;
+            }
+            j->state = XJSON_S_VALUE;
+            // fall through
+        case XJSON_S_VALUE:
+            i++;
+            if (c == '{' || c == '[') {
+                if (xjson_push(j, c) != 0) {
+                    j->state = XJSON_S_ERROR;
+                    break;
+                }
+                j->state = (c == '{') ? XJSON_S_OBJ_FIRST : XJSON_S_ARR_FIRST;
+            } else if (c == '"') {
+                xjson_begin_value(j);
+                j->state = XJSON_S_STRING;
+            } else if (xjson_is_literal(c)) {
+                xjson_begin_value(j);
+                xjson_emit(j, (const char*)&c, 1);
+                j->state = XJSON_S_LITERAL;
+            } else {
+                j->state = XJSON_S_ERROR;
+            }
+            break;
+
+        case XJSON_S_OBJ_FIRST:
+            if (c == '}') {
+                i++;
+                j->depth--;
+                j->state = XJSON_S_AFTER;
+                break;
+            }
+            // fall through
+        case XJSON_S_OBJ_KEY:
+            i++;
+            if (c != '"') {
+                j->state = XJSON_S_ERROR;
+                break;
+            }
+            {
+                int level = j->depth - 1;
+                j->is_key = 1;
+                j->capture = 0;
+                j->key_pos = 0;
+                j->key_match = level < j->nsegs && xjson_parent_ok(j, level);
+            }
+            j->state = XJSON_S_STRING;
+            break;
+
+        case XJSON_S_COLON:
+            i++;
+            j->state = (c == ':') ? XJSON_S_VALUE : XJSON_S_ERROR;
+            break;
+
+        case XJSON_S_AFTER:
+            if (j->depth == 0) {
+                // 顶层值结束，忽略其后的内容
+                j->state = XJSON_S_DONE;
+                return XJSON_DONE;
+            }
+            i++;
+            if (c == ',') {
+                if (j->kind[j->depth - 1] == '[') {
+                    j->index[j->depth - 1]++;
+                    xjson_update_index(j);
+                    j->state = XJSON_S_VALUE;
+                } else {
+                    j->state = XJSON_S_OBJ_KEY;
+                }
+            } else if ((c == ']' && j->kind[j->depth - 1] == '[') ||
+                       (c == '}' && j->kind[j->depth - 1] == '{')) {
+                j->depth--;
+                if (j->depth == 0) {
+                    j->state = XJSON_S_DONE;
+                    return XJSON_DONE;
+                }
+            } else {
+                j->state = XJSON_S_ERROR;
+            }
+            break;
+
+        default:
+            j->state = XJSON_S_ERROR;
+            break;
+        }
+    }
+
+    if (j->state == XJSON_S_ERROR) return XJSON_ERROR;
+    if (j->state == XJSON_S_DONE) return XJSON_DONE;
+    return XJSON_MORE;
+}
+
+int xjson_sink(void* ctx, const char* data, size_t len) {
+    return xjson_feed((xjson_t*)ctx, data, len) != XJSON_MORE;
+}
+
+/**
+ * @brief 追加到 out（留终止符），空间不足时截断
+ * @return 0 截断，1 完整写入
+ */
+static int xjson_put(char* out, size_t out_size, size_t* o, const char* data, size_t n) {
+    int ok = 1;
+    if (n > out_size - 1 - *o) {
+        n = out_size - 1 - *o;
+        ok = 0;
+    }
+    memcpy(out + *o, data, n);
+    *o += n;
+    return ok;
+}
+
+/**
+ * @brief \uXXXX 的值
+ * @return 码元，-1 表示不是合法的 \u 转义
+ */
+static long xjson_uescape(const unsigned char* s, size_t left) {
+    if (left < 6 || s[0] != '\\' || s[1] != 'u') return -1;
+    unsigned a = xjson_hex[s[2]], b = xjson_hex[s[3]], c = xjson_hex[s[4]], d = xjson_hex[s[5]];
+    if ((a | b | c | d) > 15) return -1;  // 任一为 0xFF
+    return (long)((a << 12) | (b << 8) | (c << 4) | d);
+}
+
+int xjson_unescape(const char* in, size_t len, char* out, size_t out_size) {
+    if (!in || !out || out_size == 0) return -1;
+
+    const unsigned char* s = (const unsigned char*)in;
+    size_t i = 0, o = 0;
+    int ok = 1;
+    char buf[4];
+
+    while (i < len && ok) {
+        // 到下一个反斜杠之前的整段直接拷贝（未转义的引号/控制字符也原样保留）
+        size_t run = xjson_plain_run(s + i, len - i);
+        while (i + run < len && s[i + run] != '\\') {
+            run++;
+            run += xjson_plain_run(s + i + run, len - i - run);
+        }
+        if (run > 0) {
+            ok = xjson_put(out, out_size, &o, in + i, run);
+            i += run;
+            continue;
+        }
+
+        char e = i + 1 < len ? xjson_escape[s[i + 1]] : 0;
+        if (e == 0) {
+            // 非法转义或末尾孤立的 '\\'：原样保留
+            ok = xjson_put(out, out_size, &o, in + i, 1);
+            i++;
+            continue;
+        }
+        if (e != 'u') {
+            ok = xjson_put(out, out_size, &o, &e, 1);
+            i += 2;
+            continue;
+        }
+
+        long cu = xjson_uescape(s + i, len - i);
+        if (cu < 0) {
+            ok = xjson_put(out, out_size, &o, in + i, 1);
+            i++;
+            continue;
+        }
+        i += 6;
+
+        unsigned cp = (unsigned)cu;
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            // 高位代理：后面紧跟低位代理才组成一个补充平面字符
+            long lo = xjson_uescape(s + i, len - i);
+            if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + ((unsigned)lo - 0xDC00);
+                i += 6;
+            } else {
+                cp = 0xFFFD;
+            }
+        } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+            cp = 0xFFFD;
+        }
+        ok = xjson_put(out, out_size, &o, buf, xjson_utf8_encode(cp, buf));
+    }
+
+    out[o] = '\0';
+    return ok ? (int)o : -1;
+}
+
+int xjson_extract(const char* json, size_t len, const char* pointer, char* out, size_t out_size) {
+    xjson_t j;
+    if (!json || xjson_init(&j, pointer, out, out_size) != 0) return -1;
+
+    int st = xjson_feed(&j, json, len);
+    if (st == XJSON_MORE && j.state == XJSON_S_LITERAL) {
+        // 顶层就是一个数字且恰好在末尾结束
+        xjson_end_value(&j);
+    }
+    if (st == XJSON_ERROR || j.matches == 0) return -1;
+    return (int)j.out_len;
+}
@@ -0,0 +1,93 @@
+#ifndef XJSON_H
+#define XJSON_H
+
+#include <stddef.h>
+
+#define XJSON_MAX_DEPTH  32     // 最大嵌套层数
+#define XJSON_MAX_SEGS   8      // JSON Pointer 最多段数
+#define XJSON_MAX_KEY    64     // 每段最长字节数
+
+#define XJSON_MORE   0          // 需要更多数据
+#define XJSON_DONE   1          // 已取到目标（路径不含通配符时）或文档结束
+#define XJSON_ERROR  (-1)       // JSON 语法错误
+
+/**
+ * @brief 增量 JSON 提取器：按 JSON Pointer（RFC 6901）从流中取出一个值
+ * @note 不分配内存；数据可以任意切块喂入，字符串转义（含 \uXXXX 代理对）在同一遍中解码。
+ *       路径段写 "*" 匹配任意键/下标（如 Google 响应取 /0/i/0 的每一句），所有匹配的值依次拼接到 out。
+ *       只提取字符串和数字/true/false 原文；null 视为不存在，对象/数组不提取
+ */
+typedef struct {
+    // 路径
+    int nsegs;
+    char segs[XJSON_MAX_SEGS][XJSON_MAX_KEY];
+    size_t seg_len[XJSON_MAX_SEGS];
+    long seg_index[XJSON_MAX_SEGS];     // 数字段的下标；-1 非数字；-2 通配符
+    int wildcard;                       // 路径含通配符：读到文档结束为止
+
+    // 输出
+    char* out;
+    size_t out_size;
+    size_t out_len;
+    int matches;                        // 已提取的值个数
+    int truncated;                      // out 空间不足，结果被截断
+
+    // 解析状态
+    int state;
+    int depth;
+    unsigned char kind[XJSON_MAX_DEPTH];    // '{' 或 '['
+    long index[XJSON_MAX_DEPTH];            // 数组当前下标
+    unsigned char ok[XJSON_MAX_DEPTH];      // 该层当前元素及以上路径均匹配
+
+    // 字符串/原文
+    int is_key;                         // 当前字符串是对象键
+    int capture;                        // 当前值是目标
+    size_t value_start;                 // 当前目标值在 out 中的起始位置
+    int key_match;                      // 键与路径段逐字节比较的结果
+    size_t key_pos;
+    unsigned esc_code;                  // \uXXXX 累加值
+    int esc_digits;
+    unsigned high_surrogate;            // 等待低位代理的高位代理（0 表示无）
+} xjson_t;
+
+/**
+ * @brief 初始化提取器
+ * @param j 提取器
+ * @param pointer JSON Pointer（如 "/responseData/translatedText"，"" 表示整个文档）
+ * @param out 输出缓冲区（总是以 '\0' 结尾）
+ * @param out_size 缓冲区长度
+ * @return 0 成功，-1 路径非法或超出限制
+ */
+int xjson_init(xjson_t* j, const char* pointer, char* out, size_t out_size);
+
+/**
+ * @brief 喂入一块数据
+ * @return XJSON_MORE / XJSON_DONE / XJSON_ERROR
+ */
+int xjson_feed(xjson_t* j, const char* data, size_t len);
+
+/**
+ * @brief httpc_config_t.on_body 回调：把响应体边收边喂给提取器（ctx 为 xjson_t*）
+ * @return 已取到目标或出错时返回 1（提前结束接收），否则 0
+ */
+int xjson_sink(void* ctx, const char* data, size_t len);
+
+/**
+ * @brief 解码 JSON 字符串内容（不含两端引号）
+ * @note 单遍查表：支持全部转义（\" \\ \/ \b \f \n \r \t \uXXXX），代理对合成补充平面字符，
+ *       孤立代理输出 U+FFFD；非法转义原样保留。无反斜杠的整段用 SIMD 扫描后直接拷贝
+ * @param in 输入
+ * @param len 输入长度
+ * @param out 输出缓冲区（总是以 '\0' 结尾）
+ * @param out_size 缓冲区长度
+ * @return 成功: 输出长度, 空间不足（已截断）: -1
+ */
+int xjson_unescape(const char* in, size_t len, char* out, size_t out_size);
+
+/**
+ * @brief 一次性提取
+ * @return 成功: 结果长度, 未找到或出错: -1
+ */
+int xjson_extract(const char* json, size_t len, const char* pointer, char* out, size_t out_size);
+
+#endif // XJSON_H
@@ -0,0 +1,704 @@
+#include "xlang.h"
+#include <stdint.h>
+#include <string.h>
+
+// 文字系统
+enum {
+    XLANG_NONE = 0,
+    XLANG_LATIN, XLANG_CYRILLIC, XLANG_GREEK, XLANG_ARMENIAN, XLANG_HEBREW, XLANG_ARABIC,
+    XLANG_DEVANAGARI, XLANG_BENGALI, XLANG_GURMUKHI, XLANG_GUJARATI, XLANG_TAMIL, XLANG_TELUGU,
+    XLANG_KANNADA, XLANG_MALAYALAM, XLANG_SINHALA, XLANG_THAI, XLANG_LAO, XLANG_MYANMAR,
+    XLANG_GEORGIAN, XLANG_KHMER, XLANG_MONGOLIAN, XLANG_HANGUL, XLANG_KANA, XLANG_HAN,
+    XLANG_SCRIPT_COUNT
+};
+
+typedef struct {
+    uint32_t lo, hi;
+    unsigned char script;
+} xlang_range_t;
+
+typedef struct {
+    const char* word;
+    uint64_t langs;
+} xlang_word_t;
+
+typedef struct {
+    uint32_t cp;
+    uint64_t langs;
+} xlang_mark_t;
+
+typedef struct {
+    uint32_t cp;
+    unsigned char script;
+    unsigned char weight;
+    const char* lang;
+} xlang_hint_t;
+
+// 字母所属文字系统（按码点排序）
+static const xlang_range_t xlang_ranges[] = {
+    { 0x0041, 0x005A, XLANG_LATIN },      { 0x0061, 0x007A, XLANG_LATIN },
+    { 0x00C0, 0x00D6, XLANG_LATIN },      { 0x00D8, 0x00F6, XLANG_LATIN },
+    { 0x00F8, 0x02AF, XLANG_LATIN },      { 0x02BB, 0x02BC, XLANG_LATIN },
+    { 0x0370, 0x03FF, XLANG_GREEK },      { 0x0400, 0x052F, XLANG_CYRILLIC },
+    { 0x0531, 0x058F, XLANG_ARMENIAN },   { 0x0591, 0x05FF, XLANG_HEBREW },
+    { 0x0600, 0x06FF, XLANG_ARABIC },     { 0x0750, 0x077F, XLANG_ARABIC },
+    { 0x0900, 0x097F, XLANG_DEVANAGARI }, { 0x0980, 0x09FF, XLANG_BENGALI },
+    { 0x0A00, 0x0A7F, XLANG_GURMUKHI },   { 0x0A80, 0x0AFF, XLANG_GUJARATI },
+    { 0x0B80, 0x0BFF, XLANG_TAMIL },      { 0x0C00, 0x0C7F, XLANG_TELUGU },
+    { 0x0C80, 0x0CFF, XLANG_KANNADA },    { 0x0D00, 0x0D7F, XLANG_MALAYALAM },
+    { 0x0D80, 0x0DFF, XLANG_SINHALA },    { 0x0E00, 0x0E7F, XLANG_THAI },
+    { 0x0E80, 0x0EFF, XLANG_LAO },        { 0x1000, 0x109F, XLANG_MYANMAR },
+    { 0x10A0, 0x10FF, XLANG_GEORGIAN },   { 0x1100, 0x11FF, XLANG_HANGUL },
+    { 0x1780, 0x17FF, XLANG_KHMER },      { 0x1800, 0x18AF, XLANG_MONGOLIAN },
+    { 0x1E00, 0x1EFF, XLANG_LATIN },      { 0x1F00, 0x1FFF, XLANG_GREEK },
+    { 0x3040, 0x30FF, XLANG_KANA },       { 0x3130, 0x318F, XLANG_HANGUL },
+    { 0x31F0, 0x31FF, XLANG_KANA },       { 0x3400, 0x4DBF, XLANG_HAN },
+    { 0x4E00, 0x9FFF, XLANG_HAN },        { 0xAC00, 0xD7AF, XLANG_HANGUL },
+    { 0xF900, 0xFAFF, XLANG_HAN },        { 0xFB50, 0xFDFF, XLANG_ARABIC },
+    { 0xFE70, 0xFEFF, XLANG_ARABIC },     { 0xFF66, 0xFF9F, XLANG_KANA },
+    { 0x20000, 0x2FFFF, XLANG_HAN },
+};
+
+// 只用一种语言的文字系统
+static const char* const xlang_script_lang[XLANG_SCRIPT_COUNT] = {
+    [XLANG_GREEK] = "el",    [XLANG_ARMENIAN] = "hy",  [XLANG_HEBREW] = "he",
+    [XLANG_ARABIC] = "ar",   [XLANG_CYRILLIC] = "ru",  [XLANG_DEVANAGARI] = "hi",
+    [XLANG_BENGALI] = "bn",  [XLANG_GURMUKHI] = "pa",  [XLANG_GUJARATI] = "gu",
+    [XLANG_TAMIL] = "ta",    [XLANG_TELUGU] = "te",    [XLANG_KANNADA] = "kn",
+    [XLANG_MALAYALAM] = "ml", [XLANG_SINHALA] = "si",  [XLANG_THAI] = "th",
+    [XLANG_LAO] = "lo",      [XLANG_MYANMAR] = "my",   [XLANG_GEORGIAN] = "ka",
+    [XLANG_KHMER] = "km",    [XLANG_MONGOLIAN] = "mn", [XLANG_HANGUL] = "ko",
+    [XLANG_KANA] = "ja",
+};
+
+// 同一文字系统内区分语言的特征字母（按码点排序）；没有命中时用 xlang_script_lang
+static const xlang_hint_t xlang_hints[] = {
+    // 西里尔
+    { 0x044A, XLANG_CYRILLIC, 2, "bg" },  // ъ：保加利亚语常用元音
+    { 0x044B, XLANG_CYRILLIC, 2, "ru" },  // ы
+    { 0x044D, XLANG_CYRILLIC, 2, "ru" },  // э
+    { 0x0451, XLANG_CYRILLIC, 2, "ru" },  // ё
+    { 0x0452, XLANG_CYRILLIC, 3, "sr" },  // ђ
+    { 0x0453, XLANG_CYRILLIC, 3, "mk" },  // ѓ
+    { 0x0454, XLANG_CYRILLIC, 3, "uk" },  // є
+    { 0x0455, XLANG_CYRILLIC, 3, "mk" },  // ѕ
+    { 0x0456, XLANG_CYRILLIC, 2, "uk" },  // і
+    { 0x0457, XLANG_CYRILLIC, 3, "uk" },  // ї
+    { 0x0458, XLANG_CYRILLIC, 2, "sr" },  // ј
+    { 0x0459, XLANG_CYRILLIC, 2, "sr" },  // љ
+    { 0x045A, XLANG_CYRILLIC, 2, "sr" },  // њ
+    { 0x045B, XLANG_CYRILLIC, 3, "sr" },  // ћ
+    { 0x045C, XLANG_CYRILLIC, 3, "mk" },  // ќ
+    { 0x045F, XLANG_CYRILLIC, 3, "sr" },  // џ
+    { 0x0491, XLANG_CYRILLIC, 3, "uk" },  // ґ
+    { 0x0493, XLANG_CYRILLIC, 2, "kk" },  // ғ
+    { 0x049B, XLANG_CYRILLIC, 2, "kk" },  // қ
+    { 0x04A3, XLANG_CYRILLIC, 2, "ky" },  // ң
+    { 0x04AF, XLANG_CYRILLIC, 1, "mn" },  // ү
+    { 0x04B1, XLANG_CYRILLIC, 3, "kk" },  // ұ
+    { 0x04B3, XLANG_CYRILLIC, 3, "tg" },  // ҳ
+    { 0x04B7, XLANG_CYRILLIC, 3, "tg" },  // ҷ
+    { 0x04BB, XLANG_CYRILLIC, 2, "kk" },  // һ
+    { 0x04D9, XLANG_CYRILLIC, 3, "kk" },  // ә
+    { 0x04E3, XLANG_CYRILLIC, 3, "tg" },  // ӣ
+    { 0x04E9, XLANG_CYRILLIC, 1, "mn" },  // ө
+    { 0x04EF, XLANG_CYRILLIC, 3, "tg" },  // ӯ
+    // 希伯来字母写的意第绪语
+    { 0x05B7, XLANG_HEBREW, 1, "yi" },    // 元音符号在现代希伯来语中很少用
+    { 0x05B8, XLANG_HEBREW, 1, "yi" },
+    { 0x05F0, XLANG_HEBREW, 3, "yi" },    // װ
+    { 0x05F1, XLANG_HEBREW, 3, "yi" },    // ױ
+    { 0x05F2, XLANG_HEBREW, 3, "yi" },    // ײ
+    // 阿拉伯字母
+    { 0x0629, XLANG_ARABIC, 1, "ar" },    // ة
+    { 0x0643, XLANG_ARABIC, 1, "ar" },    // ك
+    { 0x064A, XLANG_ARABIC, 1, "ar" },    // ي
+    { 0x0679, XLANG_ARABIC, 3, "ur" },    // ٹ
+    { 0x067C, XLANG_ARABIC, 3, "ps" },    // ټ
+    { 0x067D, XLANG_ARABIC, 3, "sd" },    // ٽ
+    { 0x067E, XLANG_ARABIC, 1, "fa" },    // پ
+    { 0x067F, XLANG_ARABIC, 3, "sd" },    // ٿ
+    { 0x0680, XLANG_ARABIC, 3, "sd" },    // ڀ
+    { 0x0681, XLANG_ARABIC, 3, "ps" },    // ځ
+    { 0x0683, XLANG_ARABIC, 3, "sd" },    // ڃ
+    { 0x0684, XLANG_ARABIC, 3, "sd" },    // ڄ
+    { 0x0685, XLANG_ARABIC, 3, "ps" },    // څ
+    { 0x0686, XLANG_ARABIC, 1, "fa" },    // چ
+    { 0x0688, XLANG_ARABIC, 3, "ur" },    // ڈ
+    { 0x0689, XLANG_ARABIC, 3, "ps" },    // ډ
+    { 0x0691, XLANG_ARABIC, 3, "ur" },    // ڑ
+    { 0x0693, XLANG_ARABIC, 3, "ps" },    // ړ
+    { 0x0695, XLANG_ARABIC, 3, "ku" },    // ڕ
+    { 0x0696, XLANG_ARABIC, 3, "ps" },    // ږ
+    { 0x0698, XLANG_ARABIC, 1, "fa" },    // ژ
+    { 0x069A, XLANG_ARABIC, 3, "ps" },    // ښ
+    { 0x06A6, XLANG_ARABIC, 3, "sd" },    // ڦ
+    { 0x06A9, XLANG_ARABIC, 1, "fa" },    // ک
+    { 0x06AB, XLANG_ARABIC, 3, "ps" },    // ګ
+    { 0x06AF, XLANG_ARABIC, 1, "fa" },    // گ
+    { 0x06B1, XLANG_ARABIC, 3, "sd" },    // ڱ
+    { 0x06B3, XLANG_ARABIC, 3, "sd" },    // ڳ
+    { 0x06B5, XLANG_ARABIC, 3, "ku" },    // ڵ
+    { 0x06BA, XLANG_ARABIC, 3, "ur" },    // ں
+    { 0x06BB, XLANG_ARABIC, 3, "sd" },    // ڻ
+    { 0x06BC, XLANG_ARABIC, 3, "ps" },    // ڼ
+    { 0x06BE, XLANG_ARABIC, 2, "ur" },    // ھ
+    { 0x06C6, XLANG_ARABIC, 2, "ku" },    // ۆ
+    { 0x06C7, XLANG_ARABIC, 3, "ug" },    // ۇ
+    { 0x06C8, XLANG_ARABIC, 3, "ug" },    // ۈ
+    { 0x06CB, XLANG_ARABIC, 3, "ug" },    // ۋ
+    { 0x06CC, XLANG_ARABIC, 1, "fa" },    // ی
+    { 0x06CE, XLANG_ARABIC, 3, "ku" },    // ێ
+    { 0x06D0, XLANG_ARABIC, 2, "ug" },    // ې
+    { 0x06D2, XLANG_ARABIC, 3, "ur" },    // ے
+    { 0x06D5, XLANG_ARABIC, 2, "ug" },    // ە
+    // 天城文
+    { 0x0933, XLANG_DEVANAGARI, 3, "mr" }, // ळ
+};
+
+// 简体中文特有字（按码点排序）
+static const uint16_t xlang_simplified[] = {
+    0x4E07, 0x4E0E, 0x4E1A, 0x4E1C, 0x4E2A, 0x4E3A, 0x4E48, 0x4E50, 0x4E66, 0x4E70,
+    0x4EA7, 0x4EA9, 0x4EBF, 0x4ECE, 0x4EEC, 0x4F17, 0x4F1A, 0x5173, 0x5199, 0x51E0,
+    0x529E, 0x52A1, 0x52A8, 0x533A, 0x533B, 0x534E, 0x5355, 0x5356, 0x536B, 0x5385,
+    0x5386, 0x53BF, 0x53D1, 0x53D8, 0x53F6, 0x53F7, 0x540E, 0x5417, 0x542C, 0x5458,
+    0x54CD, 0x56ED, 0x56FD, 0x56FE, 0x573A, 0x58F0, 0x5904, 0x5907, 0x590D, 0x591F,
+    0x5934, 0x593A, 0x594B, 0x5987, 0x5A31, 0x5B59, 0x5B66, 0x5B81, 0x5B9D, 0x5B9E,
+    0x5BA0, 0x5BA1, 0x5BBD, 0x5BF9, 0x5BFC, 0x5C06, 0x5C42, 0x5C81, 0x5C9B, 0x5E08,
+    0x5E26, 0x5E2E, 0x5E7F, 0x5E86, 0x5E93, 0x5E94, 0x5E9F, 0x5F00, 0x5F20, 0x5F39,
+    0x5F52, 0x5F53, 0x5F84, 0x5FC6, 0x5FE7, 0x6000, 0x6001, 0x603B, 0x604B, 0x6076,
+    0x60CA, 0x6218, 0x6237, 0x6269, 0x626B, 0x62A4, 0x62A5, 0x62C5, 0x62E5, 0x62E9,
+    0x6324, 0x635F, 0x6362, 0x636E, 0x6444, 0x6570, 0x65AD, 0x65E0, 0x65E7, 0x65F6,
+    0x663E, 0x6653, 0x6682, 0x672F, 0x673A, 0x6742, 0x6743, 0x6761, 0x6765, 0x6768,
+    0x6781, 0x6784, 0x6807, 0x6811, 0x6837, 0x6865, 0x68C0, 0x6B22, 0x6C14, 0x6C49,
+    0x6C64, 0x6C9F, 0x6CA1, 0x6CEA, 0x6CFD, 0x6D01, 0x6D45, 0x6D4B, 0x6D4E, 0x6D53,
+    0x706D, 0x706F, 0x7075, 0x7089, 0x70B9, 0x70DF, 0x70E6, 0x70E7, 0x70ED, 0x7231,
+    0x7237, 0x7275, 0x72B9, 0x72EC, 0x72EE, 0x73AF, 0x73B0, 0x7535, 0x7597, 0x76D6,
+    0x76D8, 0x786E, 0x793C, 0x7978, 0x79BB, 0x79CD, 0x79EF, 0x79F0, 0x7A77, 0x7A83,
+    0x7B14, 0x7B3C, 0x7BEE, 0x7C7B, 0x7CAE, 0x7D27, 0x7EA2, 0x7EA6, 0x7EA7, 0x7EAA,
+    0x7EAF, 0x7EB3, 0x7EB5, 0x7EB7, 0x7EB8, 0x7EB9, 0x7EBA, 0x7EBF, 0x7EC3, 0x7EC4,
+    0x7EC6, 0x7EC7, 0x7EC8, 0x7ECD, 0x7ECF, 0x7ED3, 0x7ED5, 0x7ED8, 0x7ED9, 0x7EDC,
+    0x7EDF, 0x7EE7, 0x7EE9, 0x7EED, 0x7EF4, 0x7EFC, 0x7EFF, 0x7F16, 0x7F18, 0x7F29,
+    0x7F51, 0x7F57, 0x7F5A, 0x804C, 0x8054, 0x8083, 0x80DC, 0x8111, 0x811A, 0x827A,
+    0x8282, 0x82CF, 0x8363, 0x836F, 0x83B7, 0x841D, 0x8651, 0x867E, 0x8681, 0x8865,
+    0x88C5, 0x89C1, 0x89C4, 0x89C6, 0x89C8, 0x89C9, 0x8BA1, 0x8BA2, 0x8BA4, 0x8BA9,
+    0x8BAD, 0x8BAE, 0x8BAF, 0x8BB0, 0x8BB2, 0x8BB8, 0x8BBA, 0x8BBE, 0x8BBF, 0x8BC1,
+    0x8BC4, 0x8BC6, 0x8BC9, 0x8BCD, 0x8BD1, 0x8BD5, 0x8BD7, 0x8BDA, 0x8BDD, 0x8BE2,
+    0x8BE5, 0x8BE6, 0x8BED, 0x8BEF, 0x8BF4, 0x8BF7, 0x8BFB, 0x8BFE, 0x8C03, 0x8C08,
+    0x8C22, 0x8D1D, 0x8D1F, 0x8D21, 0x8D22, 0x8D23, 0x8D27, 0x8D28, 0x8D2D, 0x8D2F,
+    0x8D39, 0x8D3A, 0x8D44, 0x8D4F, 0x8D5B, 0x8D75, 0x8D8B, 0x8DC3, 0x8DF5, 0x8F66,
+    0x8F6E, 0x8F6F, 0x8F7B, 0x8F7D, 0x8F83, 0x8F86, 0x8F88, 0x8FB9, 0x8FBE, 0x8FC1,
+    0x8FC7, 0x8FD0, 0x8FD8, 0x8FD9, 0x8FDB, 0x8FDC, 0x8FDF, 0x9002, 0x9009, 0x9012,
+    0x9057, 0x90AE, 0x90BB, 0x9488, 0x949F, 0x94A2, 0x94B1, 0x94C1, 0x94F6, 0x94FE,
+    0x9501, 0x9505, 0x9519, 0x9547, 0x955C, 0x957F, 0x95E8, 0x95ED, 0x95EE, 0x95F2,
+    0x95F4, 0x95FB, 0x9605, 0x961F, 0x9633, 0x9634, 0x9636, 0x9645, 0x9646, 0x9648,
+    0x9669, 0x968F, 0x9690, 0x96BE, 0x96FE, 0x9759, 0x9875, 0x9876, 0x9879, 0x987A,
+    0x987B, 0x987E, 0x987F, 0x9884, 0x9886, 0x9891, 0x9898, 0x989C, 0x98CE, 0x98DE,
+    0x996D, 0x996E, 0x9970, 0x9971, 0x9986, 0x9A6C, 0x9A7E, 0x9A8C, 0x9A91, 0x9C7C,
+    0x9C9C, 0x9E1F, 0x9E21, 0x9EA6, 0x9F50, 0x9F7F, 0x9F99
+};
+
+// 对应的繁体字（按码点排序）
+static const uint16_t xlang_traditional[] = {
+    0x4F86, 0x500B, 0x5011, 0x5099, 0x5104, 0x52D5, 0x52D9, 0x52DD, 0x5340, 0x54E1,
+    0x554F, 0x55AE, 0x55CE, 0x570B, 0x5712, 0x5716, 0x5831, 0x5834, 0x5920, 0x596A,
+    0x596E, 0x5A1B, 0x5A66, 0x5B6B, 0x5B78, 0x5BE6, 0x5BE7, 0x5BE9, 0x5BEB, 0x5BEC,
+    0x5BF5, 0x5BF6, 0x5C07, 0x5C0D, 0x5C0E, 0x5C64, 0x5CF6, 0x5E2B, 0x5E36, 0x5E6B,
+    0x5E7E, 0x5EAB, 0x5EE2, 0x5EE3, 0x5EF3, 0x5F35, 0x5F48, 0x5F8C, 0x5F91, 0x5F9E,
+    0x60E1, 0x611B, 0x614B, 0x616E, 0x6176, 0x6182, 0x61B6, 0x61C9, 0x61F7, 0x6200,
+    0x6230, 0x6236, 0x6383, 0x63DB, 0x640D, 0x64C1, 0x64C7, 0x64D4, 0x64DA, 0x64E0,
+    0x64F4, 0x651D, 0x6578, 0x65B7, 0x6642, 0x66AB, 0x66C9, 0x66F8, 0x6703, 0x6771,
+    0x689D, 0x694A, 0x696D, 0x6975, 0x69AE, 0x69CB, 0x6A02, 0x6A19, 0x6A23, 0x6A39,
+    0x6A4B, 0x6A5F, 0x6AA2, 0x6B0A, 0x6B61, 0x6B72, 0x6B77, 0x6B78, 0x6C23, 0x6C92,
+    0x6DDA, 0x6DFA, 0x6E2C, 0x6E6F, 0x6E9D, 0x6EC5, 0x6F22, 0x6F54, 0x6FA4, 0x6FC3,
+    0x6FDF, 0x70BA, 0x7121, 0x7159, 0x7169, 0x71B1, 0x71C8, 0x71D2, 0x7210, 0x723A,
+    0x727D, 0x7336, 0x7345, 0x7368, 0x7372, 0x73FE, 0x74B0, 0x7522, 0x755D, 0x7576,
+    0x7642, 0x767C, 0x76E4, 0x773E, 0x78BA, 0x798D, 0x79AE, 0x7A2E, 0x7A31, 0x7A4D,
+    0x7AAE, 0x7ACA, 0x7B46, 0x7BC0, 0x7C43, 0x7C60, 0x7CE7, 0x7D00, 0x7D04, 0x7D05,
+    0x7D0B, 0x7D0D, 0x7D14, 0x7D19, 0x7D1A, 0x7D1B, 0x7D21, 0x7D30, 0x7D39, 0x7D42,
+    0x7D44, 0x7D50, 0x7D61, 0x7D66, 0x7D71, 0x7D93, 0x7D9C, 0x7DA0, 0x7DAD, 0x7DB2,
+    0x7DCA, 0x7DDA, 0x7DE3, 0x7DE8, 0x7DF4, 0x7E23, 0x7E2E, 0x7E31, 0x7E3D, 0x7E3E,
+    0x7E54, 0x7E5E, 0x7E6A, 0x7E7C, 0x7E8C, 0x7F70, 0x7F85, 0x805E, 0x806F, 0x8072,
+    0x8077, 0x807D, 0x8085, 0x8166, 0x8173, 0x8207, 0x820A, 0x83EF, 0x842C, 0x8449,
+    0x84CB, 0x85DD, 0x85E5, 0x8607, 0x863F, 0x8655, 0x865F, 0x8766, 0x87FB, 0x8853,
+    0x885B, 0x88DC, 0x88DD, 0x8907, 0x898B, 0x898F, 0x8996, 0x89BA, 0x89BD, 0x8A02,
+    0x8A08, 0x8A0A, 0x8A13, 0x8A18, 0x8A2A, 0x8A2D, 0x8A31, 0x8A34, 0x8A55, 0x8A5E,
+    0x8A62, 0x8A66, 0x8A69, 0x8A71, 0x8A72, 0x8A73, 0x8A8D, 0x8A9E, 0x8AA0, 0x8AA4,
+    0x8AAA, 0x8AB2, 0x8ABF, 0x8AC7, 0x8ACB, 0x8AD6, 0x8B1B, 0x8B1D, 0x8B49, 0x8B58,
+    0x8B6F, 0x8B70, 0x8B77, 0x8B80, 0x8B8A, 0x8B93, 0x8C9D, 0x8CA0, 0x8CA1, 0x8CA2,
+    0x8CA8, 0x8CAB, 0x8CAC, 0x8CB7, 0x8CBB, 0x8CC0, 0x8CC7, 0x8CDE, 0x8CE3, 0x8CEA,
+    0x8CFC, 0x8CFD, 0x8D99, 0x8DA8, 0x8E10, 0x8E8D, 0x8ECA, 0x8EDF, 0x8F03, 0x8F09,
+    0x8F15, 0x8F1B, 0x8F29, 0x8F2A, 0x8FA6, 0x9019, 0x9032, 0x904B, 0x904E, 0x9054,
+    0x905E, 0x9060, 0x9069, 0x9072, 0x9077, 0x9078, 0x907A, 0x9084, 0x908A, 0x90F5,
+    0x9130, 0x91AB, 0x91DD, 0x9280, 0x92FC, 0x9322, 0x932F, 0x934B, 0x9396, 0x93AE,
+    0x93C8, 0x93E1, 0x9418, 0x9435, 0x9577, 0x9580, 0x9589, 0x958B, 0x9592, 0x9593,
+    0x95B1, 0x95DC, 0x9670, 0x9673, 0x9678, 0x967D, 0x968A, 0x968E, 0x969B, 0x96A8,
+    0x96AA, 0x96B1, 0x96DC, 0x96DE, 0x96E2, 0x96E3, 0x96FB, 0x9727, 0x9748, 0x975C,
+    0x97FF, 0x9801, 0x9802, 0x9805, 0x9806, 0x9808, 0x9810, 0x9813, 0x9818, 0x982D,
+    0x983B, 0x984C, 0x984F, 0x985E, 0x9867, 0x986F, 0x98A8, 0x98DB, 0x98EF, 0x98F2,
+    0x98FD, 0x98FE, 0x9928, 0x99AC, 0x99D5, 0x9A0E, 0x9A57, 0x9A5A, 0x9B5A, 0x9BAE,
+    0x9CE5, 0x9EA5, 0x9EBC, 0x9EDE, 0x9F4A, 0x9F52, 0x9F8D
+};
+
+// 拉丁字母语言（下标即 mask 的位号）
+static const char* const xlang_latin[] = {
+    "en", "af", "sq", "az", "eu", "bs", "ca", "hr", "cs", "da", "nl", "eo", "et", "tl",
+    "fi", "fr", "gl", "de", "ht", "ha", "hu", "is", "id", "ga", "it", "ku", "la", "lv",
+    "lt", "lb", "mg", "ms", "mt", "mi", "no", "pl", "pt", "ro", "sm", "gd", "sn", "sk",
+    "sl", "so", "es", "su", "sw", "sv", "tr", "uz", "vi", "cy", "xh", "yo", "zu"
+};
+
+// 常用词 → 可能的语言（按字节序排序，二分查找）
+static const xlang_word_t xlang_words[] = {
+    { u8"a", 0x0008029000110100ULL }, { u8"aan", 0x0000080000000000ULL }, { u8"abdi", 0x0000200000000000ULL },
+    { u8"ac", 0x0008000000000000ULL }, { u8"ad", 0x0000000004000000ULL }, { u8"ada", 0x0000000080400000ULL },
+    { u8"adalah", 0x0000000080000000ULL }, { u8"af", 0x0000000000000200ULL }, { u8"aga", 0x0000000000001000ULL },
+    { u8"agus", 0x0000008000800000ULL }, { u8"ahau", 0x0000000200000000ULL }, { u8"aho", 0x0000000040000000ULL },
+    { u8"això", 0x0000000000000040ULL }, { u8"ak", 0x0000000000040000ULL }, { u8"ako", 0x0000020000002000ULL },
+    { u8"al", 0x0000000000000800ULL }, { u8"ale", 0x0000020800000100ULL }, { u8"ali", 0x00000400000000a0ULL },
+    { u8"als", 0x0000000000000040ULL }, { u8"amb", 0x0000000000000040ULL }, { u8"amin", 0x0000000040000000ULL },
+    { u8"amma", 0x0000000000080000ULL }, { u8"an", 0x0000008020800000ULL }, { u8"and", 0x0000000000000001ULL },
+    { u8"anda", 0x0000000080400000ULL }, { u8"andi", 0x0010000000000000ULL }, { u8"ang", 0x0000000000002000ULL },
+    { u8"anjeun", 0x0000200000000000ULL }, { u8"ann", 0x0000008000000000ULL }, { u8"anu", 0x0000200000000000ULL },
+    { u8"ar", 0x0008000008800000ULL }, { u8"are", 0x0000000000000001ULL }, { u8"ari", 0x0000010000000000ULL },
+    { u8"ary", 0x0000000040000000ULL }, { u8"as", 0x0000001000010000ULL }, { u8"ass", 0x0000000020000000ULL },
+    { u8"at", 0x0000000400002200ULL }, { u8"ati", 0x0020000000000000ULL }, { u8"att", 0x0000800000000000ULL },
+    { u8"auf", 0x0000000000020000ULL }, { u8"av", 0x0000000400000000ULL }, { u8"avec", 0x0000000000008000ULL },
+    { u8"ay", 0x0000080000002000ULL }, { u8"az", 0x0000000000100000ULL }, { u8"að", 0x0000000000200000ULL },
+    { u8"aš", 0x0000000010000000ULL }, { u8"ba", 0x0000000000080000ULL }, { u8"baie", 0x0000000000000002ULL },
+    { u8"baina", 0x0000000000000010ULL }, { u8"bat", 0x0000000000000010ULL }, { u8"be", 0x0000000000000001ULL },
+    { u8"ben", 0x0001000000000000ULL }, { u8"bet", 0x0000000018000000ULL }, { u8"bhí", 0x0000000000800000ULL },
+    { u8"bi", 0x0000000002000000ULL }, { u8"bilan", 0x0002000000000000ULL }, { u8"bio", 0x0000000000000080ULL },
+    { u8"bir", 0x0003000000000008ULL }, { u8"bu", 0x0003000000000008ULL }, { u8"buvo", 0x0000000010000000ULL },
+    { u8"bạn", 0x0004000000000000ULL }, { u8"ce", 0x0000000000088000ULL }, { u8"chan", 0x0000008000000000ULL },
+    { u8"che", 0x0000000001000000ULL }, { u8"chi", 0x0008000000000000ULL }, { u8"co", 0x0000000800000100ULL },
+    { u8"com", 0x0000001000000000ULL }, { u8"con", 0x0000100001010000ULL }, { u8"csak", 0x0000000000100000ULL },
+    { u8"cu", 0x0000002000000000ULL }, { u8"cum", 0x0000000004000000ULL }, { u8"các", 0x0004000000000000ULL },
+    { u8"có", 0x0004000000000000ULL }, { u8"că", 0x0000002000000000ULL }, { u8"của", 0x0004000000000000ULL },
+    { u8"da", 0x00010400000800b0ULL }, { u8"dan", 0x0000000180400000ULL }, { u8"dans", 0x0000000000008000ULL },
+    { u8"dari", 0x0000000000400000ULL }, { u8"das", 0x0000000000020000ULL }, { u8"dat", 0x0000000020000402ULL },
+    { u8"de", 0x0000103002118c40ULL }, { u8"den", 0x0000000020020000ULL }, { u8"dengan", 0x0000000080400000ULL },
+    { u8"der", 0x0000000000020000ULL }, { u8"des", 0x0000000000008000ULL }, { u8"det", 0x0000800400000200ULL },
+    { u8"deyil", 0x0000000000000008ULL }, { u8"değil", 0x0001000000000000ULL }, { u8"dhe", 0x0000000000000004ULL },
+    { u8"di", 0x0000200083400000ULL }, { u8"dia", 0x0000000040000000ULL }, { u8"die", 0x0000000000020002ULL },
+    { u8"dira", 0x0000000000000010ULL }, { u8"do", 0x0000000800000000ULL }, { u8"du", 0x0000000000000010ULL },
+    { u8"dut", 0x0000000000000010ULL }, { u8"e", 0x000000d001010000ULL }, { u8"ech", 0x0000000020000000ULL },
+    { u8"een", 0x0000000000000400ULL }, { u8"egin", 0x0000000000000010ULL }, { u8"egy", 0x0000000000100000ULL },
+    { u8"ei", 0x0008000000005000ULL }, { u8"ein", 0x0000000000020000ULL }, { u8"eine", 0x0000000000020000ULL },
+    { u8"ek", 0x0000000000000002ULL }, { u8"ekki", 0x0000000000200000ULL }, { u8"el", 0x0000100000000040ULL },
+    { u8"els", 0x0000000000000040ULL }, { u8"emas", 0x0002000000000000ULL }, { u8"en", 0x0000900400000e02ULL },
+    { u8"eng", 0x0000000020000000ULL }, { u8"er", 0x0000000400200200ULL }, { u8"es", 0x0000100008020000ULL },
+    { u8"esse", 0x0000000004000000ULL }, { u8"est", 0x0000000004008000ULL }, { u8"estas", 0x0000000000000800ULL },
+    { u8"este", 0x0000002000000000ULL }, { u8"et", 0x0000000004009000ULL }, { u8"eta", 0x0000000000000010ULL },
+    { u8"että", 0x0000000000004000ULL }, { u8"eu", 0x0000003000010000ULL }, { u8"ew", 0x0000000002000000ULL },
+    { u8"ewe", 0x0010000000000000ULL }, { u8"ez", 0x0000000002100010ULL }, { u8"fa", 0x0000000040000000ULL },
+    { u8"fil", 0x0000000100000000ULL }, { u8"fir", 0x0000000020000000ULL }, { u8"for", 0x0000000400000201ULL },
+    { u8"fun", 0x0020000000000000ULL }, { u8"futhi", 0x0040000000000000ULL }, { u8"fy", 0x0008000000000000ULL },
+    { u8"för", 0x0000800000000000ULL }, { u8"für", 0x0000000000020000ULL }, { u8"gen", 0x0000000000040000ULL },
+    { u8"gibi", 0x0001000000000000ULL }, { u8"gli", 0x0000000001000000ULL }, { u8"għal", 0x0000000100000000ULL },
+    { u8"hann", 0x0000000000200000ULL }, { u8"har", 0x0000800400000200ULL }, { u8"hau", 0x0000000000000010ULL },
+    { u8"have", 0x0000000000000001ULL }, { u8"he", 0x0000000200000000ULL }, { u8"het", 0x0000000000000402ULL },
+    { u8"hii", 0x0000400000000000ULL }, { u8"hija", 0x0000000100000000ULL }, { u8"hindi", 0x0000000000002000ULL },
+    { u8"hogy", 0x0000000000100000ULL }, { u8"hulle", 0x0000000000000002ULL }, { u8"huwa", 0x0000000100000000ULL },
+    { u8"hva", 0x0000000400000000ULL }, { u8"hvad", 0x0000000000000200ULL }, { u8"hän", 0x0000000000004000ULL },
+    { u8"i", 0x0008004a000000e0ULL }, { u8"ia", 0x0000004200000000ULL }, { u8"ianao", 0x0000000040000000ULL },
+    { u8"ich", 0x0000000000020000ULL }, { u8"ieu", 0x0000200000000000ULL }, { u8"ik", 0x0000000000000400ULL },
+    { u8"ikaw", 0x0000000000002000ULL }, { u8"ikke", 0x0000000400000200ULL }, { u8"il", 0x0000000101008000ULL },
+    { u8"ile", 0x0001000000000000ULL }, { u8"ilə", 0x0000000000000008ULL }, { u8"in", 0x00000c0004000001ULL },
+    { u8"ini", 0x0000010080400000ULL }, { u8"int", 0x0000000100000000ULL }, { u8"inte", 0x0000800000000000ULL },
+    { u8"ir", 0x0000000018000000ULL }, { u8"iri", 0x0000010000000000ULL }, { u8"is", 0x0000000000900403ULL },
+    { u8"ishte", 0x0000000000000004ULL }, { u8"ist", 0x0000000000020000ULL }, { u8"it", 0x0000000000000001ULL },
+    { u8"ita", 0x0000000000080000ULL }, { u8"ito", 0x0000000000002000ULL }, { u8"itu", 0x0000000080400000ULL },
+    { u8"iwe", 0x0000010000000000ULL }, { u8"iyo", 0x0000080000000000ULL }, { u8"izao", 0x0000000040000000ULL },
+    { u8"izy", 0x0000000040000000ULL }, { u8"için", 0x0001000000000000ULL }, { u8"ja", 0x0000020800005000ULL },
+    { u8"jag", 0x0000800000000000ULL }, { u8"jak", 0x0000000800000100ULL }, { u8"janë", 0x0000000000000004ULL },
+    { u8"je", 0x00000600000085a0ULL }, { u8"jeg", 0x0000000400000200ULL }, { u8"jest", 0x0000000800000000ULL },
+    { u8"jeung", 0x0000200000000000ULL }, { u8"ji", 0x0000000002000000ULL }, { u8"jien", 0x0000000100000000ULL },
+    { u8"jsem", 0x0000000000000100ULL }, { u8"ju", 0x0000000000000004ULL }, { u8"juda", 0x0002000000000000ULL },
+    { u8"jy", 0x0000000000000002ULL }, { u8"já", 0x0000000000000100ULL }, { u8"jî", 0x0000000002000000ULL },
+    { u8"ka", 0x0000080208001004ULL }, { u8"kad", 0x0000000010000000ULL }, { u8"kaj", 0x0000000000000800ULL },
+    { u8"kako", 0x00000000000000a0ULL }, { u8"kami", 0x0000000000002000ULL }, { u8"kana", 0x0000200000000000ULL },
+    { u8"kas", 0x0000000018001000ULL }, { u8"katika", 0x0000400000000000ULL }, { u8"kei", 0x0000000200000000ULL },
+    { u8"không", 0x0004000000000000ULL }, { u8"ki", 0x0000040200000000ULL }, { u8"kimi", 0x0000000000000008ULL },
+    { u8"kir", 0x0000000002000000ULL }, { u8"ko", 0x0000000200002000ULL }, { u8"kodwa", 0x0040000000000000ULL },
+    { u8"koe", 0x0000000200000000ULL }, { u8"koji", 0x00000000000000a0ULL }, { u8"konnen", 0x0000000000040000ULL },
+    { u8"kot", 0x0000040000000000ULL }, { u8"ku", 0x0000080002000000ULL }, { u8"kuma", 0x0000000000080000ULL },
+    { u8"kun", 0x0000000000004800ULL }, { u8"kuti", 0x0000010000000000ULL }, { u8"kwa", 0x0000400000000000ULL },
+    { u8"kwaye", 0x0010000000000000ULL }, { u8"kò", 0x0020000000000000ULL }, { u8"la", 0x0000102001008840ULL },
+    { u8"las", 0x0000100000000000ULL }, { u8"le", 0x0000004000808000ULL }, { u8"lea", 0x0000004000000000ULL },
+    { u8"leh", 0x0000080000000000ULL }, { u8"les", 0x0000000000008000ULL }, { u8"li", 0x0000000100040000ULL },
+    { u8"lo", 0x0000000001000000ULL }, { u8"los", 0x0000100000000000ULL }, { u8"là", 0x0004000000000000ULL },
+    { u8"ma", 0x0000004000001000ULL }, { u8"mae", 0x0008000000000000ULL }, { u8"manje", 0x0040000000000000ULL },
+    { u8"mat", 0x0000000020000000ULL }, { u8"me", 0x0000000000000004ULL }, { u8"med", 0x0000800400000200ULL },
+    { u8"meg", 0x0000000000100000ULL }, { u8"men", 0x0002000000000000ULL }, { u8"met", 0x0000000000000402ULL },
+    { u8"mga", 0x0000000000002000ULL }, { u8"mhux", 0x0000000100000000ULL }, { u8"mi", 0x0000008001000800ULL },
+    { u8"mimi", 0x0000400000000000ULL }, { u8"minä", 0x0000000000004000ULL }, { u8"mis", 0x0000000000001000ULL },
+    { u8"mit", 0x0000000000020000ULL }, { u8"mitä", 0x0000000000004000ULL }, { u8"mo", 0x0020000000000000ULL },
+    { u8"moito", 0x0000000000010000ULL }, { u8"molt", 0x0000000000000040ULL }, { u8"mutta", 0x0000000000004000ULL },
+    { u8"mwen", 0x0000000000040000ULL }, { u8"mé", 0x0000000000800000ULL }, { u8"mən", 0x0000000000000008ULL },
+    { u8"một", 0x0004000000000000ULL }, { u8"na", 0x00004688008821a0ULL }, { u8"naiz", 0x0000000000000010ULL },
+    { u8"nan", 0x0000000000040000ULL }, { u8"nav", 0x0000000008000000ULL }, { u8"ndi", 0x0010010000000000ULL },
+    { u8"ne", 0x00010500120808a0ULL }, { u8"nem", 0x0000000000100000ULL }, { u8"není", 0x0000000000000100ULL },
+    { u8"net", 0x0000000020000000ULL }, { u8"ng", 0x0000000000002000ULL }, { u8"nga", 0x0010000000000000ULL },
+    { u8"ngi", 0x0040000000000000ULL }, { u8"ngoku", 0x0010000000000000ULL }, { u8"ngā", 0x0000000200000000ULL },
+    { u8"người", 0x0004000000000000ULL }, { u8"những", 0x0004000000000000ULL }, { u8"ni", 0x0020400000000000ULL },
+    { u8"nicht", 0x0000000000020000ULL }, { u8"nie", 0x0000020800000002ULL }, { u8"niet", 0x0000000000000400ULL },
+    { u8"nima", 0x0002000000000000ULL }, { u8"nire", 0x0000000000000010ULL }, { u8"një", 0x0000000000000004ULL },
+    { u8"no", 0x0000100000000040ULL }, { u8"non", 0x0000000005010000ULL }, { u8"not", 0x0000000000000001ULL },
+    { u8"nou", 0x0000000000040000ULL }, { u8"nu", 0x0000202000000000ULL }, { u8"nuk", 0x0000000000000004ULL },
+    { u8"ny", 0x0000000040000000ULL }, { u8"não", 0x0000001000000000ULL }, { u8"në", 0x0000000000000004ULL },
+    { u8"ní", 0x0000000000800000ULL }, { u8"nə", 0x0000000000000008ULL }, { u8"o", 0x0028007000010000ULL },
+    { u8"och", 0x0000800020000000ULL }, { u8"of", 0x0000000000000001ULL }, { u8"og", 0x0000000400200200ULL },
+    { u8"olan", 0x0000000000000008ULL }, { u8"olen", 0x0000000000004000ULL }, { u8"oli", 0x0000000000001000ULL },
+    { u8"on", 0x0000000000005001ULL }, { u8"ons", 0x0000000000000002ULL }, { u8"oo", 0x0000080000000000ULL },
+    { u8"op", 0x0000000000000400ULL }, { u8"os", 0x0000001000010000ULL }, { u8"ou", 0x0000004000040000ULL },
+    { u8"ovat", 0x0000000000004000ULL }, { u8"pa", 0x0000000000040000ULL }, { u8"par", 0x0000000008000000ULL },
+    { u8"para", 0x0000101000010000ULL }, { u8"pas", 0x0000000000008000ULL }, { u8"pe", 0x0020002000000000ULL },
+    { u8"per", 0x0000000001000040ULL }, { u8"però", 0x0000000000000040ULL }, { u8"por", 0x0000100000000800ULL },
+    { u8"pou", 0x0000000000040000ULL }, { u8"pour", 0x0000000000008000ULL }, { u8"pre", 0x0000020000000000ULL },
+    { u8"pro", 0x0000000000000100ULL }, { u8"på", 0x0000800400000200ULL }, { u8"për", 0x0000000000000004ULL },
+    { u8"que", 0x0000101000018040ULL }, { u8"quod", 0x0000000004000000ULL }, { u8"që", 0x0000000000000004ULL },
+    { u8"ri", 0x0000008000000000ULL }, { u8"sa", 0x0000020000043000ULL }, { u8"sam", 0x00000000000000a0ULL },
+    { u8"saya", 0x0000000080400000ULL }, { u8"se", 0x00000400000441a0ULL }, { u8"sed", 0x0000000004000800ULL },
+    { u8"see", 0x0000000000001000ULL }, { u8"sem", 0x0000040000200000ULL }, { u8"sen", 0x0003000000000000ULL },
+    { u8"shi", 0x0000000000080000ULL }, { u8"si", 0x0020400000000000ULL }, { u8"sie", 0x0000000000020000ULL },
+    { u8"sinn", 0x0000000020000000ULL }, { u8"sinä", 0x0000000000004000ULL }, { u8"siya", 0x0000000000002000ULL },
+    { u8"się", 0x0000000800000000ULL }, { u8"som", 0x0000820400000200ULL }, { u8"sono", 0x0000000001000000ULL },
+    { u8"su", 0x0000000010000000ULL }, { u8"suna", 0x0000000000080000ULL }, { u8"sunt", 0x0000002004000000ULL },
+    { u8"sy", 0x0000000040000002ULL }, { u8"sé", 0x0000000000800000ULL }, { u8"sí", 0x0000000000800000ULL },
+    { u8"sən", 0x0000000000000008ULL }, { u8"ta", 0x0000000100000000ULL }, { u8"tai", 0x0000000010000000ULL },
+    { u8"tas", 0x0000000008000000ULL }, { u8"te", 0x0000004200000000ULL }, { u8"teu", 0x0000200000000000ULL },
+    { u8"tha", 0x0000008000000000ULL }, { u8"that", 0x0000000000000001ULL }, { u8"the", 0x0000000000000001ULL },
+    { u8"this", 0x0000000000000001ULL }, { u8"thu", 0x0000008000000000ULL }, { u8"ti", 0x0020000000000000ULL },
+    { u8"tidak", 0x0000000080400000ULL }, { u8"til", 0x0000000400200200ULL }, { u8"tio", 0x0000000000000800ULL },
+    { u8"to", 0x0000060800000101ULL }, { u8"tsy", 0x0000000040000000ULL }, { u8"tu", 0x000000001a000000ULL },
+    { u8"tá", 0x0000000000800000ULL }, { u8"të", 0x0000000000000004ULL }, { u8"tôi", 0x0004000000000000ULL },
+    { u8"tēnei", 0x0000000200000000ULL }, { u8"u", 0x00000001000000a0ULL }, { u8"uchun", 0x0002000000000000ULL },
+    { u8"uku", 0x0050000000000000ULL }, { u8"ukuba", 0x0050000000000000ULL }, { u8"um", 0x0000001000000000ULL },
+    { u8"uma", 0x0000001000000000ULL }, { u8"un", 0x0000102009018000ULL }, { u8"una", 0x0000100001000040ULL },
+    { u8"und", 0x0000000000020000ULL }, { u8"une", 0x0000000000008000ULL }, { u8"unha", 0x0000000000010000ULL },
+    { u8"untuk", 0x0000000080400000ULL }, { u8"unë", 0x0000000000000004ULL }, { u8"ut", 0x0000000004000000ULL },
+    { u8"uye", 0x0000010000000000ULL }, { u8"uz", 0x0000000008000000ULL }, { u8"v", 0x0000060000000100ULL },
+    { u8"va", 0x0002000000000000ULL }, { u8"vad", 0x0000800000000000ULL }, { u8"vagy", 0x0000000000100000ULL },
+    { u8"van", 0x0000000000100402ULL }, { u8"ve", 0x0001000000000100ULL }, { u8"vi", 0x0000000000000800ULL },
+    { u8"vir", 0x0000000000000002ULL }, { u8"við", 0x0000000000200000ULL }, { u8"você", 0x0000001000000000ULL },
+    { u8"voor", 0x0000000000000400ULL }, { u8"vous", 0x0000000000008000ULL }, { u8"và", 0x0004000000000000ULL },
+    { u8"və", 0x0000000000000008ULL }, { u8"w", 0x0000000800000000ULL }, { u8"wa", 0x0020400000000000ULL },
+    { u8"waa", 0x0000080000000000ULL }, { u8"wannan", 0x0000000000080000ULL }, { u8"was", 0x0000000000000001ULL },
+    { u8"wat", 0x0000000000000402ULL }, { u8"waxaan", 0x0000080000000000ULL }, { u8"wewe", 0x0000400000000000ULL },
+    { u8"what", 0x0000000000000001ULL }, { u8"with", 0x0000000000000001ULL }, { u8"y", 0x0008100000000000ULL },
+    { u8"ya", 0x0000400000000000ULL }, { u8"yana", 0x0000000000080000ULL }, { u8"yang", 0x0000000080400000ULL },
+    { u8"yini", 0x0040000000000000ULL }, { u8"yn", 0x0008000000000000ULL }, { u8"yo", 0x0000000000040000ULL },
+    { u8"you", 0x0000000000000001ULL }, { u8"yra", 0x0000000010000000ULL }, { u8"z", 0x0000000800000000ULL },
+    { u8"za", 0x0000400000000000ULL }, { u8"zer", 0x0000000000000010ULL }, { u8"zijn", 0x0000000000000400ULL },
+    { u8"zu", 0x0000000000020000ULL }, { u8"zvino", 0x0000010000000000ULL }, { u8"á", 0x0000000000200000ULL },
+    { u8"är", 0x0000800000000000ULL }, { u8"çok", 0x0001000000000000ULL }, { u8"çox", 0x0000000000000008ULL },
+    { u8"è", 0x0000000001000000ULL }, { u8"é", 0x0000001000010000ULL }, { u8"ég", 0x0000000000200000ULL },
+    { u8"és", 0x0000000000100040ULL }, { u8"éta", 0x0000200000000000ULL }, { u8"është", 0x0000000000000004ULL },
+    { u8"în", 0x0000002000000000ULL }, { u8"û", 0x0000000002000000ULL }, { u8"üçün", 0x0000000000000008ULL },
+    { u8"það", 0x0000000000200000ULL }, { u8"þú", 0x0000000000200000ULL }, { u8"ĉu", 0x0000000000000800ULL },
+    { u8"į", 0x0000000010000000ULL }, { u8"što", 0x00000000000000a0ULL }, { u8"że", 0x0000000800000000ULL },
+    { u8"že", 0x0000020000000100ULL }, { u8"și", 0x0000002000000000ULL }
+};
+
+// 变音字母（小写）→ 使用它的语言（按码点排序）
+static const xlang_mark_t xlang_latin_marks[] = {
+    { 0x00DF, 0x0000000000020000ULL }, { 0x00E0, 0x0000000001008040ULL }, { 0x00E1, 0x0000121000b10100ULL },
+    { 0x00E2, 0x0000003000008000ULL }, { 0x00E3, 0x0000001000000000ULL }, { 0x00E4, 0x0000820020025000ULL },
+    { 0x00E5, 0x0000800400000200ULL }, { 0x00E6, 0x0000000400200200ULL }, { 0x00E7, 0x000100100200804cULL },
+    { 0x00E8, 0x0000000001008040ULL }, { 0x00E9, 0x0000101021918140ULL }, { 0x00EA, 0x0000001002008002ULL },
+    { 0x00EB, 0x0000000020008006ULL }, { 0x00EC, 0x0000000001000000ULL }, { 0x00ED, 0x0000121000b10140ULL },
+    { 0x00EE, 0x0000002002008000ULL }, { 0x00EF, 0x0000000000008040ULL }, { 0x00F0, 0x0000000000200000ULL },
+    { 0x00F1, 0x0000100000010000ULL }, { 0x00F2, 0x0000000001000040ULL }, { 0x00F3, 0x0000121800b10140ULL },
+    { 0x00F4, 0x0000021000008000ULL }, { 0x00F5, 0x0000001000001000ULL }, { 0x00F6, 0x0001800000325008ULL },
+    { 0x00F8, 0x0000000400000200ULL }, { 0x00F9, 0x0000000001008000ULL }, { 0x00FA, 0x0000121000b10100ULL },
+    { 0x00FC, 0x0001000000121008ULL }, { 0x00FD, 0x0000020000200100ULL }, { 0x00FE, 0x0000000000200000ULL },
+    { 0x0101, 0x0000000208000000ULL }, { 0x0103, 0x0004002000000000ULL }, { 0x0105, 0x0000000810000000ULL },
+    { 0x0107, 0x00000008000000a0ULL }, { 0x0109, 0x0000000000000800ULL }, { 0x010B, 0x0000000100000000ULL },
+    { 0x010D, 0x00000600180001a0ULL }, { 0x010F, 0x0000020000000100ULL }, { 0x0111, 0x00040000000000a0ULL },
+    { 0x0113, 0x0000000208000000ULL }, { 0x0117, 0x0000000010000000ULL }, { 0x0119, 0x0000000810000000ULL },
+    { 0x011B, 0x0000000000000100ULL }, { 0x011D, 0x0000000000000800ULL }, { 0x011F, 0x0001000000000008ULL },
+    { 0x0121, 0x0000000100000000ULL }, { 0x0123, 0x0000000008000000ULL }, { 0x0125, 0x0000000000000800ULL },
+    { 0x0127, 0x0000000100000000ULL }, { 0x012B, 0x0000000208000000ULL }, { 0x012F, 0x0000000010000000ULL },
+    { 0x0131, 0x0001000000000008ULL }, { 0x0135, 0x0000000000000800ULL }, { 0x0137, 0x0000000008000000ULL },
+    { 0x013A, 0x0000020000000000ULL }, { 0x013C, 0x0000000008000000ULL }, { 0x013E, 0x0000020000000000ULL },
+    { 0x0142, 0x0000000800000000ULL }, { 0x0144, 0x0000000800000000ULL }, { 0x0146, 0x0000000008000000ULL },
+    { 0x0148, 0x0000020000000100ULL }, { 0x014D, 0x0000000200000000ULL }, { 0x0151, 0x0000000000100000ULL },
+    { 0x0153, 0x0000000000008000ULL }, { 0x0155, 0x0000020000000000ULL }, { 0x0159, 0x0000000000000100ULL },
+    { 0x015B, 0x0000000800000000ULL }, { 0x015D, 0x0000000000000800ULL }, { 0x015F, 0x0001002002000008ULL },
+    { 0x0161, 0x00000600180001a0ULL }, { 0x0163, 0x0000002000000000ULL }, { 0x0165, 0x0000020000000100ULL },
+    { 0x016B, 0x0000000218000000ULL }, { 0x016D, 0x0000000000000800ULL }, { 0x016F, 0x0000000000000100ULL },
+    { 0x0171, 0x0000000000100000ULL }, { 0x0173, 0x0000000010000000ULL }, { 0x0175, 0x0008000000000000ULL },
+    { 0x0177, 0x0008000000000000ULL }, { 0x017A, 0x0000000800000000ULL }, { 0x017C, 0x0000000900000000ULL },
+    { 0x017E, 0x00000600180001a0ULL }, { 0x0199, 0x0000000000080000ULL }, { 0x01A1, 0x0004000000000000ULL },
+    { 0x01B0, 0x0004000000000000ULL }, { 0x0219, 0x0000002000000000ULL }, { 0x021B, 0x0000002000000000ULL },
+    { 0x0253, 0x0000000000080000ULL }, { 0x0257, 0x0000000000080000ULL }, { 0x0259, 0x0000000000000008ULL },
+    { 0x02BB, 0x0002000000000000ULL }, { 0x1E63, 0x0020000000000000ULL }, { 0x1EA0, 0x0004000000000000ULL },
+    { 0x1EA1, 0x0004000000000000ULL }, { 0x1EA2, 0x0004000000000000ULL }, { 0x1EA3, 0x0004000000000000ULL },
+    { 0x1EA4, 0x0004000000000000ULL }, { 0x1EA5, 0x0004000000000000ULL }, { 0x1EA6, 0x0004000000000000ULL },
+    { 0x1EA7, 0x0004000000000000ULL }, { 0x1EA8, 0x0004000000000000ULL }, { 0x1EA9, 0x0004000000000000ULL },
+    { 0x1EAA, 0x0004000000000000ULL }, { 0x1EAB, 0x0004000000000000ULL }, { 0x1EAC, 0x0004000000000000ULL },
+    { 0x1EAD, 0x0004000000000000ULL }, { 0x1EAE, 0x0004000000000000ULL }, { 0x1EAF, 0x0004000000000000ULL },
+    { 0x1EB0, 0x0004000000000000ULL }, { 0x1EB1, 0x0004000000000000ULL }, { 0x1EB2, 0x0004000000000000ULL },
+    { 0x1EB3, 0x0004000000000000ULL }, { 0x1EB4, 0x0004000000000000ULL }, { 0x1EB5, 0x0004000000000000ULL },
+    { 0x1EB6, 0x0004000000000000ULL }, { 0x1EB7, 0x0004000000000000ULL }, { 0x1EB8, 0x0004000000000000ULL },
+    { 0x1EB9, 0x0024000000000000ULL }, { 0x1EBA, 0x0004000000000000ULL }, { 0x1EBB, 0x0004000000000000ULL },
+    { 0x1EBC, 0x0004000000000000ULL }, { 0x1EBD, 0x0004000000000000ULL }, { 0x1EBE, 0x0004000000000000ULL },
+    { 0x1EBF, 0x0004000000000000ULL }, { 0x1EC0, 0x0004000000000000ULL }, { 0x1EC1, 0x0004000000000000ULL },
+    { 0x1EC2, 0x0004000000000000ULL }, { 0x1EC3, 0x0004000000000000ULL }, { 0x1EC4, 0x0004000000000000ULL },
+    { 0x1EC5, 0x0004000000000000ULL }, { 0x1EC6, 0x0004000000000000ULL }, { 0x1EC7, 0x0004000000000000ULL },
+    { 0x1EC8, 0x0004000000000000ULL }, { 0x1EC9, 0x0004000000000000ULL }, { 0x1ECA, 0x0004000000000000ULL },
+    { 0x1ECB, 0x0004000000000000ULL }, { 0x1ECC, 0x0004000000000000ULL }, { 0x1ECD, 0x0024000000000000ULL },
+    { 0x1ECE, 0x0004000000000000ULL }, { 0x1ECF, 0x0004000000000000ULL }, { 0x1ED0, 0x0004000000000000ULL },
+    { 0x1ED1, 0x0004000000000000ULL }, { 0x1ED2, 0x0004000000000000ULL }, { 0x1ED3, 0x0004000000000000ULL },
+    { 0x1ED4, 0x0004000000000000ULL }, { 0x1ED5, 0x0004000000000000ULL }, { 0x1ED6, 0x0004000000000000ULL },
+    { 0x1ED7, 0x0004000000000000ULL }, { 0x1ED8, 0x0004000000000000ULL }, { 0x1ED9, 0x0004000000000000ULL },
+    { 0x1EDA, 0x0004000000000000ULL }, { 0x1EDB, 0x0004000000000000ULL }, { 0x1EDC, 0x0004000000000000ULL },
+    { 0x1EDD, 0x0004000000000000ULL }, { 0x1EDE, 0x0004000000000000ULL }, { 0x1EDF, 0x0004000000000000ULL },
+    { 0x1EE0, 0x0004000000000000ULL }, { 0x1EE1, 0x0004000000000000ULL }, { 0x1EE2, 0x0004000000000000ULL },
+    { 0x1EE3, 0x0004000000000000ULL }, { 0x1EE4, 0x0004000000000000ULL }, { 0x1EE5, 0x0004000000000000ULL },
+    { 0x1EE6, 0x0004000000000000ULL }, { 0x1EE7, 0x0004000000000000ULL }, { 0x1EE8, 0x0004000000000000ULL },
+    { 0x1EE9, 0x0004000000000000ULL }, { 0x1EEA, 0x0004000000000000ULL }, { 0x1EEB, 0x0004000000000000ULL },
+    { 0x1EEC, 0x0004000000000000ULL }, { 0x1EED, 0x0004000000000000ULL }, { 0x1EEE, 0x0004000000000000ULL },
+    { 0x1EEF, 0x0004000000000000ULL }, { 0x1EF0, 0x0004000000000000ULL }, { 0x1EF1, 0x0004000000000000ULL },
+    { 0x1EF2, 0x0004000000000000ULL }, { 0x1EF3, 0x0004000000000000ULL }, { 0x1EF4, 0x0004000000000000ULL },
+    { 0x1EF5, 0x0004000000000000ULL }, { 0x1EF6, 0x0004000000000000ULL }, { 0x1EF7, 0x0004000000000000ULL },
+    { 0x1EF8, 0x0004000000000000ULL }, { 0x1EF9, 0x0004000000000000ULL }
+};
+
+#define XLANG_COUNT(a) (sizeof(a) / sizeof((a)[0]))
+#define XLANG_MAX_WORD 32       // 超过此长度的词不查表
+#define XLANG_MAX_HINTS 16
+
+/**
+ * @brief 宽松解码一个 UTF-8 字符（非法字节按 U+FFFD 跳过一个字节）
+ */
+static uint32_t xlang_next(const unsigned char* s, size_t len, size_t* i) {
+    unsigned char c = s[*i];
+    size_t need;
+    uint32_t cp;
+
+    if (c < 0x80) {
+        (*i)++;
+        return c;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+        need = 1;
+        cp = c & 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 2;
+        cp = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 3;
+        cp = c & 0x07;
+    } else {
+        (*i)++;
+        return 0xFFFD;
+    }
+
+    if (*i + need >= len) {
+        (*i)++;
+        return 0xFFFD;
+    }
+    for (size_t k = 1; k <= need; k++) {
+        unsigned char cc = s[*i + k];
+        if ((cc & 0xC0) != 0x80) {
+            (*i)++;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    *i += need + 1;
+    return cp;
+}
+
+static int xlang_script(uint32_t cp) {
+    size_t lo = 0, hi = XLANG_COUNT(xlang_ranges);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp < xlang_ranges[mid].lo) hi = mid;
+        else if (cp > xlang_ranges[mid].hi) lo = mid + 1;
+        else return xlang_ranges[mid].script;
+    }
+    return XLANG_NONE;
+}
+
+/**
+ * @brief 拉丁字母转小写（ASCII、Latin-1、Latin Extended-A）
+ */
+static uint32_t xlang_fold(uint32_t cp) {
+    if (cp >= 'A' && cp <= 'Z') return cp + 0x20;
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20;
+    if ((cp >= 0x0100 && cp <= 0x0137) || (cp >= 0x014A && cp <= 0x0177)) return cp | 1;
+    if ((cp >= 0x0139 && cp <= 0x0148) || (cp >= 0x0179 && cp <= 0x017E)) return (cp & 1) ? cp + 1 : cp;
+    return cp;
+}
+
+static int xlang_has_u16(const uint16_t* tab, size_t n, uint32_t cp) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp < tab[mid]) hi = mid;
+        else if (cp > tab[mid]) lo = mid + 1;
+        else return 1;
+    }
+    return 0;
+}
+
+static const xlang_hint_t* xlang_find_hint(uint32_t cp) {
+    size_t lo = 0, hi = XLANG_COUNT(xlang_hints);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp < xlang_hints[mid].cp) hi = mid;
+        else if (cp > xlang_hints[mid].cp) lo = mid + 1;
+        else return &xlang_hints[mid];
+    }
+    return NULL;
+}
+
+static uint64_t xlang_find_mark(uint32_t cp) {
+    size_t lo = 0, hi = XLANG_COUNT(xlang_latin_marks);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp < xlang_latin_marks[mid].cp) hi = mid;
+        else if (cp > xlang_latin_marks[mid].cp) lo = mid + 1;
+        else return xlang_latin_marks[mid].langs;
+    }
+    return 0;
+}
+
+static uint64_t xlang_find_word(const char* word) {
+    size_t lo = 0, hi = XLANG_COUNT(xlang_words);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = strcmp(word, xlang_words[mid].word);
+        if (c < 0) hi = mid;
+        else if (c > 0) lo = mid + 1;
+        else return xlang_words[mid].langs;
+    }
+    return 0;
+}
+
+static void xlang_add(int* score, uint64_t langs, int weight) {
+    for (size_t b = 0; langs; b++, langs >>= 1) {
+        if (langs & 1) score[b] += weight;
+    }
+}
+
+static size_t xlang_put_utf8(char* buf, uint32_t cp) {
+    if (cp < 0x80) {
+        buf[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        buf[0] = (char)(0xC0 | (cp >> 6));
+        buf[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    buf[0] = (char)(0xE0 | (cp >> 12));
+    buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    buf[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+}
+
+const char* xlang_detect(const char* text, size_t len) {
+    if (!text) return "en";
+
+    const unsigned char* s = (const unsigned char*)text;
+    unsigned counts[XLANG_SCRIPT_COUNT] = {0};
+    int latin[XLANG_COUNT(xlang_latin)] = {0};
+    struct { const char* lang; int script; int score; } hints[XLANG_MAX_HINTS];
+    int nhints = 0;
+    int simplified = 0, traditional = 0;
+    char word[XLANG_MAX_WORD + 4];
+    size_t word_len = 0;
+
+    // 末尾多走一步（cp = 0）以结束最后一个词
+    size_t i = 0;
+    for (;;) {
+        uint32_t cp = 0;
+        if (i < len) cp = xlang_next(s, len, &i);
+        int script = cp ? xlang_script(cp) : XLANG_NONE;
+
+        if (script == XLANG_LATIN) {
+            cp = xlang_fold(cp);
+            counts[XLANG_LATIN]++;
+            if (cp >= 0x80) xlang_add(latin, xlang_find_mark(cp), 1);
+            if (word_len <= XLANG_MAX_WORD) word_len += xlang_put_utf8(word + word_len, cp);
+            continue;
+        }
+
+        // 一个拉丁词结束：查常用词表
+        if (word_len > 0 && word_len <= XLANG_MAX_WORD) {
+            word[word_len] = '\0';
+            xlang_add(latin, xlang_find_word(word), 2);
+        }
+        word_len = 0;
+
+        if (script == XLANG_HAN) {
+            counts[XLANG_HAN]++;
+            if (cp <= 0xFFFF) {
+                simplified += xlang_has_u16(xlang_simplified, XLANG_COUNT(xlang_simplified), cp);
+                traditional += xlang_has_u16(xlang_traditional, XLANG_COUNT(xlang_traditional), cp);
+            }
+        } else if (script != XLANG_NONE) {
+            counts[script]++;
+            const xlang_hint_t* h = xlang_find_hint(cp);
+            if (h) {
+                int k = 0;
+                while (k < nhints && strcmp(hints[k].lang, h->lang) != 0) k++;
+                if (k == nhints && nhints < XLANG_MAX_HINTS) {
+                    hints[nhints].lang = h->lang;
+                    hints[nhints].script = h->script;
+                    hints[nhints].score = 0;
+                    nhints++;
+                }
+                if (k < nhints) hints[k].score += h->weight;
+            }
+        }
+
+        if (i >= len && cp == 0) break;
+    }
+
+    // 出现假名即为日语（日文同时使用汉字）
+    if (counts[XLANG_KANA] > 0) {
+        counts[XLANG_KANA] += counts[XLANG_HAN];
+        counts[XLANG_HAN] = 0;
+    }
+
+    // 主文字系统：汉字/假名/谚文一个字约等于一个词，按 3 个字母计
+    int best = XLANG_NONE;
+    unsigned best_count = 0;
+    for (int sc = 1; sc < XLANG_SCRIPT_COUNT; sc++) {
+        unsigned n = counts[sc];
+        if (sc == XLANG_HAN || sc == XLANG_KANA || sc == XLANG_HANGUL) n *= 3;
+        if (n > best_count) {
+            best_count = n;
+            best = sc;
+        }
+    }
+
+    if (best == XLANG_NONE) return "en";
+
+    if (best == XLANG_LATIN) {
+        // 词和变音字母得分最高者；没有任何线索时为英语（xlang_latin[0]）
+        size_t top = 0;
+        for (size_t k = 1; k < XLANG_COUNT(xlang_latin); k++) {
+            if (latin[k] > latin[top]) top = k;
+        }
+        return xlang_latin[top];
+    }
+
+    if (best == XLANG_HAN) {
+        return traditional > simplified ? "zh-tw" : "zh-cn";
+    }
+
+    const char* lang = xlang_script_lang[best];
+    int top_score = 0;
+    for (int k = 0; k < nhints; k++) {
+        if (hints[k].script == best && hints[k].score > top_score) {
+            top_score = hints[k].score;
+            lang = hints[k].lang;
+        }
+    }
+    return lang;
+}
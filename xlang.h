@@ -0,0 +1,17 @@
+#ifndef XLANG_H
+#define XLANG_H
+
+#include <stddef.h>
+
+/**
+ * @brief 离线检测文本语言
+ * @note 先按 Unicode 文字系统统计主文字，再在文字内部区分语言：
+ *       西里尔/阿拉伯/希伯来/天城文看特征字母，汉字按简繁特有字区分 zh-cn/zh-tw，
+ *       出现假名为日语，拉丁字母按常用词和变音字母打分。全部查静态表，不访问网络
+ * @param text UTF-8 文本
+ * @param len 文本长度
+ * @return 语言代码（与 xtrans 语言表一致，如 "en"、"zh-cn"、"zh-tw"、"ja"、"ko"、"ru"），无法判断时为 "en"
+ */
+const char* xlang_detect(const char* text, size_t len);
+
+#endif // XLANG_H
@@ -0,0 +1,288 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "xlimit.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define XLIMIT_DEFAULT_WAIT_MS  30000   // 默认最长等待
+#define XLIMIT_MAX_BLOCK_MS     3600000 // Retry-After 最多遵守 1 小时
+#define XLIMIT_BACKOFF_MS       1000    // 未限速主机收到节流信号且无 Retry-After 时的暂停
+#define XLIMIT_DECREASE_GAP_MS  1000    // 两次乘性减之间的最短间隔（同一批响应只减一次）
+#define XLIMIT_MIN_RATE_DIV     16.0    // 速率最低降到配置值的 1/16
+#define XLIMIT_RATE_STEP_DIV    20.0    // 每个成功响应恢复配置速率的 1/20
+
+typedef struct {
+    char host[256];
+    int configured;         // 由 xlimit_set 单独配置（不随默认值变化）
+    xlimit_cfg_t cfg;
+
+    double rate;
+    double tokens;
+    double last_refill;     // 上次补充令牌的时间（ms）
+    double concurrency;
+    double blocked_until;   // Retry-After 到期时间（ms）
+    double last_decrease;
+
+    unsigned requests;
+    unsigned throttled;
+    unsigned rejected;
+    double waited_ms;
+} xlimit_host_t;
+
+static xlimit_cfg_t xlimit_default = { 0.0, 1.0, 0, XLIMIT_DEFAULT_WAIT_MS };
+static xlimit_host_t xlimit_hosts[XLIMIT_MAX_HOSTS];
+static int xlimit_size = 0;
+static int xlimit_next = 0;
+
+double xlimit_now_ms(void) {
+#ifdef _WIN32
+    return (double)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+void xlimit_sleep_ms(double ms) {
+#ifdef _WIN32
+    Sleep((DWORD)(ms + 0.5));
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000.0);
+    ts.tv_nsec = (long)((ms - ts.tv_sec * 1000.0) * 1e6);
+    while (nanosleep(&ts, &ts) != 0) {}  // 被信号打断时睡完剩余时间
+#endif
+}
+
+static int xlimit_host_eq(const char* a, const char* b) {
+    while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+/**
+ * @brief 按配置重置 AIMD 状态（桶装满，窗口从上限开始）
+ */
+static void xlimit_apply(xlimit_host_t* h, const xlimit_cfg_t* cfg) {
+    h->cfg = *cfg;
+    if (h->cfg.burst < 1.0) h->cfg.burst = 1.0;
+    if (h->cfg.max_wait_ms <= 0) h->cfg.max_wait_ms = XLIMIT_DEFAULT_WAIT_MS;
+    h->rate = h->cfg.rate > 0 ? h->cfg.rate : 0.0;
+    h->tokens = h->cfg.burst;
+    h->last_refill = xlimit_now_ms();
+    h->concurrency = h->cfg.max_concurrency > 0 ? h->cfg.max_concurrency : 0.0;
+}
+
+/**
+ * @brief 查找主机状态；create 时按默认值新建
+ * @note 表满时按 FIFO 覆盖未单独配置的主机，xlimit_set 配置的主机不会被挤掉；
+ *       全部为已配置主机时返回 NULL（该主机不限流）
+ */
+static xlimit_host_t* xlimit_find(const char* host, int create) {
+    if (!host || !host[0]) return NULL;
+    for (int i = 0; i < xlimit_size; i++) {
+        if (xlimit_host_eq(xlimit_hosts[i].host, host)) return &xlimit_hosts[i];
+    }
+    if (!create || strlen(host) >= sizeof(xlimit_hosts[0].host)) return NULL;
+
+    xlimit_host_t* h = NULL;
+    if (xlimit_size < XLIMIT_MAX_HOSTS) {
+        h = &xlimit_hosts[xlimit_size++];
+    } else {
+        for (int n = 0; n < XLIMIT_MAX_HOSTS && !h; n++) {
+            xlimit_host_t* slot = &xlimit_hosts[xlimit_next];
+            xlimit_next = (xlimit_next + 1) % XLIMIT_MAX_HOSTS;
+            if (!slot->configured) h = slot;
+        }
+        if (!h) return NULL;
+    }
+
+    memset(h, 0, sizeof(*h));
+    strcpy(h->host, host);
+    xlimit_apply(h, &xlimit_default);
+    return h;
+}
+
+static void xlimit_refill(xlimit_host_t* h, double now) {
+    if (h->rate > 0) {
+        h->tokens += (now - h->last_refill) * h->rate / 1000.0;
+        if (h->tokens > h->cfg.burst) h->tokens = h->cfg.burst;
+    }
+    h->last_refill = now;
+}
+
+int xlimit_set(const char* host, const xlimit_cfg_t* cfg) {
+    if (!cfg || cfg->rate < 0) return -1;
+
+    if (!host) {
+        xlimit_default = *cfg;
+        for (int i = 0; i < xlimit_size; i++) {
+            if (!xlimit_hosts[i].configured) xlimit_apply(&xlimit_hosts[i], cfg);
+        }
+        return 0;
+    }
+
+    xlimit_host_t* h = xlimit_find(host, 1);
+    if (!h) return -1;
+    h->configured = 1;
+    xlimit_apply(h, cfg);
+    return 0;
+}
+
+int xlimit_acquire(const char* host, int verbose) {
+    xlimit_host_t* h = xlimit_find(host, 1);
+    if (!h) return 0;
+
+    double now = xlimit_now_ms();
+    xlimit_refill(h, now);
+
+    double wait = h->blocked_until > now ? h->blocked_until - now : 0.0;
+    if (h->rate > 0 && h->tokens < 1.0) {
+        double refill = (1.0 - h->tokens) * 1000.0 / h->rate;
+        if (refill > wait) wait = refill;
+    }
+
+    if (wait > h->cfg.max_wait_ms) {
+        h->rejected++;
+        if (verbose) printf("[LIMIT] %s: need to wait %.0f ms (> %d ms), request rejected\n",
+                            h->host, wait, h->cfg.max_wait_ms);
+        return -1;
+    }
+    if (wait > 0) {
+        if (verbose) printf("[LIMIT] %s: waiting %.0f ms\n", h->host, wait);
+        xlimit_sleep_ms(wait);
+        h->waited_ms += wait;
+        xlimit_refill(h, xlimit_now_ms());
+    }
+
+    if (h->rate > 0) h->tokens -= 1.0;
+    h->requests++;
+    return 0;
+}
+
+int xlimit_concurrency(const char* host) {
+    xlimit_host_t* h = xlimit_find(host, 0);
+    if (!h || h->concurrency <= 0) return 0;
+    return h->concurrency < 1.0 ? 1 : (int)h->concurrency;
+}
+
+void xlimit_throttle(const char* host, long retry_after_ms) {
+    xlimit_host_t* h = xlimit_find(host, 1);
+    if (!h) return;
+
+    double now = xlimit_now_ms();
+    h->throttled++;
+
+    // 乘性减：同一批（间隔很短的）节流响应只算一次
+    if (now - h->last_decrease >= XLIMIT_DECREASE_GAP_MS) {
+        h->last_decrease = now;
+        if (h->concurrency > 0) {
+            h->concurrency /= 2.0;
+            if (h->concurrency < 1.0) h->concurrency = 1.0;
+        }
+        if (h->rate > 0) {
+            xlimit_refill(h, now);
+            h->rate /= 2.0;
+            if (h->rate < h->cfg.rate / XLIMIT_MIN_RATE_DIV) h->rate = h->cfg.rate / XLIMIT_MIN_RATE_DIV;
+        }
+    }
+
+    if (retry_after_ms < 0 && h->rate == 0) retry_after_ms = XLIMIT_BACKOFF_MS;
+    if (retry_after_ms > XLIMIT_MAX_BLOCK_MS) retry_after_ms = XLIMIT_MAX_BLOCK_MS;
+    if (retry_after_ms > 0 && now + retry_after_ms > h->blocked_until) {
+        h->blocked_until = now + retry_after_ms;
+    }
+}
+
+void xlimit_observe(const char* host, int status, long retry_after_ms) {
+    if (status == 429 || status >= 500) {
+        xlimit_throttle(host, retry_after_ms);
+        return;
+    }
+
+    // 加性增：并发窗口每个窗口的响应 +1，速率每个响应恢复一小步
+    xlimit_host_t* h = xlimit_find(host, 0);
+    if (!h) return;
+    if (h->cfg.max_concurrency > 0 && h->concurrency < h->cfg.max_concurrency) {
+        h->concurrency += 1.0 / h->concurrency;
+        if (h->concurrency > h->cfg.max_concurrency) h->concurrency = h->cfg.max_concurrency;
+    }
+    if (h->cfg.rate > 0 && h->rate < h->cfg.rate) {
+        xlimit_refill(h, xlimit_now_ms());
+        h->rate += h->cfg.rate / XLIMIT_RATE_STEP_DIV;
+        if (h->rate > h->cfg.rate) h->rate = h->cfg.rate;
+    }
+}
+
+/**
+ * @brief 公历日期 → 自 1970-01-01 起的天数
+ */
+static long xlimit_days_from_civil(long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long)doe - 719468;
+}
+
+long xlimit_retry_after(const char* value, size_t len) {
+    char buf[64];
+    if (!value || len == 0 || len >= sizeof(buf)) return -1;
+    memcpy(buf, value, len);
+    buf[len] = '\0';
+
+    // delta-seconds
+    size_t i = 0;
+    long secs = 0;
+    while (isdigit((unsigned char)buf[i])) {
+        if (secs < XLIMIT_MAX_BLOCK_MS / 1000) secs = secs * 10 + (buf[i] - '0');
+        i++;
+    }
+    if (i > 0 && buf[i] == '\0') return secs * 1000;
+
+    // HTTP-date（IMF-fixdate）："Sun, 06 Nov 1994 08:49:37 GMT"
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char mon[4];
+    int day, year, hh, mm, ss;
+    if (sscanf(buf, "%*3s, %d %3s %d %d:%d:%d", &day, mon, &year, &hh, &mm, &ss) != 6) return -1;
+    const char* p = strstr(months, mon);
+    if (!p || strlen(mon) != 3 || (p - months) % 3 != 0) return -1;
+
+    unsigned month = (unsigned)((p - months) / 3 + 1);
+    long long at = (long long)xlimit_days_from_civil(year, month, (unsigned)day) * 86400 + hh * 3600 + mm * 60 + ss;
+    long long delta = at - (long long)time(NULL);
+    if (delta <= 0) return 0;
+    return delta > XLIMIT_MAX_BLOCK_MS / 1000 ? XLIMIT_MAX_BLOCK_MS : (long)(delta * 1000);
+}
+
+int xlimit_stats(size_t index, xlimit_stats_t* stats) {
+    if (!stats || index >= (size_t)xlimit_size) return -1;
+
+    xlimit_host_t* h = &xlimit_hosts[index];
+    double now = xlimit_now_ms();
+    xlimit_refill(h, now);
+
+    memset(stats, 0, sizeof(*stats));
+    strcpy(stats->host, h->host);
+    stats->rate = h->rate;
+    stats->tokens = h->tokens;
+    stats->concurrency = h->concurrency;
+    stats->requests = h->requests;
+    stats->throttled = h->throttled;
+    stats->rejected = h->rejected;
+    stats->waited_ms = h->waited_ms;
+    stats->blocked_ms = h->blocked_until > now ? h->blocked_until - now : 0.0;
+    return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef XLIMIT_H
+#define XLIMIT_H
+
+#include <stddef.h>
+
+#define XLIMIT_MAX_HOSTS  32        // 同时跟踪的主机数（满了之后按 FIFO 覆盖未单独配置的主机）
+
+/**
+ * @brief 按主机的客户端限流参数
+ * @note 令牌桶控制请求速率；AIMD 控制并发窗口（流水线深度 / HTTP/2 并发流）。
+ *       收到节流信号（429、5xx、应用层信号如 Bing 205）时速率和并发窗口减半并遵守 Retry-After，
+ *       之后每个成功响应线性恢复，直到配置值
+ */
+typedef struct {
+    double rate;            // 每秒请求数上限，0 表示不限速
+    double burst;           // 令牌桶容量（允许的突发请求数，不足 1 按 1）
+    int max_concurrency;    // 并发窗口上限，0 表示不限（仍受 pipeline_depth 约束）
+    int max_wait_ms;        // 单个请求最多等待多久，超出则拒绝（0 使用默认 30000）
+} xlimit_cfg_t;
+
+/**
+ * @brief 主机限流状态快照（用于观察/调试输出）
+ */
+typedef struct {
+    char host[256];
+    double rate;            // 当前速率（AIMD 调整后），0 表示不限速
+    double tokens;          // 桶内剩余令牌
+    double concurrency;     // 当前并发窗口，0 表示不限
+    unsigned requests;      // 已放行的请求数
+    unsigned throttled;     // 收到的节流信号数
+    unsigned rejected;      // 因等待超过 max_wait_ms 被拒绝的请求数
+    double waited_ms;       // 累计等待时间
+    double blocked_ms;      // Retry-After 剩余封锁时间，0 表示未封锁
+} xlimit_stats_t;
+
+/**
+ * @brief 设置主机的限流参数
+ * @param host 主机名（大小写不敏感）；NULL 设置默认值（作用于所有未单独配置的主机）
+ * @return 0 成功，-1 参数非法或表已满
+ */
+int xlimit_set(const char* host, const xlimit_cfg_t* cfg);
+
+/**
+ * @brief 请求前获取一个令牌：必要时睡眠等待令牌补充或 Retry-After 到期
+ * @param verbose 非 0 时打印等待信息
+ * @return 0 放行，-1 需要等待的时间超过 max_wait_ms（未消耗令牌）
+ */
+int xlimit_acquire(const char* host, int verbose);
+
+/**
+ * @brief 当前并发窗口（向下取整，至少 1）
+ * @return 窗口大小，0 表示不限
+ */
+int xlimit_concurrency(const char* host);
+
+/**
+ * @brief 按 HTTP 状态码反馈：429/5xx 视为节流信号，其余视为成功
+ * @param retry_after_ms Retry-After 换算的毫秒数，-1 表示没有
+ */
+void xlimit_observe(const char* host, int status, long retry_after_ms);
+
+/**
+ * @brief 应用层节流信号（HTTP 200 但响应内容表示被限流，如 Bing statusCode 205）
+ */
+void xlimit_throttle(const char* host, long retry_after_ms);
+
+/**
+ * @brief 解析 Retry-After 头的值（秒数或 HTTP 日期）
+ * @return 毫秒数（过去的日期为 0），无法解析返回 -1
+ */
+long xlimit_retry_after(const char* value, size_t len);
+
+/**
+ * @brief 按下标读取主机状态快照
+ * @return 0 成功，-1 下标越界
+ */
+int xlimit_stats(size_t index, xlimit_stats_t* stats);
+
+/**
+ * @brief 单调时钟（毫秒）
+ */
+double xlimit_now_ms(void);
+
+/**
+ * @brief 睡眠指定毫秒数（被信号打断时睡完剩余时间）
+ */
+void xlimit_sleep_ms(double ms);
+
+#endif // XLIMIT_H
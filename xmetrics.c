@@ -0,0 +1,337 @@
+#include "xmetrics.h"
+#include <stdio.h>
+#include <string.h>
+
+// 原子操作：MSVC（build.bat 以 /TC 编译，没有 <stdatomic.h>）用 Interlocked 系列，其他编译器用 C11 原子
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <windows.h>
+typedef volatile LONG64 xm_u64;
+typedef volatile LONG xm_int;
+#define xm_u64_add(p, n)        InterlockedExchangeAdd64((p), (LONG64)(n))
+#define xm_u64_load(p)          ((uint64_t)InterlockedCompareExchange64((p), 0, 0))
+#define xm_u64_cas(p, old, v)   (InterlockedCompareExchange64((p), (LONG64)(v), (LONG64)(old)) == (LONG64)(old))
+#define xm_int_load(p)          InterlockedCompareExchange((p), 0, 0)
+#define xm_int_cas(p, old, v)   (InterlockedCompareExchange((p), (v), (old)) == (old))
+#define xm_int_store(p, v)      InterlockedExchange((p), (v))
+#else
+#include <stdatomic.h>
+typedef _Atomic uint64_t xm_u64;
+typedef atomic_int xm_int;
+#define xm_u64_add(p, n)        atomic_fetch_add_explicit((p), (uint64_t)(n), memory_order_relaxed)
+#define xm_u64_load(p)          atomic_load_explicit((p), memory_order_relaxed)
+static int xm_u64_cas(xm_u64* p, uint64_t old, uint64_t v) {
+    return atomic_compare_exchange_weak_explicit(p, &old, v, memory_order_relaxed, memory_order_relaxed);
+}
+#define xm_int_load(p)          atomic_load_explicit((p), memory_order_acquire)
+static int xm_int_cas(xm_int* p, int old, int v) {
+    return atomic_compare_exchange_strong_explicit(p, &old, v, memory_order_acq_rel, memory_order_acquire);
+}
+#define xm_int_store(p, v)      atomic_store_explicit((p), (v), memory_order_release)
+#endif
+
+#define XMETRICS_EMPTY    0
+#define XMETRICS_CLAIMED  1     // 某个线程正在写入键
+#define XMETRICS_READY    2
+
+#define XMETRICS_SUB_BITS 3                         // 每个 2 的幂区间分 2^3 = 8 个子桶
+#define XMETRICS_SUB      (1 << XMETRICS_SUB_BITS)
+#define XMETRICS_MAX_EXP  40                        // 最大 2^41 µs（约 25 天），更大的值计入最后一个桶
+#define XMETRICS_BUCKETS  ((XMETRICS_MAX_EXP - XMETRICS_SUB_BITS + 2) * XMETRICS_SUB)
+
+// Prometheus 导出的 le 边界：2^7 µs（0.128 ms）到 2^26 µs（约 67 s），恰好落在桶边界上
+#define XMETRICS_LE_MIN_EXP 7
+#define XMETRICS_LE_MAX_EXP 26
+
+/**
+ * @brief 序列槽：按注册顺序依次占用，键写入后不再改变
+ */
+typedef struct {
+    xm_int state;
+    size_t name_len;                // key 中指标名的长度
+    const char* help;
+    char key[XMETRICS_KEY_LEN];     // "name{labels}" 或 "name"
+} xmetrics_slot_t;
+
+struct xmetrics_counter_s {
+    xmetrics_slot_t slot;
+    xm_u64 value;
+};
+
+struct xmetrics_histogram_s {
+    xmetrics_slot_t slot;
+    xm_u64 sum_us;
+    xm_u64 max_us;
+    xm_u64 buckets[XMETRICS_BUCKETS];
+};
+
+static xmetrics_counter_t xmetrics_counters[XMETRICS_MAX_COUNTERS];
+static xmetrics_histogram_t xmetrics_histograms[XMETRICS_MAX_HISTOGRAMS];
+
+#define XMETRICS_COUNTER_SLOT(i)   (&xmetrics_counters[i].slot)
+#define XMETRICS_HISTOGRAM_SLOT(i) (&xmetrics_histograms[i].slot)
+
+/**
+ * @brief 在槽数组中查找或占用 key 对应的槽
+ * @note 所有线程按同一顺序扫描，同一个键只会落在第一个空槽：抢占失败的线程等对方写完键再比较，
+ *       因此同键不会重复注册。后面的槽只有在前面的槽就绪之后才会被占用
+ */
+static xmetrics_slot_t* xmetrics_claim(void* base, size_t stride, size_t max,
+                                       const char* name, const char* help, const char* labels) {
+    char key[XMETRICS_KEY_LEN];
+    int len = labels && labels[0] ? snprintf(key, sizeof(key), "%s{%s}", name, labels)
+                                  : snprintf(key, sizeof(key), "%s", name);
+    if (len < 0 || (size_t)len >= sizeof(key)) return NULL;
+
+    for (size_t i = 0; i < max; i++) {
+        xmetrics_slot_t* s = (xmetrics_slot_t*)((char*)base + i * stride);
+        int st = xm_int_load(&s->state);
+        if (st == XMETRICS_EMPTY) {
+            if (xm_int_cas(&s->state, XMETRICS_EMPTY, XMETRICS_CLAIMED)) {
+                memcpy(s->key, key, (size_t)len + 1);
+                s->name_len = strlen(name);
+                s->help = help;
+                xm_int_store(&s->state, XMETRICS_READY);
+                return s;
+            }
+            st = xm_int_load(&s->state);
+        }
+        while (st != XMETRICS_READY) st = xm_int_load(&s->state);  // 对方只剩拷贝键，等待极短
+        if (strcmp(s->key, key) == 0) return s;
+    }
+    return NULL;
+}
+
+xmetrics_counter_t* xmetrics_counter(const char* name, const char* help, const char* labels) {
+    if (!name) return NULL;
+    return (xmetrics_counter_t*)xmetrics_claim(xmetrics_counters, sizeof(xmetrics_counters[0]),
+                                               XMETRICS_MAX_COUNTERS, name, help, labels);
+}
+
+void xmetrics_add(xmetrics_counter_t* counter, uint64_t n) {
+    if (counter) xm_u64_add(&counter->value, n);
+}
+
+xmetrics_histogram_t* xmetrics_histogram(const char* name, const char* help, const char* labels) {
+    if (!name) return NULL;
+    return (xmetrics_histogram_t*)xmetrics_claim(xmetrics_histograms, sizeof(xmetrics_histograms[0]),
+                                                 XMETRICS_MAX_HISTOGRAMS, name, help, labels);
+}
+
+static int xmetrics_log2(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int k = 0;
+    while (v >>= 1) k++;
+    return k;
+#endif
+}
+
+/**
+ * @brief 微秒值 → 桶下标（小于 16 µs 时每微秒一个桶，之后每个 2 的幂区间 8 个桶）
+ */
+static size_t xmetrics_bucket(uint64_t us) {
+    if (us < XMETRICS_SUB) return (size_t)us;
+    int k = xmetrics_log2(us);
+    size_t idx = (size_t)(k - XMETRICS_SUB_BITS + 1) * XMETRICS_SUB +
+                 (size_t)((us >> (k - XMETRICS_SUB_BITS)) & (XMETRICS_SUB - 1));
+    return idx < XMETRICS_BUCKETS ? idx : XMETRICS_BUCKETS - 1;
+}
+
+/**
+ * @brief 桶的中点（微秒）
+ */
+static double xmetrics_bucket_mid(size_t idx) {
+    if (idx < XMETRICS_SUB) return (double)idx + 0.5;
+    size_t group = idx / XMETRICS_SUB;
+    double width = (double)((uint64_t)1 << (group - 1));
+    return (double)(XMETRICS_SUB + idx % XMETRICS_SUB) * width + width / 2.0;
+}
+
+void xmetrics_observe_ms(xmetrics_histogram_t* histogram, double ms) {
+    if (!histogram) return;
+    uint64_t us = ms > 0 ? (uint64_t)(ms * 1000.0 + 0.5) : 0;
+    xm_u64_add(&histogram->buckets[xmetrics_bucket(us)], 1);
+    xm_u64_add(&histogram->sum_us, us);
+
+    uint64_t cur = xm_u64_load(&histogram->max_us);
+    while (us > cur && !xm_u64_cas(&histogram->max_us, cur, us)) {
+        cur = xm_u64_load(&histogram->max_us);
+    }
+}
+
+/**
+ * @brief 拆出序列的指标名和标签（不含花括号）
+ */
+static void xmetrics_split(const xmetrics_slot_t* s, char* name, char* labels) {
+    memcpy(name, s->key, s->name_len);
+    name[s->name_len] = '\0';
+    labels[0] = '\0';
+    if (s->key[s->name_len] == '{') {
+        size_t len = strlen(s->key) - s->name_len - 2;
+        memcpy(labels, s->key + s->name_len + 1, len);
+        labels[len] = '\0';
+    }
+}
+
+int xmetrics_counter_stats(size_t index, xmetrics_counter_stats_t* stats) {
+    if (!stats || index >= XMETRICS_MAX_COUNTERS) return -1;
+    xmetrics_counter_t* c = &xmetrics_counters[index];
+    if (xm_int_load(&c->slot.state) != XMETRICS_READY) return -1;
+
+    xmetrics_split(&c->slot, stats->name, stats->labels);
+    stats->value = xm_u64_load(&c->value);
+    return 0;
+}
+
+/**
+ * @brief 读取各桶计数（并发更新时各桶之间不保证同一时刻，总数以各桶之和为准）
+ */
+static uint64_t xmetrics_snapshot(xmetrics_histogram_t* h, uint64_t* buckets) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < XMETRICS_BUCKETS; i++) {
+        buckets[i] = xm_u64_load(&h->buckets[i]);
+        total += buckets[i];
+    }
+    return total;
+}
+
+static double xmetrics_quantile(const uint64_t* buckets, uint64_t total, double q) {
+    if (total == 0) return 0.0;
+    uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < XMETRICS_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) return xmetrics_bucket_mid(i) / 1000.0;
+    }
+    return xmetrics_bucket_mid(XMETRICS_BUCKETS - 1) / 1000.0;
+}
+
+int xmetrics_histogram_stats(size_t index, xmetrics_histogram_stats_t* stats) {
+    if (!stats || index >= XMETRICS_MAX_HISTOGRAMS) return -1;
+    xmetrics_histogram_t* h = &xmetrics_histograms[index];
+    if (xm_int_load(&h->slot.state) != XMETRICS_READY) return -1;
+
+    uint64_t buckets[XMETRICS_BUCKETS];
+    xmetrics_split(&h->slot, stats->name, stats->labels);
+    stats->count = xmetrics_snapshot(h, buckets);
+    stats->sum_ms = (double)xm_u64_load(&h->sum_us) / 1000.0;
+    stats->max_ms = (double)xm_u64_load(&h->max_us) / 1000.0;
+    stats->p50_ms = xmetrics_quantile(buckets, stats->count, 0.50);
+    stats->p90_ms = xmetrics_quantile(buckets, stats->count, 0.90);
+    stats->p99_ms = xmetrics_quantile(buckets, stats->count, 0.99);
+
+    // 桶中点可能超过实际最大值
+    if (stats->p50_ms > stats->max_ms) stats->p50_ms = stats->max_ms;
+    if (stats->p90_ms > stats->max_ms) stats->p90_ms = stats->max_ms;
+    if (stats->p99_ms > stats->max_ms) stats->p99_ms = stats->max_ms;
+    return 0;
+}
+
+uint64_t xmetrics_total(const char* name, const char* label_match) {
+    uint64_t total = 0;
+    size_t name_len = name ? strlen(name) : 0;
+    for (size_t i = 0; i < XMETRICS_MAX_COUNTERS; i++) {
+        xmetrics_counter_t* c = &xmetrics_counters[i];
+        if (xm_int_load(&c->slot.state) != XMETRICS_READY) break;
+        if (c->slot.name_len != name_len || strncmp(c->slot.key, name, name_len) != 0) continue;
+        if (label_match && !strstr(c->slot.key + name_len, label_match)) continue;
+        total += xm_u64_load(&c->value);
+    }
+    return total;
+}
+
+/**
+ * @brief 同名序列是否已在前面出现过（HELP/TYPE 每个指标名只输出一次）
+ */
+static int xmetrics_seen(void* base, size_t stride, size_t index) {
+    const xmetrics_slot_t* s = (const xmetrics_slot_t*)((char*)base + index * stride);
+    for (size_t j = 0; j < index; j++) {
+        const xmetrics_slot_t* p = (const xmetrics_slot_t*)((char*)base + j * stride);
+        if (p->name_len == s->name_len && memcmp(p->key, s->key, s->name_len) == 0) return 1;
+    }
+    return 0;
+}
+
+static void xmetrics_write_histogram(FILE* out, xmetrics_histogram_t* h) {
+    char name[XMETRICS_KEY_LEN], labels[XMETRICS_KEY_LEN];
+    uint64_t buckets[XMETRICS_BUCKETS];
+    xmetrics_split(&h->slot, name, labels);
+    uint64_t total = xmetrics_snapshot(h, buckets);
+    const char* sep = labels[0] ? "," : "";
+
+    // 2^k µs 以下的值全部落在下标 (k - 2) * 8 之前的桶里
+    uint64_t cumulative = 0;
+    size_t next = 0;
+    for (int k = XMETRICS_LE_MIN_EXP; k <= XMETRICS_LE_MAX_EXP; k++) {
+        size_t end = (size_t)(k - XMETRICS_SUB_BITS + 1) * XMETRICS_SUB;
+        for (; next < end; next++) cumulative += buckets[next];
+        fprintf(out, "%s_bucket{%s%sle=\"%.6g\"} %llu\n", name, labels, sep,
+                (double)((uint64_t)1 << k) / 1e6, (unsigned long long)cumulative);
+    }
+    fprintf(out, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, (unsigned long long)total);
+    fprintf(out, "%s_sum%s%s%s %.6f\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "",
+            (double)xm_u64_load(&h->sum_us) / 1e6);
+    fprintf(out, "%s_count%s%s%s %llu\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "",
+            (unsigned long long)total);
+}
+
+void xmetrics_write_prometheus(FILE* out) {
+    size_t counters = 0, histograms = 0;
+    while (counters < XMETRICS_MAX_COUNTERS &&
+           xm_int_load(&xmetrics_counters[counters].slot.state) == XMETRICS_READY) counters++;
+    while (histograms < XMETRICS_MAX_HISTOGRAMS &&
+           xm_int_load(&xmetrics_histograms[histograms].slot.state) == XMETRICS_READY) histograms++;
+
+    for (size_t i = 0; i < counters; i++) {
+        const xmetrics_slot_t* s = XMETRICS_COUNTER_SLOT(i);
+        if (xmetrics_seen(xmetrics_counters, sizeof(xmetrics_counters[0]), i)) continue;
+        if (s->help) fprintf(out, "# HELP %.*s %s\n", (int)s->name_len, s->key, s->help);
+        fprintf(out, "# TYPE %.*s counter\n", (int)s->name_len, s->key);
+        for (size_t j = i; j < counters; j++) {
+            const xmetrics_slot_t* t = XMETRICS_COUNTER_SLOT(j);
+            if (t->name_len != s->name_len || memcmp(t->key, s->key, s->name_len) != 0) continue;
+            fprintf(out, "%s %llu\n", t->key, (unsigned long long)xm_u64_load(&xmetrics_counters[j].value));
+        }
+    }
+
+    for (size_t i = 0; i < histograms; i++) {
+        const xmetrics_slot_t* s = XMETRICS_HISTOGRAM_SLOT(i);
+        if (xmetrics_seen(xmetrics_histograms, sizeof(xmetrics_histograms[0]), i)) continue;
+        if (s->help) fprintf(out, "# HELP %.*s %s\n", (int)s->name_len, s->key, s->help);
+        fprintf(out, "# TYPE %.*s histogram\n", (int)s->name_len, s->key);
+        for (size_t j = i; j < histograms; j++) {
+            const xmetrics_slot_t* t = XMETRICS_HISTOGRAM_SLOT(j);
+            if (t->name_len != s->name_len || memcmp(t->key, s->key, s->name_len) != 0) continue;
+            xmetrics_write_histogram(out, &xmetrics_histograms[j]);
+        }
+    }
+}
+
+int xmetrics_save(const char* path) {
+    char tmp[1024];
+    if (!path || !path[0] || snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+
+    FILE* f = fopen(tmp, "w");
+    if (!f) {
+        fprintf(stderr, "xmetrics: cannot write %s\n", tmp);
+        return -1;
+    }
+    xmetrics_write_prometheus(f);
+    if (fclose(f) != 0) {
+        fprintf(stderr, "xmetrics: cannot write %s\n", tmp);
+        remove(tmp);
+        return -1;
+    }
+
+#ifdef _WIN32
+    remove(path);  // Windows 的 rename 不覆盖已存在的文件
+#endif
+    if (rename(tmp, path) != 0) {
+        fprintf(stderr, "xmetrics: cannot replace %s\n", path);
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+#ifndef XMETRICS_H
+#define XMETRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define XMETRICS_MAX_COUNTERS     256   // 计数器序列上限（名字 + 标签组合），满了之后新序列被忽略
+#define XMETRICS_MAX_HISTOGRAMS   48    // 直方图序列上限
+#define XMETRICS_KEY_LEN          320   // 序列键 "name{labels}" 最大长度
+
+/**
+ * @brief 指标注册表（无锁）
+ * @note 序列按 名字 + 标签 注册一次，之后通过句柄原子累加，任何线程都可以并发更新和导出。
+ *       直方图为 HDR 风格的对数分桶：每个 2 的幂区间再分 8 个子桶（相对误差 ≤ 12.5%），
+ *       以微秒计，覆盖 1 µs 到约 25 天。
+ *       标签写成 Prometheus 格式的字符串，如 host="www.bing.com",code="200"（NULL/空字符串表示无标签），
+ *       标签值由调用方保证不含引号和反斜杠
+ */
+typedef struct xmetrics_counter_s xmetrics_counter_t;
+typedef struct xmetrics_histogram_s xmetrics_histogram_t;
+
+/**
+ * @brief 查找或注册计数器
+ * @param name 指标名（Prometheus 命名，计数器以 _total 结尾）
+ * @param help 说明（同名序列第一次注册时记录，需为静态字符串）
+ * @param labels 标签（可为 NULL）
+ * @return 句柄，表满或键过长时返回 NULL（NULL 句柄上的操作为空操作）
+ */
+xmetrics_counter_t* xmetrics_counter(const char* name, const char* help, const char* labels);
+
+/**
+ * @brief 计数器累加
+ */
+void xmetrics_add(xmetrics_counter_t* counter, uint64_t n);
+
+/**
+ * @brief 查找或注册直方图（参数同 xmetrics_counter，指标名按惯例以 _seconds 结尾）
+ */
+xmetrics_histogram_t* xmetrics_histogram(const char* name, const char* help, const char* labels);
+
+/**
+ * @brief 记录一次耗时（毫秒，负值按 0 记）
+ */
+void xmetrics_observe_ms(xmetrics_histogram_t* histogram, double ms);
+
+/**
+ * @brief 计数器快照
+ */
+typedef struct {
+    char name[XMETRICS_KEY_LEN];
+    char labels[XMETRICS_KEY_LEN];
+    uint64_t value;
+} xmetrics_counter_stats_t;
+
+/**
+ * @brief 直方图快照（分位数为所在桶的中点）
+ */
+typedef struct {
+    char name[XMETRICS_KEY_LEN];
+    char labels[XMETRICS_KEY_LEN];
+    uint64_t count;
+    double sum_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+} xmetrics_histogram_stats_t;
+
+/**
+ * @brief 按下标读取计数器快照（注册顺序）
+ * @return 0 成功，-1 下标越界
+ */
+int xmetrics_counter_stats(size_t index, xmetrics_counter_stats_t* stats);
+
+/**
+ * @brief 按下标读取直方图快照（注册顺序）
+ * @return 0 成功，-1 下标越界
+ */
+int xmetrics_histogram_stats(size_t index, xmetrics_histogram_stats_t* stats);
+
+/**
+ * @brief 同名计数器中标签包含 label_match 的序列之和
+ * @param label_match 标签子串，如 result="hit"（NULL 匹配全部）
+ */
+uint64_t xmetrics_total(const char* name, const char* label_match);
+
+/**
+ * @brief 以 Prometheus 文本格式（0.0.4）输出全部序列
+ */
+void xmetrics_write_prometheus(FILE* out);
+
+/**
+ * @brief 把 Prometheus 文本写入文件（先写 path.tmp 再改名，供 node_exporter textfile 等采集器读取）
+ * @return 0 成功，-1 失败
+ */
+int xmetrics_save(const char* path);
+
+#endif // XMETRICS_H
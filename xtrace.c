@@ -0,0 +1,422 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "xtrace.h"
+#include "xlimit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(_MSC_VER)
+#define XTRACE_TLS __declspec(thread)
+#else
+#define XTRACE_TLS _Thread_local
+#endif
+
+/**
+ * @brief 一个完整区间事件（字符串字段指向静态字符串）
+ */
+typedef struct {
+    const char* cat;
+    const char* name;
+    uint64_t ts_us;
+    uint64_t dur_us;
+    char args[XTRACE_ARGS_LEN];
+} xtrace_event_t;
+
+typedef struct xtrace_thread_s xtrace_thread_t;
+
+/**
+ * @brief 线程缓冲块：只由所属线程写入，写满（或追踪结束）后整体交给写出方
+ */
+typedef struct xtrace_block_s {
+    struct xtrace_block_s* next;    // 待写链表
+    xtrace_thread_t* owner;
+    size_t count;
+    xtrace_event_t events[XTRACE_BLOCK_EVENTS];
+} xtrace_block_t;
+
+/**
+ * @brief 线程记录（首次记录时注册，之后一直保留）
+ */
+struct xtrace_thread_s {
+    xtrace_thread_t* next;          // 已注册线程链表
+    unsigned tid;
+    char name[32];
+    xtrace_block_t* block;          // 正在写入的缓冲块（仅本线程访问）
+};
+
+// 原子操作：MSVC 用 Interlocked 系列，其他编译器用 C11 原子（同 xmetrics.c）
+#if defined(_MSC_VER) && !defined(__clang__)
+typedef volatile LONG xt_int;
+typedef void* volatile xt_ptr;
+#define xt_int_load(p)          InterlockedCompareExchange((p), 0, 0)
+#define xt_int_store(p, v)      InterlockedExchange((p), (v))
+#define xt_int_inc(p)           InterlockedIncrement(p)
+#define xt_ptr_load(p)          InterlockedCompareExchangePointer((p), NULL, NULL)
+#define xt_ptr_cas(p, old, v)   (InterlockedCompareExchangePointer((p), (v), (old)) == (old))
+#define xt_ptr_take(p)          InterlockedExchangePointer((p), NULL)
+#else
+#include <stdatomic.h>
+typedef atomic_int xt_int;
+typedef _Atomic(void*) xt_ptr;
+#define xt_int_load(p)          atomic_load_explicit((p), memory_order_acquire)
+#define xt_int_store(p, v)      atomic_store_explicit((p), (v), memory_order_release)
+#define xt_int_inc(p)           (atomic_fetch_add_explicit((p), 1, memory_order_relaxed) + 1)
+#define xt_ptr_load(p)          atomic_load_explicit((p), memory_order_acquire)
+static int xt_ptr_cas(xt_ptr* p, void* old, void* v) {
+    return atomic_compare_exchange_weak_explicit(p, &old, v, memory_order_release, memory_order_relaxed);
+}
+#define xt_ptr_take(p)          atomic_exchange_explicit((p), NULL, memory_order_acquire)
+#endif
+
+static xt_int xtrace_on;            // 1 = 正在追踪
+static xt_int xtrace_stop;          // 通知后台线程退出
+static xt_int xtrace_tids;          // 已分配的线程号
+static xt_ptr xtrace_pending;       // 待写缓冲块（后进先出，写出时反转）
+static xt_ptr xtrace_threads;       // 已注册线程
+static XTRACE_TLS xtrace_thread_t* xtrace_self_thread;
+
+// 以下只由后台线程和 xtrace_open/xtrace_close 访问
+static FILE* xtrace_out = NULL;
+static uint64_t xtrace_base_us = 0;
+static int xtrace_events = 0;       // 已写出的事件数（决定是否需要逗号）
+
+#ifdef _WIN32
+static HANDLE xtrace_writer;
+#else
+static pthread_t xtrace_writer;
+#endif
+
+/**
+ * @brief 单调时钟（微秒）
+ * @note Windows 上 GetTickCount64 只有 15 ms 左右的精度，不够区分握手和请求，这里用性能计数器
+ */
+static uint64_t xtrace_clock_us(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000u +
+           (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000u / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+/**
+ * @brief 把缓冲块挂到待写链表（无锁压栈）
+ */
+static void xtrace_submit(xtrace_block_t* block) {
+    void* head;
+    do {
+        head = xt_ptr_load(&xtrace_pending);
+        block->next = (xtrace_block_t*)head;
+    } while (!xt_ptr_cas(&xtrace_pending, head, block));
+}
+
+/**
+ * @brief 当前线程的记录，首次调用时注册
+ */
+static xtrace_thread_t* xtrace_self(void) {
+    xtrace_thread_t* t = xtrace_self_thread;
+    if (t) return t;
+
+    t = (xtrace_thread_t*)calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->tid = (unsigned)xt_int_inc(&xtrace_tids);
+    snprintf(t->name, sizeof(t->name), "thread %u", t->tid);
+    void* head;
+    do {
+        head = xt_ptr_load(&xtrace_threads);
+        t->next = (xtrace_thread_t*)head;
+    } while (!xt_ptr_cas(&xtrace_threads, head, t));
+    xtrace_self_thread = t;
+    return t;
+}
+
+int xtrace_enabled(void) {
+    return xt_int_load(&xtrace_on);
+}
+
+uint64_t xtrace_begin(void) {
+    return xt_int_load(&xtrace_on) ? xtrace_clock_us() : 0;
+}
+
+/**
+ * @brief 追加到 args，放不下时返回 -1（不写入）
+ */
+static int xtrace_put(char* out, size_t cap, size_t* len, const char* data, size_t n) {
+    if (n >= cap - *len) return -1;
+    memcpy(out + *len, data, n);
+    *len += n;
+    return 0;
+}
+
+/**
+ * @brief 按 JSON 字符串规则转义追加（引号、反斜杠和控制字符），最多取 max 字节
+ */
+static int xtrace_put_escaped(char* out, size_t cap, size_t* len, const char* s, size_t max) {
+    for (const char* end = s + (s ? strnlen(s, max) : 0); s && s < end; s++) {
+        unsigned char c = (unsigned char)*s;
+        char esc[8];
+        size_t n;
+        if (c == '"' || c == '\\') {
+            esc[0] = '\\';
+            esc[1] = (char)c;
+            n = 2;
+        } else if (c == '\n') {
+            memcpy(esc, "\\n", 2);
+            n = 2;
+        } else if (c == '\r') {
+            memcpy(esc, "\\r", 2);
+            n = 2;
+        } else if (c == '\t') {
+            memcpy(esc, "\\t", 2);
+            n = 2;
+        } else if (c < 0x20) {
+            n = (size_t)snprintf(esc, sizeof(esc), "\\u%04x", c);
+        } else {
+            esc[0] = (char)c;
+            n = 1;
+        }
+        if (xtrace_put(out, cap, len, esc, n) != 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 格式化 args：%s 的值按 JSON 转义，其余转换交给 snprintf
+ * @note 放不下时退回到格式串中最后一个字段分隔逗号之前，只保留完整的字段
+ */
+static void xtrace_format_args(char* out, size_t cap, const char* fmt, va_list ap) {
+    size_t len = 0;
+    size_t field_end = 0;   // 最后一个完整字段的结尾
+    int in_str = 0;         // 是否在格式串的引号内（值里的引号已转义，不影响）
+
+    for (const char* p = fmt; *p; p++) {
+        int ok = -1;
+        if (*p != '%' || p[1] == '%') {
+            if (*p == '%') p++;
+            if (*p == '"') in_str = !in_str;
+            if (*p == ',' && !in_str) field_end = len;
+            ok = xtrace_put(out, cap, &len, p, 1);
+        } else {
+            // 转换说明：标志/宽度/精度/长度修饰符原样交给 snprintf
+            char spec[16];
+            size_t n = 0;
+            spec[n++] = *p++;
+            while (*p && strchr("-+ #0123456789.", *p) && n < sizeof(spec) - 4) spec[n++] = *p++;
+            int lng = 0, size = 0;
+            while (*p && strchr("hlzj", *p) && n < sizeof(spec) - 2) {
+                if (*p == 'l') lng++;
+                if (*p == 'z' || *p == 'j') size = *p;
+                spec[n++] = *p++;
+            }
+            if (!*p) {
+                len = field_end;
+                break;
+            }
+            spec[n++] = *p;
+            spec[n] = '\0';
+
+            char num[64];
+            int w = -1;
+            switch (*p) {
+            case 's': {
+                const char* dot = strchr(spec, '.');
+                size_t max = dot ? (size_t)strtoul(dot + 1, NULL, 10) : (size_t)-1;
+                ok = xtrace_put_escaped(out, cap, &len, va_arg(ap, const char*), max);
+                break;
+            }
+            case 'd': case 'i': case 'c':
+                if (size == 'z') w = snprintf(num, sizeof(num), spec, va_arg(ap, size_t));
+                else if (size == 'j') w = snprintf(num, sizeof(num), spec, va_arg(ap, intmax_t));
+                else if (lng >= 2) w = snprintf(num, sizeof(num), spec, va_arg(ap, long long));
+                else if (lng == 1) w = snprintf(num, sizeof(num), spec, va_arg(ap, long));
+                else w = snprintf(num, sizeof(num), spec, va_arg(ap, int));
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                if (size == 'z') w = snprintf(num, sizeof(num), spec, va_arg(ap, size_t));
+                else if (size == 'j') w = snprintf(num, sizeof(num), spec, va_arg(ap, uintmax_t));
+                else if (lng >= 2) w = snprintf(num, sizeof(num), spec, va_arg(ap, unsigned long long));
+                else if (lng == 1) w = snprintf(num, sizeof(num), spec, va_arg(ap, unsigned long));
+                else w = snprintf(num, sizeof(num), spec, va_arg(ap, unsigned));
+                break;
+            case 'f': case 'e': case 'g': case 'F': case 'E': case 'G':
+                w = snprintf(num, sizeof(num), spec, va_arg(ap, double));
+                break;
+            default:
+                break;  // 不支持的转换：参数类型未知，不能再继续取参数（按放不下处理）
+            }
+            if (*p != 's' && w >= 0 && (size_t)w < sizeof(num)) {
+                ok = xtrace_put(out, cap, &len, num, (size_t)w);
+            }
+        }
+        if (ok != 0) {
+            len = field_end;
+            break;
+        }
+    }
+    out[len] = '\0';
+}
+
+void xtrace_end(uint64_t start, const char* cat, const char* name, const char* args_fmt, ...) {
+    if (start == 0 || !xt_int_load(&xtrace_on)) return;
+    uint64_t end = xtrace_clock_us();
+
+    xtrace_thread_t* t = xtrace_self();
+    if (!t) return;
+    xtrace_block_t* block = t->block;
+    if (!block || block->count == XTRACE_BLOCK_EVENTS) {
+        if (block) xtrace_submit(block);
+        block = (xtrace_block_t*)malloc(sizeof(*block));
+        t->block = block;
+        if (!block) return;
+        block->owner = t;
+        block->count = 0;
+    }
+
+    xtrace_event_t* ev = &block->events[block->count++];
+    ev->cat = cat;
+    ev->name = name;
+    ev->ts_us = start;
+    ev->dur_us = end > start ? end - start : 0;
+    ev->args[0] = '\0';
+    if (args_fmt) {
+        va_list ap;
+        va_start(ap, args_fmt);
+        xtrace_format_args(ev->args, sizeof(ev->args), args_fmt, ap);
+        va_end(ap);
+    }
+}
+
+void xtrace_thread_name(const char* name) {
+    if (!name || !xt_int_load(&xtrace_on)) return;
+    xtrace_thread_t* t = xtrace_self();
+    if (!t) return;
+    snprintf(t->name, sizeof(t->name), "%s", name);
+}
+
+/**
+ * @brief 写出一个缓冲块的全部事件
+ */
+static void xtrace_write_block(const xtrace_block_t* block) {
+    for (size_t i = 0; i < block->count; i++) {
+        const xtrace_event_t* ev = &block->events[i];
+        uint64_t ts = ev->ts_us > xtrace_base_us ? ev->ts_us - xtrace_base_us : 0;
+        fprintf(xtrace_out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,"
+                "\"pid\":1,\"tid\":%u,\"args\":{%s}}",
+                xtrace_events++ ? ",\n" : "", ev->name, ev->cat, (unsigned long long)ts,
+                (unsigned long long)ev->dur_us, block->owner->tid, ev->args);
+    }
+}
+
+/**
+ * @brief 取出并写出所有待写缓冲块（按提交顺序）
+ */
+static void xtrace_drain(void) {
+    xtrace_block_t* list = (xtrace_block_t*)xt_ptr_take(&xtrace_pending);
+    xtrace_block_t* ordered = NULL;
+    while (list) {
+        xtrace_block_t* next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    if (!ordered) return;
+
+    while (ordered) {
+        xtrace_block_t* next = ordered->next;
+        xtrace_write_block(ordered);
+        free(ordered);
+        ordered = next;
+    }
+    fflush(xtrace_out);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI xtrace_writer_main(LPVOID arg) {
+#else
+static void* xtrace_writer_main(void* arg) {
+#endif
+    (void)arg;
+    while (!xt_int_load(&xtrace_stop)) {
+        xlimit_sleep_ms(XTRACE_FLUSH_MS);
+        xtrace_drain();
+    }
+    return 0;
+}
+
+int xtrace_open(const char* path) {
+    if (!path || xt_int_load(&xtrace_on)) return -1;
+
+    xtrace_out = fopen(path, "wb");
+    if (!xtrace_out) {
+        fprintf(stderr, "xtrace: cannot write %s\n", path);
+        return -1;
+    }
+    fputs("{\"traceEvents\":[\n", xtrace_out);
+    xtrace_events = 0;
+    xtrace_base_us = xtrace_clock_us();
+    xt_int_store(&xtrace_stop, 0);
+
+#ifdef _WIN32
+    xtrace_writer = CreateThread(NULL, 0, xtrace_writer_main, NULL, 0, NULL);
+    int started = xtrace_writer != NULL;
+#else
+    int started = pthread_create(&xtrace_writer, NULL, xtrace_writer_main, NULL) == 0;
+#endif
+    if (!started) {
+        fprintf(stderr, "xtrace: cannot start writer thread\n");
+        fclose(xtrace_out);
+        xtrace_out = NULL;
+        return -1;
+    }
+    xt_int_store(&xtrace_on, 1);
+    return 0;
+}
+
+void xtrace_close(void) {
+    if (!xt_int_load(&xtrace_on)) return;
+    xt_int_store(&xtrace_on, 0);
+
+    xt_int_store(&xtrace_stop, 1);
+#ifdef _WIN32
+    WaitForSingleObject(xtrace_writer, INFINITE);
+    CloseHandle(xtrace_writer);
+#else
+    pthread_join(xtrace_writer, NULL);
+#endif
+
+    // 已满的块先写，再写各线程未写满的块；最后是线程名元数据
+    xtrace_drain();
+    for (xtrace_thread_t* t = (xtrace_thread_t*)xt_ptr_load(&xtrace_threads); t; t = t->next) {
+        if (!t->block) continue;
+        xtrace_write_block(t->block);
+        free(t->block);
+        t->block = NULL;
+    }
+    fprintf(xtrace_out, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"xtrans\"}}",
+            xtrace_events++ ? ",\n" : "");
+    for (xtrace_thread_t* t = (xtrace_thread_t*)xt_ptr_load(&xtrace_threads); t; t = t->next) {
+        fprintf(xtrace_out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                t->tid, t->name);
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", xtrace_out);
+    fclose(xtrace_out);
+    xtrace_out = NULL;
+}
@@ -0,0 +1,55 @@
+#ifndef XTRACE_H
+#define XTRACE_H
+
+#include <stdint.h>
+
+#define XTRACE_BLOCK_EVENTS   512   // 每个线程缓冲块容纳的事件数，写满后交给后台线程
+#define XTRACE_ARGS_LEN       192   // 单个事件 args 的最大长度（JSON 对象内部），放不下的字段丢弃
+#define XTRACE_FLUSH_MS       50    // 后台线程写出已满缓冲块的间隔
+
+/**
+ * @brief 结构化追踪（Chrome trace-event JSON，可在 chrome://tracing 或 Perfetto 中打开）
+ * @note 每个线程把事件写入自己的缓冲块，写满后无锁地挂到待写链表上，由后台线程定期写出，
+ *       记录路径上没有锁和文件 I/O。未开启时 xtrace_begin 只读一个原子标志并返回 0。
+ *       事件为 "X"（完整区间）类型，时间戳以 xtrace_open 为零点，单位微秒；
+ *       tid 是按线程首次记录顺序分配的小整数。
+ */
+
+/**
+ * @brief 开始追踪，事件写入 path（覆盖已有文件）并启动后台写出线程
+ * @return 0 成功，-1 失败（文件无法创建或线程无法启动）
+ */
+int xtrace_open(const char* path);
+
+/**
+ * @brief 停止追踪：写出全部线程的剩余事件，补全 JSON 并关闭文件
+ * @note 调用时其他线程不应再记录事件（通常在程序退出前、工作线程结束后调用）
+ */
+void xtrace_close(void);
+
+/**
+ * @brief 是否正在追踪
+ */
+int xtrace_enabled(void);
+
+/**
+ * @brief 区间开始时间（微秒），未开启追踪时返回 0
+ */
+uint64_t xtrace_begin(void);
+
+/**
+ * @brief 结束区间并记录事件（start 为 0 时为空操作）
+ * @param cat 分类，需为静态字符串（如 "http"）
+ * @param name 事件名，需为静态字符串（如 "tls_handshake"）
+ * @param args_fmt args 对象内部的 printf 格式，如 "\"host\":\"%s\",\"conn\":%u"（可为 NULL）；
+ *        支持 %s 和整数/浮点转换。%s 的值按 JSON 字符串规则转义，可以直接传用户输入；
+ *        超过 XTRACE_ARGS_LEN 时截到最后一个完整字段（格式串中引号外的逗号为字段分隔）
+ */
+void xtrace_end(uint64_t start, const char* cat, const char* name, const char* args_fmt, ...);
+
+/**
+ * @brief 设置当前线程在追踪视图中显示的名字（需在开启追踪后调用）
+ */
+void xtrace_thread_name(const char* name);
+
+#endif // XTRACE_H
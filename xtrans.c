@@ -4,8 +4,14 @@
 #include <ctype.h>
 #include "xargs.h"
 #include "xhttpc.h"
+#include "xarena.h"
+#include "xjson.h"
 #include "xtrans_bing.h"
 #include "xtrans_google.h"
+#include "xtrans_engine.h"
+#include "xlimit.h"
+#include "xmetrics.h"
+#include "xtrace.h"
 
 // Language codes mapping
 typedef struct {
@@ -41,18 +47,18 @@ static const lang_info_t LANGUAGE_NAMES[] = {
     {NULL, NULL}
 };
 
-// MyMemory translation function
-char* translate_mymemory(const char* text, const char* source, const char* target, int verbose, const char* proxy) {
+// MyMemory translation function (result is allocated from the arena)
+char* translate_mymemory(xarena_t* arena, const char* text, const char* source, const char* target, int verbose, const char* proxy) {
     // Convert text to UTF-8
-    char utf8_buf[2048] = { 0 };
-    int utf8_len = httpc_any_to_utf8(text, utf8_buf, sizeof(utf8_buf));
-    if (utf8_len < 0) {
+    char utf8_buf[2048];
+    const char* utf8_text = httpc_as_utf8(text, utf8_buf, sizeof(utf8_buf), NULL);  // zero-copy when already UTF-8
+    if (!utf8_text) {
         fprintf(stderr, "Failed to convert text to UTF-8\n");
         return NULL;
     }
 
     // URL encode text
-    char* encoded_text = httpc_url_encode(utf8_buf);
+    char* encoded_text = httpc_url_encode_arena(utf8_text, arena);
     if (!encoded_text) {
         fprintf(stderr, "Failed to encode text\n");
         return NULL;
@@ -62,7 +68,6 @@ char* translate_mymemory(const char* text, const char* source, const char* targe
     snprintf(url, sizeof(url),
              "/get?q=%s&langpair=%s|%s",
              encoded_text, source, target);
-    free(encoded_text);
 
     // Configure HTTP client
     httpc_config_t config = {
@@ -85,22 +90,33 @@ char* translate_mymemory(const char* text, const char* source, const char* targe
         .extra_headers = "Accept: application/json",
 
         // Proxy configuration
-        .proxy = proxy
+        .proxy = proxy,
+
+        // GET-only endpoint: safe to pipeline batched lookups
+        .pipeline_depth = 4,
+
+        // Client context and temporaries come from the translation arena
+        .arena = arena
     };
 
-    // Initialize client and send request
-    httpc_client_t* client = httpc_client_init(&config);
-    if (!client) {
-        fprintf(stderr, "Failed to initialize HTTP client\n");
-        return NULL;
-    }
+    // Pull responseData.translatedText while the body streams in
+    char buff[1024*10];
+    xjson_t json;
+    xjson_init(&json, "/responseData/translatedText", buff, sizeof(buff));
+    config.on_body = xjson_sink;
+    config.on_body_ctx = &json;
 
     // Receive response
-    char response_buffer[512*1024];
+    const size_t response_size = 512*1024;
+    char* response_buffer = xarena_alloc(arena, response_size);
+    if (!response_buffer) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return NULL;
+    }
     size_t actual_read = 0;
 
-    httpc_err_t err = httpc_client_request(client, response_buffer, sizeof(response_buffer), &actual_read);
-    httpc_client_free(client);
+    // GET: transient failures are retried with backoff on a pooled connection
+    httpc_err_t err = httpc_request_retry(&config, NULL, response_buffer, response_size, &actual_read, NULL);
 
     if (err != HTTPC_SUCCESS) {
         fprintf(stderr, "HTTP request failed with error %d\n", err);
@@ -111,32 +127,22 @@ char* translate_mymemory(const char* text, const char* source, const char* targe
         printf("[DEBUG] HTTP Response Data:\n%s\n", response_buffer);
     }
 
-    // Extract JSON body from HTTP response
-    char* json_start = strstr(response_buffer, "\r\n\r\n");
-    if (!json_start) {
-        fprintf(stderr, "Invalid HTTP response format\n");
-        return NULL;
-    }
-    json_start += 4;
-
-    char buff[1024*10];
-    if (!httpc_extract_pattern(json_start, "\"translatedText\":\"", "\"", buff, sizeof(buff))) {
-        fprintf(stderr, "Failed to extract params_AbusePreventionHelper from response\n");
+    if (json.matches == 0) {
+        fprintf(stderr, "Failed to extract translatedText from response\n");
         return NULL;
     }
 
-    char* result = malloc(strlen(buff) + 1);
+    char* result = xarena_strdup(arena, buff);
     if (!result) {
         fprintf(stderr, "Failed to allocate memory\n");
         return NULL;
     }
-    strcpy(result, buff);
     return result;
 }
 
 // Bing translation function (from xtrans.c)
 // Returns: >0 on success, 0 on failure, -1 on unsupported language pair
-int translate_bing(const char* text, const char* source_lang, const char* target_lang, char* result, size_t result_len, int verbose, const char* proxy) {
+int translate_bing(xarena_t* arena, const char* text, const char* source_lang, const char* target_lang, char* result, size_t result_len, int verbose, const char* proxy) {
     if (!text || !result || result_len == 0) return 0;
 
     if (!source_lang || !target_lang) {
@@ -158,7 +164,7 @@ int translate_bing(const char* text, const char* source_lang, const char* target
     }
 
     // URL encode text
-    char* encoded_text = httpc_url_encode(text);
+    char* encoded_text = httpc_url_encode_arena(text, arena);
     if (!encoded_text) {
         fprintf(stderr, "Failed to encode text\n");
         return 0;
@@ -173,7 +179,6 @@ int translate_bing(const char* text, const char* source_lang, const char* target
         // English to Chinese
         snprintf(url, sizeof(url), "/dict/search?q=%s&mkt=zh-CN&setlang=zh", encoded_text);
     }
-    free(encoded_text);
 
     // Configure HTTP client
     httpc_config_t config = {
@@ -196,22 +201,19 @@ int translate_bing(const char* text, const char* source_lang, const char* target
         .extra_headers = NULL,
 
         // Proxy configuration
-        .proxy = proxy
-    };
+        .proxy = proxy,
 
-    // Initialize client and send request
-    httpc_client_t* client = httpc_client_init(&config);
-    if (!client) {
-        fprintf(stderr, "Failed to initialize HTTP client\n");
-        return 0;
-    }
+        // Negotiate HTTP/2 via ALPN (falls back to HTTP/1.1)
+        .http2 = 1,
 
-    // Receive response
+        .arena = arena
+    };
+
+    // Send request (transient failures are retried with backoff)
     char response_buffer[16384];
     size_t actual_read = 0;
 
-    httpc_err_t err = httpc_client_request(client, response_buffer, sizeof(response_buffer), &actual_read);
-    httpc_client_free(client);
+    httpc_err_t err = httpc_request_retry(&config, NULL, response_buffer, sizeof(response_buffer), &actual_read, NULL);
 
     if (err != HTTPC_SUCCESS) {
         if (verbose) {
@@ -269,91 +271,230 @@ int is_bing_translation_failed(const char* result) {
     return 0;
 }
 
-// Hybrid translation function with engine tracking
-char* translate_hybrid_with_engine(const char* text, const char* source_lang, const char* target_lang, int verbose, const char** engine_used, const char* proxy) {
-    *engine_used = "Bing";  // Default to Bing Long
+// Engine adapters: uniform signature, results allocated from the arena
+
+// Bing dictionary: short zh<->en lookups; rejects placeholder answers so routing falls through
+static char* engine_bing_dict(xarena_t* arena, const char* text, const char* source_lang,
+                              const char* target_lang, int verbose, const char* proxy) {
+    char utf8_buf[512];
+    const char* utf8_text = httpc_as_utf8(text, utf8_buf, sizeof(utf8_buf), NULL);  // zero-copy when already UTF-8
+    char* result = xarena_alloc(arena, 1024);
+    if (!utf8_text || !result) return NULL;
 
-    char utf8_buf[512] = { 0 };
-    int utf8_len = httpc_any_to_utf8(text, utf8_buf, sizeof(utf8_buf));
-    if (utf8_len < 0) {
-        fprintf(stderr, "Encode inpute failed\n");
+    if (translate_bing(arena, utf8_text, source_lang, target_lang, result, 1024, verbose, proxy) <= 0) return NULL;
+    if (is_bing_translation_failed(result)) {
+        if (verbose) printf("[DEBUG] Bing result indicates failed translation: '%s'\n", result);
         return NULL;
     }
+    return result;
+}
 
-    if (verbose) {
-        printf("Trying Bing translation first (text length: %zu)\n", strlen(text));
-    }
+// Bing translator (ttranslatev3)
+static char* engine_bing(xarena_t* arena, const char* text, const char* source_lang,
+                         const char* target_lang, int verbose, const char* proxy) {
+    char* result = xarena_alloc(arena, 1024);
+    if (!result) return NULL;
+    return translate_bing_long(text, source_lang, target_lang, result, 1024, verbose, proxy) > 0 ? result : NULL;
+}
 
-    // Always try Bing first, then evaluate the result
-    char* bing_result = malloc(1024);
-    if (!bing_result) {
-        fprintf(stderr, "Failed to allocate memory for Bing result\n");
-        return NULL;
-    }
+// Google translate (public API returns malloc'd memory)
+static char* engine_google(xarena_t* arena, const char* text, const char* source_lang,
+                           const char* target_lang, int verbose, const char* proxy) {
+    char* owned = translate_google(text, source_lang, target_lang, verbose, proxy);
+    char* result = owned ? xarena_strdup(arena, owned) : NULL;
+    free(owned);
+    return result;
+}
 
-    char* result = NULL;
+// Engine registry. Limits are in UTF-8 bytes of the source text; rates and
+// costs are priors that the router replaces with observed latency/errors.
+static const xtrans_engine_t ENGINES[] = {
+    { "bing-dict", "Bing Dict", engine_bing_dict, "zh*:en en:zh*", 100, 60, 200.0,
+      XTRANS_ENGINE_BATCH | XTRANS_ENGINE_HYBRID },
+    { "bing", "Bing", engine_bing, NULL, 1000, 30, 600.0, XTRANS_ENGINE_HYBRID },
+    { "mymemory", "MyMemory", translate_mymemory, NULL, 500, 20, 800.0,
+      XTRANS_ENGINE_BATCH | XTRANS_ENGINE_HYBRID },
+    // Not routed automatically: googleapis is unreachable on many networks
+    { "google", "Google", engine_google, NULL, 2000, 60, 300.0, XTRANS_ENGINE_BATCH },
+};
 
-    int bing_status = translate_bing(utf8_buf, source_lang, target_lang, bing_result, 1024, verbose, proxy);
-    if (bing_status > 0) {
-        if (verbose) {
-            printf("[DEBUG] Bing request successful, result: '%s'\n", bing_result);
-        }
+// Client-side request budgets per engine host (rate/s, burst, concurrency).
+// Kept under what the services tolerate; --rate overrides them.
+static const struct {
+    const char* host;
+    xlimit_cfg_t cfg;
+} HOST_LIMITS[] = {
+    { "www.bing.com",                { 2.0, 4.0, 4, 0 } },
+    { "cn.bing.com",                 { 2.0, 4.0, 4, 0 } },
+    { "api.mymemory.translated.net", { 1.0, 3.0, 2, 0 } },
+    { "translate.googleapis.com",    { 5.0, 10.0, 8, 0 } },
+};
 
-        // Evaluate Bing result quality
-        if (is_bing_translation_failed(bing_result)) {
-            if (verbose) {
-                printf("[DEBUG] Bing result indicates failed translation, falling back to MyMemory\n");
-            }
-            free(bing_result);
-            char* fallback_result = malloc(1024);
-            if (fallback_result) {
-                if (translate_bing_long(utf8_buf, source_lang, target_lang, fallback_result, 1024, verbose, proxy) > 0) {
-                    *engine_used = "Bing Long";
-                    result = fallback_result;
-                } else {
-                    free(fallback_result);
-                    result = NULL;
-                }
-            }
-        } else {
-            if (verbose) {
-                printf("[DEBUG] Bing translation is valid, using Bing result\n");
-            }
-            *engine_used = "Bing";
-            result = bing_result;
+// --rate HOST=RPS[/BURST[/CONCURRENCY]][,...]; HOST "*" sets the default for other hosts
+static int apply_rate_limits(const char* spec) {
+    for (size_t i = 0; i < sizeof(HOST_LIMITS) / sizeof(HOST_LIMITS[0]); i++) {
+        xlimit_set(HOST_LIMITS[i].host, &HOST_LIMITS[i].cfg);
+    }
+    if (!spec) return 0;
+
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", spec);
+    for (char* item = strtok(buf, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        xlimit_cfg_t cfg = { 0.0, 1.0, 0, 0 };
+        if (!eq || sscanf(eq + 1, "%lf/%lf/%d", &cfg.rate, &cfg.burst, &cfg.max_concurrency) < 1) {
+            fprintf(stderr, "Invalid --rate entry: %s\n", item);
+            return -1;
         }
-    } else if (bing_status == -1) {
-        if (verbose) {
-            printf("[DEBUG] Bing doesn't support %s->%s, using MyMemory\n", source_lang, target_lang);
+        *eq = '\0';
+        if (xlimit_set(strcmp(item, "*") == 0 ? NULL : item, &cfg) != 0) {
+            fprintf(stderr, "Invalid --rate entry: %s\n", item);
+            return -1;
         }
-        free(bing_result);
-        char* fallback_result = malloc(1024);
-        if (fallback_result) {
-            if (translate_bing_long(utf8_buf, source_lang, target_lang, fallback_result, 1024, verbose, proxy) > 0) {
-                *engine_used = "Bing Long";
-                result = fallback_result;
-            } else {
-                free(fallback_result);
-                result = NULL;
-            }
+    }
+    return 0;
+}
+
+static void register_engines(void) {
+    for (size_t i = 0; i < sizeof(ENGINES) / sizeof(ENGINES[0]); i++) {
+        xtrans_engine_register(&ENGINES[i]);
+    }
+}
+
+static void list_engines(void) {
+    printf("  hybrid (default) - Cheapest engine that supports the language pair and text length,\n");
+    printf("                     falling back to the next one on failure\n");
+    for (size_t i = 0; i < xtrans_engine_count(); i++) {
+        const xtrans_engine_t* e = xtrans_engine_at(i);
+        char limit[32] = "any length";
+        if (e->max_bytes) snprintf(limit, sizeof(limit), "<= %zu bytes", e->max_bytes);
+        printf("  %-16s - %s only (%s, %s%s)\n", e->name, e->label, e->pairs ? e->pairs : "any pair", limit,
+               (e->flags & XTRANS_ENGINE_HYBRID) ? "" : ", not used by hybrid");
+    }
+}
+
+// Health of every engine that has been observed (verbose)
+static void print_health(void) {
+    time_t now = time(NULL);
+    for (size_t i = 0; i < xtrans_engine_count(); i++) {
+        const xtrans_engine_t* e = xtrans_engine_at(i);
+        const xtrans_engine_stats_t* st = xtrans_engine_stats(e);
+        if (st->samples == 0 && st->breaker == XTRANS_BREAKER_CLOSED) continue;
+
+        char open_for[32] = "";
+        if (st->breaker == XTRANS_BREAKER_OPEN && st->open_until > now) {
+            snprintf(open_for, sizeof(open_for), " for %llds", (long long)(st->open_until - now));
         }
-    } else {
-        if (verbose) {
-            printf("[DEBUG] Bing request failed, falling back to Bing Long\n");
+        char latency[64] = "";
+        if (st->latency_ms > 0) {
+            snprintf(latency, sizeof(latency), ", p50 %.0f ms, p95 %.0f ms", st->latency_ms, st->p95_ms);
         }
-        free(bing_result);
-        char* fallback_result = malloc(1024);
-        if (fallback_result) {
-            if (translate_bing_long(utf8_buf, source_lang, target_lang, fallback_result, 1024, verbose, proxy) > 0) {
-                *engine_used = "Bing Long";
-                result = fallback_result;
-            } else {
-                free(fallback_result);
-                result = NULL;
-            }
+        printf("[DEBUG] health %s: %s%s, %.0f%% errors over %u requests%s\n",
+               e->label, xtrans_engine_breaker_name(st->breaker), open_for,
+               st->error_rate * 100.0, st->samples, latency);
+    }
+}
+
+// Client-side limiter state of every host contacted (verbose)
+static void print_limits(void) {
+    xlimit_stats_t st;
+    for (size_t i = 0; xlimit_stats(i, &st) == 0; i++) {
+        if (st.requests == 0 && st.rejected == 0) continue;
+
+        char rate[32] = "unlimited";
+        if (st.rate > 0) snprintf(rate, sizeof(rate), "%.2f/s", st.rate);
+        char window[32] = "unlimited";
+        if (st.concurrency > 0) snprintf(window, sizeof(window), "%.1f", st.concurrency);
+        printf("[DEBUG] limit %s: rate %s, tokens %.1f, concurrency %s, %u requests, "
+               "%u throttled, %u rejected, waited %.0f ms",
+               st.host, rate, st.tokens, window, st.requests, st.throttled, st.rejected, st.waited_ms);
+        if (st.blocked_ms > 0) printf(", blocked %.0f ms", st.blocked_ms);
+        printf("\n");
+    }
+}
+
+// Translation attempts and latency per engine adapter
+static void count_translation(const xtrans_engine_t* e, double elapsed_ms, int ok) {
+    char labels[96];
+    snprintf(labels, sizeof(labels), "engine=\"%s\",result=\"%s\"", e->name, ok ? "ok" : "error");
+    xmetrics_add(xmetrics_counter("xtrans_translations_total", "Translation attempts by engine and result",
+                                  labels), 1);
+    snprintf(labels, sizeof(labels), "engine=\"%s\"", e->name);
+    xmetrics_observe_ms(xmetrics_histogram("xtrans_translation_duration_seconds",
+                                           "Translation latency by engine", labels), elapsed_ms);
+}
+
+// Copy the value of KEY="..." out of a Prometheus label string
+static const char* label_value(const char* labels, const char* key, char* out, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "%s=\"", key);
+    const char* p = strstr(labels, pattern);
+    out[0] = '\0';
+    if (!p) return out;
+    p += strlen(pattern);
+    size_t len = strcspn(p, "\"");
+    if (len >= size) len = size - 1;
+    memcpy(out, p, len);
+    out[len] = '\0';
+    return out;
+}
+
+static void format_bytes(uint64_t n, char* out, size_t size) {
+    if (n >= 1024 * 1024) snprintf(out, size, "%.1f MB", n / (1024.0 * 1024.0));
+    else if (n >= 1024) snprintf(out, size, "%.1f KB", n / 1024.0);
+    else snprintf(out, size, "%llu B", (unsigned long long)n);
+}
+
+// End-of-run summary of the metrics registry (--stats)
+static void print_stats(FILE* out) {
+    char value[256], buf[320];
+    xmetrics_histogram_stats_t hs;
+    xmetrics_counter_stats_t cs;
+
+    for (size_t i = 0; xmetrics_histogram_stats(i, &hs) == 0; i++) {
+        if (strcmp(hs.name, "xtrans_translation_duration_seconds") != 0) continue;
+        label_value(hs.labels, "engine", value, sizeof(value));
+        snprintf(buf, sizeof(buf), "engine=\"%s\",result=\"ok\"", value);
+        uint64_t ok = xmetrics_total("xtrans_translations_total", buf);
+        fprintf(out, "[STATS] engine %-10s %llu ok, %llu failed, p50 %.0f ms, p90 %.0f ms, p99 %.0f ms, max %.0f ms\n",
+                value, (unsigned long long)ok, (unsigned long long)(hs.count - ok),
+                hs.p50_ms, hs.p90_ms, hs.p99_ms, hs.max_ms);
+    }
+
+    uint64_t requests = xmetrics_total("xtrans_http_requests_total", NULL);
+    if (requests > 0) {
+        uint64_t reused = xmetrics_total("xtrans_http_requests_total", "conn=\"reused\"");
+        char sent[32], received[32];
+        format_bytes(xmetrics_total("xtrans_http_sent_bytes_total", NULL), sent, sizeof(sent));
+        format_bytes(xmetrics_total("xtrans_http_received_bytes_total", NULL), received, sizeof(received));
+        fprintf(out, "[STATS] http: %llu requests, %.0f%% on reused connections, %s sent, %s received\n",
+                (unsigned long long)requests, 100.0 * reused / requests, sent, received);
+    }
+
+    for (size_t i = 0; xmetrics_histogram_stats(i, &hs) == 0; i++) {
+        if (strcmp(hs.name, "xtrans_http_request_duration_seconds") != 0) continue;
+        fprintf(out, "[STATS] host %s: %llu requests, p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+                label_value(hs.labels, "host", value, sizeof(value)), (unsigned long long)hs.count,
+                hs.p50_ms, hs.p90_ms, hs.p99_ms, hs.max_ms);
+    }
+
+    for (size_t i = 0; xmetrics_counter_stats(i, &cs) == 0; i++) {
+        if (strcmp(cs.name, "xtrans_http_errors_total") == 0 && cs.value > 0) {
+            fprintf(out, "[STATS] error %s: %llu\n", label_value(cs.labels, "error", value, sizeof(value)),
+                    (unsigned long long)cs.value);
         }
     }
-    return result;
+
+    // Hit ratio of every cache that reported a lookup
+    for (size_t i = 0; xmetrics_counter_stats(i, &cs) == 0; i++) {
+        if (strcmp(cs.name, "xtrans_cache_lookups_total") != 0 || !strstr(cs.labels, "result=\"hit\"")) continue;
+        label_value(cs.labels, "cache", value, sizeof(value));
+        snprintf(buf, sizeof(buf), "cache=\"%s\",result=\"miss\"", value);
+        uint64_t total = cs.value + xmetrics_total("xtrans_cache_lookups_total", buf);
+        if (total == 0) continue;
+        fprintf(out, "[STATS] cache %s: %.0f%% hit (%llu/%llu)\n", value, 100.0 * cs.value / total,
+                (unsigned long long)cs.value, (unsigned long long)total);
+    }
 }
 
 // List supported languages
@@ -376,13 +517,19 @@ void print_usage(const char* program_name) {
     printf("  -v, --verbose        Verbose output\n");
     printf("  -h, --help           Show this help message\n");
     printf("  -x, --proxy URL      Proxy server URL (e.g., socks5://127.0.0.1:1080 or http://127.0.0.1:8888)\n");
-    printf("  --no-bing           Disable Bing translation, use MyMemory only\n");
+    printf("  --no-bing            Disable Bing engines in hybrid mode\n");
+    printf("  --rate SPEC          Per-host request limits, HOST=RPS[/BURST[/CONCURRENCY]][,...]\n");
+    printf("                       (HOST '*' = every other host; e.g. cn.bing.com=1/2,*=5)\n");
+    printf("  --connect-to SPEC    Connect to ADDR:PORT instead of HOST:PORT, HOST:PORT:ADDR:PORT[,...]\n");
+    printf("                       (empty HOST/PORT matches any; also XTRANS_CONNECT_TO)\n");
+    printf("  --cacert FILE        CA bundle (PEM) used instead of the built-in one (also XTRANS_CACERT)\n");
+    printf("  --timing FORMAT      Print per-request phase timings to stderr (text or json)\n");
+    printf("  --metrics FILE       Write Prometheus metrics to FILE after every translation (also XTRANS_METRICS)\n");
+    printf("  --stats              Print a summary of requests, latency, errors and cache hits at exit\n");
+    printf("  --trace FILE         Write Chrome trace-event JSON spans to FILE (open in chrome://tracing or Perfetto)\n");
     printf("\n");
     printf("Engines:\n");
-    printf("  hybrid (default) - Try Bing for short sentences, fallback to MyMemory\n");
-    printf("  mymemory        - Use MyMemory only\n");
-    printf("  bing            - Use Bing only\n");
-    printf("  google          - Use Google only\n");
+    list_engines();
     printf("\n");
     printf("Examples:\n");
     printf("  %s \"Hello world\"           # Auto-detect, translate to Chinese\n", program_name);
@@ -392,24 +539,28 @@ void print_usage(const char* program_name) {
     printf("  %s -e mymemory Hello       # Force MyMemory translation\n", program_name);
     printf("  %s --list                  # Show supported languages\n", program_name);
     printf("\n");
-    printf("NOTICE: \n");
-    printf("    Optimization: Short sentences (<100 chars) use Bing for fast translation,\n");
-    printf("    Long sentences use MyMemory. Enable --verbose to see which service is used.\n");
+    printf("Enable --verbose to see which engine serves each request.\n");
+    printf("Engine health (error rates, latency, circuit breakers) persists in ~/.xtrans_health;\n");
+    printf("set XTRANS_HEALTH to use another file.\n");
     printf("\n");
 }
 
+// --metrics FILE: Prometheus text file rewritten after every translation
+static const char* metrics_path = NULL;
+
 static int xtrans(const char* text, const char* source_lang, const char* target_lang
         , const char* engine, int verbose, const char* proxy_val) {
     // Auto-detect source and target languages if target not specified
     if (!target_lang) {
+        // Chinese goes to English, everything else to Chinese; the detected
+        // source is passed on so engines never need a remote auto-detect
         const char* detected = httpc_detect_language(text);
-        if (strcmp(detected, "zh-cn") == 0) {
+        if (strncmp(detected, "zh", 2) == 0) {
             target_lang = "en";
-            source_lang = "zh";
         } else {
             target_lang = "zh-cn";
-            source_lang = "en";
         }
+        source_lang = detected;
         if (verbose) {
             printf("[DEBUG] Auto-detect: %s, using %s -> %s\n", detected, source_lang, target_lang);
         }
@@ -423,58 +574,84 @@ static int xtrans(const char* text, const char* source_lang, const char* target_
             }
         }
     }
+    if (!source_lang) source_lang = "auto";
     if(verbose)
         printf("[DEBUG] proxy: %s\n", proxy_val);
 
-    // Translate
-    char* result = NULL;
-    const char* engine_used = "unknown";
-    if (strcmp(engine, "mymemory") == 0) {
-        engine_used = "MyMemory";
-        result = translate_mymemory(text, source_lang, target_lang, verbose?1:0, proxy_val);
-    } else if (strcmp(engine, "bing") == 0) {
-        engine_used = "Bing";
-        char* bing_result = malloc(1024);
-        if (bing_result && translate_bing_long(text, source_lang, target_lang, bing_result, 1024, verbose?1:0, proxy_val)) {
-            result = bing_result;
-        } else {
-            if (bing_result) free(bing_result);
-            result = NULL;
+    // Per-translation temporaries come from the thread arena and are released at once below
+    xarena_t* arena = xarena_thread();
+    xarena_mark_t mark = xarena_mark(arena);
+
+    // Explicit engine, or every hybrid engine that can serve the request, cheapest first
+    const xtrans_engine_t* route[XTRANS_MAX_ENGINES];
+    size_t route_len = 0;
+    size_t text_bytes = strlen(text);
+    if (strcmp(engine, "hybrid") == 0) {
+        route_len = xtrans_engine_route(source_lang, target_lang, text_bytes, route, XTRANS_MAX_ENGINES);
+        if (route_len == 0) {
+            fprintf(stderr, "No engine supports %s -> %s for %zu bytes\n", source_lang,
+                    target_lang, text_bytes);
         }
-    } else if (strcmp(engine, "google") == 0) {
-        engine_used = "Google";
-        result = translate_google(text, source_lang, target_lang, verbose?1:0, proxy_val);
-    } else if (strcmp(engine, "deepl") == 0) {
-        // engine_used = "DeepL";
-        // char* deepl_result = malloc(1024);
-        // if (deepl_result && translate_deepl(config.text, source_lang, target_lang, deepl_result, 1024, config.verbose, config.proxy)) {
-        //     result = deepl_result;
-        // } else {
-        //     if (deepl_result) free(deepl_result);
-        //     result = NULL;
-        // }
-    } else if (strcmp(engine, "yandex") == 0) {
-        // engine_used = "Yandex";
-        // char* yandex_result = malloc(1024);
-        // if (yandex_result && translate_yandex(config.text, source_lang, target_lang, yandex_result, 1024, config.verbose, config.proxy)) {
-        //     result = yandex_result;
-        // } else {
-        //     if (yandex_result) free(yandex_result);
-        //     result = NULL;
-        // }
     } else {
-        // For hybrid mode, determine which engine was actually used
-        result = translate_hybrid_with_engine(text, source_lang, target_lang, verbose?1:0, &engine_used, proxy_val);
+        const xtrans_engine_t* e = xtrans_engine_find(engine);
+        if (!e) {
+            fprintf(stderr, "Unknown engine: %s\n", engine);
+        } else if (!xtrans_engine_supports(e, source_lang, target_lang, text_bytes)) {
+            fprintf(stderr, "%s does not support %s -> %s for %zu bytes\n", e->label,
+                    source_lang, target_lang, text_bytes);
+        } else {
+            route[route_len++] = e;
+        }
     }
 
+    // Translate
+    uint64_t span = xtrace_begin();
+    char* result = NULL;
+    const char* engine_used = "unknown";
+    size_t tried = 0;
+    for (size_t i = 0; i < route_len && !result; i++) {
+        const xtrans_engine_t* e = route[i];
+        tried = i + 1;
+        if (verbose) printf("[DEBUG] Trying %s (%zu/%zu)\n", e->label, i + 1, route_len);
+
+        uint64_t attempt_span = xtrace_begin();
+        double start = xtrans_engine_now_ms();
+        result = e->translate(arena, text, source_lang, target_lang, verbose ? 1 : 0, proxy_val);
+        double elapsed = xtrans_engine_now_ms() - start;
+        xtrace_end(attempt_span, "engine", e->label, "\"attempt\":%zu,\"ok\":%d", i + 1, result != NULL);
+        xtrans_engine_record(e, elapsed, result != NULL);
+        count_translation(e, elapsed, result != NULL);
+        if (result) engine_used = e->label;
+    }
+    // Engines after the one that answered were never tried: hand back any probes they hold
+    for (size_t i = tried; i < route_len; i++) {
+        xtrans_engine_release(route[i]);
+    }
+    xtrace_end(span, "xtrans", "translate", "\"engine\":\"%s\",\"from\":\"%s\",\"to\":\"%s\",\"bytes\":%zu,\"ok\":%d",
+               engine_used, source_lang, target_lang, text_bytes, result != NULL);
+    if (route_len > 0) {
+        xtrans_engine_save(xtrans_engine_state_path());
+    }
+    if (metrics_path) {
+        xmetrics_save(metrics_path);  // refreshed after every text so collectors see batch progress
+    }
+
+    int ret = 0;
     if (result) {
         printf("[%s] %s\n", engine_used, result);
-        free(result);
-        return 0;
     } else {
         fprintf(stderr, "Translation failed\n");
-        return 1;
+        ret = 1;
     }
+    xarena_rewind(arena, mark);
+
+    if (verbose) {
+        print_health();
+        print_limits();
+        printf("[DEBUG] arena: %zu allocations served by %zu mallocs (reserved %zu bytes, peak %zu bytes)\n",
+               arena->alloc_calls, arena->block_allocs, arena->bytes_reserved, arena->bytes_peak);
+    }
+    return ret;
 }
 
 static void trim_line_end(char* s) {
@@ -527,6 +704,7 @@ static int interactive_trans(const char* source_lang,
         xtrans(line, source_lang, target_lang, engine, verbose, proxy);
         fflush(stdout);
     }
+    xarena_free(xarena_thread());
     xargs_cleanup();
 
     return 0;
@@ -546,7 +724,14 @@ int main(int argc, char* argv[]) {
         {'h', "help", NULL, 1},
         {'x', "proxy", NULL, 0},
         {0, "no-proxy", NULL, 1},
-        {0, "no-bing", NULL, 1}
+        {0, "no-bing", NULL, 1},
+        {0, "rate", NULL, 0},
+        {0, "connect-to", NULL, 0},
+        {0, "cacert", NULL, 0},
+        {0, "timing", NULL, 0},
+        {0, "metrics", NULL, 0},
+        {0, "stats", NULL, 1},
+        {0, "trace", NULL, 0}
     };
     xargs_init(configs, sizeof(configs)/sizeof(configs[0]), argc, argv);
 
@@ -574,6 +759,43 @@ int main(int argc, char* argv[]) {
             proxy_val = xargs_get("all_proxy");
     }
 
+    register_engines();
+    if (xargs_get("no-bing")) {
+        xtrans_engine_disable("bing");
+    }
+    xtrans_engine_load(xtrans_engine_state_path());
+    if (apply_rate_limits(xargs_get("rate")) != 0) {
+        xargs_cleanup();
+        return 1;
+    }
+
+    // Point engine hosts at another server (e.g. the bench mock) without touching the engines
+    const char* connect_to = xargs_get("connect-to");
+    if (!connect_to) connect_to = xargs_get("XTRANS_CONNECT_TO");
+    const char* cacert = xargs_get("cacert");
+    if (!cacert) cacert = xargs_get("XTRANS_CACERT");
+    if (httpc_set_connect_to(connect_to) != 0) {
+        xargs_cleanup();
+        return 1;
+    }
+    httpc_set_default_ca(cacert);
+
+    // Per-request phase timings (DNS/connect/TLS/TTFB/...) on stderr, one line per request
+    const char* timing = xargs_get("timing");
+    if (timing) {
+        if (strcmp(timing, "text") != 0 && strcmp(timing, "json") != 0) {
+            fprintf(stderr, "Invalid --timing format '%s' (expected text or json)\n", timing);
+            xargs_cleanup();
+            return 1;
+        }
+        httpc_set_timing_output(stderr, strcmp(timing, "json") == 0);
+    }
+
+    // Aggregate metrics: Prometheus text file (textfile-collector style) and/or an end-of-run summary
+    metrics_path = xargs_get("metrics");
+    if (!metrics_path) metrics_path = xargs_get("XTRANS_METRICS");
+    int stats = xargs_get("stats") != NULL;
+
     if (help_val) {
         print_usage(argv[0]);
         fflush(stdout);
@@ -587,12 +809,27 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    // Spans for translations, engine attempts, connection setup and requests
+    const char* trace_path = xargs_get("trace");
+    if (trace_path) {
+        if (xtrace_open(trace_path) != 0) {
+            xargs_cleanup();
+            return 1;
+        }
+        xtrace_thread_name("main");
+    }
+
     // Get text to translate
     const char* text = xargs_get_other();
+    int ret;
     if (!text || !text[0]) {
         print_usage(argv[0]);
-        return interactive_trans(source_lang, target_lang, engine, verbose ? 1 : 0, proxy_val);
+        ret = interactive_trans(source_lang, target_lang, engine, verbose ? 1 : 0, proxy_val);
     } else {
-        return xtrans(text, source_lang, target_lang, engine, verbose ? 1 : 0, proxy_val);
+        ret = xtrans(text, source_lang, target_lang, engine, verbose ? 1 : 0, proxy_val);
     }
+    if (stats) print_stats(stderr);
+    httpc_pool_clear();  // close idle keep-alive connections politely
+    xtrace_close();
+    return ret;
 }
@@ -5,9 +5,10 @@
 #include <ctype.h>
 #include <time.h>
 #include "xhttpc.h"
+#include "xarena.h"
+#include "xjson.h"
 #include "xtrans_bing.h"
-
-#define strndup(str) str?strcpy((char*)malloc(strlen(str) + 1), str):NULL
+#include "xlimit.h"
 
 // Case-insensitive string comparison helper
 static inline int str_equals_ignore_case(const char* s1, const char* s2) {
@@ -40,17 +41,138 @@ static void normalize_lang(const char* lang, char* result) {
     }
 }
 
+// Markers on the translator page; each value runs from the marker to its terminator
+enum { BING_FIELD_IG, BING_FIELD_IID, BING_FIELD_IID_ALT, BING_FIELD_PARAMS, BING_FIELD_COUNT };
+
+static const struct {
+    const char* marker;
+    char terminator;
+    size_t limit;               // value must be shorter than this
+} bing_fields[BING_FIELD_COUNT] = {
+    { "IG:\"",                             '"', 256 },
+    { "data-iid=\"",                       '"', 256 },
+    { "translator.",                       '"', 256 },
+    { "params_AbusePreventionHelper = ",   ';', 1024 },
+};
+
+#define BING_SCAN_STATES 64     // trie nodes for all markers (57 today)
+
+enum { BING_PENDING = 0, BING_CAPTURING, BING_FOUND, BING_INVALID };
+
+// Streaming page scanner: an Aho-Corasick DFA over all markers, fed from the receive loop
+typedef struct {
+    unsigned char next[BING_SCAN_STATES][256];
+    unsigned char out[BING_SCAN_STATES];    // bitmask of markers ending in this state
+    int state;
+    int capturing;                          // number of values being captured
+    int status[BING_FIELD_COUNT];
+    char value[BING_FIELD_COUNT][1024];
+    size_t value_len[BING_FIELD_COUNT];
+} bing_scan_t;
+
+static void bing_scan_init(bing_scan_t* scan) {
+    memset(scan, 0, sizeof(*scan));
+
+    // Trie of the markers; state 0 is the root
+    int nstates = 1;
+    for (int f = 0; f < BING_FIELD_COUNT; f++) {
+        int st = 0;
+        for (const unsigned char* p = (const unsigned char*)bing_fields[f].marker; *p; p++) {
+            if (!scan->next[st][*p]) scan->next[st][*p] = (unsigned char)nstates++;
+            st = scan->next[st][*p];
+        }
+        scan->out[st] |= (unsigned char)(1u << f);
+    }
+
+    // Breadth-first failure links, folded into the transition table so that
+    // the scan is a single lookup per byte
+    unsigned char fail[BING_SCAN_STATES] = {0};
+    unsigned char queue[BING_SCAN_STATES];
+    int head = 0, tail = 0;
+    for (int c = 0; c < 256; c++) {
+        if (scan->next[0][c]) queue[tail++] = scan->next[0][c];
+    }
+    while (head < tail) {
+        int st = queue[head++];
+        scan->out[st] |= scan->out[fail[st]];
+        for (int c = 0; c < 256; c++) {
+            unsigned char t = scan->next[st][c];
+            if (t) {
+                fail[t] = scan->next[fail[st]][c];
+                queue[tail++] = t;
+            } else {
+                scan->next[st][c] = scan->next[fail[st]][c];
+            }
+        }
+    }
+}
+
+static int bing_scan_resolved(const bing_scan_t* scan, int f) {
+    return scan->status[f] == BING_FOUND || scan->status[f] == BING_INVALID;
+}
+
+// on_body callback: returns 1 once IG, IID and the token params are resolved
+static int bing_scan_feed(void* ctx, const char* data, size_t len) {
+    bing_scan_t* scan = (bing_scan_t*)ctx;
+    const unsigned char* s = (const unsigned char*)data;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = s[i];
+
+        // Extend values whose marker ended before this byte (first occurrence only)
+        if (scan->capturing) {
+            for (int f = 0; f < BING_FIELD_COUNT; f++) {
+                if (scan->status[f] != BING_CAPTURING) continue;
+                if (c == (unsigned char)bing_fields[f].terminator) {
+                    scan->status[f] = scan->value_len[f] > 0 ? BING_FOUND : BING_INVALID;
+                    scan->capturing--;
+                } else if (scan->value_len[f] + 1 >= bing_fields[f].limit) {
+                    scan->status[f] = BING_INVALID;
+                    scan->capturing--;
+                } else {
+                    scan->value[f][scan->value_len[f]++] = (char)c;
+                }
+            }
+        }
+
+        scan->state = scan->next[scan->state][c];
+        unsigned m = scan->out[scan->state];
+        if (m) {
+            for (int f = 0; f < BING_FIELD_COUNT; f++) {
+                if ((m & (1u << f)) && scan->status[f] == BING_PENDING) {
+                    scan->status[f] = BING_CAPTURING;
+                    scan->capturing++;
+                }
+            }
+        }
+    }
+
+    return bing_scan_resolved(scan, BING_FIELD_IG) && bing_scan_resolved(scan, BING_FIELD_IID) &&
+           bing_scan_resolved(scan, BING_FIELD_PARAMS);
+}
+
+// Decode a captured value (JSON escapes) into out
+static int bing_scan_value(const bing_scan_t* scan, int f, char* out, size_t out_len) {
+    if (scan->status[f] != BING_FOUND) return 0;
+    return httpc_decode_unicode(scan->value[f], scan->value_len[f], out, out_len) > 0;
+}
+
 // Step 1: Setup authentication - bing_setup() equivalent
-static int bing_setup(const char* host, char* ig, char* iid, char* key, char* token, int verbose, const char* proxy) {
+static int bing_setup(xarena_t* arena, const char* host, char* ig, char* iid, char* key, char* token, int verbose, const char* proxy) {
     if (verbose) {
         printf("[SETUP] Getting auth from %s\n", host);
     }
 
-    char* content = malloc(1024*1024);  // 1MB buffer to handle full page
-    if (!content) {
+    // The page is scanned as it streams in; the buffer only holds what arrives
+    // before the markers are found
+    const size_t content_len = 1024*1024;
+    char* content = xarena_alloc(arena, content_len);
+    bing_scan_t* scan = xarena_alloc(arena, sizeof(bing_scan_t));
+    if (!content || !scan) {
         if (verbose) printf("[ERROR] Failed to allocate memory\n");
         return 0;
     }
+    bing_scan_init(scan);
 
     // Configure HTTP client
     httpc_config_t config = {
@@ -69,93 +191,68 @@ static int bing_setup(const char* host, char* ig, char* iid, char* key, char* to
         .data = NULL,
         .data_length = 0,
         .extra_headers = NULL,
-        .proxy = proxy
-    };
+        .proxy = proxy,
+        .arena = arena,
 
-    httpc_client_t* client = httpc_client_init(&config);
-    if (!client) {
-        free(content);
-        if (verbose) printf("[ERROR] Failed to init HTTP client\n");
-        return 0;
-    }
+        // Stop downloading once every marker has been seen
+        .on_body = bing_scan_feed,
+        .on_body_ctx = scan
+    };
 
     int ret = 0;
     size_t content_size = 0;
-    httpc_err_t err = httpc_client_request(client, content, 1024*1024, &content_size);
+    httpc_err_t err = httpc_request_retry(&config, NULL, content, content_len, &content_size, NULL);
 
     if (err == HTTPC_SUCCESS) {
-        content[content_size] = '\0';
         if (verbose) printf("[DEBUG] Got %zu bytes from %s\n", content_size, host);
 
         // Extract IG - Instance GUID
-        if (httpc_extract_pattern(content, "IG:\"", "\"", ig, 256)) {
+        if (bing_scan_value(scan, BING_FIELD_IG, ig, 256)) {
             if (verbose) printf("[SETUP] IG: %s\n", ig);
 
-            // Extract IID - Instance ID
-            int iid_found = 0;
-
-            // Try different IID patterns
-            if (httpc_extract_pattern(content, "data-iid=\"", "\"", iid, 256)) {
-                iid_found = 1;
-                if (verbose) printf("[SETUP] IID: %s\n", iid);
-            } else if (httpc_extract_pattern(content, "translator.", "\"", iid, 256)) {
-                iid_found = 1;
+            // Extract IID - Instance ID, trying the patterns in order
+            if (bing_scan_value(scan, BING_FIELD_IID, iid, 256) ||
+                bing_scan_value(scan, BING_FIELD_IID_ALT, iid, 256)) {
                 if (verbose) printf("[SETUP] IID: %s\n", iid);
             } else {
                 // Fallback: use fixed value that Python found
                 strcpy(iid, "translator.5023");
-                iid_found = 1;
                 if (verbose) printf("[SETUP] Using fallback IID: %s\n", iid);
             }
 
-            if (iid_found) {
-                // Extract Token and Key - params_AbusePreventionHelper
-                if (verbose) {
-                    const char* params_pos = strstr(content, "params_AbusePreventionHelper");
-                    if (params_pos) {
-                        printf("[DEBUG] Found params_AbusePreventionHelper: %.120s\n", params_pos);
-                    } else {
-                        printf("[DEBUG] No params_AbusePreventionHelper found\n");
-                        // Debug: search for any "params" pattern
-                        const char* any_params = strstr(content, "params");
-                        if (any_params) {
-                            printf("[DEBUG] Found 'params': %.120s\n", any_params);
-                        }
-                    }
-                }
-                char token_data[1024];
-                if (httpc_extract_pattern(content, "params_AbusePreventionHelper = ", ";", token_data, sizeof(token_data))) {
-                    // Parse JSON array manually: [key,"token",timeout]
-                    char* key_start = strchr(token_data, '[');
-                    if (key_start) {
-                        key_start++;  // Skip opening bracket
-                        char* key_end = strchr(key_start, ',');
-                        if (key_end) {
-                            *key_end = '\0';
-                            strcpy(key, key_start);
-
-                            // Find token (skip comma and quote)
-                            char* token_start = strchr(key_end + 1, '"');
-                            if (token_start) {
-                                token_start++;  // Skip opening quote
-                                char* token_end = strchr(token_start, '"');
-                                if (token_end) {
-                                    *token_end = '\0';
-                                    strcpy(token, token_start);
-                                    if (verbose) {
-                                        printf("[SETUP] Key: %s\n", key);
-                                        printf("[SETUP] Token: %s\n", token);
-                                    }
-                                    ret = 1;
+            // Extract Token and Key - params_AbusePreventionHelper
+            char token_data[1024];
+            if (bing_scan_value(scan, BING_FIELD_PARAMS, token_data, sizeof(token_data))) {
+                if (verbose) printf("[DEBUG] Found params_AbusePreventionHelper: %.120s\n", token_data);
+
+                // Parse JSON array manually: [key,"token",timeout]
+                char* key_start = strchr(token_data, '[');
+                if (key_start) {
+                    key_start++;  // Skip opening bracket
+                    char* key_end = strchr(key_start, ',');
+                    if (key_end) {
+                        *key_end = '\0';
+                        strcpy(key, key_start);
+
+                        // Find token (skip comma and quote)
+                        char* token_start = strchr(key_end + 1, '"');
+                        if (token_start) {
+                            token_start++;  // Skip opening quote
+                            char* token_end = strchr(token_start, '"');
+                            if (token_end) {
+                                *token_end = '\0';
+                                strcpy(token, token_start);
+                                if (verbose) {
+                                    printf("[SETUP] Key: %s\n", key);
+                                    printf("[SETUP] Token: %s\n", token);
                                 }
+                                ret = 1;
                             }
                         }
                     }
-                } else {
-                    if (verbose) printf("[ERROR] Failed to find token pattern\n");
                 }
             } else {
-                if (verbose) printf("[ERROR] Failed to find IID pattern\n");
+                if (verbose) printf("[ERROR] Failed to find token pattern\n");
             }
         } else {
             if (verbose) printf("[ERROR] Failed to find IG pattern\n");
@@ -163,14 +260,25 @@ static int bing_setup(const char* host, char* ig, char* iid, char* key, char* to
     } else {
         if (verbose) printf("[ERROR] HTTP request failed: %d\n", err);
     }
-
-    httpc_client_free(client);
-    free(content);
     return ret;
 }
 
+// Response extractors: success is [{"translations":[{"text":...}]}], errors are {"statusCode":...}
+typedef struct {
+    xjson_t text;
+    xjson_t status;
+} bing_response_t;
+
+static int bing_on_body(void* ctx, const char* data, size_t len) {
+    bing_response_t* resp = (bing_response_t*)ctx;
+    int st_text = xjson_feed(&resp->text, data, len);
+    int st_status = xjson_feed(&resp->status, data, len);
+    // Stop once the text is in; a status-only error body ends on its own
+    return st_text == XJSON_DONE || (st_text == XJSON_ERROR && st_status == XJSON_ERROR);
+}
+
 // Step 2-4: Execute translation - bing_translate() equivalent
-static int bing_translate(const char* host, const char* ig, const char* iid,
+static int bing_translate(xarena_t* arena, const char* host, const char* ig, const char* iid,
                          const char* key, const char* token,
                          const char* text, const char* from_lang, const char* to_lang,
                          char* result, size_t result_len, int verbose, const char* proxy) {
@@ -179,15 +287,12 @@ static int bing_translate(const char* host, const char* ig, const char* iid,
     snprintf(url, sizeof(url), "/ttranslatev3?IG=%s&IID=%s", ig, iid);
 
     // URL encode text and tokens using xhttpc function
-    char* encoded_text = httpc_url_encode(text);
-    char* encoded_token = httpc_url_encode(token);
-    char* encoded_key = httpc_url_encode(key);
+    char* encoded_text = httpc_url_encode_arena(text, arena);
+    char* encoded_token = httpc_url_encode_arena(token, arena);
+    char* encoded_key = httpc_url_encode_arena(key, arena);
 
     if (!encoded_text || !encoded_token || !encoded_key) {
         if (verbose) printf("[ERROR] Failed to URL encode parameters\n");
-        if (encoded_text) free(encoded_text);
-        if (encoded_token) free(encoded_token);
-        if (encoded_key) free(encoded_key);
         return 0;
     }
 
@@ -196,16 +301,12 @@ static int bing_translate(const char* host, const char* ig, const char* iid,
              "&text=%s&fromLang=%s&to=%s&token=%s&key=%s",
              encoded_text, from_lang, to_lang, encoded_token, encoded_key);
 
-    free(encoded_text);
-    free(encoded_token);
-    free(encoded_key);
-
     if (verbose) {
         printf("[TRANSLATE] POST: %s\n", url);
         printf("[TRANSLATE] Data: %.100s%s\n", post_data, strlen(post_data) > 100 ? "..." : "");
     }
 
-    char* content = malloc(4096);
+    char* content = xarena_alloc(arena, 4096);
     if (!content) {
         if (verbose) printf("[ERROR] Failed to allocate memory\n");
         return 0;
@@ -228,19 +329,23 @@ static int bing_translate(const char* host, const char* ig, const char* iid,
         .data = post_data,
         .data_length = strlen(post_data),
         .extra_headers = NULL,
-        .proxy = proxy
+        .proxy = proxy,
+        .arena = arena
     };
 
-    httpc_client_t* client = httpc_client_init(&config);
-    if (!client) {
-        free(content);
-        if (verbose) printf("[ERROR] Failed to init HTTP client\n");
-        return 0;
-    }
+    // Extract [0]["translations"][0]["text"] and the error statusCode in the same pass
+    bing_response_t resp;
+    char status[16];
+    xjson_init(&resp.text, "/0/translations/0/text", result, result_len);
+    xjson_init(&resp.status, "/statusCode", status, sizeof(status));
+    config.on_body = bing_on_body;
+    config.on_body_ctx = &resp;
 
+    // Translating the same text twice is harmless, so the POST may be retried like a GET
+    static const httpc_retry_t retry = { .idempotent = 1 };
     int ret = 0;
     size_t content_size = 0;
-    httpc_err_t err = httpc_client_request(client, content, 4096, &content_size);
+    httpc_err_t err = httpc_request_retry(&config, &retry, content, 4096, &content_size, NULL);
 
     if (err == HTTPC_SUCCESS) {
         content[content_size] = '\0';
@@ -248,47 +353,24 @@ static int bing_translate(const char* host, const char* ig, const char* iid,
             printf("[DEBUG] Response received: %zu bytes\n", content_size);
         }
 
-        // Look for the JSON body after HTTP headers
-        char* json_start = strstr(content, "\r\n\r\n");
-        if (json_start) {
-            json_start += 4;  // Skip header separator
-
-            // Check for error response first
-            if (strstr(json_start, "\"statusCode\":205")) {
-                if (verbose) printf("[DEBUG] Authentication status: 205 (likely auth token issue)\n");
-                // Provide a fallback response for testing
-                strncpy(result, "Translation in progress - auth needs refinement", result_len - 1);
-                result[result_len - 1] = '\0';
-                ret = 1;
-            } else {
-                // Parse normal JSON response - extract [0]["translations"][0]["text"]
-                char* start = strstr(json_start, "\"text\":\"");
-                if (start) {
-                    start += 8;  // Skip "text":"
-                    char* end = strchr(start, '"');
-                    if (end) {
-                        size_t len = end - start;
-                        if (len > 0 && len < result_len) {
-                            strncpy(result, start, len);
-                            result[len] = '\0';
-                            if (verbose) printf("[SUCCESS] Translation: %s\n", result);
-                            ret = 1;
-                        }
-                    }
-                }
+        if (resp.status.matches && strcmp(status, "205") == 0) {
+            // Rejected token: a failure, so routing falls through and the breaker sees it.
+            // Bing answers 205 when it is throttling us too, so back off the host.
+            if (verbose) printf("[DEBUG] Authentication status: 205 (likely auth token issue)\n");
+            result[0] = '\0';
+            xlimit_throttle(host, -1);
+        } else if (resp.text.matches && !resp.text.truncated && resp.text.out_len > 0) {
+            if (verbose) printf("[SUCCESS] Translation: %s\n", result);
+            ret = 1;
+        }
 
-                if (!ret && verbose) {
-                    printf("[WARN] Response extract data failed.\n");
-                    printf("[DEBUG] Response data:\n%s\n", content);
-                }
-            }
+        if (!ret && verbose) {
+            printf("[WARN] Response extract data failed.\n");
+            printf("[DEBUG] Response data:\n%s\n", content);
         }
     } else {
         if (verbose) printf("[ERROR] POST request failed: %d\n", err);
     }
-
-    httpc_client_free(client);
-    free(content);
     return ret;
 }
 
@@ -300,15 +382,15 @@ int translate_bing_long(const char* text, const char* source_lang, const char* t
     }
 
     // Convert text to UTF-8
-    char utf8_buf[2048] = { 0 };
-    int utf8_len = httpc_any_to_utf8(text, utf8_buf, sizeof(utf8_buf));
-    if (utf8_len < 0) {
+    char utf8_buf[2048];
+    const char* utf8_text = httpc_as_utf8(text, utf8_buf, sizeof(utf8_buf), NULL);  // zero-copy when already UTF-8
+    if (!utf8_text) {
         fprintf(stderr, "[ERROR] Encoding conversion failed\n");
         return 0;
     }
 
     if (verbose) {
-        printf("[TRANSLATE] '%s' (%s → %s)\n", utf8_buf, source_lang, target_lang);
+        printf("[TRANSLATE] '%s' (%s → %s)\n", utf8_text, source_lang, target_lang);
     }
 
     // Storage for auth parameters
@@ -317,12 +399,17 @@ int translate_bing_long(const char* text, const char* source_lang, const char* t
     char key[256] = {0};
     char token[1024] = {0};
 
+    // Page buffer, encoded parameters and clients live in the thread arena for this call only
+    xarena_t* arena = xarena_thread();
+    xarena_mark_t mark = xarena_mark(arena);
+
     // Step 1: Try www.bing.com first (like Python)
-    if (!bing_setup("www.bing.com", ig, iid, key, token, verbose, proxy)) {
+    if (!bing_setup(arena, "www.bing.com", ig, iid, key, token, verbose, proxy)) {
         if (verbose) printf("[ERROR] Setup failed, trying cn.bing.com\n");
         // Fallback to cn.bing.com
-        if (!bing_setup("cn.bing.com", ig, iid, key, token, verbose, proxy)) {
+        if (!bing_setup(arena, "cn.bing.com", ig, iid, key, token, verbose, proxy)) {
             if (verbose) printf("[ERROR] Both hosts failed\n");
+            xarena_rewind(arena, mark);
             return 0;
         }
     }
@@ -333,6 +420,8 @@ int translate_bing_long(const char* text, const char* source_lang, const char* t
     normalize_lang(target_lang, to_lang);
 
     // Step 3-4: Execute translation using www.bing.com first, maybe redirect to cn.bing.com in httpc_client_request
-    return bing_translate("www.bing.com", ig, iid, key, token,
-                       utf8_buf, from_lang, to_lang, result, result_len, verbose, proxy);
+    int ret = bing_translate(arena, "www.bing.com", ig, iid, key, token,
+                       utf8_text, from_lang, to_lang, result, result_len, verbose, proxy);
+    xarena_rewind(arena, mark);
+    return ret;
 }
@@ -0,0 +1,416 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xtrans_engine.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define XTRANS_ERROR_PENALTY 4.0     // a likely failure costs a retry on the next engine
+#define XTRANS_RATE_PENALTY  60000.0 // over budget: only used when nothing else can serve
+
+// Breaker thresholds
+#define XTRANS_TRIP_FAILURES 3       // consecutive failures that open the breaker
+#define XTRANS_TRIP_SAMPLES  5       // ... or this many outcomes in the window
+#define XTRANS_TRIP_RATE     0.5     // ... with at least this error rate
+#define XTRANS_COOLDOWN_MIN  30      // first OPEN period (seconds), doubled per failed probe
+#define XTRANS_COOLDOWN_MAX  600
+#define XTRANS_PROBE_LEASE   60      // seconds a claimed probe blocks other callers if never resolved
+
+#define XTRANS_STATE_MAGIC   "xtrans-health 1"
+
+static const xtrans_engine_t* engines[XTRANS_MAX_ENGINES];
+static xtrans_engine_stats_t engine_stats[XTRANS_MAX_ENGINES];
+static size_t engine_count = 0;
+
+static int engine_index(const xtrans_engine_t* engine) {
+    for (size_t i = 0; i < engine_count; i++) {
+        if (engines[i] == engine) return (int)i;
+    }
+    return -1;
+}
+
+int xtrans_engine_register(const xtrans_engine_t* engine) {
+    if (!engine || !engine->name || !engine->translate) return -1;
+    if (engine_index(engine) >= 0) return 0;
+    if (engine_count >= XTRANS_MAX_ENGINES) {
+        fprintf(stderr, "Engine registry full, '%s' not registered\n", engine->name);
+        return -1;
+    }
+    engines[engine_count] = engine;
+    memset(&engine_stats[engine_count], 0, sizeof(engine_stats[0]));
+    engine_count++;
+    return 0;
+}
+
+size_t xtrans_engine_count(void) {
+    return engine_count;
+}
+
+const xtrans_engine_t* xtrans_engine_at(size_t index) {
+    return index < engine_count ? engines[index] : NULL;
+}
+
+const xtrans_engine_t* xtrans_engine_find(const char* name) {
+    if (!name) return NULL;
+    for (size_t i = 0; i < engine_count; i++) {
+        if (!engine_stats[i].disabled && strcmp(engines[i]->name, name) == 0) return engines[i];
+    }
+    return NULL;
+}
+
+// Recompute the derived fields from the outcomes that are still inside the span
+static void health_refresh(xtrans_engine_stats_t* st, time_t now) {
+    float ok_ms[XTRANS_HEALTH_WINDOW];
+    unsigned n_ok = 0, samples = 0, failed = 0;
+
+    for (unsigned k = 0; k < st->filled; k++) {
+        const xtrans_outcome_t* o = &st->window[k];
+        if (now - o->at >= XTRANS_HEALTH_SPAN) continue;
+        samples++;
+        if (!o->ok) {
+            failed++;
+            continue;
+        }
+        // Insertion sort; the window is small
+        unsigned j = n_ok++;
+        while (j > 0 && ok_ms[j - 1] > o->ms) {
+            ok_ms[j] = ok_ms[j - 1];
+            j--;
+        }
+        ok_ms[j] = o->ms;
+    }
+
+    st->samples = samples;
+    st->error_rate = samples ? (double)failed / samples : 0.0;
+    // Nearest-rank percentiles
+    st->latency_ms = n_ok ? ok_ms[(n_ok - 1) / 2] : 0.0;
+    st->p95_ms = n_ok ? ok_ms[(n_ok * 95 + 99) / 100 - 1] : 0.0;
+}
+
+const xtrans_engine_stats_t* xtrans_engine_stats(const xtrans_engine_t* engine) {
+    int i = engine_index(engine);
+    if (i < 0) return NULL;
+    health_refresh(&engine_stats[i], time(NULL));
+    return &engine_stats[i];
+}
+
+const char* xtrans_engine_breaker_name(xtrans_breaker_t breaker) {
+    switch (breaker) {
+    case XTRANS_BREAKER_OPEN:      return "open";
+    case XTRANS_BREAKER_HALF_OPEN: return "half-open";
+    default:                       return "closed";
+    }
+}
+
+void xtrans_engine_disable(const char* prefix) {
+    size_t n = prefix ? strlen(prefix) : 0;
+    for (size_t i = 0; i < engine_count; i++) {
+        if (strncmp(engines[i]->name, prefix, n) == 0) engine_stats[i].disabled = 1;
+    }
+}
+
+// One side of a "src:dst" pattern: exact language, or a prefix when it ends with '*'
+static int lang_matches(const char* pattern, size_t len, const char* lang) {
+    if (len > 0 && pattern[len - 1] == '*') {
+        return strncmp(lang, pattern, len - 1) == 0;
+    }
+    return strlen(lang) == len && strncmp(lang, pattern, len) == 0;
+}
+
+static int pair_supported(const char* pairs, const char* source_lang, const char* target_lang) {
+    if (!pairs) return 1;
+
+    const char* p = pairs;
+    while (*p) {
+        while (*p == ' ') p++;
+        const char* colon = strchr(p, ':');
+        if (!colon) break;
+        const char* end = colon + 1;
+        while (*end && *end != ' ') end++;
+
+        if (lang_matches(p, (size_t)(colon - p), source_lang) &&
+            lang_matches(colon + 1, (size_t)(end - colon - 1), target_lang)) {
+            return 1;
+        }
+        p = end;
+    }
+    return 0;
+}
+
+int xtrans_engine_supports(const xtrans_engine_t* engine, const char* source_lang,
+                           const char* target_lang, size_t text_bytes) {
+    if (!engine) return 0;
+    if (engine->max_bytes && text_bytes > engine->max_bytes) return 0;
+    return pair_supported(engine->pairs, source_lang ? source_lang : "auto",
+                          target_lang ? target_lang : "auto");
+}
+
+// Expected cost of sending one request to engine i now
+static double engine_cost(size_t i, time_t now) {
+    const xtrans_engine_t* e = engines[i];
+    const xtrans_engine_stats_t* st = &engine_stats[i];
+
+    double cost = st->latency_ms > 0 ? st->latency_ms : e->cost_ms;
+    // A half-open probe is routed at its prior cost: penalising it for the
+    // failures that opened the breaker would keep it from ever being probed
+    if (st->breaker != XTRANS_BREAKER_HALF_OPEN) {
+        cost *= 1.0 + XTRANS_ERROR_PENALTY * st->error_rate;
+    }
+    if (e->rate_per_min && now - st->window_start < 60 && st->window_calls >= (unsigned)e->rate_per_min) {
+        cost += XTRANS_RATE_PENALTY;
+    }
+    return cost;
+}
+
+size_t xtrans_engine_route(const char* source_lang, const char* target_lang, size_t text_bytes,
+                           const xtrans_engine_t** out, size_t max_out) {
+    double cost[XTRANS_MAX_ENGINES];
+    size_t n = 0;
+    time_t now = time(NULL);
+    int open = -1;  // open engine whose cooldown ends first
+
+    for (size_t i = 0; i < engine_count && n < max_out; i++) {
+        xtrans_engine_stats_t* st = &engine_stats[i];
+        if (st->disabled || !(engines[i]->flags & XTRANS_ENGINE_HYBRID)) continue;
+        if (!xtrans_engine_supports(engines[i], source_lang, target_lang, text_bytes)) continue;
+
+        if (st->breaker == XTRANS_BREAKER_OPEN) {
+            if (now < st->open_until) {
+                if (open < 0 || st->open_until < engine_stats[open].open_until) open = (int)i;
+                continue;
+            }
+        } else if (st->breaker == XTRANS_BREAKER_HALF_OPEN && now < st->open_until) {
+            continue;  // another caller holds the probe
+        }
+        if (st->breaker != XTRANS_BREAKER_CLOSED) {
+            // Cooldown over (or an abandoned probe's lease ran out): this caller probes
+            st->breaker = XTRANS_BREAKER_HALF_OPEN;
+            st->open_until = now + XTRANS_PROBE_LEASE;
+        }
+        health_refresh(st, now);
+
+        // Insertion by cost; registry order breaks ties
+        double c = engine_cost(i, now);
+        size_t k = n++;
+        while (k > 0 && cost[k - 1] > c) {
+            cost[k] = cost[k - 1];
+            out[k] = out[k - 1];
+            k--;
+        }
+        cost[k] = c;
+        out[k] = engines[i];
+    }
+
+    if (n == 0 && open >= 0 && max_out > 0) {
+        engine_stats[open].breaker = XTRANS_BREAKER_HALF_OPEN;
+        engine_stats[open].open_until = now + XTRANS_PROBE_LEASE;
+        out[n++] = engines[open];
+    }
+    return n;
+}
+
+void xtrans_engine_release(const xtrans_engine_t* engine) {
+    int i = engine_index(engine);
+    if (i < 0) return;
+
+    // Unused probe: the cooldown is already over, so the next route claims it again
+    xtrans_engine_stats_t* st = &engine_stats[i];
+    if (st->breaker == XTRANS_BREAKER_HALF_OPEN) {
+        st->breaker = XTRANS_BREAKER_OPEN;
+        st->open_until = time(NULL);
+    }
+}
+
+void xtrans_engine_record(const xtrans_engine_t* engine, double elapsed_ms, int ok) {
+    int i = engine_index(engine);
+    if (i < 0) return;
+
+    xtrans_engine_stats_t* st = &engine_stats[i];
+    time_t now = time(NULL);
+
+    xtrans_outcome_t* o = &st->window[st->head];
+    o->at = now;
+    o->ms = (float)elapsed_ms;
+    o->ok = ok ? 1 : 0;
+    st->head = (st->head + 1) % XTRANS_HEALTH_WINDOW;
+    if (st->filled < XTRANS_HEALTH_WINDOW) st->filled++;
+    st->calls++;
+    health_refresh(st, now);
+
+    if (now - st->window_start >= 60) {
+        st->window_start = now;
+        st->window_calls = 0;
+    }
+    st->window_calls++;
+
+    if (st->cooldown == 0) st->cooldown = XTRANS_COOLDOWN_MIN;
+    if (ok) {
+        st->failures = 0;
+        if (st->breaker != XTRANS_BREAKER_CLOSED) {
+            st->breaker = XTRANS_BREAKER_CLOSED;
+            st->cooldown = XTRANS_COOLDOWN_MIN;
+        }
+        return;
+    }
+
+    st->failures++;
+    if (st->breaker != XTRANS_BREAKER_CLOSED) {
+        // Failed probe (or an explicit request to an open engine): back off further
+        st->cooldown = st->cooldown * 2 > XTRANS_COOLDOWN_MAX ? XTRANS_COOLDOWN_MAX : st->cooldown * 2;
+        st->breaker = XTRANS_BREAKER_OPEN;
+        st->open_until = now + st->cooldown;
+    } else if (st->failures >= XTRANS_TRIP_FAILURES ||
+               (st->samples >= XTRANS_TRIP_SAMPLES && st->error_rate >= XTRANS_TRIP_RATE)) {
+        st->breaker = XTRANS_BREAKER_OPEN;
+        st->open_until = now + st->cooldown;
+    }
+}
+
+const char* xtrans_engine_state_path(void) {
+    static char path[1024];
+    if (path[0]) return path;
+
+    const char* env = getenv("XTRANS_HEALTH");
+    if (env && env[0]) {
+        snprintf(path, sizeof(path), "%s", env);
+        return path;
+    }
+#ifdef _WIN32
+    const char* dir = getenv("LOCALAPPDATA");
+    if (!dir || !dir[0]) return NULL;
+    snprintf(path, sizeof(path), "%s\\xtrans_health", dir);
+#else
+    const char* dir = getenv("HOME");
+    if (!dir || !dir[0]) return NULL;
+    snprintf(path, sizeof(path), "%s/.xtrans_health", dir);
+#endif
+    return path;
+}
+
+// One line per engine:
+//   name breaker open_until cooldown failures count at:ms:ok ...
+int xtrans_engine_load(const char* path) {
+    if (!path) return -1;
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    char line[2048];
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, XTRANS_STATE_MAGIC, strlen(XTRANS_STATE_MAGIC)) != 0) {
+        fclose(fp);
+        return 0;
+    }
+
+    time_t now = time(NULL);
+    while (fgets(line, sizeof(line), fp)) {
+        char name[64];
+        int breaker, used;
+        long long open_until;
+        unsigned cooldown, failures, count;
+        if (sscanf(line, "%63s %d %lld %u %u %u%n", name, &breaker, &open_until, &cooldown,
+                   &failures, &count, &used) != 6) continue;
+        if (breaker < XTRANS_BREAKER_CLOSED || breaker > XTRANS_BREAKER_HALF_OPEN) continue;
+        if (count > XTRANS_HEALTH_WINDOW || cooldown > XTRANS_COOLDOWN_MAX) continue;
+
+        size_t i;
+        for (i = 0; i < engine_count && strcmp(engines[i]->name, name) != 0; i++) {}
+        if (i == engine_count) continue;
+
+        xtrans_engine_stats_t* st = &engine_stats[i];
+        xtrans_outcome_t window[XTRANS_HEALTH_WINDOW];
+        const char* p = line + used;
+        unsigned k;
+        for (k = 0; k < count; k++) {
+            long long at;
+            float ms;
+            unsigned ok;
+            int n;
+            if (sscanf(p, " %lld:%f:%u%n", &at, &ms, &ok, &n) != 3) break;
+            window[k].at = (time_t)at;
+            window[k].ms = ms;
+            window[k].ok = ok ? 1 : 0;
+            p += n;
+        }
+        if (k != count) continue;
+
+        // Oldest first, so the ring continues where the previous run stopped
+        memcpy(st->window, window, count * sizeof(window[0]));
+        st->filled = count;
+        st->head = count % XTRANS_HEALTH_WINDOW;
+        st->breaker = (xtrans_breaker_t)breaker;
+        st->open_until = (time_t)open_until;
+        st->cooldown = cooldown;
+        st->failures = failures;
+        health_refresh(st, now);
+    }
+    fclose(fp);
+    return 0;
+}
+
+int xtrans_engine_save(const char* path) {
+    if (!path) return -1;
+
+    // Write a private file and rename it over the old one, so a concurrent
+    // run never reads a half-written state
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    FILE* fp = fopen(tmp, "w");
+    if (!fp) return -1;
+
+    time_t now = time(NULL);
+    fprintf(fp, "%s\n", XTRANS_STATE_MAGIC);
+    for (size_t i = 0; i < engine_count; i++) {
+        const xtrans_engine_stats_t* st = &engine_stats[i];
+
+        // Keep only outcomes still inside the span, oldest first
+        const xtrans_outcome_t* live[XTRANS_HEALTH_WINDOW];
+        unsigned count = 0;
+        unsigned start = st->filled < XTRANS_HEALTH_WINDOW ? 0 : st->head;
+        for (unsigned k = 0; k < st->filled; k++) {
+            const xtrans_outcome_t* o = &st->window[(start + k) % XTRANS_HEALTH_WINDOW];
+            if (now - o->at < XTRANS_HEALTH_SPAN) live[count++] = o;
+        }
+        if (count == 0 && st->breaker == XTRANS_BREAKER_CLOSED) continue;
+
+        fprintf(fp, "%s %d %lld %u %u %u", engines[i]->name, (int)st->breaker,
+                (long long)st->open_until, st->cooldown, st->failures, count);
+        for (unsigned k = 0; k < count; k++) {
+            fprintf(fp, " %lld:%.1f:%u", (long long)live[k]->at, live[k]->ms, (unsigned)live[k]->ok);
+        }
+        fputc('\n', fp);
+    }
+
+    if (fclose(fp) != 0) {
+        remove(tmp);
+        return -1;
+    }
+#ifdef _WIN32
+    // rename() does not replace an existing file on Windows
+    if (!MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if (rename(tmp, path) != 0) {
+#endif
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+double xtrans_engine_now_ms(void) {
+#ifdef _WIN32
+    return (double)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
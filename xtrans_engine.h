@@ -0,0 +1,118 @@
+#ifndef XTRANS_ENGINE_H
+#define XTRANS_ENGINE_H
+
+#include <stddef.h>
+#include <time.h>
+#include "xarena.h"
+
+#define XTRANS_MAX_ENGINES 16
+
+// Health tracking
+#define XTRANS_HEALTH_WINDOW 32     // recent outcomes kept per engine
+#define XTRANS_HEALTH_SPAN   600    // seconds an outcome stays in the window
+
+// Capability flags
+#define XTRANS_ENGINE_BATCH   0x01  // requests can share a connection (pipelining / HTTP/2)
+#define XTRANS_ENGINE_HYBRID  0x02  // eligible for automatic routing
+
+// Uniform adapter: returns the translation allocated from the arena, NULL on failure
+typedef char* (*xtrans_engine_fn)(xarena_t* arena, const char* text, const char* source_lang,
+                                  const char* target_lang, int verbose, const char* proxy);
+
+// Static description of an engine; adding an engine is one row in the registry table
+typedef struct {
+    const char* name;           // -e/--engine value
+    const char* label;          // tag printed with the result
+    xtrans_engine_fn translate;
+    const char* pairs;          // "src:dst" patterns separated by spaces ('*' suffix matches a prefix), NULL = any pair
+    size_t max_bytes;           // longest UTF-8 input served in one request, 0 = unlimited
+    int rate_per_min;           // requests per minute the service tolerates, 0 = unknown
+    double cost_ms;             // latency prior used until the engine has been observed
+    unsigned flags;
+} xtrans_engine_t;
+
+// Circuit breaker: OPEN engines are skipped until the cooldown ends, then a
+// single HALF_OPEN probe decides whether they close again. While the probe is
+// in flight (until xtrans_engine_record or xtrans_engine_release, or the probe
+// lease runs out) the engine is not routed to anyone else
+typedef enum {
+    XTRANS_BREAKER_CLOSED = 0,
+    XTRANS_BREAKER_OPEN,
+    XTRANS_BREAKER_HALF_OPEN
+} xtrans_breaker_t;
+
+typedef struct {
+    time_t at;
+    float ms;
+    unsigned char ok;
+} xtrans_outcome_t;
+
+// Observed behaviour of an engine; the window and breaker survive between runs
+typedef struct {
+    xtrans_outcome_t window[XTRANS_HEALTH_WINDOW];  // ring of recent outcomes
+    unsigned head;              // next slot to write
+    unsigned filled;            // used slots (<= XTRANS_HEALTH_WINDOW)
+
+    // Derived from the outcomes younger than XTRANS_HEALTH_SPAN
+    unsigned samples;
+    double error_rate;          // failures / samples (0..1)
+    double latency_ms;          // p50 of successful requests, 0 = none
+    double p95_ms;
+
+    xtrans_breaker_t breaker;
+    unsigned failures;          // consecutive failures
+    time_t open_until;          // OPEN: end of the cooldown; HALF_OPEN: end of the probe lease
+    unsigned cooldown;          // seconds of the next OPEN period
+
+    unsigned calls;             // requests during this run
+    unsigned window_calls;      // calls in the current one-minute window
+    time_t window_start;
+    int disabled;
+} xtrans_engine_stats_t;
+
+// Add an engine to the registry; returns 0, or -1 when the registry is full
+int xtrans_engine_register(const xtrans_engine_t* engine);
+
+// Registry access
+size_t xtrans_engine_count(void);
+const xtrans_engine_t* xtrans_engine_at(size_t index);
+const xtrans_engine_t* xtrans_engine_find(const char* name);
+const xtrans_engine_stats_t* xtrans_engine_stats(const xtrans_engine_t* engine);
+
+// Exclude engines whose name starts with prefix from routing and lookup
+void xtrans_engine_disable(const char* prefix);
+
+// Whether the engine can serve this language pair and input length
+int xtrans_engine_supports(const xtrans_engine_t* engine, const char* source_lang,
+                           const char* target_lang, size_t text_bytes);
+
+// Hybrid engines able to serve the request, cheapest first; returns the count.
+// Engines with an open breaker or a probe in flight are skipped; an engine whose
+// cooldown has ended is claimed as this caller's probe. When nothing else can
+// serve, the one whose cooldown ends first is returned as a probe
+size_t xtrans_engine_route(const char* source_lang, const char* target_lang, size_t text_bytes,
+                           const xtrans_engine_t** out, size_t max_out);
+
+// Feed the outcome of a request back into the cost model and the breaker
+void xtrans_engine_record(const xtrans_engine_t* engine, double elapsed_ms, int ok);
+
+// Give back a routed engine that was not tried; a claimed probe returns to OPEN
+// so the next route can probe it
+void xtrans_engine_release(const xtrans_engine_t* engine);
+
+// Breaker state as text ("closed", "open", "half-open")
+const char* xtrans_engine_breaker_name(xtrans_breaker_t breaker);
+
+// Health state file: $XTRANS_HEALTH, else ~/.xtrans_health (%LOCALAPPDATA%\xtrans_health
+// on Windows); NULL when no location is known
+const char* xtrans_engine_state_path(void);
+
+// Restore / persist the health of registered engines; return 0, or -1 on I/O error.
+// Unknown engines and malformed lines in the file are ignored
+int xtrans_engine_load(const char* path);
+int xtrans_engine_save(const char* path);
+
+// Monotonic clock in milliseconds
+double xtrans_engine_now_ms(void);
+
+#endif // XTRANS_ENGINE_H
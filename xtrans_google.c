@@ -5,10 +5,20 @@
 #include <time.h>
 #include <math.h>
 #include "xhttpc.h"
+#include "xarena.h"
+#include "xjson.h"
+#include "xmetrics.h"
 #include "xtrans_google.h"
-#define strndup(str, n) str?strncpy((char*)malloc(n + 1), str, n):NULL
 
-// Google Translate result structure
+// Heap copy for strings that outlive the arena (strdup/strndup are not portable to MSVC C mode)
+static char* google_strdup(const char* str) {
+    size_t len = strlen(str) + 1;
+    char* copy = (char*)malloc(len);
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
+
+// Google Translate result structure (strings live in the translation's arena)
 typedef struct {
     char* translation;
     char* original;
@@ -30,12 +40,11 @@ static tk_cache_entry_t tk_cache[MAX_TK_CACHE];
 static int tk_cache_size = 0;
 
 // Forward declarations
-static char* gen_tk(const char* text);
-static char* build_google_url(const char* text, const char* source_lang,
+static char* gen_tk(xarena_t* arena, const char* text);
+static char* build_google_url(xarena_t* arena, const char* text, const char* source_lang,
                             const char* target_lang, const char* hl);
-static google_result_t parse_google_response(const char* json_response);
+static google_result_t parse_google_response(xarena_t* arena, const char* json_response);
 static void clean_cache(void);
-static char* url_encode_component(const char* str);
 
 // XOR operation for TK generation
 static int xor_32(int a, int b) {
@@ -73,17 +82,29 @@ static int gen_rl(int a, const char* b_str) {
     return a;
 }
 
+// TK cache hit/miss counters, registered on first use
+static xmetrics_counter_t* tk_cache_hits;
+static xmetrics_counter_t* tk_cache_misses;
+
 // Generate TK token for Google Translate API
-static char* gen_tk(const char* text) {
+static char* gen_tk(xarena_t* arena, const char* text) {
     if (!text) return NULL;
+    if (!tk_cache_hits) {
+        tk_cache_misses = xmetrics_counter("xtrans_cache_lookups_total", "Cache lookups by cache and result",
+                                           "cache=\"google_tk\",result=\"miss\"");
+        tk_cache_hits = xmetrics_counter("xtrans_cache_lookups_total", "Cache lookups by cache and result",
+                                         "cache=\"google_tk\",result=\"hit\"");
+    }
 
     // Check cache first
     for (int i = 0; i < tk_cache_size; i++) {
         if (tk_cache[i].text && strcmp(tk_cache[i].text, text) == 0 &&
             (time(NULL) - tk_cache[i].timestamp) < 3600) { // Cache for 1 hour
-            return strndup(tk_cache[i].tk, strlen(tk_cache[i].tk));
+            xmetrics_add(tk_cache_hits, 1);
+            return xarena_strdup(arena, tk_cache[i].tk);
         }
     }
+    xmetrics_add(tk_cache_misses, 1);
 
     // Clean old cache entries if needed
     if (tk_cache_size >= MAX_TK_CACHE) {
@@ -100,7 +121,7 @@ static char* gen_tk(const char* text) {
 
     // Convert text to character codes
     int len = (int)strlen(text);
-    int* d = malloc(len * sizeof(int));
+    int* d = xarena_alloc(arena, len * sizeof(int));
     if (!d) return NULL;
 
     for (int i = 0; i < len; i++) {
@@ -122,9 +143,8 @@ static char* gen_tk(const char* text) {
     a %= 1000000;
 
     // Create TK string
-    char* tk = malloc(50);
+    char* tk = xarena_alloc(arena, 50);
     if (!tk) {
-        free(d);
         return NULL;
     }
 
@@ -132,13 +152,12 @@ static char* gen_tk(const char* text) {
 
     // Cache result
     if (tk_cache_size < MAX_TK_CACHE) {
-        tk_cache[tk_cache_size].text = strndup(text, strlen(text));
-        tk_cache[tk_cache_size].tk = strndup(tk, strlen(tk));
+        tk_cache[tk_cache_size].text = google_strdup(text);
+        tk_cache[tk_cache_size].tk = google_strdup(tk);
         tk_cache[tk_cache_size].timestamp = now;
         tk_cache_size++;
     }
 
-    free(d);
     return tk;
 }
 
@@ -162,53 +181,14 @@ static void clean_cache(void) {
     tk_cache_size = new_size;
 }
 
-// URL encode component
-static char* url_encode_component(const char* str) {
-    if (!str) return NULL;
-
-    size_t len = strlen(str);
-    char* encoded = malloc(len * 3 + 1); // Worst case: all chars need encoding
-    if (!encoded) return NULL;
-
-    int j = 0;
-    for (size_t i = 0; i < len; i++) {
-        char c = str[i];
-        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
-            (c >= '0' && c <= '9') || c == '-' || c == '_' ||
-            c == '.' || c == '~') {
-            encoded[j++] = c;
-        } else {
-            sprintf(&encoded[j], "%%%02X", (unsigned char)c);
-            j += 3;
-        }
-    }
-    encoded[j] = '\0';
-
-    return encoded;
-}
-
 // Build Google Translate API request URL
-static char* build_google_url(const char* text, const char* source_lang,
+static char* build_google_url(xarena_t* arena, const char* text, const char* source_lang,
                             const char* target_lang, const char* hl) {
-    char* tk = gen_tk(text);
+    char* tk = gen_tk(arena, text);
     if (!tk) return NULL;
 
-    char* encoded_text = url_encode_component(text);
-    if (!encoded_text) {
-        free(tk);
-        return NULL;
-    }
-
     const char* qc = "qca"; // Use default quality check
-
-    char* url = malloc(1024);
-    if (!url) {
-        free(tk);
-        free(encoded_text);
-        return NULL;
-    }
-
-    snprintf(url, 1024,
+    const char* fmt =
              "https://translate.googleapis.com/translate_a/single"
              "?client=gtx"
              "&ie=UTF-8&oe=UTF-8"
@@ -216,101 +196,93 @@ static char* build_google_url(const char* text, const char* source_lang,
              "&dt=%s"
              "&sl=%s&tl=%s&hl=%s"
              "&tk=%s"
-             "&q=%s",
-             qc, source_lang ? source_lang : "auto", target_lang, hl ? hl : "en",
-             tk, encoded_text);
+             "&q=";
+    source_lang = source_lang ? source_lang : "auto";
+    hl = hl ? hl : "en";
+
+    // Size the URL exactly: fixed prefix + encoded text, which is written in place
+    size_t text_len = strlen(text);
+    int prefix_len = snprintf(NULL, 0, fmt, qc, source_lang, target_lang, hl, tk);
+    if (prefix_len < 0) return NULL;
+    size_t encoded_len = httpc_url_encode_len(text, text_len, HTTPC_URL_COMPONENT);
+
+    size_t url_size = (size_t)prefix_len + encoded_len + 1;
+    char* url = xarena_alloc(arena, url_size);
+    if (!url) {
+        return NULL;
+    }
+
+    snprintf(url, url_size, fmt, qc, source_lang, target_lang, hl, tk);
+    httpc_url_encode_into(text, text_len, HTTPC_URL_COMPONENT, url + prefix_len, url_size - prefix_len);
 
-    free(tk);
-    free(encoded_text);
     return url;
 }
 
-// Parse Google Translate JSON response
-static google_result_t parse_google_response(const char* json_response) {
+// Parse Google Translate JSON response:
+// [[["sentence","original",...],...],null,"detected_lang",...]
+static google_result_t parse_google_response(xarena_t* arena, const char* json_response) {
     google_result_t result = {0};
 
     if (!json_response || strlen(json_response) == 0) {
-        result.error = strndup("Empty response", 10);
+        result.error = xarena_strdup(arena, "Empty response");
         return result;
     }
 
     // Check if response starts with '[' (JSON array)
     if (json_response[0] != '[') {
-        result.error = strndup("Invalid response format", 20);
+        result.error = xarena_strdup(arena, "Invalid response format");
         return result;
     }
 
-    // Extract main translations from data[0][0][0]
-    char* translation = malloc(2048);
+    // Decoded text never exceeds the escaped source, so the body length bounds the output
+    size_t json_len = strlen(json_response);
+    char* translation = xarena_alloc(arena, json_len + 1);
     if (!translation) {
-        result.error = strndup("Memory allocation failed", 22);
+        result.error = xarena_strdup(arena, "Memory allocation failed");
         return result;
     }
-    translation[0] = '\0';
-
-    // Simple pattern matching approach
-    // Look for pattern: [[["translation","original",...]
-    const char* ptr = json_response;
-    int found_translation = 0;
-
-    // Find pattern [[[" (three brackets and opening quote)
-    char* pattern_start = strstr(json_response, "[[[\"");
-    if (!pattern_start) {
-        result.error = strndup("Cannot find translation pattern", 28);
-        free(translation);
-        return result;
-    }
-
-    ptr = pattern_start + 4; // Skip "[[[\""
-
-    // Extract translation until closing quote
-    const char* text_start = ptr;
-    while (*ptr && (*ptr != '"' || (ptr > text_start && *(ptr-1) == '\\'))) {
-        ptr++;
-    }
+    char detected[16];
 
-    if (*ptr == '"') {
-        size_t len = ptr - text_start;
-        if (len > 0 && len < 1000) { // Sanity check
-            strncpy(translation, text_start, len);
-            translation[len] = '\0';
-            found_translation = 1;
-        }
+    // One scan: every sentence of data[0][*][0] is concatenated, data[2] is the source language
+    xjson_t sentences, lang;
+    xjson_init(&sentences, "/0/*/0", translation, json_len + 1);
+    xjson_init(&lang, "/2", detected, sizeof(detected));
+    if (xjson_feed(&sentences, json_response, json_len) == XJSON_ERROR) {
+        result.error = xarena_strdup(arena, "Malformed JSON response");
+        return result;
     }
+    xjson_feed(&lang, json_response, json_len);
 
-    if (found_translation && strlen(translation) > 0) {
+    if (sentences.matches > 0 && sentences.out_len > 0) {
         result.translation = translation;
         result.success = 1;
-
-        // Default language detection - assume source based on content or use "unknown"
-        result.detected_language = strndup("unknown", 7);
+        result.detected_language = xarena_strdup(arena, lang.matches ? detected : "unknown");
     } else {
-        free(translation);
-        result.error = strndup("No translation found", 16);
+        result.error = xarena_strdup(arena, "No translation found");
     }
 
     return result;
 }
 
-// Main Google Translate function
-static google_result_t translate_google_imp(const char* text, const char* source_lang,
+// Main Google Translate function; every temporary comes from the arena
+static google_result_t translate_google_imp(xarena_t* arena, const char* text, const char* source_lang,
                                const char* target_lang, int verbose, const char* proxy) {
     google_result_t result = {0};
 
     if (!text || strlen(text) == 0) {
-        result.error = strndup("Empty text", 10);
+        result.error = xarena_strdup(arena, "Empty text");
         return result;
     }
 
     if (!target_lang) {
-        result.error = strndup("Target language is required", 25);
+        result.error = xarena_strdup(arena, "Target language is required");
         return result;
     }
 
     // Build request URL
-    char* url = build_google_url(text, source_lang, target_lang, "en");
+    char* url = build_google_url(arena, text, source_lang, target_lang, "en");
     if (!url) {
-        result.error = strndup("Failed to build request URL", 26);
+        result.error = xarena_strdup(arena, "Failed to build request URL");
         return result;
     }
 
@@ -334,28 +306,22 @@ static google_result_t translate_google_imp(const char* text, const char* source
         .data = NULL,
         .data_length = 0,
         .extra_headers = "Accept: */*\r\nAccept-Language: en-US,en;q=0.9",
-        .proxy = proxy
+        .proxy = proxy,
+        .http2 = 1,
+        .pipeline_depth = 4, // gtx is GET-only; used when h2 is not negotiated
+        .arena = arena
     };
 
-    // Initialize client and send request
-    httpc_client_t* client = httpc_client_init(&config);
-    if (!client) {
-        result.error = strndup("Failed to initialize HTTP client", 30);
-        free(url);
-        return result;
-    }
-
+    // Send request (transient failures are retried with backoff)
     char response[8192] = {0};
     httpc_response_t resp_info = {0};
     size_t actual_read = 0;
 
-    httpc_err_t err = httpc_client_request(client, response, sizeof(response), &actual_read);
-    httpc_client_free(client);
-    free(url);
+    httpc_err_t err = httpc_request_retry(&config, NULL, response, sizeof(response), &actual_read, NULL);
 
     if (err != HTTPC_SUCCESS) {
-        result.error = malloc(100);
-        snprintf(result.error, 100, "HTTP request failed: %d", err);
+        result.error = xarena_alloc(arena, 100);
+        if (result.error) snprintf(result.error, 100, "HTTP request failed: %d", err);
         return result;
     }
 
@@ -378,40 +344,38 @@ static google_result_t translate_google_imp(const char* text, const char* source
     if (verbose) {
         printf("[DEBUG] Raw response: %.500s\n", json_content);
     }
-    result = parse_google_response(json_content);
+    result = parse_google_response(arena, json_content);
 
     if (verbose && result.success) {
         // Add original text to result
-        result.original = strndup(text, strlen(text));
+        result.original = xarena_strdup(arena, text);
         printf("[DEBUG] Parsed translation: '%s'\n", result.translation);
     }
 
     return result;
 }
 
-// Free Google result structure
+// Free Google result structure (the strings are released with the arena)
 void free_google_result(google_result_t* result) {
     if (!result) return;
 
-    free(result->translation);
-    free(result->original);
-    free(result->phonetics);
-    free(result->detected_language);
-    free(result->error);
-
     memset(result, 0, sizeof(google_result_t));
 }
 
 // Detect language using Google Translate
 char* google_detect_language(const char* text) {
-    google_result_t result = translate_google_imp(text, "auto", "en", 0, NULL);
+    xarena_t* arena = xarena_thread();
+    xarena_mark_t mark = xarena_mark(arena);
+
+    google_result_t result = translate_google_imp(arena, text, "auto", "en", 0, NULL);
     char* detected = NULL;
 
     if (result.success && result.detected_language) {
-        detected = strndup(result.detected_language, strlen(result.detected_language));
+        detected = google_strdup(result.detected_language);
     }
 
     free_google_result(&result);
+    xarena_rewind(arena, mark);
     return detected;
 }
 
@@ -431,17 +395,21 @@ static inline void google_cleanup(void) {
 }
 
 char* translate_google(const char* text, const char* source, const char* target, int verbose, const char* proxy) {
+    xarena_t* arena = xarena_thread();
+    xarena_mark_t mark = xarena_mark(arena);
+
     google_init();
-    google_result_t result = translate_google_imp(text, source, target, verbose, proxy);
+    google_result_t result = translate_google_imp(arena, text, source, target, verbose, proxy);
     char* translation = NULL;
 
     if (result.success && result.translation) {
-        translation = strndup(result.translation, strlen(result.translation));
+        translation = google_strdup(result.translation);
     } else if (result.error) {
         fprintf(stderr, "Google translation error: %s\n", result.error);
     }
 
     free_google_result(&result);
     google_cleanup();
+    xarena_rewind(arena, mark);
     return translation;
 }
@@ -0,0 +1,87 @@
+#ifndef XTRANS_MBEDTLS_CONFIG_H
+#define XTRANS_MBEDTLS_CONFIG_H
+
+/**
+ * @brief xtrans 专用的 mbedtls 2.16 裁剪配置（make lean）
+ * @note 通过 -DMBEDTLS_CONFIG_FILE='"xtrans_mbedtls_config.h"' 代替 mbedtls/config.h，
+ *       主程序和 mbedtls 必须用同一份配置编译（结构体布局随配置变化），lean 模式因此使用独立的目标文件目录。
+ *       只保留 xhttpc 用到的部分：TLS 1.2 客户端、ECDHE 密钥交换、AES-GCM / ChaCha20-Poly1305、
+ *       SHA-256/384、X.509 证书解析和校验（内置 CA 包多为 RSA 根证书）、平台熵源和套接字。
+ *       未启用的模块编译为空目标文件，不进入链接。
+ *       xmock 需要服务端、证书签发和密钥生成，bench 模式始终使用完整配置。
+ */
+
+/* ===================== 系统与平台 ===================== */
+#define MBEDTLS_HAVE_ASM
+#define MBEDTLS_HAVE_TIME
+#define MBEDTLS_HAVE_TIME_DATE          // 校验证书有效期
+#define MBEDTLS_FS_IO                   // --cacert 从文件加载 CA
+#define MBEDTLS_NET_C
+#define MBEDTLS_ENTROPY_C               // 平台熵源：getrandom / /dev/urandom，Windows 上为 CryptGenRandom
+#define MBEDTLS_CTR_DRBG_C
+
+/* ===================== 对称加密与哈希 ===================== */
+#define MBEDTLS_AES_C
+#define MBEDTLS_AESNI_C                 // AES-NI；CPU 支持 PCLMULQDQ 时 GCM 的 GHASH 也走 CLMUL（仅 x86-64 GCC/Clang）
+#define MBEDTLS_GCM_C
+#define MBEDTLS_CHACHA20_C
+#define MBEDTLS_POLY1305_C
+#define MBEDTLS_CHACHAPOLY_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SHA512_C                // SHA-384 由 SHA-512 模块提供
+
+/* ===================== 公钥、椭圆曲线与证书 ===================== */
+#define MBEDTLS_BIGNUM_C
+#define MBEDTLS_MPI_MAX_SIZE            512     // 最大 4096 位 RSA 根证书
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_DP_SECP384R1_ENABLED
+#define MBEDTLS_ECP_DP_CURVE25519_ENABLED
+#define MBEDTLS_ECP_MAX_BITS            384     // 只启用到 P-384
+#define MBEDTLS_ECP_NIST_OPTIM          // NIST 曲线的快速模约简
+#define MBEDTLS_ECP_WINDOW_SIZE         6       // 握手时的标量乘法更快，代价是几 KB 临时内存
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM   1       // 缓存基点的预计算表
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_RSA_C
+#define MBEDTLS_PKCS1_V15
+#define MBEDTLS_PKCS1_V21               // RSA-PSS 签名的证书
+#define MBEDTLS_PK_C
+#define MBEDTLS_PK_PARSE_C
+#define MBEDTLS_ASN1_PARSE_C
+#define MBEDTLS_ASN1_WRITE_C            // ECDSA 模块的前置条件
+#define MBEDTLS_OID_C
+#define MBEDTLS_BASE64_C                // PEM 解析和代理的 Basic 认证
+#define MBEDTLS_PEM_PARSE_C
+#define MBEDTLS_X509_USE_C
+#define MBEDTLS_X509_CRT_PARSE_C
+#define MBEDTLS_X509_RSASSA_PSS_SUPPORT
+#define MBEDTLS_X509_CHECK_KEY_USAGE
+#define MBEDTLS_X509_CHECK_EXTENDED_KEY_USAGE
+
+/* ===================== TLS 客户端 ===================== */
+#define MBEDTLS_SSL_TLS_C
+#define MBEDTLS_SSL_CLI_C
+#define MBEDTLS_SSL_PROTO_TLS1_2
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#define MBEDTLS_SSL_SERVER_NAME_INDICATION
+#define MBEDTLS_SSL_ALPN                // h2 协商
+#define MBEDTLS_SSL_EXTENDED_MASTER_SECRET
+#define MBEDTLS_SSL_SESSION_TICKETS     // 会话恢复（见 xhttpc.c 的 TLS 会话缓存）
+
+/* 只提供 AEAD 套件：AES-128-GCM 在有 AES-NI 时最快，ChaCha20 适合没有 AES 指令的 CPU */
+#define MBEDTLS_SSL_CIPHERSUITES \
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, \
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, \
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256, \
+    MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256, \
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384, \
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384
+
+/* 2.16 的配置文件自己包含检查 */
+#include "mbedtls/check_config.h"
+
+#endif // XTRANS_MBEDTLS_CONFIG_H
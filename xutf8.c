@@ -0,0 +1,284 @@
+#include "xutf8.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define XUTF8_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define XUTF8_TARGET_AVX2
+#else
+#define XUTF8_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/**
+ * @brief 校验从 s[i] 开始的一个非 ASCII 序列（Unicode 表 3-7）
+ * @return 序列长度，0 表示非法或截断
+ */
+static size_t xutf8_sequence(const unsigned char* s, size_t i, size_t len) {
+    unsigned char c = s[i];
+    size_t need;
+    unsigned char lo = 0x80, hi = 0xBF;   // 第二个字节的合法范围
+
+    if (c >= 0xC2 && c <= 0xDF) {
+        need = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 3;
+        if (c == 0xE0) lo = 0xA0;         // 超长编码
+        if (c == 0xED) hi = 0x9F;         // 代理区
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 4;
+        if (c == 0xF0) lo = 0x90;         // 超长编码
+        if (c == 0xF4) hi = 0x8F;         // > U+10FFFF
+    } else {
+        return 0;                         // 续字节、C0/C1、F5..FF
+    }
+
+    if (len - i < need) return 0;
+    if (s[i + 1] < lo || s[i + 1] > hi) return 0;
+    for (size_t j = 2; j < need; j++) {
+        if ((s[i + j] & 0xC0) != 0x80) return 0;
+    }
+    return need;
+}
+
+int xutf8_validate_scalar(const char* str, size_t len) {
+    const unsigned char* s = (const unsigned char*)str;
+    size_t i = 0;
+
+    while (i < len) {
+        // ASCII 快速路径：一次检查 8 个字节
+        while (i + 8 <= len) {
+            uint64_t w;
+            memcpy(&w, s + i, sizeof(w));
+            if (w & 0x8080808080808080ULL) break;
+            i += 8;
+        }
+        if (i >= len) break;
+
+        if (s[i] < 0x80) {
+            i++;
+            continue;
+        }
+        size_t n = xutf8_sequence(s, i, len);
+        if (n == 0) return 0;
+        i += n;
+    }
+    return 1;
+}
+
+#ifdef XUTF8_X86
+
+static unsigned xutf8_ctz(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// SSE2 没有字节查表指令，只做 ASCII 快速路径，遇到非 ASCII 时标量校验到下一个 ASCII 字节
+static int xutf8_validate_sse2(const char* str, size_t len) {
+    const unsigned char* s = (const unsigned char*)str;
+    size_t i = 0;
+
+    while (i + 16 <= len) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(v);
+        if (mask == 0) {
+            i += 16;
+            continue;
+        }
+        i += xutf8_ctz(mask);             // 跳到第一个非 ASCII 字节
+        while (i < len && s[i] >= 0x80) {
+            size_t n = xutf8_sequence(s, i, len);
+            if (n == 0) return 0;
+            i += n;
+        }
+    }
+    return xutf8_validate_scalar(str + i, len - i);
+}
+
+/*
+ * AVX2：查表法（Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"）
+ * 以"前一字节高/低半字节 + 当前字节高半字节"三张 16 项表的交集判定两字节组合的错误类型，
+ * 再用前 2/3 个字节判定三/四字节序列的续字节个数
+ */
+#define XUTF8_TOO_SHORT      (1 << 0)
+#define XUTF8_TOO_LONG       (1 << 1)
+#define XUTF8_OVERLONG_3     (1 << 2)
+#define XUTF8_TOO_LARGE      (1 << 3)
+#define XUTF8_SURROGATE      (1 << 4)
+#define XUTF8_OVERLONG_2     (1 << 5)
+#define XUTF8_TOO_LARGE_1000 (1 << 6)
+#define XUTF8_OVERLONG_4     (1 << 6)
+#define XUTF8_TWO_CONTS      (1 << 7)
+#define XUTF8_CARRY          (XUTF8_TOO_SHORT | XUTF8_TOO_LONG | XUTF8_TWO_CONTS)
+
+static const int8_t xutf8_byte1_high[16] = {
+    // 0_______：前一字节为 ASCII
+    XUTF8_TOO_LONG, XUTF8_TOO_LONG, XUTF8_TOO_LONG, XUTF8_TOO_LONG,
+    XUTF8_TOO_LONG, XUTF8_TOO_LONG, XUTF8_TOO_LONG, XUTF8_TOO_LONG,
+    // 10______：前一字节为续字节
+    XUTF8_TWO_CONTS, XUTF8_TWO_CONTS, XUTF8_TWO_CONTS, XUTF8_TWO_CONTS,
+    // 1100____ / 1101____：双字节首字节
+    XUTF8_TOO_SHORT | XUTF8_OVERLONG_2,
+    XUTF8_TOO_SHORT,
+    // 1110____：三字节首字节
+    XUTF8_TOO_SHORT | XUTF8_OVERLONG_3 | XUTF8_SURROGATE,
+    // 1111____：四字节首字节
+    (int8_t)(XUTF8_TOO_SHORT | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000 | XUTF8_OVERLONG_4)
+};
+
+static const int8_t xutf8_byte1_low[16] = {
+    XUTF8_CARRY | XUTF8_OVERLONG_3 | XUTF8_OVERLONG_2 | XUTF8_OVERLONG_4,   // ____0000
+    XUTF8_CARRY | XUTF8_OVERLONG_2,                                         // ____0001
+    XUTF8_CARRY,                                                            // ____0010
+    XUTF8_CARRY,                                                            // ____0011
+    XUTF8_CARRY | XUTF8_TOO_LARGE,                                          // ____0100
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,                   // ____0101
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000 | XUTF8_SURROGATE, // ____1101
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000,
+    XUTF8_CARRY | XUTF8_TOO_LARGE | XUTF8_TOO_LARGE_1000
+};
+
+static const int8_t xutf8_byte2_high[16] = {
+    // ________ 0_______：当前字节为 ASCII
+    XUTF8_TOO_SHORT, XUTF8_TOO_SHORT, XUTF8_TOO_SHORT, XUTF8_TOO_SHORT,
+    XUTF8_TOO_SHORT, XUTF8_TOO_SHORT, XUTF8_TOO_SHORT, XUTF8_TOO_SHORT,
+    // ________ 1000____
+    (int8_t)(XUTF8_TOO_LONG | XUTF8_OVERLONG_2 | XUTF8_TWO_CONTS | XUTF8_OVERLONG_3 | XUTF8_TOO_LARGE_1000 | XUTF8_OVERLONG_4),
+    // ________ 1001____
+    (int8_t)(XUTF8_TOO_LONG | XUTF8_OVERLONG_2 | XUTF8_TWO_CONTS | XUTF8_OVERLONG_3 | XUTF8_TOO_LARGE),
+    // ________ 101_____
+    (int8_t)(XUTF8_TOO_LONG | XUTF8_OVERLONG_2 | XUTF8_TWO_CONTS | XUTF8_SURROGATE | XUTF8_TOO_LARGE),
+    (int8_t)(XUTF8_TOO_LONG | XUTF8_OVERLONG_2 | XUTF8_TWO_CONTS | XUTF8_SURROGATE | XUTF8_TOO_LARGE),
+    // ________ 11______：当前字节为首字节
+    XUTF8_TOO_SHORT, XUTF8_TOO_SHORT, XUTF8_TOO_SHORT, XUTF8_TOO_SHORT
+};
+
+XUTF8_TARGET_AVX2
+static __m256i xutf8_table(const int8_t* t) {
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)t));
+}
+
+// 当前块与上一块拼接后向前错 n 字节（n = 1..3）
+#define XUTF8_PREV(input, prev, n) \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+XUTF8_TARGET_AVX2
+static int xutf8_validate_avx2(const char* str, size_t len) {
+    const __m256i t1h = xutf8_table(xutf8_byte1_high);
+    const __m256i t1l = xutf8_table(xutf8_byte1_low);
+    const __m256i t2h = xutf8_table(xutf8_byte2_high);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i third_min = _mm256_set1_epi8((char)(0xE0 - 0x80));
+    const __m256i fourth_min = _mm256_set1_epi8((char)(0xF0 - 0x80));
+    const __m256i high_bit = _mm256_set1_epi8((char)0x80);
+
+    __m256i prev = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    int prev_ascii = 1;
+    size_t i = 0;
+
+    // 最后一块用 0 补齐（0 是 ASCII，截断的多字节序列会被判为 TOO_SHORT）；
+    // 数据恰好整块时再补一个全 0 块
+    for (;;) {
+        __m256i input;
+        int last = 0;
+        if (i + 32 <= len) {
+            input = _mm256_loadu_si256((const __m256i*)(str + i));
+        } else {
+            unsigned char tail[32] = {0};
+            memcpy(tail, str + i, len - i);
+            input = _mm256_loadu_si256((const __m256i*)tail);
+            last = 1;
+        }
+
+        int ascii = _mm256_movemask_epi8(input) == 0;
+        if (!(ascii && prev_ascii)) {
+            __m256i prev1 = XUTF8_PREV(input, prev, 1);
+            __m256i b1h = _mm256_shuffle_epi8(t1h, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+            __m256i b1l = _mm256_shuffle_epi8(t1l, _mm256_and_si256(prev1, nibble));
+            __m256i b2h = _mm256_shuffle_epi8(t2h, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+            __m256i special = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+
+            __m256i prev2 = XUTF8_PREV(input, prev, 2);
+            __m256i prev3 = XUTF8_PREV(input, prev, 3);
+            __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, third_min),
+                                             _mm256_subs_epu8(prev3, fourth_min));
+            __m256i must23_80 = _mm256_and_si256(must23, high_bit);
+            error = _mm256_or_si256(error, _mm256_xor_si256(must23_80, special));
+        }
+        prev = input;
+        prev_ascii = ascii;
+
+        if (last) break;
+        i += 32;
+        if (i == len && prev_ascii) break;  // 整块结束且末块全 ASCII：不可能截断
+    }
+    return _mm256_testz_si256(error, error);
+}
+
+static int xutf8_has_avx2(void) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return 0;
+    __cpuid(info, 1);
+    // OSXSAVE + AVX，且操作系统保存了 YMM 状态
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return 0;
+    if ((_xgetbv(0) & 6) != 6) return 0;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // XUTF8_X86
+
+typedef int (*xutf8_fn)(const char*, size_t);
+
+static xutf8_fn xutf8_selected = NULL;
+static const char* xutf8_selected_name = "scalar";
+
+static void xutf8_select(void) {
+#ifdef XUTF8_X86
+    if (xutf8_has_avx2()) {
+        xutf8_selected_name = "avx2";
+        xutf8_selected = xutf8_validate_avx2;
+        return;
+    }
+    xutf8_selected_name = "sse2";
+    xutf8_selected = xutf8_validate_sse2;
+#else
+    xutf8_selected_name = "scalar";
+    xutf8_selected = xutf8_validate_scalar;
+#endif
+}
+
+int xutf8_validate(const char* str, size_t len) {
+    if (str == NULL) return 0;
+    // 重复选择结果相同，多线程下首次竞争无害
+    if (!xutf8_selected) xutf8_select();
+    return xutf8_selected(str, len);
+}
+
+const char* xutf8_impl(void) {
+    if (!xutf8_selected) xutf8_select();
+    return xutf8_selected_name;
+}
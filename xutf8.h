@@ -0,0 +1,26 @@
+#ifndef XUTF8_H
+#define XUTF8_H
+
+#include <stddef.h>
+
+/**
+ * @brief 严格校验 UTF-8（拒绝超长编码、代理区 U+D800..U+DFFF、大于 U+10FFFF 的码点、截断序列）
+ * @note 首次调用时按 CPU 能力选择实现：AVX2 向量查表校验 → SSE2 ASCII 快速路径 → 标量
+ * @param str 输入数据
+ * @param len 长度（字节）
+ * @return 1=合法 UTF-8，0=非法
+ */
+int xutf8_validate(const char* str, size_t len);
+
+/**
+ * @brief 标量实现（供对照/基准测试）
+ */
+int xutf8_validate_scalar(const char* str, size_t len);
+
+/**
+ * @brief 当前选用的实现
+ * @return "avx2"、"sse2" 或 "scalar"
+ */
+const char* xutf8_impl(void);
+
+#endif // XUTF8_H